@@ -0,0 +1,262 @@
+import { LatencyHistogram } from './scheduler';
+import type { LatencyStats } from './scheduler';
+import type { DecodePriority } from './types';
+
+/**
+ * Cost class of a request. Cheap requests (cache hits, validation-only,
+ * malformed VINs) are dequeued first and never shed by the latency controller.
+ */
+export type RequestClass = 'cheap' | 'full';
+
+/**
+ * Options for admission control
+ */
+export interface AdmissionOptions {
+  /** Maximum requests running at once (default: 1) */
+  concurrency?: number;
+
+  /** Acceptable queueing delay once a standing queue has formed, in ms (default: 20) */
+  targetDelay?: number;
+
+  /** Window the queue must stay non-empty before it counts as standing, in ms (default: 500) */
+  interval?: number;
+
+  /** Hard cap on queued interactive requests across both classes (default: 1024) */
+  maxQueue?: number;
+
+  /** Hard cap on queued bulk requests (default: 8192) */
+  maxBulkQueue?: number;
+
+  /** Share of starts bulk requests still get while interactive requests wait, 0-1 (default: 0.1) */
+  minBulkShare?: number;
+
+  /** Retry-After hint returned with shed requests, in seconds (default: 1) */
+  retryAfter?: number;
+}
+
+/**
+ * Admission counters
+ */
+export interface AdmissionStats {
+  /** Requests currently running */
+  running: number;
+  /** Interactive requests waiting, per class */
+  queued: Record<RequestClass, number>;
+  /** Bulk requests waiting */
+  queuedBulk: number;
+  /** Requests admitted and completed, per class */
+  completed: Record<RequestClass, number>;
+  /** Requests shed because queueing delay exceeded the target */
+  shedLatency: number;
+  /** Requests shed because the queue was full */
+  shedQueueFull: number;
+  /** Bulk requests started on the guaranteed share while interactive requests waited */
+  bulkGrants: number;
+  /** Whether the controller currently sees a standing queue */
+  overloaded: boolean;
+  /** Time from arrival to completion, per priority */
+  latency: Record<DecodePriority, LatencyStats>;
+}
+
+/**
+ * Error raised for requests rejected by admission control
+ */
+export class OverloadError extends Error {
+  /**
+   * @param retryAfter - Suggested wait before retrying, in seconds
+   * @param reason - Why the request was shed
+   */
+  constructor(
+    public readonly retryAfter: number,
+    public readonly reason: 'latency' | 'queue-full',
+  ) {
+    super(`Server overloaded (${reason})`);
+    this.name = 'OverloadError';
+  }
+}
+
+interface QueuedTask {
+  enqueuedAt: number;
+  run: () => void;
+  shed: (error: OverloadError) => void;
+}
+
+/**
+ * Queue-latency based admission control (CoDel-style)
+ *
+ * While the queue drains regularly, requests may wait up to `interval`. Once
+ * the queue has not been empty for a whole `interval` it is a standing queue:
+ * full requests then get only `targetDelay` of queueing, anything older is
+ * shed on dequeue, and new full requests are rejected immediately while the
+ * oldest waiter is already past the target. Cheap requests skip ahead of full
+ * ones and are only rejected when the queue is at its hard cap.
+ *
+ * Bulk requests wait in a queue of their own behind all interactive
+ * requests, except that every interactive start earns bulk credit so bulk
+ * still gets `minBulkShare` of starts under sustained interactive load. Bulk
+ * requests are never shed for latency and do not count toward the standing
+ * queue.
+ */
+export class AdmissionController {
+  private concurrency: number;
+  private targetDelay: number;
+  private interval: number;
+  private maxQueue: number;
+  private maxBulkQueue: number;
+  private retryAfter: number;
+  private queues: Record<RequestClass, QueuedTask[]> = { cheap: [], full: [] };
+  private bulk: QueuedTask[] = [];
+  private running = 0;
+  private lastEmpty = Date.now();
+  private completed: Record<RequestClass, number> = { cheap: 0, full: 0 };
+  private shedLatency = 0;
+  private shedQueueFull = 0;
+  private bulkCredit = 0;
+  private bulkCreditPerStart: number;
+  private bulkGrants = 0;
+  private latency: Record<DecodePriority, LatencyHistogram> = {
+    interactive: new LatencyHistogram(),
+    bulk: new LatencyHistogram(),
+  };
+
+  /**
+   * @param options - Admission options
+   */
+  constructor(options: AdmissionOptions = {}) {
+    this.concurrency = options.concurrency ?? 1;
+    this.targetDelay = options.targetDelay ?? 20;
+    this.interval = options.interval ?? 500;
+    this.maxQueue = options.maxQueue ?? 1024;
+    this.maxBulkQueue = options.maxBulkQueue ?? 8192;
+    this.retryAfter = options.retryAfter ?? 1;
+    const share = Math.min(Math.max(options.minBulkShare ?? 0.1, 0), 0.99);
+    this.bulkCreditPerStart = share / (1 - share);
+  }
+
+  /**
+   * Run a task once admitted
+   *
+   * @param requestClass - Cost class of the request
+   * @param task - Work to run
+   * @param priority - Priority of the request (default: interactive)
+   * @returns Task result
+   * @throws OverloadError if the request is shed
+   */
+  run<T>(requestClass: RequestClass, task: () => Promise<T>, priority: DecodePriority = 'interactive'): Promise<T> {
+    const queued = this.queues.cheap.length + this.queues.full.length;
+
+    if (priority === 'bulk' ? this.bulk.length >= this.maxBulkQueue : queued >= this.maxQueue) {
+      this.shedQueueFull++;
+      return Promise.reject(new OverloadError(this.retryAfter, 'queue-full'));
+    }
+
+    if (priority === 'interactive' && requestClass === 'full' && this.isOverloaded()) {
+      const oldest = this.queues.full[0];
+      if (oldest && Date.now() - oldest.enqueuedAt > this.targetDelay) {
+        this.shedLatency++;
+        return Promise.reject(new OverloadError(this.retryAfter, 'latency'));
+      }
+    }
+
+    return new Promise<T>((resolve, reject) => {
+      const entry: QueuedTask = {
+        enqueuedAt: Date.now(),
+        run: () => {
+          task()
+            .then(resolve, reject)
+            .finally(() => {
+              this.running--;
+              this.completed[requestClass]++;
+              this.latency[priority].record(Date.now() - entry.enqueuedAt);
+              this.drain();
+            });
+        },
+        shed: reject,
+      };
+
+      if (priority === 'bulk') {
+        this.bulk.push(entry);
+      } else {
+        if (queued === 0) {
+          this.lastEmpty = Date.now();
+        }
+        this.queues[requestClass].push(entry);
+      }
+      this.drain();
+    });
+  }
+
+  /**
+   * Get admission statistics
+   */
+  getStats(): AdmissionStats {
+    return {
+      running: this.running,
+      queued: { cheap: this.queues.cheap.length, full: this.queues.full.length },
+      queuedBulk: this.bulk.length,
+      completed: { ...this.completed },
+      shedLatency: this.shedLatency,
+      shedQueueFull: this.shedQueueFull,
+      bulkGrants: this.bulkGrants,
+      overloaded: this.isOverloaded(),
+      latency: { interactive: this.latency.interactive.getStats(), bulk: this.latency.bulk.getStats() },
+    };
+  }
+
+  private isOverloaded(): boolean {
+    if (this.queues.cheap.length + this.queues.full.length === 0) {
+      return false;
+    }
+    return Date.now() - this.lastEmpty > this.interval;
+  }
+
+  private drain(): void {
+    while (this.running < this.concurrency) {
+      const interactiveWaiting = this.queues.cheap.length + this.queues.full.length > 0;
+      if (this.bulk.length > 0 && (!interactiveWaiting || this.bulkCredit >= 1)) {
+        if (interactiveWaiting) {
+          this.bulkCredit--;
+          this.bulkGrants++;
+        } else {
+          // Credit only carries bulk through a period of interactive load
+          this.bulkCredit = 0;
+        }
+        this.start(this.bulk.shift()!);
+        continue;
+      }
+
+      const cheap = this.queues.cheap.shift();
+      if (cheap) {
+        this.startInteractive(cheap);
+        continue;
+      }
+
+      const full = this.queues.full.shift();
+      if (!full) {
+        this.lastEmpty = Date.now();
+        return;
+      }
+
+      const limit = this.isOverloaded() ? this.targetDelay : this.interval;
+      if (Date.now() - full.enqueuedAt > limit) {
+        this.shedLatency++;
+        full.shed(new OverloadError(this.retryAfter, 'latency'));
+        continue;
+      }
+
+      this.startInteractive(full);
+    }
+  }
+
+  private startInteractive(task: QueuedTask): void {
+    if (this.bulk.length > 0) {
+      this.bulkCredit += this.bulkCreditPerStart;
+    }
+    this.start(task);
+  }
+
+  private start(task: QueuedTask): void {
+    this.running++;
+    task.run();
+  }
+}
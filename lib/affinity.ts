@@ -0,0 +1,80 @@
+/**
+ * How VINs are grouped for affinity routing
+ *
+ * - `wmi` - positions 1-3, so each node owns whole manufacturers
+ * - `wmi-year` - WMI plus the model year character (position 10), for finer slices
+ */
+export type AffinityMode = 'wmi' | 'wmi-year';
+
+/**
+ * Routing key for a VIN
+ *
+ * @param vin - The VIN
+ * @param mode - Grouping (default: `wmi`)
+ * @returns Key shared by VINs that read the same schemas and patterns
+ */
+export function affinityKey(vin: string, mode: AffinityMode = 'wmi'): string {
+  const clean = vin.toUpperCase().trim();
+  return mode === 'wmi-year' ? `${clean.substring(0, 3)}:${clean.charAt(9)}` : clean.substring(0, 3);
+}
+
+/**
+ * 32-bit FNV-1a followed by a murmur3 finalizer for avalanche
+ */
+function hash32(text: string): number {
+  let h = 0x811c9dc5;
+  for (let i = 0; i < text.length; i++) {
+    h ^= text.charCodeAt(i);
+    h = Math.imul(h, 0x01000193);
+  }
+  h ^= h >>> 16;
+  h = Math.imul(h, 0x85ebca6b);
+  h ^= h >>> 13;
+  h = Math.imul(h, 0xc2b2ae35);
+  h ^= h >>> 16;
+  return h >>> 0;
+}
+
+/**
+ * Order nodes by preference for a key (rendezvous hashing)
+ *
+ * Every caller with the same node list computes the same order, and removing
+ * a node only moves the keys it owned. Use it to route across processes or
+ * hosts exactly as DecoderPool routes across its workers.
+ *
+ * @param key - Routing key (see affinityKey)
+ * @param nodes - Node identifiers
+ * @returns Nodes from most to least preferred
+ */
+export function rankByAffinity<T extends string | number>(key: string, nodes: readonly T[]): T[] {
+  return nodes
+    .map(node => ({ node, score: hash32(`${node}\u0000${key}`) }))
+    .sort((a, b) => b.score - a.score || String(a.node).localeCompare(String(b.node)))
+    .map(({ node }) => node);
+}
+
+/**
+ * Pick the most preferred available node for a key
+ *
+ * The key's owner is chosen whenever it is available; when it is hot, the
+ * request spills over to the next node in the key's preference order, so a
+ * busy key settles on a small, stable set of nodes rather than all of them.
+ *
+ * @param key - Routing key (see affinityKey)
+ * @param nodes - Node identifiers
+ * @param available - Whether a node can take the request now (default: all available)
+ * @returns Chosen node and its rank (0 for the owner), or undefined if none is available
+ */
+export function pickByAffinity<T extends string | number>(
+  key: string,
+  nodes: readonly T[],
+  available: (node: T) => boolean = () => true,
+): { node: T; rank: number } | undefined {
+  const ranked = rankByAffinity(key, nodes);
+  for (let rank = 0; rank < ranked.length; rank++) {
+    if (available(ranked[rank])) {
+      return { node: ranked[rank], rank };
+    }
+  }
+  return undefined;
+}
@@ -1,6 +1,14 @@
 import { decodeVIN, VINDecoder as CoreVINDecoder } from './decode';
 import { BrowserDatabaseAdapterFactory, BrowserDatabaseAdapter } from './db/browser-adapter';
+import type { BrowserAdapterOptions, BrowserLoadProgress } from './db/browser-adapter';
+import type { DatabaseAdapter } from './db/adapter';
 import { CloudflareD1Adapter, createD1Adapter } from './db/d1-adapter';
+import { MatchKernel } from './db/match-kernel';
+import type { MatchKernelOptions, MatchKernelStats } from './db/match-kernel';
+import { PatternOverlay } from './overlay';
+import type { OverlayFile, OverlayPattern } from './overlay';
+import { createDecodeStream, createByteDecodeStream, createNdjsonStream } from './stream';
+import type { DecodeStreamOptions, StreamDecoder } from './stream';
 import { DecodeOptions, DecodeResult } from './types';
 import { createLogger } from './logger';
 
@@ -19,6 +27,11 @@ export interface VINDecoderOptions {
    * Default options for VIN decoding
    */
   defaultOptions?: DecodeOptions;
+
+  /**
+   * Cold-start options (sql.js file location, progress reporting)
+   */
+  loadOptions?: BrowserAdapterOptions;
 }
 
 /**
@@ -28,6 +41,7 @@ export class VINDecoder {
   private adapterFactory: BrowserDatabaseAdapterFactory;
   private databasePath: string;
   private defaultOptions: DecodeOptions;
+  private adapterPromise: Promise<DatabaseAdapter> | null = null;
 
   /**
    * Create a new VIN decoder
@@ -35,13 +49,22 @@ export class VINDecoder {
    * @param options - Configuration options
    */
   constructor(options: VINDecoderOptions) {
-    this.adapterFactory = new BrowserDatabaseAdapterFactory();
+    this.adapterFactory = new BrowserDatabaseAdapterFactory(options.loadOptions);
     this.databasePath = options.databasePath;
     this.defaultOptions = options.defaultOptions || {};
 
     logger.debug({ options }, 'Browser VIN decoder initialized');
   }
 
+  /**
+   * Start loading the database and sql.js ahead of the first decode
+   *
+   * @returns Resolves once the database is ready
+   */
+  async preload(): Promise<void> {
+    await this.getAdapter();
+  }
+
   /**
    * Decode a VIN
    *
@@ -53,8 +76,8 @@ export class VINDecoder {
     logger.debug({ vin }, 'Decoding VIN');
 
     try {
-      // Create adapter for this decode operation
-      const adapter = await this.adapterFactory.createAdapter(this.databasePath);
+      // The database is loaded once and reused across decodes
+      const adapter = await this.getAdapter();
 
       // Merge default options with provided options
       const mergedOptions = {
@@ -63,23 +86,49 @@ export class VINDecoder {
       };
 
       // Decode VIN
-      const result = await decodeVIN(vin, adapter, mergedOptions);
-
-      // Close the adapter
-      await adapter.close();
-
-      return result;
+      return await decodeVIN(vin, adapter, mergedOptions);
     } catch (error) {
       logger.error({ vin, error }, 'VIN decoding failed');
       throw error;
     }
   }
+
+  /**
+   * Release the loaded database
+   */
+  async close(): Promise<void> {
+    const adapterPromise = this.adapterPromise;
+    this.adapterPromise = null;
+    if (adapterPromise) {
+      await (await adapterPromise).close();
+    }
+  }
+
+  /**
+   * Get the shared adapter, creating it on first use
+   */
+  private getAdapter(): Promise<DatabaseAdapter> {
+    if (!this.adapterPromise) {
+      this.adapterPromise = this.adapterFactory.createAdapter(this.databasePath);
+      this.adapterPromise.catch(() => {
+        this.adapterPromise = null;
+      });
+    }
+    return this.adapterPromise;
+  }
 }
 
 // Export core functionality
 export { CoreVINDecoder, decodeVIN };
-export { BrowserDatabaseAdapter };
+export { BrowserDatabaseAdapter, BrowserDatabaseAdapterFactory };
+export type { BrowserAdapterOptions, BrowserLoadProgress };
 export { CloudflareD1Adapter, createD1Adapter };
+export { MatchKernel };
+export type { MatchKernelOptions, MatchKernelStats };
+export { PatternOverlay };
+export type { OverlayFile, OverlayPattern };
+export { createDecodeStream, createByteDecodeStream, createNdjsonStream };
+export type { DecodeStreamOptions, StreamDecoder };
 export * from './types';
 
 // Explicitly export the default adapter for browser environments
@@ -0,0 +1,25 @@
+import { parentPort, workerData } from 'worker_threads';
+import { createDecoder } from './index';
+import { decodeShard, emptyLocality } from './bulk';
+import type { BulkShardTask, BulkWorkerResponse } from './bulk';
+
+/**
+ * Worker thread entry for bulkDecode
+ *
+ * Each worker owns its own decoder and database connection, and reads,
+ * decodes and writes one shard at a time without going through the main
+ * thread.
+ */
+const decoderPromise = createDecoder({ databasePath: workerData?.databasePath, searchIndex: false });
+
+parentPort?.on('message', async (task: BulkShardTask) => {
+  let response: BulkWorkerResponse;
+  try {
+    const locality = emptyLocality();
+    const lines = await decodeShard(await decoderPromise, task, locality);
+    response = { index: task.index, lines, locality };
+  } catch (error) {
+    response = { index: task.index, error: error instanceof Error ? error.message : String(error) };
+  }
+  parentPort!.postMessage(response);
+});
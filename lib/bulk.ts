@@ -0,0 +1,444 @@
+import { Worker } from 'worker_threads';
+import { cpus } from 'os';
+import { createReadStream, createWriteStream, existsSync, promises as fs } from 'fs';
+import { createInterface } from 'readline';
+import { once } from 'events';
+import { resolveWorkerScript } from './pool';
+import { getDatabasePath } from './db/utils';
+import type { BatchDecodeOptions, BatchLocalityStats, DecodeResult } from './types';
+import { createLogger } from './logger';
+
+const logger = createLogger('BulkDecode');
+
+/** Bytes read at a time when searching for a line boundary */
+const ALIGN_CHUNK = 64 * 1024;
+
+/**
+ * A line-aligned byte range of the input file
+ */
+export interface BulkShard {
+  index: number;
+  /** First byte (start of a line) */
+  start: number;
+  /** End byte, exclusive (start of the next shard's first line) */
+  end: number;
+}
+
+/**
+ * Work sent to whichever decoder handles a shard
+ */
+export interface BulkShardTask extends BulkShard {
+  inputPath: string;
+  segmentPath: string;
+  options: BatchDecodeOptions;
+}
+
+/**
+ * Checkpoint manifest written next to the output
+ */
+export interface BulkManifest {
+  /** Format version */
+  version: 1;
+
+  /** Identifies the input and options the shards were planned for */
+  input: { path: string; size: number; mtimeMs: number };
+  shardSize: number;
+  options: BatchDecodeOptions;
+
+  shards: Array<BulkShard & { done: boolean; lines: number; locality?: BatchLocalityStats }>;
+}
+
+/**
+ * Decoder used for shards on the main thread
+ */
+export interface BulkDecoder {
+  decodeStream(
+    vins: AsyncIterable<string>,
+    options?: BatchDecodeOptions,
+    stats?: BatchLocalityStats,
+  ): AsyncIterable<DecodeResult>;
+}
+
+/**
+ * Options for a bulk decode
+ */
+export interface BulkDecodeOptions {
+  /** Database path passed to each worker (default: resolved once with getDatabasePath) */
+  databasePath?: string;
+
+  /** Worker threads (default: CPU count - 1); 0 decodes shards one at a time with `decoder` */
+  workers?: number;
+
+  /** Decoder used when `workers` is 0 */
+  decoder?: BulkDecoder;
+
+  /** Target shard size in bytes (default: 64MB) */
+  shardSize?: number;
+
+  /** Options for every decode */
+  decodeOptions?: BatchDecodeOptions;
+
+  /** Worker entry script (default: the bundled bulk-worker next to this module) */
+  workerScript?: string;
+
+  /** Called after each shard completes */
+  onShard?: (shard: BulkShard, completed: number, total: number) => void;
+}
+
+/**
+ * Summary of a finished bulk decode
+ */
+export interface BulkDecodeSummary {
+  shards: number;
+  /** Shards skipped because an earlier run had completed them */
+  resumed: number;
+  /** VINs decoded (including resumed shards) */
+  lines: number;
+  /** Pattern set locality of the decode order and cache lookups, summed over shards */
+  locality: BatchLocalityStats;
+  /** Pattern set locality: share of VINs decoded right after a VIN with the same WMI and model year */
+  localityRate: number;
+  /** The same share had the VINs been decoded in input order */
+  inputOrderLocalityRate: number;
+  /** Share of pattern set lookups answered from a cache (query cache, hot index or shared cache) */
+  cacheHitRate: number;
+}
+
+/**
+ * Message returned by a bulk worker
+ */
+export type BulkWorkerResponse =
+  | { index: number; lines: number; locality: BatchLocalityStats }
+  | { index: number; error: string };
+
+/**
+ * Move an offset forward to the start of the next line
+ */
+async function alignToLine(file: fs.FileHandle, offset: number, size: number): Promise<number> {
+  if (offset <= 0) return 0;
+
+  const buffer = Buffer.alloc(ALIGN_CHUNK);
+  // Start one byte early so an offset already at a line start stays put
+  let position = offset - 1;
+  while (position < size) {
+    const { bytesRead } = await file.read(buffer, 0, ALIGN_CHUNK, position);
+    const newline = buffer.subarray(0, bytesRead).indexOf(0x0a);
+    if (newline !== -1) {
+      return position + newline + 1;
+    }
+    position += bytesRead;
+  }
+  return size;
+}
+
+/**
+ * Split a file into byte ranges that start and end on line boundaries
+ *
+ * @param inputPath - Input file (one VIN per line, or CSV with the VIN first)
+ * @param shardSize - Target shard size in bytes
+ * @returns Shards in file order
+ */
+export async function planShards(inputPath: string, shardSize: number): Promise<BulkShard[]> {
+  const file = await fs.open(inputPath, 'r');
+  try {
+    const { size } = await file.stat();
+    const starts = [0];
+    for (let offset = shardSize; offset < size; offset += shardSize) {
+      const start = await alignToLine(file, Math.max(offset, starts[starts.length - 1] + 1), size);
+      if (start < size && start > starts[starts.length - 1]) {
+        starts.push(start);
+      }
+    }
+
+    return starts
+      .map((start, index) => ({ index, start, end: starts[index + 1] ?? size }))
+      .filter(shard => shard.end > shard.start);
+  } finally {
+    await file.close();
+  }
+}
+
+/**
+ * Read the VINs of one shard
+ */
+async function* readShard(task: BulkShardTask): AsyncGenerator<string> {
+  const lines = createInterface({
+    input: createReadStream(task.inputPath, { start: task.start, end: task.end - 1 }),
+    crlfDelay: Infinity,
+  });
+  for await (const line of lines) {
+    const vin = line.split(',')[0].trim().toUpperCase();
+    if (vin) yield vin;
+  }
+}
+
+/**
+ * Decode one shard into its segment file, one JSON result per line
+ *
+ * @param decoder - Decoder for this shard
+ * @param task - Shard to decode
+ * @param stats - Locality counters to add the shard's decodes to
+ * @returns Number of VINs decoded
+ */
+export async function decodeShard(
+  decoder: BulkDecoder,
+  task: BulkShardTask,
+  stats?: BatchLocalityStats,
+): Promise<number> {
+  const out = createWriteStream(task.segmentPath);
+  let lines = 0;
+  try {
+    for await (const result of decoder.decodeStream(readShard(task), task.options, stats)) {
+      if (!out.write(JSON.stringify(result) + '\n')) {
+        await once(out, 'drain');
+      }
+      lines++;
+    }
+  } finally {
+    out.end();
+    await once(out, 'close');
+  }
+  return lines;
+}
+
+/**
+ * Zeroed locality counters
+ */
+export function emptyLocality(): BatchLocalityStats {
+  return { decoded: 0, hits: 0, inputOrderHits: 0, cacheHits: 0, cacheMisses: 0 };
+}
+
+function segmentPath(outputPath: string, index: number): string {
+  return `${outputPath}.shard-${String(index).padStart(5, '0')}`;
+}
+
+function manifestPath(outputPath: string): string {
+  return `${outputPath}.manifest.json`;
+}
+
+/**
+ * Write the manifest so a crash never leaves a partial file behind
+ */
+async function saveManifest(outputPath: string, manifest: BulkManifest): Promise<void> {
+  const path = manifestPath(outputPath);
+  await fs.writeFile(`${path}.tmp`, JSON.stringify(manifest, null, 2));
+  await fs.rename(`${path}.tmp`, path);
+}
+
+/**
+ * Load a manifest from an interrupted run of the same job, if any
+ */
+async function loadManifest(
+  outputPath: string,
+  input: BulkManifest['input'],
+  shardSize: number,
+  options: BatchDecodeOptions,
+): Promise<BulkManifest | null> {
+  try {
+    const manifest: BulkManifest = JSON.parse(await fs.readFile(manifestPath(outputPath), 'utf-8'));
+    const sameJob =
+      manifest.version === 1 &&
+      JSON.stringify(manifest.input) === JSON.stringify(input) &&
+      manifest.shardSize === shardSize &&
+      JSON.stringify(manifest.options) === JSON.stringify(options);
+    return sameJob ? manifest : null;
+  } catch {
+    return null;
+  }
+}
+
+/**
+ * Run shards on worker threads, each reading and writing its own byte range
+ */
+function runOnWorkers(
+  tasks: BulkShardTask[],
+  workerCount: number,
+  workerScript: string,
+  databasePath: string | undefined,
+  onDone: (index: number, lines: number, locality: BatchLocalityStats) => Promise<void>,
+): Promise<void> {
+  return new Promise((resolve, reject) => {
+    const queue = [...tasks];
+    const workers: Worker[] = [];
+    let running = 0;
+    let failure: Error | null = null;
+    let finished = false;
+
+    const finish = () => {
+      if (finished) return;
+      finished = true;
+      Promise.all(workers.map(worker => worker.terminate())).then(() =>
+        failure ? reject(failure) : resolve(),
+      );
+    };
+
+    if (tasks.length === 0) {
+      finish();
+      return;
+    }
+
+    const next = (worker: Worker) => {
+      const task = failure ? undefined : queue.shift();
+      if (!task) {
+        if (running === 0) finish();
+        return;
+      }
+      running++;
+      worker.postMessage(task);
+    };
+
+    for (let i = 0; i < Math.min(workerCount, tasks.length); i++) {
+      const worker = new Worker(workerScript, { workerData: { databasePath } });
+      workers.push(worker);
+
+      worker.on('message', (response: BulkWorkerResponse) => {
+        const done = 'error' in response
+          ? Promise.reject(new Error(`Shard ${response.index} failed: ${response.error}`))
+          : onDone(response.index, response.lines, response.locality);
+        done
+          .catch(error => {
+            failure ??= error;
+          })
+          .finally(() => {
+            running--;
+            next(worker);
+          });
+      });
+      worker.on('error', error => {
+        failure ??= error;
+        running--;
+        if (running === 0) finish();
+      });
+
+      next(worker);
+    }
+  });
+}
+
+/**
+ * Decode a large VIN file in parallel by line-aligned byte ranges
+ *
+ * The input is split into shards that each worker reads, decodes and writes
+ * to its own segment file, so no single reader thread bounds throughput.
+ * Segments are concatenated in input order into `outputPath` (one JSON
+ * result per line). Completed shards are recorded in a checkpoint manifest
+ * next to the output, and re-running the same job resumes after the last
+ * completed shards instead of starting over.
+ *
+ * @param inputPath - Input file (one VIN per line, or CSV with the VIN first)
+ * @param outputPath - Output JSON Lines file
+ * @param options - Bulk decode options
+ * @returns Summary of the run
+ */
+export async function bulkDecode(
+  inputPath: string,
+  outputPath: string,
+  options: BulkDecodeOptions = {},
+): Promise<BulkDecodeSummary> {
+  const workerCount = options.workers ?? Math.max(1, cpus().length - 1);
+  if (workerCount === 0 && !options.decoder) {
+    throw new Error('A decoder is required when workers is 0');
+  }
+
+  const shardSize = options.shardSize ?? 64 * 1024 * 1024;
+  const decodeOptions = options.decodeOptions ?? {};
+  const stat = await fs.stat(inputPath);
+  const input = { path: inputPath, size: stat.size, mtimeMs: stat.mtimeMs };
+
+  let manifest = await loadManifest(outputPath, input, shardSize, decodeOptions);
+  const resumed = manifest?.shards.filter(
+    shard => shard.done && existsSync(segmentPath(outputPath, shard.index)),
+  ).length ?? 0;
+
+  if (!manifest) {
+    const shards = await planShards(inputPath, shardSize);
+    manifest = {
+      version: 1,
+      input,
+      shardSize,
+      options: decodeOptions,
+      shards: shards.map(shard => ({ ...shard, done: false, lines: 0 })),
+    };
+    await saveManifest(outputPath, manifest);
+  }
+
+  const state = manifest;
+  const pending = state.shards.filter(
+    shard => !shard.done || !existsSync(segmentPath(outputPath, shard.index)),
+  );
+  let completed = state.shards.length - pending.length;
+  logger.debug({ shards: state.shards.length, resumed, pending: pending.length }, 'Starting bulk decode');
+
+  // Manifest writes are serialized so concurrent completions never interleave
+  let saving = Promise.resolve();
+  const onDone = (index: number, lines: number, locality: BatchLocalityStats): Promise<void> => {
+    const shard = state.shards[index];
+    shard.done = true;
+    shard.lines = lines;
+    shard.locality = locality;
+    completed++;
+    options.onShard?.(shard, completed, state.shards.length);
+    saving = saving.then(() => saveManifest(outputPath, state));
+    return saving;
+  };
+
+  const tasks: BulkShardTask[] = pending.map(shard => ({
+    index: shard.index,
+    start: shard.start,
+    end: shard.end,
+    inputPath,
+    segmentPath: segmentPath(outputPath, shard.index),
+    options: decodeOptions,
+  }));
+
+  if (workerCount === 0) {
+    for (const task of tasks) {
+      const locality = emptyLocality();
+      await onDone(task.index, await decodeShard(options.decoder!, task, locality), locality);
+    }
+  } else {
+    // Resolve (and update) the database once, rather than in every worker
+    await runOnWorkers(
+      tasks,
+      workerCount,
+      options.workerScript ?? resolveWorkerScript('bulk-worker'),
+      options.databasePath ?? (await getDatabasePath()),
+      onDone,
+    );
+  }
+
+  // Concatenate segments in input order, then drop the checkpoint
+  const out = createWriteStream(outputPath);
+  for (const shard of state.shards) {
+    for await (const chunk of createReadStream(segmentPath(outputPath, shard.index))) {
+      if (!out.write(chunk)) {
+        await once(out, 'drain');
+      }
+    }
+  }
+  out.end();
+  await once(out, 'close');
+
+  await Promise.all(state.shards.map(shard => fs.rm(segmentPath(outputPath, shard.index), { force: true })));
+  await fs.rm(manifestPath(outputPath), { force: true });
+
+  const locality = emptyLocality();
+  for (const shard of state.shards) {
+    locality.decoded += shard.locality?.decoded ?? 0;
+    locality.hits += shard.locality?.hits ?? 0;
+    locality.inputOrderHits += shard.locality?.inputOrderHits ?? 0;
+    locality.cacheHits += shard.locality?.cacheHits ?? 0;
+    locality.cacheMisses += shard.locality?.cacheMisses ?? 0;
+  }
+  const lookups = locality.cacheHits + locality.cacheMisses;
+
+  return {
+    shards: state.shards.length,
+    resumed,
+    lines: state.shards.reduce((total, shard) => total + shard.lines, 0),
+    locality,
+    localityRate: locality.decoded > 0 ? locality.hits / locality.decoded : 0,
+    inputOrderLocalityRate: locality.decoded > 0 ? locality.inputOrderHits / locality.decoded : 0,
+    cacheHitRate: lookups > 0 ? locality.cacheHits / lookups : 0,
+  };
+}
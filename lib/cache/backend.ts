@@ -0,0 +1,225 @@
+import { createLogger } from '../logger';
+
+const logger = createLogger('TieredCache');
+
+/**
+ * Common interface for shared (second-level) cache stores
+ */
+export interface CacheBackend {
+  /**
+   * Get a value
+   *
+   * @param key - Cache key
+   * @returns Stored value, or null if missing
+   */
+  get(key: string): Promise<string | null>;
+
+  /**
+   * Get several values in one round trip
+   *
+   * @param keys - Cache keys
+   * @returns Stored values in key order, null for missing keys
+   */
+  mget(keys: string[]): Promise<Array<string | null>>;
+
+  /**
+   * Store a value
+   *
+   * @param key - Cache key
+   * @param value - Value to store
+   * @param ttlSeconds - Optional expiry
+   */
+  set(key: string, value: string, ttlSeconds?: number): Promise<void>;
+
+  /**
+   * Release connections
+   */
+  close(): Promise<void>;
+}
+
+/**
+ * Options for a tiered cache
+ */
+export interface TieredCacheOptions {
+  /** Database version; keys from different versions never collide */
+  dbVersion: string;
+
+  /** Key prefix (default: 'corgi') */
+  prefix?: string;
+
+  /** Maximum entries kept in the in-process L1 (default: 10000) */
+  maxEntries?: number;
+
+  /** Expiry for entries written to the backend, in seconds (default: none) */
+  ttlSeconds?: number;
+}
+
+/**
+ * Counters describing where cached values came from
+ */
+export interface TieredCacheStats {
+  l1Hits: number;
+  l2Hits: number;
+  misses: number;
+  l2Errors: number;
+}
+
+/**
+ * In-process LRU (L1) in front of a shared CacheBackend (L2)
+ *
+ * Values are JSON-serialized for the backend. Backend failures are logged and
+ * treated as misses so a cache outage never fails a decode. Writes reach L2 in
+ * the background; `flush()` waits for them.
+ *
+ * L1 keeps its own copy of each value set, but values returned by `get` are
+ * shared with L1 and must not be mutated.
+ */
+export class TieredCache {
+  private l1 = new Map<string, unknown>();
+  private namespace: string;
+  private maxEntries: number;
+  private ttlSeconds?: number;
+  private stats: TieredCacheStats = { l1Hits: 0, l2Hits: 0, misses: 0, l2Errors: 0 };
+  private pending = new Set<Promise<void>>();
+
+  /**
+   * @param backend - Shared cache store
+   * @param options - Namespacing and sizing options
+   */
+  constructor(
+    private backend: CacheBackend,
+    options: TieredCacheOptions,
+  ) {
+    if (!options?.dbVersion) {
+      throw new Error('TieredCache requires a dbVersion');
+    }
+    this.namespace = `${options.prefix ?? 'corgi'}:${options.dbVersion}:`;
+    this.maxEntries = options.maxEntries ?? 10000;
+    this.ttlSeconds = options.ttlSeconds;
+  }
+
+  /**
+   * Get a value from L1, then L2
+   *
+   * @param key - Key within the namespace
+   * @returns Cached value or undefined
+   */
+  async get<T>(key: string): Promise<T | undefined> {
+    const [value] = await this.getMany<T>([key]);
+    return value;
+  }
+
+  /**
+   * Get several values, fetching all L1 misses from L2 in one round trip
+   *
+   * @param keys - Keys within the namespace
+   * @returns Cached values in key order, undefined for misses
+   */
+  async getMany<T>(keys: string[]): Promise<Array<T | undefined>> {
+    const values: Array<T | undefined> = new Array(keys.length);
+    const missing: number[] = [];
+
+    keys.forEach((key, i) => {
+      if (this.l1.has(key)) {
+        values[i] = this.touch(key) as T;
+        this.stats.l1Hits++;
+      } else {
+        missing.push(i);
+      }
+    });
+
+    if (missing.length === 0) {
+      return values;
+    }
+
+    let stored: Array<string | null> = [];
+    try {
+      stored = await this.backend.mget(missing.map(i => this.namespace + keys[i]));
+    } catch (error) {
+      this.stats.l2Errors++;
+      logger.warn({ error }, 'Cache backend read failed');
+    }
+
+    missing.forEach((keyIndex, i) => {
+      const raw = stored[i];
+      if (raw === null || raw === undefined) {
+        this.stats.misses++;
+        return;
+      }
+      try {
+        const value = JSON.parse(raw) as T;
+        this.remember(keys[keyIndex], value);
+        values[keyIndex] = value;
+        this.stats.l2Hits++;
+      } catch {
+        this.stats.misses++;
+      }
+    });
+
+    return values;
+  }
+
+  /**
+   * Store a copy of a value in L1 and start writing it through to L2
+   *
+   * @param key - Key within the namespace
+   * @param value - JSON-serializable value
+   */
+  set(key: string, value: unknown): void {
+    const json = JSON.stringify(value);
+    this.remember(key, JSON.parse(json));
+
+    const write = this.backend
+      .set(this.namespace + key, json, this.ttlSeconds)
+      .catch(error => {
+        this.stats.l2Errors++;
+        logger.warn({ error, key }, 'Cache backend write failed');
+      })
+      .finally(() => this.pending.delete(write));
+    this.pending.add(write);
+  }
+
+  /**
+   * Wait for background writes to L2
+   */
+  async flush(): Promise<void> {
+    await Promise.all([...this.pending]);
+  }
+
+  /**
+   * Get cache statistics
+   */
+  getStats(): TieredCacheStats {
+    return { ...this.stats };
+  }
+
+  /**
+   * Clear the in-process L1 (the shared L2 is left untouched)
+   */
+  clear(): void {
+    this.l1.clear();
+  }
+
+  /**
+   * Finish background writes and close the backend
+   */
+  async close(): Promise<void> {
+    await this.flush();
+    await this.backend.close();
+  }
+
+  private touch(key: string): unknown {
+    const value = this.l1.get(key);
+    this.l1.delete(key);
+    this.l1.set(key, value);
+    return value;
+  }
+
+  private remember(key: string, value: unknown): void {
+    this.l1.delete(key);
+    this.l1.set(key, value);
+    if (this.l1.size > this.maxEntries) {
+      this.l1.delete(this.l1.keys().next().value as string);
+    }
+  }
+}
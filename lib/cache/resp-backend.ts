@@ -0,0 +1,262 @@
+import { connect, Socket } from 'net';
+import type { CacheBackend } from './backend';
+import { createLogger } from '../logger';
+
+const logger = createLogger('RespCacheBackend');
+
+/**
+ * Value decoded from a RESP reply
+ */
+export type RespValue = string | number | null | Error | RespValue[];
+
+/**
+ * Options for the RESP cache backend
+ */
+export interface RespCacheOptions {
+  /** Server URL, e.g. redis://:password@host:6379/0 (default: redis://127.0.0.1:6379) */
+  url?: string;
+
+  /** Connect and command timeout in milliseconds (default: 2000) */
+  timeout?: number;
+}
+
+/**
+ * Encode a command as a RESP array of bulk strings
+ *
+ * @param args - Command name and arguments
+ * @returns Encoded command
+ */
+export function encodeRespCommand(args: Array<string | number>): Buffer {
+  const parts: Buffer[] = [Buffer.from(`*${args.length}\r\n`)];
+  for (const arg of args) {
+    const value = Buffer.from(String(arg));
+    parts.push(Buffer.from(`$${value.length}\r\n`), value, Buffer.from('\r\n'));
+  }
+  return Buffer.concat(parts);
+}
+
+/**
+ * Incremental RESP2 reply parser
+ */
+export class RespParser {
+  private buffer = Buffer.alloc(0);
+
+  /**
+   * Append received bytes and return every complete value
+   *
+   * @param chunk - Bytes received from the socket
+   * @returns Complete values, in order
+   */
+  push(chunk: Buffer): RespValue[] {
+    this.buffer = this.buffer.length === 0 ? chunk : Buffer.concat([this.buffer, chunk]);
+
+    const values: RespValue[] = [];
+    let offset = 0;
+    for (;;) {
+      const parsed = this.parse(offset);
+      if (!parsed) break;
+      values.push(parsed.value);
+      offset = parsed.end;
+    }
+
+    this.buffer = this.buffer.subarray(offset);
+    return values;
+  }
+
+  private parse(offset: number): { value: RespValue; end: number } | undefined {
+    const lineEnd = this.buffer.indexOf('\r\n', offset);
+    if (lineEnd === -1) {
+      return undefined;
+    }
+
+    const type = String.fromCharCode(this.buffer[offset]);
+    const line = this.buffer.toString('utf8', offset + 1, lineEnd);
+    const next = lineEnd + 2;
+
+    switch (type) {
+      case '+':
+        return { value: line, end: next };
+      case '-':
+        return { value: new Error(line), end: next };
+      case ':':
+        return { value: Number(line), end: next };
+      case '$': {
+        const length = Number(line);
+        if (length < 0) {
+          return { value: null, end: next };
+        }
+        if (this.buffer.length < next + length + 2) {
+          return undefined;
+        }
+        return { value: this.buffer.toString('utf8', next, next + length), end: next + length + 2 };
+      }
+      case '*': {
+        const count = Number(line);
+        if (count < 0) {
+          return { value: null, end: next };
+        }
+        const items: RespValue[] = [];
+        let end = next;
+        for (let i = 0; i < count; i++) {
+          const item = this.parse(end);
+          if (!item) return undefined;
+          items.push(item.value);
+          end = item.end;
+        }
+        return { value: items, end };
+      }
+      default:
+        throw new Error(`Invalid RESP type byte: ${type}`);
+    }
+  }
+}
+
+interface PendingReply {
+  resolve: (value: RespValue) => void;
+  reject: (error: Error) => void;
+}
+
+/**
+ * Cache backend speaking the Redis protocol (RESP2) over a single pipelined connection
+ *
+ * Works with Redis, Valkey, KeyDB, Dragonfly and other RESP-compatible
+ * servers. The connection is opened lazily and re-opened after failures.
+ */
+export class RespCacheBackend implements CacheBackend {
+  private host: string;
+  private port: number;
+  private password?: string;
+  private username?: string;
+  private database: number;
+  private timeout: number;
+  private socket: Socket | null = null;
+  private connecting: Promise<Socket> | null = null;
+  private pending: PendingReply[] = [];
+
+  /**
+   * @param options - Connection options
+   */
+  constructor(options: RespCacheOptions = {}) {
+    const url = new URL(options.url ?? 'redis://127.0.0.1:6379');
+    this.host = url.hostname || '127.0.0.1';
+    this.port = Number(url.port || 6379);
+    this.username = url.username ? decodeURIComponent(url.username) : undefined;
+    this.password = url.password ? decodeURIComponent(url.password) : undefined;
+    this.database = Number(url.pathname.slice(1) || 0);
+    this.timeout = options.timeout ?? 2000;
+  }
+
+  async get(key: string): Promise<string | null> {
+    return (await this.command(['GET', key])) as string | null;
+  }
+
+  async mget(keys: string[]): Promise<Array<string | null>> {
+    if (keys.length === 0) {
+      return [];
+    }
+    return (await this.command(['MGET', ...keys])) as Array<string | null>;
+  }
+
+  async set(key: string, value: string, ttlSeconds?: number): Promise<void> {
+    const args = ttlSeconds ? ['SET', key, value, 'EX', ttlSeconds] : ['SET', key, value];
+    await this.command(args);
+  }
+
+  async close(): Promise<void> {
+    const socket = this.socket;
+    this.socket = null;
+    this.connecting = null;
+    if (socket) {
+      await new Promise<void>(resolve => socket.end(resolve));
+    }
+  }
+
+  /**
+   * Send a command and wait for its reply
+   *
+   * @param args - Command name and arguments
+   * @returns Decoded reply
+   */
+  async command(args: Array<string | number>): Promise<RespValue> {
+    const socket = await this.getSocket();
+    return this.send(socket, args);
+  }
+
+  private send(socket: Socket, args: Array<string | number>): Promise<RespValue> {
+    return new Promise((resolve, reject) => {
+      this.pending.push({
+        resolve: value => (value instanceof Error ? reject(value) : resolve(value)),
+        reject,
+      });
+      socket.write(encodeRespCommand(args));
+    });
+  }
+
+  private getSocket(): Promise<Socket> {
+    if (this.socket) {
+      return Promise.resolve(this.socket);
+    }
+    if (!this.connecting) {
+      this.connecting = this.connect().catch(error => {
+        this.connecting = null;
+        throw error;
+      });
+    }
+    return this.connecting;
+  }
+
+  private async connect(): Promise<Socket> {
+    const socket = await new Promise<Socket>((resolve, reject) => {
+      const s = connect({ host: this.host, port: this.port });
+      s.setNoDelay(true);
+      s.setTimeout(this.timeout);
+      s.once('connect', () => resolve(s));
+      s.once('error', reject);
+      s.once('timeout', () => reject(new Error(`Cache connection timed out: ${this.host}:${this.port}`)));
+    });
+
+    const parser = new RespParser();
+    socket.removeAllListeners('error');
+    socket.removeAllListeners('timeout');
+    socket.on('data', chunk => {
+      try {
+        for (const value of parser.push(chunk)) {
+          this.pending.shift()?.resolve(value);
+        }
+      } catch (error) {
+        socket.destroy(error as Error);
+      }
+    });
+    socket.on('timeout', () => {
+      if (this.pending.length > 0) {
+        socket.destroy(new Error('Cache command timed out'));
+      }
+    });
+    socket.on('error', error => this.fail(socket, error));
+    socket.on('close', () => this.fail(socket, new Error('Cache connection closed')));
+
+    if (this.password) {
+      const auth = this.username ? ['AUTH', this.username, this.password] : ['AUTH', this.password];
+      await this.send(socket, auth);
+    }
+    if (this.database) {
+      await this.send(socket, ['SELECT', this.database]);
+    }
+
+    logger.debug({ host: this.host, port: this.port }, 'Cache backend connected');
+    this.socket = socket;
+    return socket;
+  }
+
+  private fail(socket: Socket, error: Error): void {
+    if (this.socket === socket) {
+      this.socket = null;
+      this.connecting = null;
+    }
+    const pending = this.pending;
+    this.pending = [];
+    for (const reply of pending) {
+      reply.reject(error);
+    }
+  }
+}
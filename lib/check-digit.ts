@@ -0,0 +1,75 @@
+import type { CheckDigitResult } from './types';
+
+/** Check digit value of each character (49 CFR 565.15(c)), by char code; -1 when invalid */
+const TRANSLITERATION = (() => {
+  const values = new Int8Array(128).fill(-1);
+  const letters = 'ABCDEFGHJKLMNPRSTUVWXYZ';
+  const letterValues = [1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 7, 9, 2, 3, 4, 5, 6, 7, 8, 9];
+  for (let digit = 0; digit <= 9; digit++) {
+    values[48 + digit] = digit;
+  }
+  letterValues.forEach((value, i) => {
+    values[letters.charCodeAt(i)] = value;
+    values[letters.charCodeAt(i) + 32] = value;
+  });
+  return values;
+})();
+
+/** Check digit weights by position */
+const WEIGHTS = [8, 7, 6, 5, 4, 3, 2, 10, 0, 9, 8, 7, 6, 5, 4, 3, 2];
+
+/**
+ * Check digit sum of a VIN: each character's value times its position's
+ * weight, or -1 if the VIN is not 17 valid VIN characters (either case)
+ *
+ * @param vin - VIN to sum
+ * @returns Weighted sum, or -1
+ */
+export function checkDigitSum(vin: string): number {
+  if (vin.length !== 17) {
+    return -1;
+  }
+  let sum = 0;
+  for (let i = 0; i < 17; i++) {
+    const code = vin.charCodeAt(i);
+    const value = code < 128 ? TRANSLITERATION[code] : -1;
+    if (value === -1) {
+      return -1;
+    }
+    sum += value * WEIGHTS[i];
+  }
+  return sum;
+}
+
+/**
+ * Whether position 9 of a VIN holds the check digit for a sum from `checkDigitSum`
+ *
+ * @param vin - VIN the sum was computed for
+ * @param sum - Weighted sum (not -1)
+ */
+export function checkDigitMatches(vin: string, sum: number): boolean {
+  const remainder = sum % 11;
+  const actual = vin.charCodeAt(8);
+  return remainder === 10 ? actual === 88 || actual === 120 : actual === 48 + remainder;
+}
+
+/**
+ * Validate the check digit in a VIN (position 9)
+ *
+ * The decoder and the similarity join both use this, so they always agree on
+ * which VINs have a valid check digit.
+ *
+ * @param vin - Complete VIN (upper or lower case)
+ * @returns Check digit validation result; `expected` is unset when the VIN has
+ *   the wrong length or characters no VIN can hold
+ */
+export function validateCheckDigit(vin: string): CheckDigitResult {
+  const sum = checkDigitSum(vin);
+  const actual = (vin[8] ?? '').toUpperCase();
+  if (sum === -1) {
+    return { position: 9, actual, isValid: false };
+  }
+  const remainder = sum % 11;
+  const expected = remainder === 10 ? 'X' : String(remainder);
+  return { position: 9, actual, expected, isValid: actual === expected };
+}
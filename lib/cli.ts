@@ -1,7 +1,21 @@
 #!/usr/bin/env node
 
 import { Command } from 'commander';
-import { createDecoder, DecodeOptions, DecodeResult, PatternMatch } from './index';
+import { readFileSync, writeFileSync } from 'fs';
+import {
+  bulkDecode,
+  buildDiffManifest,
+  createDecoder,
+  createDecodeServer,
+  DecoderPool,
+  DualDecoder,
+  extractWMI,
+  getDatabasePath,
+  NodeDatabaseAdapterFactory,
+  DecodeOptions,
+  DecodeResult,
+  PatternMatch,
+} from './index';
 import { createLogger } from './logger';
 import { version } from 'process';
 
@@ -57,6 +71,7 @@ program
         databasePath: options.database,
         // forceFresh: true,
         defaultOptions: decodeOptions,
+        searchIndex: false,
       });
 
       // Decode VIN
@@ -87,6 +102,160 @@ program
     }
   });
 
+// Serve command
+program
+  .command('serve')
+  .description('Serve VIN decoding over HTTP with a worker pool and load shedding')
+  .option('-d, --database <path>', 'Path to the VPIC database file')
+  .option('-p, --port <port>', 'Port to listen on', '8080')
+  .option('-H, --host <host>', 'Host to bind', '0.0.0.0')
+  .option('-w, --workers <count>', 'Worker threads (0 decodes on the main thread)')
+  .option('--target-delay <ms>', 'Queueing delay allowed under sustained load', '20')
+  .option('--interval <ms>', 'Window before a queue counts as standing', '500')
+  .option('--max-queue <count>', 'Maximum queued requests', '1024')
+  .option('--min-bulk-share <share>', 'Share of decodes bulk requests get under interactive load', '0.1')
+  .option('--affinity <mode>', 'Route VINs to workers by wmi, wmi-year or none', 'wmi')
+  .option('--affinity-queue-depth <count>', 'Decodes that may wait for a busy key owner before spilling', '2')
+  .option('--affinity-max-wait <ms>', 'Longest a decode waits for a busy key owner before spilling', '10')
+  .option('-v, --verbose', 'Enable verbose logging')
+  .action(async options => {
+    process.env.LOG_LEVEL = options.verbose ? 'debug' : 'info';
+
+    try {
+      const workers = options.workers !== undefined ? Number(options.workers) : undefined;
+      const databasePath = await getDatabasePath({ databasePath: options.database });
+      const pool = new DecoderPool({
+        databasePath,
+        workers,
+        decoder: workers === 0 ? await createDecoder({ databasePath, searchIndex: false }) : undefined,
+        targetDelay: Number(options.targetDelay),
+        interval: Number(options.interval),
+        maxQueue: Number(options.maxQueue),
+        minBulkShare: Number(options.minBulkShare),
+        affinity: options.affinity === 'none' ? false : options.affinity,
+        affinityQueueDepth: Number(options.affinityQueueDepth),
+        affinityMaxWait: Number(options.affinityMaxWait),
+      });
+
+      const server = createDecodeServer(pool);
+      server.listen(Number(options.port), options.host, () => {
+        console.log(`Listening on http://${options.host}:${options.port} (${pool.getStats().workers} workers)`);
+      });
+
+      const shutdown = () => {
+        server.close();
+        pool.close().then(() => process.exit(0));
+      };
+      process.on('SIGINT', shutdown);
+      process.on('SIGTERM', shutdown);
+    } catch (error: unknown) {
+      logger.error({ error }, 'Failed to start server');
+      console.error(`Error: ${error instanceof Error ? error.message : 'Unknown error'}`);
+      process.exit(1);
+    }
+  });
+
+// Diff command
+program
+  .command('diff <input>')
+  .description('Decode a VIN list against two database snapshots and report differences')
+  .requiredOption('--old <path>', 'Current VPIC database file')
+  .requiredOption('--new <path>', 'Candidate VPIC database file')
+  .option('-o, --out <path>', 'Write the JSON report to a file instead of stdout')
+  .option('--no-manifest', 'Decode every VIN against both snapshots')
+  .option('-v, --verbose', 'Enable verbose logging')
+  .action(async (input, options) => {
+    process.env.LOG_LEVEL = options.verbose ? 'debug' : 'info';
+
+    try {
+      // One VIN per line, or CSV with the VIN in the first column
+      const vins = readFileSync(input, 'utf-8')
+        .split(/\r?\n/)
+        .map(line => line.split(',')[0].trim().toUpperCase())
+        .filter(Boolean);
+
+      const factory = new NodeDatabaseAdapterFactory();
+      const before = await factory.createAdapter(options.old);
+      const after = await factory.createAdapter(options.new);
+
+      const manifest = options.manifest
+        ? await buildDiffManifest(
+            before,
+            after,
+            vins.filter(vin => vin.length === 17).map(vin => extractWMI(vin)),
+          )
+        : undefined;
+
+      const decoder = new DualDecoder(before, after, manifest);
+      const report = await decoder.report(vins);
+      await decoder.close();
+
+      const text = JSON.stringify(report, null, 2);
+      if (options.out) {
+        writeFileSync(options.out, text);
+        const { total, changed, reused } = report.summary;
+        console.log(`${changed} of ${total} VINs changed (${reused} reused from unchanged WMIs)`);
+      } else {
+        console.log(text);
+      }
+
+      process.exit(0);
+    } catch (error: unknown) {
+      logger.error({ error }, 'Failed to diff snapshots');
+      console.error(`Error: ${error instanceof Error ? error.message : 'Unknown error'}`);
+      process.exit(1);
+    }
+  });
+
+// Bulk command
+program
+  .command('bulk <input>')
+  .description('Decode a large VIN file in parallel shards to JSON Lines, resuming interrupted runs')
+  .requiredOption('-o, --out <path>', 'Output JSON Lines file')
+  .option('-d, --database <path>', 'Path to the VPIC database file')
+  .option('-w, --workers <count>', 'Worker threads')
+  .option('-s, --shard-size <mb>', 'Target shard size in megabytes', '64')
+  .option('--reorder-window <count>', 'VINs grouped by WMI, year and VDS before decoding (0 keeps input order)', '0')
+  .option('--fast-reject', 'Write shared error results for malformed VINs and unknown WMIs without full decoding')
+  .option('-p, --patterns', 'Include pattern matching details')
+  .option('-r, --raw', 'Include raw database records')
+  .option('-v, --verbose', 'Enable verbose logging')
+  .action(async (input, options) => {
+    process.env.LOG_LEVEL = options.verbose ? 'debug' : 'info';
+
+    try {
+      const workers = options.workers !== undefined ? Number(options.workers) : undefined;
+      const databasePath = await getDatabasePath({ databasePath: options.database });
+      const summary = await bulkDecode(input, options.out, {
+        databasePath,
+        workers,
+        decoder: workers === 0 ? await createDecoder({ databasePath, searchIndex: false }) : undefined,
+        shardSize: Math.max(1, Number(options.shardSize) * 1024 * 1024),
+        decodeOptions: {
+          includePatternDetails: options.patterns,
+          includeRawData: options.raw,
+          reorderWindow: Number(options.reorderWindow),
+          fastReject: options.fastReject,
+        },
+        onShard: (shard, completed, total) => {
+          console.error(`Shard ${shard.index} done (${completed}/${total})`);
+        },
+      });
+
+      const resumed = summary.resumed > 0 ? `, ${summary.resumed} resumed` : '';
+      console.log(`Decoded ${summary.lines} VINs in ${summary.shards} shards${resumed} to ${options.out}`);
+      console.log(
+        `Pattern set cache hit rate ${(summary.cacheHitRate * 100).toFixed(1)}%, locality ${(summary.localityRate * 100).toFixed(1)}% (input order ${(summary.inputOrderLocalityRate * 100).toFixed(1)}%)`,
+      );
+      process.exit(0);
+    } catch (error: unknown) {
+      logger.error({ error }, 'Bulk decode failed');
+      console.error(`Error: ${error instanceof Error ? error.message : 'Unknown error'}`);
+      console.error('Re-run the same command to resume from the last completed shard.');
+      process.exit(1);
+    }
+  });
+
 // Default command (decode)
 program.action(() => {
   program.help();
@@ -1,4 +1,9 @@
 import { DatabaseAdapter } from './db/adapter';
+import type { TieredCache } from './cache/backend';
+import type { VdsClassTable } from './db/vds-classes';
+import type { CatalogData } from './db/catalog';
+import { isOverlaySchemaId } from './overlay';
+import type { OverlayElement, PatternOverlay } from './overlay';
 import { WMIResult } from './types';
 import { logger } from './logger';
 
@@ -16,14 +21,21 @@ export interface QueryResult {
 export class VPICDatabase {
   private adapter: DatabaseAdapter;
   private queryCache: Map<string, any> = new Map();
+  private inflight: Map<string, Promise<QueryResult[]>> = new Map();
+  private sharedCache?: TieredCache;
+  private vdsClasses: Map<number, VdsClassTable | null> = new Map();
+  private vdsClassesAvailable?: Promise<boolean>;
+  private overlay?: PatternOverlay;
 
   /**
    * Create a new VPIC database instance
    *
    * @param adapter - The database adapter for the target environment
+   * @param sharedCache - Optional shared cache consulted for pattern sets after the query cache
    */
-  constructor(adapter: DatabaseAdapter) {
+  constructor(adapter: DatabaseAdapter, sharedCache?: TieredCache) {
     this.adapter = adapter;
+    this.sharedCache = sharedCache;
   }
 
   /**
@@ -44,7 +56,7 @@ export class VPICDatabase {
       }
 
       // Execute the query
-      const result = await this.adapter.exec(sql, params);
+      const result = await this.execShared(cacheKey, sql, params);
 
       // Transform result to object if we have data
       if (result[0]?.values?.length > 0) {
@@ -68,6 +80,13 @@ export class VPICDatabase {
     }
   }
 
+  /**
+   * Query cache key for a multi-row query
+   */
+  private queryCacheKey(sql: string, params: any[]): string {
+    return `query:${sql}:${JSON.stringify(params)}`;
+  }
+
   /**
    * Execute a query and get multiple rows as objects
    *
@@ -78,7 +97,7 @@ export class VPICDatabase {
   private async query<T>(sql: string, params: any[] = []): Promise<T[]> {
     try {
       // Create a cache key from the query and parameters
-      const cacheKey = `query:${sql}:${JSON.stringify(params)}`;
+      const cacheKey = this.queryCacheKey(sql, params);
 
       // Check if we have a cached result
       if (this.queryCache.has(cacheKey)) {
@@ -86,7 +105,7 @@ export class VPICDatabase {
       }
 
       // Execute the query
-      const result = await this.adapter.exec(sql, params);
+      const result = await this.execShared(cacheKey, sql, params);
 
       // Transform results to objects
       if (result[0]?.values?.length > 0) {
@@ -114,6 +133,39 @@ export class VPICDatabase {
     }
   }
 
+  /**
+   * Execute a query, joining an identical query that is already in flight
+   *
+   * Lets prefetches and decodes for upcoming VINs share I/O instead of
+   * issuing the same query twice before either result is cached.
+   *
+   * @param cacheKey - Query cache key
+   * @param sql - SQL query to execute
+   * @param params - Query parameters
+   * @returns Raw query results
+   */
+  private execShared(cacheKey: string, sql: string, params: any[]): Promise<QueryResult[]> {
+    let pending = this.inflight.get(cacheKey);
+    if (!pending) {
+      pending = this.adapter.exec(sql, params).finally(() => this.inflight.delete(cacheKey));
+      this.inflight.set(cacheKey, pending);
+    }
+    return pending;
+  }
+
+  /**
+   * Get a view of this database with a tenant overlay layered on top
+   *
+   * The view shares this instance's adapter and caches; only WMIs and schemas
+   * the overlay covers are answered differently.
+   *
+   * @param overlay - Tenant overlay
+   * @returns Database view for the overlay
+   */
+  withOverlay(overlay: PatternOverlay): VPICDatabase {
+    return Object.assign(Object.create(VPICDatabase.prototype), this, { overlay });
+  }
+
   /**
    * Clear the query cache
    */
@@ -135,6 +187,16 @@ export class VPICDatabase {
    * @returns WMI information or null if not found
    */
   async getWMI(wmi: string): Promise<WMIResult | null> {
+    const overlaid = this.overlay?.getWMI(wmi);
+    if (overlaid !== undefined) {
+      return overlaid;
+    }
+
+    const indexed = this.adapter.index?.getWMI(wmi);
+    if (indexed !== undefined) {
+      return indexed;
+    }
+
     const sql = /*sql*/ `
       WITH RECURSIVE
       WmiMakes AS (
@@ -186,30 +248,250 @@ export class VPICDatabase {
     wmi: string,
     modelYear: number,
   ): Promise<Array<{ SchemaId: number; SchemaName: string }>> {
+    if (this.overlay) {
+      return this.overlay.getValidSchemas(wmi, modelYear, await this.getBaseSchemas(wmi, modelYear));
+    }
+    return this.getBaseSchemas(wmi, modelYear);
+  }
+
+  /**
+   * Get valid schemas from the index or database, ignoring any overlay
+   */
+  private async getBaseSchemas(
+    wmi: string,
+    modelYear: number,
+  ): Promise<Array<{ SchemaId: number; SchemaName: string }>> {
+    const indexed = this.adapter.index?.getValidSchemas(wmi, modelYear);
+    if (indexed !== undefined) {
+      return indexed;
+    }
+
+    // Filtered from the WMI's schema links, so every model year (and getWmiYearRanges) shares one cached query
+    const schemas = new Map<number, { SchemaId: number; SchemaName: string }>();
+    for (const { SchemaId, SchemaName, YearFrom, YearTo } of await this.getSchemaYearRanges(wmi)) {
+      if (modelYear >= YearFrom && (YearTo === null || modelYear <= YearTo) && !schemas.has(SchemaId)) {
+        schemas.set(SchemaId, { SchemaId, SchemaName });
+      }
+    }
+    return [...schemas.values()];
+  }
+
+  /**
+   * Get every schema linked to a WMI together with its model year range
+   *
+   * @param wmi - 3-character WMI code
+   * @returns Schema ids, names and year ranges (YearTo null when open-ended)
+   */
+  async getSchemaYearRanges(
+    wmi: string,
+  ): Promise<Array<{ SchemaId: number; SchemaName: string; YearFrom: number; YearTo: number | null }>> {
     const sql = /*sql*/ `
-      SELECT DISTINCT vs.Id as SchemaId, vs.Name as SchemaName
+      SELECT vs.Id as SchemaId, vs.Name as SchemaName, wvs.YearFrom, wvs.YearTo
       FROM Wmi w
       JOIN Wmi_VinSchema wvs ON w.Id = wvs.WmiId
       JOIN VinSchema vs ON wvs.VinSchemaId = vs.Id
       WHERE w.Wmi = ?
-        AND ? >= wvs.YearFrom 
-        AND (wvs.YearTo IS NULL OR ? <= wvs.YearTo)
+      ORDER BY wvs.YearFrom, vs.Id
+    `;
+
+    return this.query(sql, [wmi]);
+  }
+
+  /**
+   * Get the model year ranges of every schema linked to a WMI
+   *
+   * @param wmi - 3-character WMI code
+   * @returns [YearFrom, YearTo] pairs (YearTo null when open-ended), empty when unknown
+   */
+  async getWmiYearRanges(wmi: string): Promise<Array<[number, number | null]>> {
+    const overlaid = this.overlay?.getYearRanges(wmi);
+    if (overlaid !== undefined) {
+      return overlaid;
+    }
+
+    const indexed = this.adapter.index?.getYearRanges?.(wmi);
+    if (indexed !== undefined) {
+      return indexed;
+    }
+
+    // Same cached query getValidSchemas filters, so choosing the cycle costs no extra query
+    const ranges = new Map<string, [number, number | null]>();
+    for (const link of await this.getSchemaYearRanges(wmi)) {
+      ranges.set(`${link.YearFrom}:${link.YearTo}`, [link.YearFrom, link.YearTo ?? null]);
+    }
+    return [...ranges.values()];
+  }
+
+  /**
+   * Get every make and model pair from Make_Model
+   *
+   * @returns Make and model ids and names
+   */
+  async getMakeModels(): Promise<Array<{ MakeId: number; Make: string; ModelId: number; Model: string }>> {
+    const sql = /*sql*/ `
+      SELECT ma.Id as MakeId, ma.Name as Make, mo.Id as ModelId, mo.Name as Model
+      FROM Make_Model mm
+      JOIN Make ma ON ma.Id = mm.MakeId
+      JOIN Model mo ON mo.Id = mm.ModelId
+      ORDER BY ma.Id, mo.Id
+    `;
+
+    return this.query(sql);
+  }
+
+  /**
+   * Get the model year ranges of every make and model with Model patterns
+   *
+   * @returns One row per make, model and schema year range (YearTo null when open-ended)
+   */
+  async getModelYearRanges(): Promise<
+    Array<{ MakeId: number; Make: string; ModelId: number; Model: string; YearFrom: number; YearTo: number | null }>
+  > {
+    const sql = /*sql*/ `
+      SELECT mm.MakeId, ma.Name as Make, mm.ModelId, mo.Name as Model, wvs.YearFrom, wvs.YearTo
+      FROM Pattern p
+      JOIN Element e ON p.ElementId = e.Id
+      JOIN Wmi_VinSchema wvs ON wvs.VinSchemaId = p.VinSchemaId
+      JOIN Make_Model mm ON mm.ModelId = CAST(p.AttributeId AS INTEGER)
+      JOIN Make ma ON ma.Id = mm.MakeId
+      JOIN Model mo ON mo.Id = mm.ModelId
+      WHERE e.Name = 'Model'
+      GROUP BY mm.MakeId, mm.ModelId, wvs.YearFrom, wvs.YearTo
+    `;
+
+    return this.query(sql);
+  }
+
+  /**
+   * Get the make, model and year catalog stored by `scripts/build-catalog.ts`
+   *
+   * @returns Catalog data, or null if the database has no Catalog table
+   */
+  async getStoredCatalog(): Promise<CatalogData | null> {
+    const table = await this.get<{ name: string }>(
+      "SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'Catalog'",
+    ).catch(() => null);
+    if (!table) {
+      return null;
+    }
+
+    const row = await this.get<{ Data: string }>('SELECT Data FROM Catalog ORDER BY Id DESC LIMIT 1');
+    return row ? JSON.parse(row.Data) : null;
+  }
+
+  /**
+   * Get every Model pattern with the WMIs and years its schema is linked with
+   *
+   * @returns WMI, pattern keys and year range (YearTo null when open-ended)
+   */
+  async getModelPatternYearRanges(): Promise<Array<{ Wmi: string; Pattern: string; YearFrom: number; YearTo: number | null }>> {
+    const sql = /*sql*/ `
+      SELECT DISTINCT w.Wmi, p.Keys as Pattern, wvs.YearFrom, wvs.YearTo
+      FROM Pattern p
+      JOIN Element e ON p.ElementId = e.Id
+      JOIN Wmi_VinSchema wvs ON wvs.VinSchemaId = p.VinSchemaId
+      JOIN Wmi w ON w.Id = wvs.WmiId
+      WHERE e.Name = 'Model'
+    `;
+
+    return this.query(sql);
+  }
+
+  /**
+   * Get the plausibility filter stored by `scripts/build-plausibility.ts`
+   *
+   * @returns Serialized filter, or null if the database has no PlausibilityFilter table
+   */
+  async getStoredPlausibilityFilter(): Promise<Uint8Array | null> {
+    const table = await this.get<{ name: string }>(
+      "SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'PlausibilityFilter'",
+    ).catch(() => null);
+    if (!table) {
+      return null;
+    }
+
+    const row = await this.get<{ Data: Uint8Array | ArrayBuffer | number[] }>(
+      'SELECT Data FROM PlausibilityFilter ORDER BY Id DESC LIMIT 1',
+    );
+    if (!row) {
+      return null;
+    }
+    // Adapters return BLOBs as Buffer, Uint8Array, ArrayBuffer or number arrays
+    return row.Data instanceof Uint8Array ? row.Data : new Uint8Array(row.Data);
+  }
+
+  /**
+   * Get the model year ranges every schema is linked with
+   *
+   * @returns Schema ids and year ranges (YearTo null when open-ended)
+   */
+  async getAllSchemaYearRanges(): Promise<Array<{ SchemaId: number; YearFrom: number; YearTo: number | null }>> {
+    const sql = /*sql*/ `
+      SELECT VinSchemaId as SchemaId, YearFrom, YearTo
+      FROM Wmi_VinSchema
+      ORDER BY VinSchemaId, YearFrom
     `;
 
-    return this.query(sql, [wmi, modelYear, modelYear]);
+    return this.query(sql);
+  }
+
+  /**
+   * Get every pattern of one element, with its value resolved
+   *
+   * Values are read through the element's lookup table when it has one and
+   * taken from AttributeId otherwise.
+   *
+   * @param elementName - Element name (e.g. "Model", "Trim")
+   * @returns Schema, pattern, raw attribute id and resolved value per row
+   */
+  async getElementPatterns(
+    elementName: string,
+  ): Promise<Array<{ SchemaId: number; Pattern: string; AttributeId: string; Value: string }>> {
+    const element = await this.get<{ Id: number; LookupTable: string | null }>(
+      'SELECT Id, LookupTable FROM Element WHERE Name = ?',
+      [elementName],
+    );
+    if (!element) {
+      return [];
+    }
+
+    const lookup = element.LookupTable && /^\w+$/.test(element.LookupTable) ? element.LookupTable : null;
+    const sql = /*sql*/ `
+      SELECT
+        p.VinSchemaId as SchemaId,
+        p.Keys as Pattern,
+        CAST(p.AttributeId AS TEXT) as AttributeId,
+        ${lookup ? 'COALESCE(l.Name, p.AttributeId)' : 'p.AttributeId'} as Value
+      FROM Pattern p
+      ${lookup ? `LEFT JOIN ${lookup} l ON CAST(l.Id AS TEXT) = CAST(p.AttributeId AS TEXT)` : ''}
+      WHERE p.ElementId = ?
+    `;
+
+    return this.query(sql, [element.Id]);
   }
 
   /**
    * Get patterns for a specific set of schemas
    *
    * @param schemaIds - Array of schema IDs
+   * @param lookup - Receives whether the set came from a cache (query cache, hot index or shared cache)
    * @returns Array of pattern definitions
    */
-  async getPatterns(schemaIds: number[]): Promise<any[]> {
+  async getPatterns(schemaIds: number[], lookup?: { cached?: boolean }): Promise<any[]> {
     if (schemaIds.length === 0) {
       return [];
     }
 
+    if (this.overlay && schemaIds.some(isOverlaySchemaId)) {
+      return this.getOverlayPatterns(this.overlay, schemaIds, lookup);
+    }
+
+    const indexed = this.adapter.index?.getPatterns(schemaIds);
+    if (indexed !== undefined) {
+      if (lookup) lookup.cached = true;
+      return indexed;
+    }
+
     const sql = /*sql*/ `
       WITH ValidSchemas AS (
         SELECT vs.Id, vs.Name 
@@ -260,7 +542,108 @@ export class VPICDatabase {
       AND p.VinSchemaId IN (${schemaIds.join(',')})
     `;
 
-    return this.query(sql, []);
+    // The shared cache sits behind the query cache, so local hits skip it entirely
+    const queryKey = this.queryCacheKey(sql, []);
+    const local = this.queryCache.get(queryKey);
+    if (local) {
+      if (lookup) lookup.cached = true;
+      return local;
+    }
+
+    const sharedKey = `patterns:${schemaIds.join(',')}`;
+    if (this.sharedCache) {
+      const shared = await this.sharedCache.get<any[]>(sharedKey);
+      if (shared !== undefined) {
+        // L1 rows are shared and the matcher writes ResolvedValue into the rows it gets, so hand out copies
+        const rows = shared.map(row => ({ ...row }));
+        this.queryCache.set(queryKey, rows);
+        if (lookup) lookup.cached = true;
+        return rows;
+      }
+    }
+
+    if (lookup) lookup.cached = false;
+    const patterns = await this.query(sql, []);
+    if (this.sharedCache && patterns.length > 0) {
+      this.sharedCache.set(sharedKey, patterns);
+    }
+    return patterns;
+  }
+
+  /**
+   * Model years a schema is linked to a WMI for, spanning all of its links
+   *
+   * @returns [from, to] (to null when open-ended), or undefined if the schema is not linked to the WMI
+   */
+  private async getSchemaYearsForWmi(wmi: string, schemaId: number): Promise<[number, number | null] | undefined> {
+    const links = (await this.getSchemaYearRanges(wmi)).filter(range => range.SchemaId === schemaId);
+    if (links.length === 0) {
+      return undefined;
+    }
+    const from = Math.min(...links.map(link => link.YearFrom));
+    const to = links.some(link => link.YearTo === null) ? null : Math.max(...links.map(link => link.YearTo!));
+    return [from, to];
+  }
+
+  /**
+   * Get patterns for a schema set that includes overlay schemas
+   *
+   * Base schemas are read as usual (sharing the base caches); each overlay
+   * schema is compiled once from its base schema's rows.
+   */
+  private async getOverlayPatterns(
+    overlay: PatternOverlay,
+    schemaIds: number[],
+    lookup?: { cached?: boolean },
+  ): Promise<any[]> {
+    const baseIds = schemaIds.filter(id => !isOverlaySchemaId(id));
+    const rows = baseIds.length > 0 ? [...(await this.getPatterns(baseIds, lookup))] : [];
+
+    for (const id of schemaIds) {
+      const schema = overlay.getSchema(id);
+      if (!schema) {
+        continue;
+      }
+      let compiled = overlay.getCompiled(id);
+      if (!compiled) {
+        const baseRows = schema.baseId === null ? [] : await this.getPatterns([schema.baseId]);
+        const baseYears = schema.baseId === null ? undefined : await this.getSchemaYearsForWmi(schema.wmi, schema.baseId);
+        compiled = overlay.compile(
+          schema,
+          baseRows,
+          await this.getElements(overlay.getElementNames(schema)),
+          baseYears,
+        );
+      }
+      rows.push(...compiled);
+    }
+
+    return rows;
+  }
+
+  /**
+   * Get element columns for pattern rows by element name
+   *
+   * @param names - Element names (matched case-insensitively)
+   * @returns Element columns keyed by lower-case name
+   */
+  async getElements(names: string[]): Promise<Map<string, OverlayElement>> {
+    if (names.length === 0) {
+      return new Map();
+    }
+
+    const placeholders = names.map(() => '?').join(',');
+    const rows = await this.query<OverlayElement>(
+      /*sql*/ `
+        SELECT e.Id as ElementId, e.Name as ElementName, e.Code as ElementCode,
+          e.GroupName, e.Description, e.weight as ElementWeight
+        FROM Element e
+        WHERE e.Name COLLATE NOCASE IN (${placeholders})
+      `,
+      names,
+    );
+
+    return new Map(rows.map(row => [row.ElementName.toLowerCase(), row]));
   }
 
   /**
@@ -275,6 +658,11 @@ export class VPICDatabase {
       return new Map();
     }
 
+    const indexed = this.adapter.index?.lookupValues(tableName, ids);
+    if (indexed !== undefined) {
+      return indexed;
+    }
+
     try {
       const placeholders = ids.map(() => '?').join(',');
       const sql = /*sql*/ `
@@ -297,4 +685,63 @@ export class VPICDatabase {
       return new Map();
     }
   }
+
+  /**
+   * Get compiled VDS class tables for a set of schemas
+   *
+   * Tables are written by `scripts/build-vds-classes.ts`; databases without the
+   * VdsClass table, or with any schema left uncompiled, return undefined, as do
+   * schemas served by an overlay. Schemas served by the adapter's precompiled
+   * index use the tables compiled into it, without querying.
+   *
+   * @param schemaIds - Array of schema IDs
+   * @returns Class tables in schema order, or undefined if any schema is not covered
+   */
+  async getVdsClassTables(schemaIds: number[]): Promise<VdsClassTable[] | undefined> {
+    if (schemaIds.length === 0 || schemaIds.some(isOverlaySchemaId)) {
+      return undefined;
+    }
+
+    const index = this.adapter.index;
+    if (index?.hasSchemas(schemaIds)) {
+      return index.getVdsClassTables?.(schemaIds) ?? undefined;
+    }
+
+    const tables = await this.getVdsClassTablesBySchema(schemaIds);
+    return tables?.every(table => table !== null) ? (tables as VdsClassTable[]) : undefined;
+  }
+
+  /**
+   * Get compiled VDS class tables schema by schema
+   *
+   * @param schemaIds - Array of schema IDs
+   * @returns Class table per schema (null if not compiled), or undefined if the database has no VdsClass table
+   */
+  async getVdsClassTablesBySchema(schemaIds: number[]): Promise<Array<VdsClassTable | null> | undefined> {
+    if (!this.vdsClassesAvailable) {
+      this.vdsClassesAvailable = this.get<{ name: string }>(
+        "SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'VdsClass'",
+      )
+        .then(row => row !== null)
+        .catch(() => false);
+    }
+    if (!(await this.vdsClassesAvailable)) {
+      return undefined;
+    }
+
+    const missing = schemaIds.filter(id => !this.vdsClasses.has(id));
+    if (missing.length > 0) {
+      const rows = await this.query<{ VinSchemaId: number; Data: string }>(
+        `SELECT VinSchemaId, Data FROM VdsClass WHERE VinSchemaId IN (${missing.join(',')})`,
+      );
+      for (const id of missing) {
+        this.vdsClasses.set(id, null);
+      }
+      for (const row of rows) {
+        this.vdsClasses.set(row.VinSchemaId, JSON.parse(row.Data));
+      }
+    }
+
+    return schemaIds.map(id => this.vdsClasses.get(id) ?? null);
+  }
 }
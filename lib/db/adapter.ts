@@ -1,3 +1,7 @@
+import type { WMIResult } from '../types';
+import type { MatchKernel } from './match-kernel';
+import type { VdsClassTable } from './vds-classes';
+
 /**
  * Common interface for database operations across different environments
  */
@@ -10,6 +14,16 @@ export interface DatabaseAdapter {
    * @returns Array of query results
    */
   exec(query: string, params?: any[]): Promise<QueryResult[]>;
+
+  /**
+   * Optional precompiled index consulted before issuing SQL
+   */
+  index?: VPICIndex;
+
+  /**
+   * Optional WebAssembly matcher used for VDS patterns instead of the JS matcher
+   */
+  kernel?: MatchKernel;
   
   /**
    * Close the database connection
@@ -45,4 +59,51 @@ export interface DatabaseAdapterFactory {
    * @returns Initialized database adapter
    */
   createAdapter(pathOrUrl: string): Promise<DatabaseAdapter>;
-}
\ No newline at end of file
+}
+
+/**
+ * Precompiled data that can answer VPIC lookups without SQL.
+ *
+ * Each method returns undefined when the requested key is not covered,
+ * in which case the caller falls back to querying the adapter.
+ */
+export interface VPICIndex {
+  /**
+   * Get WMI information (null if the WMI is known not to exist)
+   */
+  getWMI(wmi: string): WMIResult | null | undefined;
+
+  /**
+   * Get valid schemas for a WMI and model year
+   */
+  getValidSchemas(
+    wmi: string,
+    modelYear: number,
+  ): Array<{ SchemaId: number; SchemaName: string }> | undefined;
+
+  /**
+   * Get the [YearFrom, YearTo] ranges of every schema linked to a WMI
+   */
+  getYearRanges?(wmi: string): Array<[number, number | null]> | undefined;
+
+  /**
+   * Whether every schema is covered, without building rows or counting a lookup
+   */
+  hasSchemas(schemaIds: number[]): boolean;
+
+  /**
+   * Get pattern rows for a set of schemas
+   */
+  getPatterns(schemaIds: number[]): any[] | undefined;
+
+  /**
+   * Get compiled VDS class tables for a set of schemas
+   * (null if the schemas are covered but not every one has a table)
+   */
+  getVdsClassTables?(schemaIds: number[]): VdsClassTable[] | null | undefined;
+
+  /**
+   * Resolve ids in a lookup table
+   */
+  lookupValues(tableName: string, ids: string[]): Map<string, string> | undefined;
+}
@@ -1,5 +1,6 @@
 import type { DatabaseAdapter, QueryResult, DatabaseAdapterFactory } from './adapter';
 import { createLogger } from '../logger';
+import { MatchKernel } from './match-kernel';
 
 const logger = createLogger('BrowserDatabaseAdapter');
 
@@ -31,7 +32,7 @@ interface SQLJsResult {
  */
 declare global {
   interface Window {
-    initSqlJs: () => Promise<SQLJsStatic>;
+    initSqlJs: (config?: Record<string, unknown>) => Promise<SQLJsStatic>;
     SQL: SQLJsStatic;
   }
 }
@@ -62,6 +63,7 @@ function escapeValue(value: any): string {
 export class BrowserDatabaseAdapter implements DatabaseAdapter {
   private db: SQLJsDatabase;
   private queryCount: number = 0;
+  kernel?: MatchKernel;
 
   /**
    * Create a new database adapter for browser environment
@@ -129,57 +131,292 @@ export class BrowserDatabaseAdapter implements DatabaseAdapter {
   }
 }
 
+/**
+ * Progress of the browser cold-start pipeline
+ */
+export interface BrowserLoadProgress {
+  /** Bytes received over the network (compressed size for gzip) */
+  loaded: number;
+
+  /** Total bytes expected over the network, when the server reports it */
+  total?: number;
+
+  /** Bytes of SQLite data produced so far */
+  decompressed: number;
+
+  /** Whether sql.js has finished compiling and instantiating */
+  wasmReady: boolean;
+}
+
+/**
+ * Options for the browser database adapter factory
+ */
+export interface BrowserAdapterOptions {
+  /** Resolve sql.js support files such as sql-wasm.wasm (default: `/${file}`) */
+  locateFile?: (file: string) => string;
+
+  /** Expected size of the decompressed database, used to preallocate the buffer */
+  uncompressedSize?: number;
+
+  /** Called as the download, decompression and WASM initialization progress */
+  onProgress?: (progress: BrowserLoadProgress) => void;
+
+  /**
+   * Match VDS patterns with the WebAssembly SIMD kernel (a precompiled module
+   * may be passed). Falls back to the JS matcher where SIMD is unavailable.
+   */
+  matchKernel?: boolean | WebAssembly.Module;
+}
+
+// Shared across factories so the WASM module is compiled once per page
+let sqlJsPromise: Promise<SQLJsStatic> | null = null;
+
+/**
+ * Growable byte buffer that starts at a preallocated size
+ */
+class ByteSink {
+  private buffer: Uint8Array;
+  length = 0;
+
+  constructor(initialSize: number) {
+    this.buffer = new Uint8Array(Math.max(initialSize, 64 * 1024));
+  }
+
+  push(chunk: Uint8Array): void {
+    if (this.length + chunk.length > this.buffer.length) {
+      const grown = new Uint8Array(Math.max(this.buffer.length * 2, this.length + chunk.length));
+      grown.set(this.buffer.subarray(0, this.length));
+      this.buffer = grown;
+    }
+    this.buffer.set(chunk, this.length);
+    this.length += chunk.length;
+  }
+
+  bytes(): Uint8Array {
+    return this.buffer.subarray(0, this.length);
+  }
+}
+
+/** Updates and publishes the progress of one createAdapter call */
+type ProgressReporter = (update: Partial<BrowserLoadProgress>) => void;
+
+/**
+ * Check for the gzip magic number
+ */
+function isGzipData(data: Uint8Array): boolean {
+  return data.length > 2 && data[0] === 0x1f && data[1] === 0x8b;
+}
+
+/**
+ * Decompress a complete gzip buffer
+ */
+async function gunzipBuffer(data: Uint8Array): Promise<Uint8Array> {
+  const stream = new Blob([data]).stream().pipeThrough(new DecompressionStream('gzip'));
+  return new Uint8Array(await new Response(stream).arrayBuffer());
+}
+
 /**
  * Factory for creating browser database adapters
+ *
+ * The sql.js WASM compile and the database download start together, and gzip
+ * databases are decompressed as chunks arrive, so time to first decode is
+ * close to the slower of the two rather than their sum.
  */
 export class BrowserDatabaseAdapterFactory implements DatabaseAdapterFactory {
+  private options: BrowserAdapterOptions;
+
+  /**
+   * Create a new browser database adapter factory
+   *
+   * @param options - Cold-start pipeline options
+   */
+  constructor(options: BrowserAdapterOptions = {}) {
+    this.options = options;
+  }
+
   /**
    * Create a new database adapter for the given URL
    * 
-   * @param pathOrUrl - URL to the SQLite database file
+   * @param pathOrUrl - URL to the SQLite database file (plain or .gz)
    * @returns Initialized database adapter
    */
   async createAdapter(pathOrUrl: string): Promise<DatabaseAdapter> {
     logger.debug({ pathOrUrl }, 'Creating browser database adapter');
+    // Progress belongs to this call, so concurrent loads on one factory do not mix
+    let progress: BrowserLoadProgress = { loaded: 0, decompressed: 0, wasmReady: false };
+    const report: ProgressReporter = update => {
+      progress = { ...progress, ...update };
+      this.options.onProgress?.({ ...progress });
+    };
     
     try {
-      // Load SQL.js if not already loaded
-      if (!(window as any).SQL) {
-        logger.debug('Loading SQL.js');
-        const SQL = await (window as any).initSqlJs({
-          locateFile: (file: string) => `/${file}`
-        });
-        (window as any).SQL = SQL;
-      }
+      // Start both before awaiting either
+      const sqlReady = this.loadSqlJs(report);
+      const dataReady = this.fetchDatabase(pathOrUrl, report);
+      const { matchKernel } = this.options;
+      const kernelReady = matchKernel
+        ? MatchKernel.create(matchKernel === true ? undefined : matchKernel)
+        : Promise.resolve(null);
 
-      // Fetch and load the database
-      logger.debug({ pathOrUrl }, 'Fetching database');
-      const response = await fetch(pathOrUrl);
-      
-      // Check if response exists and has an ok property (for tests)
-      if (response && 'ok' in response && !response.ok) {
-        throw new Error(`Failed to load database: ${response.statusText}`);
-      }
-
-      // In test environment, response may be mocked, handle gracefully
-      let arrayBuffer;
-      try {
-        arrayBuffer = await response.arrayBuffer();
-      } catch (error) {
-        logger.debug('Using empty array buffer for tests');
-        // For tests, provide a small valid buffer
-        arrayBuffer = new ArrayBuffer(8);
-      }
+      const [SQL, data, kernel] = await Promise.all([sqlReady, dataReady, kernelReady]);
       logger.debug({ 
-        size: arrayBuffer.byteLength / 1024 / 1024
+        size: data.byteLength / 1024 / 1024
       }, 'Database loaded');
       
-      const db = new (window as any).SQL.Database(new Uint8Array(arrayBuffer));
+      const db = new SQL.Database(data);
 
-      return new BrowserDatabaseAdapter(db);
+      const adapter = new BrowserDatabaseAdapter(db);
+      adapter.kernel = kernel ?? undefined;
+      return adapter;
     } catch (error) {
       logger.error({ pathOrUrl, error }, 'Failed to create browser database adapter');
       throw error;
     }
   }
-}
\ No newline at end of file
+
+  /**
+   * Load sql.js, compiling the WASM module with streaming instantiation
+   *
+   * @param report - Progress reporter for this load
+   * @returns sql.js static module
+   */
+  private loadSqlJs(report: ProgressReporter): Promise<SQLJsStatic> {
+    if ((window as any).SQL) {
+      report({ wasmReady: true });
+      return Promise.resolve((window as any).SQL);
+    }
+
+    if (!sqlJsPromise) {
+      logger.debug('Loading SQL.js');
+      const locateFile = this.options.locateFile ?? ((file: string) => `/${file}`);
+      const config: Record<string, unknown> = { locateFile };
+
+      // initSqlJs never settles when instantiateWasm fails, so failures reject this instead
+      let failWasm: (error: unknown) => void = () => undefined;
+      const wasmFailed = new Promise<never>((_, reject) => {
+        failWasm = reject;
+      });
+
+      if (typeof WebAssembly !== 'undefined' && typeof WebAssembly.instantiateStreaming === 'function') {
+        config.instantiateWasm = (
+          imports: WebAssembly.Imports,
+          receive: (instance: WebAssembly.Instance, module: WebAssembly.Module) => void,
+        ) => {
+          const url = locateFile('sql-wasm.wasm');
+          WebAssembly.instantiateStreaming(fetch(url), imports)
+            .catch(async error => {
+              // Servers without the application/wasm MIME type need the buffered path
+              logger.debug({ error }, 'Streaming WASM compile failed, retrying buffered');
+              const response = await fetch(url);
+              if (!response.ok) {
+                throw new Error(`Failed to load ${url}: ${response.status} ${response.statusText}`);
+              }
+              return WebAssembly.instantiate(await response.arrayBuffer(), imports);
+            })
+            .then(result => receive(result.instance, result.module))
+            .catch(error => {
+              logger.error({ url, error }, 'Failed to compile SQL.js WASM');
+              failWasm(error);
+            });
+          return {};
+        };
+      }
+
+      sqlJsPromise = Promise.race([(window as any).initSqlJs(config) as Promise<SQLJsStatic>, wasmFailed]).then(
+        (SQL: SQLJsStatic) => {
+          (window as any).SQL = SQL;
+          return SQL;
+        },
+      );
+      sqlJsPromise!.catch(() => {
+        sqlJsPromise = null;
+      });
+    }
+
+    return sqlJsPromise!.then(SQL => {
+      report({ wasmReady: true });
+      return SQL;
+    });
+  }
+
+  /**
+   * Download the database, decompressing gzip as chunks arrive
+   *
+   * @param pathOrUrl - URL to the database file
+   * @param report - Progress reporter for this load
+   * @returns Raw SQLite bytes
+   */
+  private async fetchDatabase(pathOrUrl: string, report: ProgressReporter): Promise<Uint8Array> {
+    logger.debug({ pathOrUrl }, 'Fetching database');
+    const response = await fetch(pathOrUrl);
+    
+    // Check if response exists and has an ok property (for tests)
+    if (response && 'ok' in response && !response.ok) {
+      throw new Error(`Failed to load database: ${response.statusText}`);
+    }
+
+    if (!response?.body || typeof DecompressionStream === 'undefined') {
+      return this.readBuffered(response, report);
+    }
+
+    const total = Number(response.headers.get('content-length')) || undefined;
+    const contentType = response.headers.get('content-type') || '';
+    // A Content-Encoding of gzip is already undone by the browser
+    const gzipped =
+      !response.headers.get('content-encoding') &&
+      (/\.gz($|\?)/.test(pathOrUrl) || /gzip/.test(contentType));
+
+    report({ total });
+
+    let loaded = 0;
+    const counter = new TransformStream<Uint8Array, Uint8Array>({
+      transform: (chunk, controller) => {
+        loaded += chunk.length;
+        report({ loaded });
+        controller.enqueue(chunk);
+      },
+    });
+
+    let stream = response.body.pipeThrough(counter);
+    if (gzipped) {
+      stream = stream.pipeThrough(new DecompressionStream('gzip') as unknown as TransformStream<Uint8Array, Uint8Array>);
+    }
+
+    const estimate = this.options.uncompressedSize ?? (total ? (gzipped ? total * 3 : total) : 0);
+    const sink = new ByteSink(estimate);
+    const reader = stream.getReader();
+
+    for (;;) {
+      const { done, value } = await reader.read();
+      if (done) break;
+      sink.push(value);
+      report({ decompressed: sink.length });
+    }
+
+    const data = sink.bytes();
+    return isGzipData(data) ? gunzipBuffer(data) : data;
+  }
+
+  /**
+   * Fallback for environments without streaming bodies
+   */
+  private async readBuffered(response: Response | undefined, report: ProgressReporter): Promise<Uint8Array> {
+    // In test environment, response may be mocked, handle gracefully
+    let arrayBuffer;
+    try {
+      arrayBuffer = await response!.arrayBuffer();
+    } catch (error) {
+      logger.debug('Using empty array buffer for tests');
+      // For tests, provide a small valid buffer
+      arrayBuffer = new ArrayBuffer(8);
+    }
+
+    let data = new Uint8Array(arrayBuffer);
+    report({ loaded: data.length });
+    if (isGzipData(data) && typeof DecompressionStream !== 'undefined') {
+      data = await gunzipBuffer(data);
+    }
+    report({ decompressed: data.length });
+    return data;
+  }
+}
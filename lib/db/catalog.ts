@@ -0,0 +1,273 @@
+import type { DatabaseAdapter } from './adapter';
+import { VPICDatabase } from '../db';
+
+/** Fields per catalog entry: make index, model index, first year, last year (0 when open-ended) */
+const ENTRY_STRIDE = 4;
+
+/**
+ * Serialized make, model and year catalog, as produced by `scripts/build-catalog.ts`
+ */
+export interface CatalogData {
+  /** Format version */
+  version: 1;
+
+  /** [MakeId, Name], sorted by name */
+  makes: Array<[number, string]>;
+
+  /** [ModelId, Name], sorted by name */
+  models: Array<[number, string]>;
+
+  /**
+   * Merged year ranges, flattened as [make index, model index, from, to] and
+   * sorted by make, model and year; `to` is 0 for ranges still open
+   */
+  entries: number[];
+}
+
+/**
+ * A make or model in the catalog
+ */
+export interface CatalogItem {
+  id: number;
+  name: string;
+}
+
+/**
+ * Size of a catalog
+ */
+export interface CatalogStats {
+  makes: number;
+  models: number;
+  /** Merged (make, model, year range) entries */
+  ranges: number;
+  /** Last model year served for open-ended ranges */
+  openYear: number;
+}
+
+function byName(a: [number, string], b: [number, string]): number {
+  return a[1] < b[1] ? -1 : a[1] > b[1] ? 1 : a[0] - b[0];
+}
+
+/**
+ * Compile catalog data from make, model and year range rows
+ *
+ * @param rows - Rows from VPICDatabase.getModelYearRanges
+ * @returns Catalog data with overlapping and adjacent ranges merged
+ */
+export function compileCatalog(
+  rows: Array<{ MakeId: number; Make: string; ModelId: number; Model: string; YearFrom: number; YearTo: number | null }>,
+): CatalogData {
+  const makes = new Map<number, string>();
+  const models = new Map<number, string>();
+  for (const row of rows) {
+    makes.set(row.MakeId, row.Make);
+    models.set(row.ModelId, row.Model);
+  }
+
+  const sortedMakes = [...makes].sort(byName);
+  const sortedModels = [...models].sort(byName);
+  const makeIndex = new Map(sortedMakes.map(([id], index) => [id, index]));
+  const modelIndex = new Map(sortedModels.map(([id], index) => [id, index]));
+
+  const ranges = rows
+    .map(row => [
+      makeIndex.get(row.MakeId)!,
+      modelIndex.get(row.ModelId)!,
+      row.YearFrom,
+      row.YearTo ?? Infinity,
+    ])
+    .sort((a, b) => a[0] - b[0] || a[1] - b[1] || a[2] - b[2]);
+
+  const entries: number[] = [];
+  for (const [make, model, from, to] of ranges) {
+    const last = entries.length - ENTRY_STRIDE;
+    if (last >= 0 && entries[last] === make && entries[last + 1] === model && from <= entries[last + 3] + 1) {
+      entries[last + 3] = Math.max(entries[last + 3], to);
+    } else {
+      entries.push(make, model, from, to);
+    }
+  }
+  for (let i = 3; i < entries.length; i += ENTRY_STRIDE) {
+    if (entries[i] === Infinity) {
+      entries[i] = 0;
+    }
+  }
+
+  return { version: 1, makes: sortedMakes, models: sortedModels, entries };
+}
+
+/**
+ * Makes, models and model years according to vPIC Model patterns
+ *
+ * A model is listed for a year when one of its Model patterns belongs to a
+ * schema valid for that year. Answers come from sorted arrays: a binary
+ * search finds a make's or model's entries, and make lists are built once per
+ * year and reused.
+ */
+export class VehicleCatalog {
+  private makes: Array<[number, string]>;
+  private models: Array<[number, string]>;
+  private entries: Int32Array;
+  private openYear: number;
+  private makeIds = new Map<number, number>();
+  private makeNames = new Map<string, number>();
+  private modelNames = new Map<string, number[]>();
+  private modelIds = new Map<number, number>();
+  private makesByYear = new Map<number, CatalogItem[]>();
+
+  /**
+   * @param data - Compiled catalog data
+   * @param openYear - Last year listed for open-ended ranges (default: next calendar year)
+   */
+  constructor(data: CatalogData, openYear = new Date().getFullYear() + 1) {
+    if (data.version !== 1) {
+      throw new Error(`Unsupported catalog version: ${data.version}`);
+    }
+    this.makes = data.makes;
+    this.models = data.models;
+    this.entries = Int32Array.from(data.entries);
+    this.openYear = openYear;
+
+    this.makes.forEach(([id, name], index) => {
+      this.makeIds.set(id, index);
+      this.makeNames.set(name.toUpperCase(), index);
+    });
+    this.models.forEach(([id, name], index) => {
+      this.modelIds.set(id, index);
+      const key = name.toUpperCase();
+      this.modelNames.set(key, [...(this.modelNames.get(key) ?? []), index]);
+    });
+  }
+
+  /**
+   * Load the catalog stored in the database, or compile it from the Pattern table
+   *
+   * @param adapter - Database adapter
+   * @returns Catalog
+   */
+  static async load(adapter: DatabaseAdapter): Promise<VehicleCatalog> {
+    const db = new VPICDatabase(adapter);
+    const stored = await db.getStoredCatalog();
+    return new VehicleCatalog(stored ?? compileCatalog(await db.getModelYearRanges()));
+  }
+
+  /**
+   * Get catalog size
+   */
+  getStats(): CatalogStats {
+    return {
+      makes: this.makes.length,
+      models: this.models.length,
+      ranges: this.entries.length / ENTRY_STRIDE,
+      openYear: this.openYear,
+    };
+  }
+
+  /**
+   * List makes with at least one model in a model year
+   *
+   * @param year - Model year
+   * @returns Makes sorted by name
+   */
+  listMakes(year: number): CatalogItem[] {
+    let makes = this.makesByYear.get(year);
+    if (!makes) {
+      makes = [];
+      let previous = -1;
+      for (let i = 0; i < this.entries.length; i += ENTRY_STRIDE) {
+        const make = this.entries[i];
+        if (make !== previous && this.covers(i, year)) {
+          makes.push({ id: this.makes[make][0], name: this.makes[make][1] });
+          previous = make;
+        }
+      }
+      this.makesByYear.set(year, makes);
+    }
+    return [...makes];
+  }
+
+  /**
+   * List a make's models, optionally only those in a model year
+   *
+   * @param make - Make id or name (case-insensitive)
+   * @param year - Model year
+   * @returns Models sorted by name
+   */
+  listModels(make: number | string, year?: number): CatalogItem[] {
+    const makeIndex = this.resolveMake(make);
+    if (makeIndex === undefined) {
+      return [];
+    }
+
+    const models: CatalogItem[] = [];
+    let previous = -1;
+    for (let i = this.lowerBound(makeIndex, 0); i < this.entries.length && this.entries[i] === makeIndex; i += ENTRY_STRIDE) {
+      const model = this.entries[i + 1];
+      if (model !== previous && (year === undefined || this.covers(i, year))) {
+        models.push({ id: this.models[model][0], name: this.models[model][1] });
+        previous = model;
+      }
+    }
+    return models;
+  }
+
+  /**
+   * List the model years of a make's model
+   *
+   * @param make - Make id or name (case-insensitive)
+   * @param model - Model id or name (case-insensitive)
+   * @returns Years in ascending order
+   */
+  listYears(make: number | string, model: number | string): number[] {
+    const makeIndex = this.resolveMake(make);
+    if (makeIndex === undefined) {
+      return [];
+    }
+
+    const candidates =
+      typeof model === 'number'
+        ? this.modelIds.has(model) ? [this.modelIds.get(model)!] : []
+        : this.modelNames.get(model.toUpperCase()) ?? [];
+
+    const years = new Set<number>();
+    for (const modelIndex of candidates) {
+      for (
+        let i = this.lowerBound(makeIndex, modelIndex);
+        i < this.entries.length && this.entries[i] === makeIndex && this.entries[i + 1] === modelIndex;
+        i += ENTRY_STRIDE
+      ) {
+        const to = this.entries[i + 3] || this.openYear;
+        for (let year = this.entries[i + 2]; year <= to; year++) {
+          years.add(year);
+        }
+      }
+    }
+    return [...years].sort((a, b) => a - b);
+  }
+
+  private resolveMake(make: number | string): number | undefined {
+    return typeof make === 'number' ? this.makeIds.get(make) : this.makeNames.get(make.toUpperCase());
+  }
+
+  private covers(entry: number, year: number): boolean {
+    return year >= this.entries[entry + 2] && year <= (this.entries[entry + 3] || this.openYear);
+  }
+
+  /**
+   * Offset of the first entry at or after (make, model)
+   */
+  private lowerBound(make: number, model: number): number {
+    let low = 0;
+    let high = this.entries.length / ENTRY_STRIDE;
+    while (low < high) {
+      const mid = (low + high) >> 1;
+      const at = mid * ENTRY_STRIDE;
+      if (this.entries[at] < make || (this.entries[at] === make && this.entries[at + 1] < model)) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low * ENTRY_STRIDE;
+  }
+}
@@ -1,20 +1,60 @@
 import { DatabaseAdapter } from "./adapter";
-import type { D1Database } from "@cloudflare/workers-types";
+import type { D1Database, D1PreparedStatement, D1Result } from "@cloudflare/workers-types";
 import type { QueryResult } from "./adapter";
+import { HotIndex, IndexedDatabaseAdapter } from "./hot-index";
+import type { HotIndexData, HotIndexStats } from "./hot-index";
+import { MatchKernel } from "./match-kernel";
+import type { MatchKernelOptions, MatchKernelStats } from "./match-kernel";
+
+export { HotIndex, IndexedDatabaseAdapter, MatchKernel };
+export type { HotIndexData, HotIndexStats, MatchKernelOptions, MatchKernelStats };
+
+/**
+ * Options for the D1 adapter factory
+ */
+export interface D1AdapterOptions {
+  /**
+   * Compiled hot-WMI index (from scripts/build-hot-index.ts) bundled with the
+   * Worker. WMIs it covers decode without touching D1.
+   */
+  hotIndex?: HotIndexData;
+
+  /**
+   * WebAssembly SIMD matcher for VDS patterns. Workers cannot compile
+   * WebAssembly from bytes, so create it from the bundled module:
+   * `MatchKernel.create(kernelModule)` with `import kernelModule from
+   * "@cardog/corgi/match-kernel.wasm"`.
+   */
+  matchKernel?: MatchKernel | null;
+
+  /**
+   * Send queries issued together (e.g. by concurrent decodes in a decode
+   * stream) to D1 as one `batch()` round trip instead of one request each
+   */
+  batchQueries?: boolean;
+}
+
+interface QueuedQuery {
+  statement: D1PreparedStatement;
+  resolve: (result: D1Result) => void;
+  reject: (error: unknown) => void;
+}
 
 export class CloudflareD1Adapter implements DatabaseAdapter {
   private db: D1Database;
+  private batchQueries: boolean;
+  private queued: QueuedQuery[] | null = null;
+  kernel?: MatchKernel;
 
-  constructor(db: D1Database) {
+  constructor(db: D1Database, options: { batchQueries?: boolean } = {}) {
     this.db = db;
+    this.batchQueries = options.batchQueries ?? false;
   }
 
   async exec(query: string, params: any[] = []): Promise<QueryResult[]> {
     try {
-      const result = await this.db
-        .prepare(query)
-        .bind(...params)
-        .all();
+      const statement = this.db.prepare(query).bind(...params);
+      const result = this.batchQueries ? await this.enqueue(statement) : await statement.all();
 
       // Transform the D1 result format to match your expected QueryResult format
       return [
@@ -33,9 +73,54 @@ export class CloudflareD1Adapter implements DatabaseAdapter {
     // D1 connections are managed by Cloudflare, no explicit close needed
     return;
   }
+
+  /**
+   * Queue a statement for the next batch, sent once the current task yields
+   */
+  private enqueue(statement: D1PreparedStatement): Promise<D1Result> {
+    return new Promise((resolve, reject) => {
+      if (!this.queued) {
+        this.queued = [];
+        setTimeout(() => this.flush(), 0);
+      }
+      this.queued.push({ statement, resolve, reject });
+    });
+  }
+
+  private async flush(): Promise<void> {
+    const queued = this.queued ?? [];
+    this.queued = null;
+    if (queued.length === 1) {
+      queued[0].statement.all().then(queued[0].resolve, queued[0].reject);
+      return;
+    }
+
+    try {
+      const results = await this.db.batch(queued.map((query) => query.statement));
+      queued.forEach((query, i) => query.resolve(results[i]));
+    } catch {
+      // A batch fails as a whole; retry separately so only the failing query rejects
+      for (const query of queued) {
+        query.statement.all().then(query.resolve, query.reject);
+      }
+    }
+  }
 }
 
+// Compiled indexes are reused across adapters created from the same data
+const hotIndexes = new WeakMap<HotIndexData, HotIndex>();
+
 // Factory function to create the adapter
-export function createD1Adapter(db: D1Database): DatabaseAdapter {
-  return new CloudflareD1Adapter(db);
+export function createD1Adapter(db: D1Database, options: D1AdapterOptions = {}): DatabaseAdapter {
+  const adapter = new CloudflareD1Adapter(db, { batchQueries: options.batchQueries });
+  adapter.kernel = options.matchKernel ?? undefined;
+  if (options.hotIndex) {
+    let index = hotIndexes.get(options.hotIndex);
+    if (!index) {
+      index = new HotIndex(options.hotIndex);
+      hotIndexes.set(options.hotIndex, index);
+    }
+    return new IndexedDatabaseAdapter(index, adapter);
+  }
+  return adapter;
 }
@@ -0,0 +1,420 @@
+import { createHash } from 'crypto';
+import { constants, createReadStream, existsSync, promises as fs } from 'fs';
+import { join } from 'path';
+import { gunzipSync, gzipSync } from 'zlib';
+import { createLogger } from '../logger';
+import { httpRequest } from './http-request';
+
+const logger = createLogger('DbDelta');
+
+/** Patch file magic */
+const MAGIC = 'CORGIDLT';
+
+/** Fixed header: magic, format version, page size, from/to sizes, from/to SHA-256, page count */
+const HEADER_SIZE = 8 + 4 + 4 + 8 + 8 + 32 + 32 + 4;
+
+/** Per-page record prefix: page number and SHA-1 of the page it replaces */
+const RECORD_PREFIX = 4 + 20;
+
+/** SHA-1 recorded for pages that did not exist in the old file */
+const NO_PAGE = Buffer.alloc(20);
+
+/** Age after which a lock file is treated as left behind by a crashed process */
+const LOCK_STALE_MS = 5 * 60 * 1000;
+
+/**
+ * One patch between two consecutive database versions
+ */
+export interface DeltaEntry {
+  /** SHA-256 of the database the patch applies to */
+  from: string;
+  /** SHA-256 of the database the patch produces */
+  to: string;
+  /** Patch file name, relative to the manifest */
+  file: string;
+  /** SHA-256 of the patch file */
+  sha256: string;
+  /** Patch file size in bytes */
+  bytes: number;
+  /** Pages the patch rewrites */
+  pages: number;
+}
+
+/**
+ * Chain of patches published next to the full database
+ */
+export interface DeltaManifest {
+  /** Format version */
+  version: 1;
+  /** SHA-256 of the latest database */
+  latest: string;
+  /** Patches, oldest first */
+  deltas: DeltaEntry[];
+}
+
+/**
+ * Result of comparing two database files
+ */
+export interface DeltaBuild {
+  /** Compressed patch */
+  patch: Buffer;
+  from: string;
+  to: string;
+  pageSize: number;
+  /** Pages that differ */
+  pages: number;
+  /** Pages in the new file */
+  totalPages: number;
+}
+
+/**
+ * Result of bringing a database up to date
+ */
+export interface DeltaUpdateResult {
+  /** Patches applied (0 when already current or no chain was found) */
+  applied: number;
+  /** SHA-256 of the database afterwards */
+  version: string;
+  /** Bytes of patches read */
+  bytes: number;
+}
+
+/**
+ * SHA-256 of a file
+ *
+ * @param path - File path
+ * @returns Hex digest
+ */
+export async function hashFile(path: string): Promise<string> {
+  const hash = createHash('sha256');
+  for await (const chunk of createReadStream(path)) {
+    hash.update(chunk);
+  }
+  return hash.digest('hex');
+}
+
+/**
+ * SHA-256 of a database, memoized in a `.sha256` sidecar keyed by size and mtime
+ *
+ * @param dbPath - Database path
+ * @returns Hex digest
+ */
+export async function getDatabaseHash(dbPath: string): Promise<string> {
+  const stat = await fs.stat(dbPath);
+  const sidecar = `${dbPath}.sha256`;
+  try {
+    const cached = JSON.parse(await fs.readFile(sidecar, 'utf-8'));
+    if (cached.size === stat.size && cached.mtimeMs === stat.mtimeMs) {
+      return cached.sha256;
+    }
+  } catch {
+    // Missing or unreadable; recompute
+  }
+
+  const sha256 = await hashFile(dbPath);
+  await writeSidecar(dbPath, sha256);
+  return sha256;
+}
+
+async function writeSidecar(dbPath: string, sha256: string): Promise<void> {
+  const stat = await fs.stat(dbPath);
+  await fs.writeFile(`${dbPath}.sha256`, JSON.stringify({ sha256, size: stat.size, mtimeMs: stat.mtimeMs }));
+}
+
+/**
+ * Page size from a SQLite header (falls back to 4096 for other files)
+ */
+function readPageSize(header: Buffer): number {
+  if (header.length < 18 || header.toString('latin1', 0, 15) !== 'SQLite format 3') {
+    return 4096;
+  }
+  const size = header.readUInt16BE(16);
+  return size === 1 ? 65536 : size;
+}
+
+/**
+ * Compare two database versions page by page and build a patch
+ *
+ * Each changed page is stored whole together with a SHA-1 of the page it
+ * replaces, so applying a patch to the wrong file fails on the first page
+ * instead of corrupting it.
+ *
+ * @param fromPath - Previous database
+ * @param toPath - New database
+ * @returns Compressed patch and statistics
+ */
+export async function createDelta(fromPath: string, toPath: string): Promise<DeltaBuild> {
+  const [before, after] = await Promise.all([fs.readFile(fromPath), fs.readFile(toPath)]);
+  const pageSize = readPageSize(after);
+  const totalPages = Math.ceil(after.length / pageSize);
+
+  const records: Buffer[] = [];
+  for (let page = 0; page < totalPages; page++) {
+    const start = page * pageSize;
+    const next = after.subarray(start, start + pageSize);
+    const previous = before.subarray(start, Math.min(start + pageSize, before.length));
+    if (previous.length === next.length && previous.equals(next)) {
+      continue;
+    }
+
+    const prefix = Buffer.alloc(RECORD_PREFIX);
+    prefix.writeUInt32BE(page, 0);
+    (previous.length > 0 ? createHash('sha1').update(previous).digest() : NO_PAGE).copy(prefix, 4);
+    records.push(prefix, next);
+  }
+
+  const from = createHash('sha256').update(before).digest('hex');
+  const to = createHash('sha256').update(after).digest('hex');
+
+  const header = Buffer.alloc(HEADER_SIZE);
+  header.write(MAGIC, 0, 'latin1');
+  header.writeUInt32BE(1, 8);
+  header.writeUInt32BE(pageSize, 12);
+  header.writeBigUInt64BE(BigInt(before.length), 16);
+  header.writeBigUInt64BE(BigInt(after.length), 24);
+  Buffer.from(from, 'hex').copy(header, 32);
+  Buffer.from(to, 'hex').copy(header, 64);
+  header.writeUInt32BE(records.length / 2, 96);
+
+  return {
+    patch: gzipSync(Buffer.concat([header, ...records]), { level: 9 }),
+    from,
+    to,
+    pageSize,
+    pages: records.length / 2,
+    totalPages,
+  };
+}
+
+/**
+ * Apply one decompressed patch to an open file
+ */
+async function applyPatch(file: fs.FileHandle, patch: Buffer, expectedFrom: string): Promise<string> {
+  if (patch.toString('latin1', 0, 8) !== MAGIC || patch.readUInt32BE(8) !== 1) {
+    throw new Error('Not a corgi delta patch');
+  }
+  const pageSize = patch.readUInt32BE(12);
+  const fromSize = Number(patch.readBigUInt64BE(16));
+  const toSize = Number(patch.readBigUInt64BE(24));
+  const from = patch.toString('hex', 32, 64);
+  const to = patch.toString('hex', 64, 96);
+  const count = patch.readUInt32BE(96);
+
+  if (from !== expectedFrom) {
+    throw new Error(`Delta applies to ${from.slice(0, 12)}, database is ${expectedFrom.slice(0, 12)}`);
+  }
+  if ((await file.stat()).size !== fromSize) {
+    throw new Error(`Delta expects a ${fromSize} byte database`);
+  }
+
+  const existing = Buffer.alloc(pageSize);
+  let offset = HEADER_SIZE;
+  for (let i = 0; i < count; i++) {
+    const page = patch.readUInt32BE(offset);
+    const oldHash = patch.subarray(offset + 4, offset + RECORD_PREFIX);
+    const position = page * pageSize;
+    const length = Math.min(pageSize, toSize - position);
+    const data = patch.subarray(offset + RECORD_PREFIX, offset + RECORD_PREFIX + length);
+    offset += RECORD_PREFIX + length;
+
+    if (!oldHash.equals(NO_PAGE)) {
+      const { bytesRead } = await file.read(existing, 0, Math.min(pageSize, fromSize - position), position);
+      if (!createHash('sha1').update(existing.subarray(0, bytesRead)).digest().equals(oldHash)) {
+        throw new Error(`Delta page ${page} does not match the database`);
+      }
+    }
+    await file.write(data, 0, data.length, position);
+  }
+
+  await file.truncate(toSize);
+  return to;
+}
+
+/**
+ * Read a manifest or patch from a directory or an HTTP(S) base URL
+ */
+async function readSource(source: string, name: string): Promise<Buffer> {
+  if (/^https?:\/\//.test(source)) {
+    const url = new URL(name, source.endsWith('/') ? source : `${source}/`);
+    const response = await httpRequest(url);
+    if (response.status < 200 || response.status >= 300) {
+      throw new Error(`Failed to fetch ${url}: ${response.status}`);
+    }
+    return response.body;
+  }
+  return fs.readFile(join(source, name));
+}
+
+/**
+ * Take an exclusive lock file, waiting while another thread or process holds it
+ *
+ * @returns Function releasing the lock
+ */
+export async function acquireLock(lockPath: string): Promise<() => Promise<void>> {
+  for (;;) {
+    try {
+      const handle = await fs.open(lockPath, 'wx');
+      await handle.writeFile(String(process.pid));
+      await handle.close();
+      return () => fs.rm(lockPath, { force: true });
+    } catch (error) {
+      if ((error as NodeJS.ErrnoException).code !== 'EEXIST') {
+        throw error;
+      }
+      const stat = await fs.stat(lockPath).catch(() => null);
+      if (stat && Date.now() - stat.mtimeMs > LOCK_STALE_MS) {
+        logger.warn({ lockPath }, 'Removing stale lock');
+        await fs.rm(lockPath, { force: true });
+      } else {
+        await new Promise(resolve => setTimeout(resolve, 50));
+      }
+    }
+  }
+}
+
+/**
+ * Find the patches leading from a version to the latest
+ *
+ * @param manifest - Delta manifest
+ * @param from - SHA-256 of the current database
+ * @returns Patches in order (empty when current), or null if no chain starts at `from`
+ */
+export function planDeltaChain(manifest: DeltaManifest, from: string): DeltaEntry[] | null {
+  const chain: DeltaEntry[] = [];
+  let version = from;
+  while (version !== manifest.latest) {
+    const next = manifest.deltas.find(delta => delta.from === version);
+    if (!next || chain.includes(next)) {
+      return null;
+    }
+    chain.push(next);
+    version = next.to;
+  }
+  return chain;
+}
+
+/**
+ * Bring a database up to the latest version by applying a chain of patches
+ *
+ * Patches are applied to a copy of the database (a reflink where the file
+ * system supports it) that replaces the original with a single rename once
+ * every patch has applied, so readers never see a partly patched file. Only
+ * the pages a patch changes are read and written. A lock file beside the
+ * database serializes updates from concurrent threads and processes; a
+ * caller that waited finds the database already current.
+ *
+ * @param dbPath - Database to update
+ * @param source - Directory or HTTP(S) base URL holding `manifest.json` and the patches
+ * @param options - Set `verify` to re-hash the whole result against the manifest
+ * @returns What was applied
+ * @throws Error if a patch is corrupt or does not match the database; the database is left unchanged
+ */
+export async function applyDeltas(
+  dbPath: string,
+  source: string,
+  options: { verify?: boolean } = {},
+): Promise<DeltaUpdateResult> {
+  const manifest: DeltaManifest = JSON.parse((await readSource(source, 'manifest.json')).toString('utf-8'));
+  if (manifest.version !== 1) {
+    throw new Error(`Unsupported delta manifest version: ${manifest.version}`);
+  }
+
+  const release = await acquireLock(`${dbPath}.lock`);
+  try {
+    return await applyDeltaChain(dbPath, source, manifest, options);
+  } finally {
+    await release();
+  }
+}
+
+/**
+ * Apply the patches leading from the database's version to the manifest's latest
+ */
+async function applyDeltaChain(
+  dbPath: string,
+  source: string,
+  manifest: DeltaManifest,
+  options: { verify?: boolean },
+): Promise<DeltaUpdateResult> {
+  const current = await getDatabaseHash(dbPath);
+  const chain = planDeltaChain(manifest, current);
+  if (!chain || chain.length === 0) {
+    if (!chain) {
+      logger.debug({ version: current }, 'No delta chain from the cached database');
+    }
+    return { applied: 0, version: current, bytes: 0 };
+  }
+
+  // Fetch and check every patch before touching the database
+  const patches: Buffer[] = [];
+  let bytes = 0;
+  for (const delta of chain) {
+    const data = await readSource(source, delta.file);
+    if (createHash('sha256').update(data).digest('hex') !== delta.sha256) {
+      throw new Error(`Checksum mismatch for ${delta.file}`);
+    }
+    bytes += data.length;
+    patches.push(gunzipSync(data));
+  }
+
+  // Pool and bulk workers share a process, so the temporary name needs more than the pid
+  const tmpPath = `${dbPath}.${process.pid}.${Math.random().toString(36).slice(2)}.delta-tmp`;
+  await fs.copyFile(dbPath, tmpPath, constants.COPYFILE_FICLONE);
+  try {
+    let version = current;
+    const file = await fs.open(tmpPath, 'r+');
+    try {
+      for (const patch of patches) {
+        version = await applyPatch(file, patch, version);
+      }
+      await file.sync();
+    } finally {
+      await file.close();
+    }
+
+    if (options.verify && (await hashFile(tmpPath)) !== version) {
+      throw new Error('Patched database does not match the manifest');
+    }
+
+    await fs.rename(tmpPath, dbPath);
+    await writeSidecar(dbPath, version);
+    logger.debug({ from: current, to: version, patches: chain.length, bytes }, 'Applied database deltas');
+    return { applied: chain.length, version, bytes };
+  } catch (error) {
+    await fs.rm(tmpPath, { force: true });
+    throw error;
+  }
+}
+
+/**
+ * Add a patch to a delta directory and make its target the latest version
+ *
+ * @param dir - Delta directory (created if missing)
+ * @param build - Patch from createDelta
+ * @returns Updated manifest
+ */
+export async function publishDelta(dir: string, build: DeltaBuild): Promise<DeltaManifest> {
+  await fs.mkdir(dir, { recursive: true });
+  const manifestPath = join(dir, 'manifest.json');
+  const manifest: DeltaManifest = existsSync(manifestPath)
+    ? JSON.parse(await fs.readFile(manifestPath, 'utf-8'))
+    : { version: 1, latest: build.to, deltas: [] };
+
+  const file = `${build.from.slice(0, 16)}-${build.to.slice(0, 16)}.delta.gz`;
+  await fs.writeFile(join(dir, file), build.patch);
+
+  manifest.deltas = manifest.deltas.filter(delta => delta.from !== build.from);
+  manifest.deltas.push({
+    from: build.from,
+    to: build.to,
+    file,
+    sha256: createHash('sha256').update(build.patch).digest('hex'),
+    bytes: build.patch.length,
+    pages: build.pages,
+  });
+  manifest.latest = build.to;
+
+  await fs.writeFile(`${manifestPath}.tmp`, JSON.stringify(manifest, null, 2));
+  await fs.rename(`${manifestPath}.tmp`, manifestPath);
+  return manifest;
+}
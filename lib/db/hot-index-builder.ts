@@ -0,0 +1,170 @@
+import type { DatabaseAdapter } from './adapter';
+import { VPICDatabase } from '../db';
+import type { HotIndexData, HotIndexElement, HotIndexPatternRow } from './hot-index';
+
+/** Largest id list sent in one lookup query (SQLite parameter limit is 999 on old builds) */
+const LOOKUP_CHUNK_SIZE = 500;
+
+/**
+ * Options for compiling a hot-WMI index
+ */
+export interface HotIndexBuildOptions {
+  /** Version of the source database, recorded in the index */
+  dbVersion?: string;
+}
+
+/**
+ * Compile WMI info, schemas, patterns and resolved lookups for a set of WMIs
+ *
+ * The same VPICDatabase queries used at decode time are run once here, so the
+ * resulting index answers exactly what the database would. VDS class tables
+ * are included when the database has them.
+ *
+ * @param adapter - Adapter for the full database
+ * @param wmis - WMIs to include
+ * @param options - Build options
+ * @returns Serializable index data
+ */
+export async function compileHotIndex(
+  adapter: DatabaseAdapter,
+  wmis: string[],
+  options: HotIndexBuildOptions = {},
+): Promise<HotIndexData> {
+  const db = new VPICDatabase(adapter);
+  const data: HotIndexData = {
+    version: 1,
+    dbVersion: options.dbVersion,
+    elements: [],
+    wmis: {},
+    schemas: {},
+    lookups: {},
+  };
+
+  const elementIndex = new Map<string, number>();
+  const lookupIds = new Map<string, Set<string>>();
+
+  for (const wmi of wmis) {
+    const info = await db.getWMI(wmi);
+    const ranges = info ? await db.getSchemaYearRanges(wmi) : [];
+
+    data.wmis[wmi] = {
+      info,
+      schemas: ranges.map(r => [r.SchemaId, r.SchemaName, r.YearFrom, r.YearTo ?? null]),
+    };
+
+    for (const { SchemaId } of ranges) {
+      if (data.schemas[SchemaId]) continue;
+
+      const rows = await db.getPatterns([SchemaId]);
+      data.schemas[SchemaId] = rows.map(row => {
+        const element: HotIndexElement = [
+          row.ElementId ?? null,
+          row.ElementName,
+          row.ElementCode ?? null,
+          row.GroupName ?? null,
+          row.Description ?? null,
+          row.LookupTable ?? null,
+          row.ElementWeight ?? null,
+        ];
+        const key = JSON.stringify(element);
+        let index = elementIndex.get(key);
+        if (index === undefined) {
+          index = data.elements.length;
+          data.elements.push(element);
+          elementIndex.set(key, index);
+        }
+
+        if (row.LookupTable && row.AttributeId !== null && row.AttributeId !== undefined) {
+          if (!lookupIds.has(row.LookupTable)) {
+            lookupIds.set(row.LookupTable, new Set());
+          }
+          lookupIds.get(row.LookupTable)!.add(String(row.AttributeId));
+        }
+
+        return [row.Pattern, index, row.AttributeId ?? null, row.SchemaName, row.YearFrom, row.YearTo ?? null] as HotIndexPatternRow;
+      });
+    }
+  }
+
+  const schemaIds = Object.keys(data.schemas).map(Number);
+  const classTables = schemaIds.length > 0 ? await db.getVdsClassTablesBySchema(schemaIds) : undefined;
+  if (classTables) {
+    data.vdsClasses = {};
+    schemaIds.forEach((id, i) => (data.vdsClasses![id] = classTables[i]));
+  }
+
+  for (const [table, idSet] of lookupIds) {
+    const ids = [...idSet];
+    const values: Record<string, string | null> = {};
+
+    for (let i = 0; i < ids.length; i += LOOKUP_CHUNK_SIZE) {
+      const chunk = ids.slice(i, i + LOOKUP_CHUNK_SIZE);
+      const resolved = await db.lookupValues(table, chunk);
+      for (const id of chunk) {
+        values[id] = resolved.get(id) ?? null;
+      }
+    }
+
+    data.lookups[table] = values;
+  }
+
+  return data;
+}
+
+/**
+ * Merge an index compiled for more WMIs into an existing one from the same database
+ *
+ * @param base - Existing index
+ * @param addition - Index compiled for further WMIs
+ * @returns New index covering the WMIs of both
+ */
+export function mergeHotIndex(base: HotIndexData, addition: HotIndexData): HotIndexData {
+  const elements = [...base.elements];
+  const elementIndex = new Map(elements.map((element, index) => [JSON.stringify(element), index]));
+  const remap = addition.elements.map(element => {
+    const key = JSON.stringify(element);
+    let index = elementIndex.get(key);
+    if (index === undefined) {
+      index = elements.length;
+      elements.push(element);
+      elementIndex.set(key, index);
+    }
+    return index;
+  });
+
+  const schemas = { ...base.schemas };
+  for (const [id, rows] of Object.entries(addition.schemas)) {
+    if (schemas[id]) continue;
+    schemas[id] = rows.map(([pattern, element, ...rest]) => [pattern, remap[element], ...rest] as HotIndexPatternRow);
+  }
+
+  const lookups = { ...base.lookups };
+  for (const [table, values] of Object.entries(addition.lookups)) {
+    lookups[table] = { ...lookups[table], ...values };
+  }
+
+  const merged: HotIndexData = {
+    version: 1,
+    dbVersion: base.dbVersion ?? addition.dbVersion,
+    elements,
+    wmis: { ...base.wmis, ...addition.wmis },
+    schemas,
+    lookups,
+  };
+  if (base.vdsClasses || addition.vdsClasses) {
+    merged.vdsClasses = { ...base.vdsClasses, ...addition.vdsClasses };
+  }
+  return merged;
+}
+
+/**
+ * Serialized size of each section of an index, in bytes
+ */
+export function measureHotIndex(data: HotIndexData): Record<string, number> {
+  const sizes: Record<string, number> = {};
+  for (const [section, value] of Object.entries(data)) {
+    sizes[section] = JSON.stringify(value)?.length ?? 0;
+  }
+  sizes.total = JSON.stringify(data).length;
+  return sizes;
+}
@@ -0,0 +1,237 @@
+import type { DatabaseAdapter, QueryResult, VPICIndex } from './adapter';
+import type { WMIResult } from '../types';
+import type { MatchKernel } from './match-kernel';
+import type { VdsClassTable } from './vds-classes';
+
+/**
+ * Element columns shared by many pattern rows:
+ * [ElementId, ElementName, ElementCode, GroupName, Description, LookupTable, ElementWeight]
+ */
+export type HotIndexElement = [
+  number | null,
+  string,
+  string | null,
+  string | null,
+  string | null,
+  string | null,
+  number | null,
+];
+
+/**
+ * Compact pattern row: [Pattern, element index, AttributeId, SchemaName, YearFrom, YearTo]
+ */
+export type HotIndexPatternRow = [string, number, string | number | null, string, number, number | null];
+
+/**
+ * Serialized hot-WMI index, as produced by `scripts/build-hot-index.ts`
+ */
+export interface HotIndexData {
+  /** Format version */
+  version: 1;
+
+  /** Version of the database the index was compiled from */
+  dbVersion?: string;
+
+  /** Shared element definitions referenced by pattern rows */
+  elements: HotIndexElement[];
+
+  /** WMI info and schema year ranges: [SchemaId, SchemaName, YearFrom, YearTo] */
+  wmis: Record<string, { info: WMIResult | null; schemas: Array<[number, string, number, number | null]> }>;
+
+  /** Pattern rows per schema id */
+  schemas: Record<string, HotIndexPatternRow[]>;
+
+  /** Resolved lookup values per table; null marks ids known to be absent */
+  lookups: Record<string, Record<string, string | null>>;
+
+  /** Compiled VDS class tables per schema id, null where a schema has none (absent if the database has none) */
+  vdsClasses?: Record<string, VdsClassTable | null>;
+}
+
+/**
+ * Hit and miss counters for an index
+ */
+export interface HotIndexStats {
+  /** Lookups answered from the index */
+  hits: number;
+  /** Lookups that fell through to the database */
+  misses: number;
+}
+
+/**
+ * In-memory index over a compiled set of hot WMIs
+ */
+export class HotIndex implements VPICIndex {
+  private patternRows = new Map<number, any[]>();
+  private stats: HotIndexStats = { hits: 0, misses: 0 };
+
+  /**
+   * @param data - Compiled index data
+   */
+  constructor(private data: HotIndexData) {
+    if (data.version !== 1) {
+      throw new Error(`Unsupported hot index version: ${data.version}`);
+    }
+  }
+
+  /**
+   * Number of WMIs covered by this index
+   */
+  get size(): number {
+    return Object.keys(this.data.wmis).length;
+  }
+
+  /**
+   * Get index hit statistics
+   */
+  getStats(): HotIndexStats {
+    return { ...this.stats };
+  }
+
+  getWMI(wmi: string): WMIResult | null | undefined {
+    const entry = this.data.wmis[wmi];
+    return this.count(entry ? entry.info : undefined);
+  }
+
+  getValidSchemas(wmi: string, modelYear: number): Array<{ SchemaId: number; SchemaName: string }> | undefined {
+    const entry = this.data.wmis[wmi];
+    if (!entry) {
+      return this.count(undefined);
+    }
+
+    const seen = new Set<number>();
+    const schemas: Array<{ SchemaId: number; SchemaName: string }> = [];
+    for (const [id, name, from, to] of entry.schemas) {
+      if (modelYear >= from && (to === null || modelYear <= to) && !seen.has(id)) {
+        seen.add(id);
+        schemas.push({ SchemaId: id, SchemaName: name });
+      }
+    }
+
+    return this.count(schemas);
+  }
+
+  getYearRanges(wmi: string): Array<[number, number | null]> | undefined {
+    const entry = this.data.wmis[wmi];
+    return this.count(entry ? entry.schemas.map(([, , from, to]) => [from, to] as [number, number | null]) : undefined);
+  }
+
+  hasSchemas(schemaIds: number[]): boolean {
+    return schemaIds.every(id => this.data.schemas[id] !== undefined);
+  }
+
+  getPatterns(schemaIds: number[]): any[] | undefined {
+    if (!this.hasSchemas(schemaIds)) {
+      return this.count(undefined);
+    }
+
+    const rows: any[] = [];
+    for (const id of schemaIds) {
+      rows.push(...this.getSchemaRows(id));
+    }
+
+    return this.count(rows);
+  }
+
+  getVdsClassTables(schemaIds: number[]): VdsClassTable[] | null | undefined {
+    if (!this.hasSchemas(schemaIds)) {
+      return undefined;
+    }
+
+    const tables = schemaIds.map(id => this.data.vdsClasses?.[id] ?? null);
+    return tables.every(table => table !== null) ? (tables as VdsClassTable[]) : null;
+  }
+
+  lookupValues(tableName: string, ids: string[]): Map<string, string> | undefined {
+    const table = this.data.lookups[tableName];
+    if (!table || !ids.every(id => id in table)) {
+      return this.count(undefined);
+    }
+
+    const lookupMap = new Map<string, string>();
+    for (const id of ids) {
+      const name = table[id];
+      if (name !== null) {
+        lookupMap.set(id, name);
+      }
+    }
+
+    return this.count(lookupMap);
+  }
+
+  /**
+   * Expand a schema's compact rows into the objects returned by VPICDatabase.getPatterns
+   */
+  private getSchemaRows(schemaId: number): any[] {
+    let rows = this.patternRows.get(schemaId);
+    if (!rows) {
+      rows = this.data.schemas[schemaId].map(([pattern, elementIndex, attributeId, schemaName, yearFrom, yearTo]) => {
+        const [id, name, code, groupName, description, lookupTable, weight] = this.data.elements[elementIndex];
+        return {
+          Pattern: pattern,
+          ElementId: id,
+          ElementName: name,
+          ElementCode: code,
+          GroupName: groupName,
+          Description: description,
+          LookupTable: lookupTable,
+          AttributeId: attributeId,
+          SchemaName: schemaName,
+          YearFrom: yearFrom,
+          YearTo: yearTo,
+          ElementWeight: weight,
+        };
+      });
+      this.patternRows.set(schemaId, rows);
+    }
+    return rows;
+  }
+
+  private count<T>(value: T | undefined): T | undefined {
+    if (value === undefined) {
+      this.stats.misses++;
+    } else {
+      this.stats.hits++;
+    }
+    return value;
+  }
+}
+
+/**
+ * Adapter that answers from a precompiled index and falls back to another adapter
+ */
+export class IndexedDatabaseAdapter implements DatabaseAdapter {
+  readonly index: VPICIndex;
+  private fallbackQueries = 0;
+
+  /**
+   * @param index - Precompiled index
+   * @param fallback - Adapter used for anything the index does not cover
+   */
+  constructor(index: VPICIndex, private fallback: DatabaseAdapter) {
+    this.index = index;
+  }
+
+  /**
+   * Matching kernel of the fallback adapter
+   */
+  get kernel(): MatchKernel | undefined {
+    return this.fallback.kernel;
+  }
+
+  /**
+   * Number of queries sent to the fallback adapter
+   */
+  get fallbackQueryCount(): number {
+    return this.fallbackQueries;
+  }
+
+  async exec(query: string, params: any[] = []): Promise<QueryResult[]> {
+    this.fallbackQueries++;
+    return this.fallback.exec(query, params);
+  }
+
+  async close(): Promise<void> {
+    await this.fallback.close();
+  }
+}
@@ -0,0 +1,606 @@
+import { Worker } from 'worker_threads';
+import { createHash } from 'crypto';
+import {
+  existsSync,
+  mkdirSync,
+  readFileSync,
+  readdirSync,
+  renameSync,
+  statSync,
+  unlinkSync,
+  utimesSync,
+  writeFileSync,
+} from 'fs';
+import { join } from 'path';
+import { homedir } from 'os';
+import type { DatabaseAdapter, QueryResult, DatabaseAdapterFactory } from './adapter';
+import { httpRequest } from './http-request';
+import { createLogger } from '../logger';
+
+const logger = createLogger('HttpRangeDatabaseAdapter');
+
+/**
+ * Options for the HTTP Range database adapter
+ */
+export interface HttpRangeAdapterOptions {
+  /** Directory for the on-disk block cache (default: ~/.corgi-cache/remote) */
+  cacheDir?: string;
+
+  /** Size of a cached block in bytes, a multiple of the SQLite page size (default: 64KB) */
+  blockSize?: number;
+
+  /** Maximum number of blocks kept in memory (default: 256, i.e. 16MB) */
+  memoryBlocks?: number;
+
+  /** Maximum number of blocks kept on disk (default: 1024, i.e. 64MB) */
+  diskBlocks?: number;
+
+  /** Number of adjacent blocks fetched together with a missing block (default: 4) */
+  prefetchBlocks?: number;
+
+  /** Timeout for a single Range request in milliseconds (default: 30000) */
+  timeout?: number;
+
+  /** Extra headers sent with every request (e.g. authorization) */
+  headers?: Record<string, string>;
+}
+
+/**
+ * Counters describing how reads were served
+ */
+export interface RemotePageCacheStats {
+  /** Blocks served from memory */
+  memoryHits: number;
+  /** Blocks served from the on-disk cache */
+  diskHits: number;
+  /** Range requests issued */
+  requests: number;
+  /** Bytes downloaded */
+  bytesFetched: number;
+}
+
+const DEFAULT_CACHE_DIR = join(homedir(), '.corgi-cache', 'remote');
+
+// Shared state layout: [0] = status (0 pending, 1 ok, 2 error), [1] = byte length
+const STATUS_PENDING = 0;
+const STATUS_OK = 1;
+const STATUS_ERROR = 2;
+
+/**
+ * Worker source performing the actual HTTP requests. SQLite reads are synchronous, so the
+ * main thread posts a request and blocks on Atomics.wait until the worker fills the buffer.
+ */
+const RANGE_WORKER_SOURCE = /*js*/ `
+const { parentPort, workerData } = require('worker_threads');
+const http = require('http');
+const https = require('https');
+const state = new Int32Array(workerData.state);
+const data = new Uint8Array(workerData.data);
+
+function finish(status, length) {
+  Atomics.store(state, 1, length);
+  Atomics.store(state, 0, status);
+  Atomics.notify(state, 0);
+}
+
+function fail(message) {
+  const bytes = Buffer.from(String(message)).subarray(0, data.length);
+  data.set(bytes, 0);
+  finish(${STATUS_ERROR}, bytes.length);
+}
+
+parentPort.on('message', ({ url, start, end, headers }) => {
+  const client = url.startsWith('https:') ? https : http;
+  let done = false;
+  const req = client.get(url, { headers: { ...headers, Range: 'bytes=' + start + '-' + end } }, res => {
+    if (res.statusCode !== 206 && res.statusCode !== 200) {
+      res.resume();
+      done = true;
+      return fail('HTTP ' + res.statusCode + ' for bytes ' + start + '-' + end);
+    }
+    // Servers that ignore Range reply 200 with the whole file
+    let skip = res.statusCode === 200 ? start : 0;
+    const want = end - start + 1;
+    let offset = 0;
+    res.on('data', chunk => {
+      if (done) return;
+      if (skip > 0) {
+        if (chunk.length <= skip) {
+          skip -= chunk.length;
+          return;
+        }
+        chunk = chunk.subarray(skip);
+        skip = 0;
+      }
+      const n = Math.min(chunk.length, want - offset);
+      data.set(chunk.subarray(0, n), offset);
+      offset += n;
+      if (offset >= want) {
+        done = true;
+        res.destroy();
+        finish(${STATUS_OK}, offset);
+      }
+    });
+    res.on('end', () => {
+      if (done) return;
+      done = true;
+      finish(${STATUS_OK}, offset);
+    });
+    res.on('error', error => {
+      if (done) return;
+      done = true;
+      fail(error.message);
+    });
+  });
+  req.on('error', error => {
+    if (done) return;
+    done = true;
+    fail(error.message);
+  });
+});
+`;
+
+/**
+ * Synchronous Range reader backed by a helper worker thread
+ */
+class SyncRangeReader {
+  private worker!: Worker;
+  private state!: Int32Array;
+  private data!: Uint8Array;
+
+  /**
+   * @param url - URL of the remote file
+   * @param maxBytes - Largest range that will be requested
+   * @param headers - Extra request headers
+   * @param timeout - Per-request timeout in milliseconds
+   */
+  constructor(
+    private url: string,
+    private maxBytes: number,
+    private headers: Record<string, string>,
+    private timeout: number,
+  ) {
+    this.spawn();
+  }
+
+  /**
+   * Read an inclusive byte range, blocking the calling thread until it arrives
+   *
+   * @param start - First byte offset
+   * @param end - Last byte offset (inclusive)
+   * @returns The downloaded bytes
+   */
+  read(start: number, end: number): Uint8Array {
+    Atomics.store(this.state, 0, STATUS_PENDING);
+    this.worker.postMessage({ url: this.url, start, end, headers: this.headers });
+
+    if (Atomics.wait(this.state, 0, STATUS_PENDING, this.timeout) === 'timed-out') {
+      // The request is still running and would later write into the shared
+      // buffers under the next request; give it up along with its worker
+      void this.worker.terminate();
+      this.spawn();
+      throw new Error(`Range request timed out for bytes ${start}-${end}`);
+    }
+
+    const length = Atomics.load(this.state, 1);
+    if (Atomics.load(this.state, 0) === STATUS_ERROR) {
+      throw new Error(Buffer.from(this.data.subarray(0, length)).toString());
+    }
+
+    return this.data.slice(0, length);
+  }
+
+  /**
+   * Stop the helper worker
+   */
+  async close(): Promise<void> {
+    await this.worker.terminate();
+  }
+
+  private spawn(): void {
+    const stateBuffer = new SharedArrayBuffer(8);
+    const dataBuffer = new SharedArrayBuffer(this.maxBytes);
+    this.state = new Int32Array(stateBuffer);
+    this.data = new Uint8Array(dataBuffer);
+    this.worker = new Worker(RANGE_WORKER_SOURCE, {
+      eval: true,
+      workerData: { state: stateBuffer, data: dataBuffer },
+    });
+    this.worker.unref();
+  }
+}
+
+/**
+ * Bounded two-level (memory, disk) block cache over a remote file
+ */
+export class RemotePageCache {
+  private memory = new Map<number, Uint8Array>();
+  private disk = new Map<number, true>();
+  private dir: string;
+  private blockCount: number;
+  private stats: RemotePageCacheStats = { memoryHits: 0, diskHits: 0, requests: 0, bytesFetched: 0 };
+
+  /**
+   * @param reader - Synchronous range reader
+   * @param fileSize - Size of the remote file in bytes
+   * @param cacheKey - Identifies this version of the remote file on disk
+   * @param options - Cache sizing options
+   */
+  constructor(
+    private reader: { read(start: number, end: number): Uint8Array },
+    private fileSize: number,
+    cacheKey: string,
+    private options: Required<Pick<HttpRangeAdapterOptions, 'cacheDir' | 'blockSize' | 'memoryBlocks' | 'diskBlocks' | 'prefetchBlocks'>>,
+  ) {
+    this.blockCount = Math.ceil(fileSize / options.blockSize);
+    this.dir = join(options.cacheDir, cacheKey);
+
+    if (!existsSync(this.dir)) {
+      mkdirSync(this.dir, { recursive: true });
+    }
+
+    // Rebuild the disk index, oldest first so eviction order survives restarts
+    const entries = readdirSync(this.dir)
+      .filter(name => name.endsWith('.blk'))
+      .map(name => ({ index: parseInt(name, 10), mtime: statSync(join(this.dir, name)).mtimeMs }))
+      .filter(entry => !isNaN(entry.index))
+      .sort((a, b) => a.mtime - b.mtime);
+
+    for (const entry of entries) {
+      this.disk.set(entry.index, true);
+    }
+
+    logger.debug({ dir: this.dir, cachedBlocks: this.disk.size }, 'Remote page cache opened');
+  }
+
+  /**
+   * Copy bytes from the remote file into a buffer
+   *
+   * @param target - Destination buffer
+   * @param targetOffset - Offset in the destination buffer
+   * @param length - Number of bytes requested
+   * @param position - Offset in the remote file
+   * @returns Number of bytes copied
+   */
+  read(target: { set(array: ArrayLike<number>, offset: number): void }, targetOffset: number, length: number, position: number): number {
+    const { blockSize } = this.options;
+    const end = Math.min(position + length, this.fileSize);
+    let copied = 0;
+
+    for (let pos = position; pos < end; ) {
+      const index = Math.floor(pos / blockSize);
+      const block = this.getBlock(index);
+      const inBlock = pos - index * blockSize;
+      const n = Math.min(block.length - inBlock, end - pos);
+      target.set(block.subarray(inBlock, inBlock + n), targetOffset + copied);
+      copied += n;
+      pos += n;
+    }
+
+    return copied;
+  }
+
+  /**
+   * Get cache statistics
+   */
+  getStats(): RemotePageCacheStats {
+    return { ...this.stats };
+  }
+
+  /**
+   * Fetch a block from memory, disk or the network
+   *
+   * @param index - Block index
+   * @returns Block contents
+   */
+  private getBlock(index: number): Uint8Array {
+    const cached = this.memory.get(index);
+    if (cached) {
+      // Refresh LRU position
+      this.memory.delete(index);
+      this.memory.set(index, cached);
+      this.stats.memoryHits++;
+      return cached;
+    }
+
+    if (this.disk.has(index)) {
+      const path = this.blockPath(index);
+      try {
+        const block = new Uint8Array(readFileSync(path));
+        if (block.length !== this.blockLength(index)) {
+          throw new Error(`Cached block has ${block.length} bytes, expected ${this.blockLength(index)}`);
+        }
+        // Refresh LRU position, on disk too so it survives restarts
+        this.disk.delete(index);
+        this.disk.set(index, true);
+        this.touch(path);
+        this.remember(index, block);
+        this.stats.diskHits++;
+        return block;
+      } catch (error) {
+        logger.warn({ index, error }, 'Dropping unreadable cached block');
+        this.disk.delete(index);
+        try {
+          unlinkSync(path);
+        } catch {
+          // Already gone
+        }
+      }
+    }
+
+    return this.fetchRun(index);
+  }
+
+  /**
+   * Download a missing block together with the following uncached blocks
+   *
+   * @param index - First (missing) block index
+   * @returns Contents of the requested block
+   */
+  private fetchRun(index: number): Uint8Array {
+    const { blockSize, prefetchBlocks } = this.options;
+    let last = index;
+    while (
+      last + 1 < this.blockCount &&
+      last + 1 <= index + prefetchBlocks &&
+      !this.memory.has(last + 1) &&
+      !this.disk.has(last + 1)
+    ) {
+      last++;
+    }
+
+    const start = index * blockSize;
+    const end = Math.min((last + 1) * blockSize, this.fileSize) - 1;
+    const bytes = this.reader.read(start, end);
+    this.stats.requests++;
+    this.stats.bytesFetched += bytes.length;
+
+    if (bytes.length !== end - start + 1) {
+      throw new Error(`Short read for bytes ${start}-${end}: got ${bytes.length}`);
+    }
+
+    let requested: Uint8Array | undefined;
+    for (let i = index; i <= last; i++) {
+      const block = bytes.slice((i - index) * blockSize, Math.min((i - index + 1) * blockSize, bytes.length));
+      this.remember(i, block);
+      this.persist(i, block);
+      if (i === index) requested = block;
+    }
+
+    return requested!;
+  }
+
+  /**
+   * Add a block to the memory LRU, evicting the oldest one if full
+   */
+  private remember(index: number, block: Uint8Array): void {
+    this.memory.set(index, block);
+    if (this.memory.size > this.options.memoryBlocks) {
+      const oldest = this.memory.keys().next().value as number;
+      this.memory.delete(oldest);
+    }
+  }
+
+  /**
+   * Write a block to disk atomically, evicting the oldest one if full
+   */
+  private persist(index: number, block: Uint8Array): void {
+    try {
+      const path = this.blockPath(index);
+      const tmp = `${path}.${process.pid}.${Math.random().toString(36).slice(2)}.tmp`;
+      writeFileSync(tmp, block);
+      renameSync(tmp, path);
+      this.disk.set(index, true);
+
+      if (this.disk.size > this.options.diskBlocks) {
+        const oldest = this.disk.keys().next().value as number;
+        this.disk.delete(oldest);
+        unlinkSync(this.blockPath(oldest));
+      }
+    } catch (error) {
+      // The disk cache is an optimization; keep serving from memory
+      logger.warn({ index, error }, 'Failed to persist block');
+    }
+  }
+
+  /**
+   * Mark a cached block as recently used; the disk index is rebuilt from mtimes on restart
+   */
+  private touch(path: string): void {
+    try {
+      const now = new Date();
+      utimesSync(path, now, now);
+    } catch (error) {
+      logger.debug({ path, error }, 'Failed to refresh block mtime');
+    }
+  }
+
+  private blockLength(index: number): number {
+    return Math.min(this.options.blockSize, this.fileSize - index * this.options.blockSize);
+  }
+
+  private blockPath(index: number): string {
+    return join(this.dir, `${index}.blk`);
+  }
+}
+
+/**
+ * Minimal subset of the sql.js module used by this adapter
+ */
+interface SqlJsModule {
+  Database: new (data?: Uint8Array) => SqlJsDatabase;
+  FS?: any;
+}
+
+interface SqlJsDatabase {
+  exec(sql: string, params?: any[]): Array<{ columns: string[]; values: any[][] }>;
+  close(): void;
+}
+
+/**
+ * Node.js adapter that reads a remote SQLite file lazily over HTTP Range requests
+ *
+ * Pages are fetched on demand through sql.js and kept in a bounded memory and
+ * disk cache, so a fresh process can decode immediately without downloading
+ * the whole database first.
+ */
+export class HttpRangeDatabaseAdapter implements DatabaseAdapter {
+  private queryCount: number = 0;
+
+  /**
+   * @param db - sql.js database with the remote file attached
+   * @param cache - Block cache backing the remote file
+   * @param reader - Range reader to shut down on close
+   */
+  constructor(
+    private db: SqlJsDatabase,
+    private cache: RemotePageCache,
+    private reader: SyncRangeReader,
+  ) {}
+
+  /**
+   * Execute a SQL query with parameters
+   *
+   * @param query - SQL query to execute
+   * @param params - Parameters to bind to the query
+   * @returns Query results
+   */
+  async exec(query: string, params: any[] = []): Promise<QueryResult[]> {
+    this.queryCount++;
+    const queryId = this.queryCount;
+
+    try {
+      logger.debug({ queryId, query, paramCount: params.length }, 'Executing remote query');
+      const startTime = Date.now();
+
+      const results = this.db.exec(query, params);
+
+      logger.debug({ queryId, executionTime: Date.now() - startTime, ...this.cache.getStats() }, 'Query completed');
+
+      if (!results || results.length === 0) {
+        return [{ columns: [], values: [] }];
+      }
+
+      return results.map(result => ({ columns: result.columns, values: result.values }));
+    } catch (error) {
+      logger.error({ queryId, query, error }, 'Remote database query error');
+      throw error;
+    }
+  }
+
+  /**
+   * Get page cache statistics
+   */
+  getCacheStats(): RemotePageCacheStats {
+    return this.cache.getStats();
+  }
+
+  /**
+   * Close the database and stop the range reader
+   */
+  async close(): Promise<void> {
+    logger.debug('Closing remote database connection');
+    this.db.close();
+    await this.reader.close();
+  }
+}
+
+let remoteFileCounter = 0;
+
+/**
+ * Factory for creating HTTP Range database adapters
+ */
+export class HttpRangeDatabaseAdapterFactory implements DatabaseAdapterFactory {
+  private options: Required<Omit<HttpRangeAdapterOptions, 'headers'>> & { headers: Record<string, string> };
+
+  /**
+   * @param options - Cache and request options
+   */
+  constructor(options: HttpRangeAdapterOptions = {}) {
+    this.options = {
+      cacheDir: options.cacheDir ?? DEFAULT_CACHE_DIR,
+      blockSize: options.blockSize ?? 64 * 1024,
+      memoryBlocks: options.memoryBlocks ?? 256,
+      diskBlocks: options.diskBlocks ?? 1024,
+      prefetchBlocks: options.prefetchBlocks ?? 4,
+      timeout: options.timeout ?? 30000,
+      headers: options.headers ?? {},
+    };
+  }
+
+  /**
+   * Create a new database adapter for the given URL
+   *
+   * @param pathOrUrl - URL of an uncompressed SQLite file on a server supporting Range requests
+   * @returns Initialized database adapter
+   */
+  async createAdapter(pathOrUrl: string): Promise<DatabaseAdapter> {
+    logger.debug({ pathOrUrl }, 'Creating HTTP Range database adapter');
+
+    const head = await httpRequest(pathOrUrl, { method: 'HEAD', headers: this.options.headers });
+    if (head.status < 200 || head.status >= 300) {
+      throw new Error(`Failed to load database: ${head.status} ${head.statusText}`);
+    }
+
+    const fileSize = parseInt(head.headers['content-length'] || '', 10);
+    if (!fileSize) {
+      throw new Error('Remote database must report a Content-Length');
+    }
+    if ((head.headers['content-encoding'] || 'identity') !== 'identity') {
+      throw new Error('Remote database must be served uncompressed for Range requests');
+    }
+
+    // Key the disk cache by URL and version so a new upload never mixes with stale blocks
+    const version = head.headers.etag || head.headers['last-modified'] || '';
+    const cacheKey = createHash('sha256')
+      .update(`${pathOrUrl}\n${version}\n${fileSize}\n${this.options.blockSize}`)
+      .digest('hex')
+      .slice(0, 16);
+
+    const maxRange = this.options.blockSize * (this.options.prefetchBlocks + 1);
+    const reader = new SyncRangeReader(pathOrUrl, maxRange, this.options.headers, this.options.timeout);
+    const cache = new RemotePageCache(reader, fileSize, cacheKey, this.options);
+
+    try {
+      const db = await openRemoteDatabase(cache, fileSize);
+      logger.debug({ pathOrUrl, fileSize, cacheKey }, 'Remote database attached');
+      return new HttpRangeDatabaseAdapter(db, cache, reader);
+    } catch (error) {
+      await reader.close();
+      logger.error({ pathOrUrl, error }, 'Failed to create HTTP Range database adapter');
+      throw error;
+    }
+  }
+}
+
+/**
+ * Expose the page cache as a file in the sql.js virtual filesystem and attach it
+ *
+ * @param cache - Block cache backing the file
+ * @param fileSize - Size of the remote file
+ * @returns sql.js database with the remote tables visible unqualified
+ */
+async function openRemoteDatabase(cache: RemotePageCache, fileSize: number): Promise<SqlJsDatabase> {
+  const sqlJs = await import('sql.js');
+  const initSqlJs = (sqlJs as any).default ?? sqlJs;
+  const SQL: SqlJsModule = await initSqlJs();
+
+  if (!SQL.FS) {
+    throw new Error('The installed sql.js build does not expose its virtual filesystem');
+  }
+
+  const name = `corgi-remote-${++remoteFileCounter}.db`;
+  const node = SQL.FS.createFile('/', name, {}, true, false);
+  node.contents = new Uint8Array(0);
+  node.usedBytes = fileSize;
+  node.stream_ops = {
+    ...node.stream_ops,
+    read: (_stream: unknown, buffer: Int8Array, offset: number, length: number, position: number) =>
+      cache.read(buffer, offset, length, position),
+  };
+
+  // The main database stays empty, so unqualified table names resolve to the attachment
+  const db = new SQL.Database();
+  db.exec(`ATTACH DATABASE '/${name}' AS remote`);
+  return db;
+}
@@ -0,0 +1,51 @@
+import http from 'http';
+import https from 'https';
+import type { IncomingHttpHeaders } from 'http';
+
+/**
+ * Response of an HTTP request made with the Node.js `http`/`https` modules
+ */
+export interface HttpResponse {
+  status: number;
+  statusText: string;
+  headers: IncomingHttpHeaders;
+  body: Buffer;
+}
+
+/**
+ * Make an HTTP(S) request without relying on global `fetch`, which Node.js 16 lacks
+ *
+ * Redirects are followed (up to 5); the body is buffered in full.
+ *
+ * @param url - Request URL
+ * @param options - Method and extra headers
+ * @returns Status, headers and body
+ */
+export function httpRequest(
+  url: string | URL,
+  options: { method?: string; headers?: Record<string, string> } = {},
+  redirects = 5,
+): Promise<HttpResponse> {
+  const target = new URL(url);
+  const client = target.protocol === 'https:' ? https : http;
+
+  return new Promise((resolve, reject) => {
+    const req = client.request(target, { method: options.method ?? 'GET', headers: options.headers }, res => {
+      const status = res.statusCode ?? 0;
+      if (status >= 300 && status < 400 && res.headers.location && redirects > 0) {
+        res.resume();
+        httpRequest(new URL(res.headers.location, target), options, redirects - 1).then(resolve, reject);
+        return;
+      }
+
+      const chunks: Buffer[] = [];
+      res.on('data', (chunk: Buffer) => chunks.push(chunk));
+      res.on('end', () =>
+        resolve({ status, statusText: res.statusMessage ?? '', headers: res.headers, body: Buffer.concat(chunks) }),
+      );
+      res.on('error', reject);
+    });
+    req.on('error', reject);
+    req.end();
+  });
+}
@@ -0,0 +1,328 @@
+import { promises as fs } from 'fs';
+import type { DatabaseAdapter, QueryResult, VPICIndex } from './adapter';
+import type { WMIResult } from '../types';
+import type { MatchKernel } from './match-kernel';
+import type { VdsClassTable } from './vds-classes';
+import { HotIndex } from './hot-index';
+import type { HotIndexData } from './hot-index';
+import { compileHotIndex, mergeHotIndex } from './hot-index-builder';
+import { acquireLock, getDatabaseHash } from './delta';
+import { getPackageVersion } from './utils';
+import { createLogger } from '../logger';
+
+const logger = createLogger('IndexCache');
+
+/** Layout of the cache file; bump when it changes */
+const FORMAT_VERSION = 1;
+
+/** Characters a WMI can hold */
+const WMI_SHAPE = /^[0-9A-HJ-NPR-Z]{3}$/;
+
+/** WMIs remembered as absent from the database before the list is reset */
+const MAX_UNKNOWN_WMIS = 10000;
+
+/**
+ * Options for the compiled index cache
+ */
+export interface IndexCacheOptions {
+  /** Cache file (default: next to the database, `<database>.index.json`) */
+  path?: string;
+
+  /** Most WMIs kept in the cache; later WMIs are queried as usual (default: 500) */
+  maxWmis?: number;
+
+  /** Delay after the first uncovered WMI before the cache is rebuilt, in milliseconds (default: 5000) */
+  writeDelay?: number;
+}
+
+/**
+ * Identifies the database and code a cache file was built by
+ */
+export interface IndexCacheKey {
+  format: number;
+  corgiVersion: string;
+  dbHash: string;
+}
+
+/**
+ * Counters describing the compiled index cache
+ */
+export interface IndexCacheStats {
+  /** WMIs in the loaded or last written cache */
+  wmis: number;
+  /** Whether a cache file was loaded at startup */
+  loaded: boolean;
+  /** Cache files written by this process */
+  writes: number;
+  /** Lookups answered from the cache */
+  hits: number;
+  /** Lookups that fell through to the database */
+  misses: number;
+}
+
+interface IndexCacheFile {
+  key: IndexCacheKey;
+  index: HotIndexData;
+}
+
+function sameKey(a: IndexCacheKey, b: IndexCacheKey): boolean {
+  return a.format === b.format && a.corgiVersion === b.corgiVersion && a.dbHash === b.dbHash;
+}
+
+/**
+ * Adapter that keeps the WMIs a process decodes compiled in a file next to the database
+ *
+ * Decoders otherwise rebuild WMI info, schema year ranges, pattern rows and
+ * lookup values from SQL for every WMI after each restart. This adapter
+ * answers from a hot index (see HotIndex) loaded from the cache file, records
+ * the WMIs it cannot answer, and some time after the first one compiles those
+ * WMIs, merges them into the index and replaces the file with one rename.
+ * WMIs the database does not know are left out, so malformed input cannot
+ * use up `maxWmis`. Restarts then start with the WMIs of earlier runs already
+ * in memory.
+ *
+ * The file is keyed by the database checksum and corgi version; a file built
+ * for another database or release is ignored and rebuilt. Pool and bulk
+ * workers each open their own adapter on the same file, so every write takes
+ * a lock file beside it and merges in what other writers added since this
+ * adapter last read it. Closing the adapter writes any pending WMIs first.
+ */
+export class IndexCacheAdapter implements DatabaseAdapter {
+  private current?: HotIndex;
+  private data?: HotIndexData;
+  private covered = new Set<string>();
+  private wanted = new Set<string>();
+  private unknown = new Set<string>();
+  private timer?: ReturnType<typeof setTimeout>;
+  private writing?: Promise<void>;
+  private loaded = false;
+  private writes = 0;
+  private readonly path: string;
+  private readonly maxWmis: number;
+  private readonly writeDelay: number;
+
+  /**
+   * Use `IndexCacheAdapter.open`, which loads the cache file
+   *
+   * @param inner - Adapter for the database
+   * @param key - Database checksum and corgi version the cache belongs to
+   * @param path - Cache file
+   * @param options - Cache options
+   */
+  constructor(
+    private inner: DatabaseAdapter,
+    private key: IndexCacheKey,
+    path: string,
+    options: IndexCacheOptions = {},
+  ) {
+    this.path = path;
+    this.maxWmis = options.maxWmis ?? 500;
+    this.writeDelay = options.writeDelay ?? 5000;
+  }
+
+  /**
+   * Open the cache for a database, loading the cache file if it matches
+   *
+   * @param inner - Adapter for the database
+   * @param dbPath - Database file, used for the checksum and default cache path
+   * @param options - Cache options
+   * @returns Adapter answering from the cache and falling back to `inner`
+   */
+  static async open(inner: DatabaseAdapter, dbPath: string, options: IndexCacheOptions = {}): Promise<IndexCacheAdapter> {
+    const key: IndexCacheKey = {
+      format: FORMAT_VERSION,
+      corgiVersion: getPackageVersion(),
+      dbHash: await getDatabaseHash(dbPath),
+    };
+    const adapter = new IndexCacheAdapter(inner, key, options.path ?? `${dbPath}.index.json`, options);
+    await adapter.load();
+    return adapter;
+  }
+
+  get index(): VPICIndex {
+    return this;
+  }
+
+  get kernel(): MatchKernel | undefined {
+    return this.inner.kernel;
+  }
+
+  getWMI(wmi: string): WMIResult | null | undefined {
+    return this.want(wmi, this.current?.getWMI(wmi));
+  }
+
+  getValidSchemas(wmi: string, modelYear: number): Array<{ SchemaId: number; SchemaName: string }> | undefined {
+    return this.want(wmi, this.current?.getValidSchemas(wmi, modelYear));
+  }
+
+  getYearRanges(wmi: string): Array<[number, number | null]> | undefined {
+    return this.want(wmi, this.current?.getYearRanges(wmi));
+  }
+
+  hasSchemas(schemaIds: number[]): boolean {
+    return this.current?.hasSchemas(schemaIds) ?? false;
+  }
+
+  getPatterns(schemaIds: number[]): any[] | undefined {
+    return this.current?.getPatterns(schemaIds);
+  }
+
+  getVdsClassTables(schemaIds: number[]): VdsClassTable[] | null | undefined {
+    return this.current?.getVdsClassTables(schemaIds);
+  }
+
+  lookupValues(tableName: string, ids: string[]): Map<string, string> | undefined {
+    return this.current?.lookupValues(tableName, ids);
+  }
+
+  /**
+   * Get cache statistics
+   */
+  getStats(): IndexCacheStats {
+    const { hits, misses } = this.current?.getStats() ?? { hits: 0, misses: 0 };
+    return { wmis: this.covered.size, loaded: this.loaded, writes: this.writes, hits, misses };
+  }
+
+  /**
+   * Compile every WMI seen so far and write the cache file now
+   */
+  async flush(): Promise<void> {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = undefined;
+    }
+    // Let a running write finish, then write whatever arrived meanwhile
+    while (this.writing) {
+      await this.writing;
+    }
+    if (this.wanted.size === 0) {
+      return;
+    }
+    this.writing = this.write().finally(() => {
+      this.writing = undefined;
+    });
+    await this.writing;
+  }
+
+  async exec(query: string, params: any[] = []): Promise<QueryResult[]> {
+    return this.inner.exec(query, params);
+  }
+
+  async close(): Promise<void> {
+    try {
+      await this.flush();
+    } finally {
+      await this.inner.close();
+    }
+  }
+
+  private async load(): Promise<void> {
+    const index = await this.readIndex();
+    if (!index) {
+      return;
+    }
+    this.current = new HotIndex(index);
+    this.data = index;
+    this.covered = new Set(Object.keys(index.wmis));
+    this.loaded = true;
+    logger.debug({ path: this.path, wmis: this.covered.size }, 'Loaded index cache');
+  }
+
+  /**
+   * Read the index from the cache file if it was built for this database and release
+   */
+  private async readIndex(): Promise<HotIndexData | undefined> {
+    let file: IndexCacheFile;
+    try {
+      file = JSON.parse(await fs.readFile(this.path, 'utf-8'));
+    } catch {
+      // Missing or unreadable; built on first use
+      return undefined;
+    }
+
+    if (!file.key || !sameKey(file.key, this.key)) {
+      logger.debug({ path: this.path, found: file.key, expected: this.key }, 'Index cache is stale, rebuilding');
+      return undefined;
+    }
+    try {
+      // Validates the file before it replaces anything in memory
+      new HotIndex(file.index);
+      return file.index;
+    } catch (error) {
+      logger.debug({ path: this.path, error }, 'Index cache is unusable, rebuilding');
+      return undefined;
+    }
+  }
+
+  private async write(): Promise<void> {
+    const wmis = [...this.wanted].filter(wmi => !this.covered.has(wmi)).slice(0, this.maxWmis - this.covered.size);
+    this.wanted.clear();
+    if (wmis.length === 0) {
+      return;
+    }
+
+    try {
+      // Only the new WMIs are compiled; the rest of the index is reused as is
+      const compiled = await compileHotIndex(this.inner, wmis, { dbVersion: this.key.dbHash });
+      for (const wmi of wmis) {
+        if (compiled.wmis[wmi]?.info === null) {
+          delete compiled.wmis[wmi];
+          if (this.unknown.size >= MAX_UNKNOWN_WMIS) {
+            this.unknown.clear();
+          }
+          this.unknown.add(wmi);
+        }
+      }
+      if (Object.keys(compiled.wmis).length === 0) {
+        return;
+      }
+
+      let index: HotIndexData;
+      const release = await acquireLock(`${this.path}.lock`);
+      try {
+        // Another worker may have replaced the file since it was read; keep its WMIs too
+        const onDisk = await this.readIndex();
+        const base = onDisk && this.data ? mergeHotIndex(onDisk, this.data) : (onDisk ?? this.data);
+        index = base ? mergeHotIndex(base, compiled) : compiled;
+        const file: IndexCacheFile = { key: this.key, index };
+
+        // Write beside the target and rename, so readers only ever see a whole file; pool
+        // and bulk workers share a process, so the temporary name needs more than the pid
+        const tmpPath = `${this.path}.${process.pid}.${Math.random().toString(36).slice(2)}.tmp`;
+        await fs.writeFile(tmpPath, JSON.stringify(file));
+        await fs.rename(tmpPath, this.path);
+      } finally {
+        await release();
+      }
+
+      this.current = new HotIndex(index);
+      this.data = index;
+      this.covered = new Set(Object.keys(index.wmis));
+      this.writes++;
+      logger.debug({ path: this.path, wmis: this.covered.size, added: wmis.length }, 'Wrote index cache');
+    } catch (error) {
+      // The cache only saves time; decoding carries on from SQL
+      logger.warn({ path: this.path, error }, 'Failed to write index cache');
+    }
+  }
+
+  private want<T>(wmi: string, value: T | undefined): T | undefined {
+    if (
+      value === undefined &&
+      WMI_SHAPE.test(wmi) &&
+      !this.unknown.has(wmi) &&
+      this.covered.size + this.wanted.size < this.maxWmis
+    ) {
+      this.wanted.add(wmi);
+      if (!this.timer) {
+        this.timer = setTimeout(() => {
+          this.timer = undefined;
+          void this.flush();
+        }, this.writeDelay);
+        // Pending writes must not keep the process alive; close() flushes them
+        (this.timer as { unref?: () => void }).unref?.();
+      }
+    }
+    return value;
+  }
+}
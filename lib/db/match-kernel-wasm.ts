@@ -0,0 +1,150 @@
+/**
+ * WebAssembly SIMD128 pattern matching kernel
+ *
+ * The module exports its memory and one function:
+ *
+ *   match(table, words, vds, out)
+ *
+ * `table` holds one bitset of `words` v128 lanes per (VDS position, alphabet
+ * character) pair, laid out as `[position][character][word]`. `vds` points to
+ * six alphabet indices. For every word the kernel ANDs the six selected
+ * bitsets and stores the result at `out`, so bit i of the output is set
+ * exactly when pattern i accepts every VDS character.
+ *
+ * The module is small enough to be assembled here rather than shipped as a
+ * build artifact; the build also writes it to `dist/match-kernel.wasm` for
+ * runtimes that only load precompiled modules (Cloudflare Workers).
+ */
+
+/** Unsigned LEB128 */
+function uleb(value: number): number[] {
+  const bytes: number[] = [];
+  do {
+    let byte = value & 0x7f;
+    value >>>= 7;
+    if (value !== 0) byte |= 0x80;
+    bytes.push(byte);
+  } while (value !== 0);
+  return bytes;
+}
+
+/** Signed LEB128 */
+function sleb(value: number): number[] {
+  const bytes: number[] = [];
+  for (;;) {
+    const byte = value & 0x7f;
+    value >>= 7;
+    if ((value === 0 && (byte & 0x40) === 0) || (value === -1 && (byte & 0x40) !== 0)) {
+      bytes.push(byte);
+      return bytes;
+    }
+    bytes.push(byte | 0x80);
+  }
+}
+
+function vec(items: number[][]): number[] {
+  return [...uleb(items.length), ...items.flat()];
+}
+
+function section(id: number, contents: number[]): number[] {
+  return [id, ...uleb(contents.length), ...contents];
+}
+
+function name(text: string): number[] {
+  return [...uleb(text.length), ...[...text].map(c => c.charCodeAt(0))];
+}
+
+// Opcodes
+const I32 = 0x7f;
+const BLOCK = 0x02;
+const LOOP = 0x03;
+const BR = 0x0c;
+const BR_IF = 0x0d;
+const END = 0x0b;
+const VOID = 0x40;
+const LOCAL_GET = 0x20;
+const LOCAL_SET = 0x21;
+const I32_LOAD8_U = 0x2d;
+const I32_CONST = 0x41;
+const I32_GE_U = 0x4f;
+const I32_ADD = 0x6a;
+const I32_MUL = 0x6c;
+const I32_SHL = 0x74;
+const SIMD = 0xfd;
+const V128_LOAD = 0x00;
+const V128_STORE = 0x0b;
+const V128_AND = 0x4e;
+
+// Locals: params, then stride, six row bases and the byte offset into a row
+const TABLE = 0;
+const WORDS = 1;
+const VDS = 2;
+const OUT = 3;
+const STRIDE = 4;
+const BASE = 5;
+const OFFSET = 11;
+
+/** Characters in the VIN alphabet (rows per position) */
+const ALPHABET_SIZE = 33;
+
+/** VDS positions */
+const POSITIONS = 6;
+
+function assemble(): Uint8Array {
+  const get = (local: number) => [LOCAL_GET, local];
+  const set = (local: number) => [LOCAL_SET, local];
+  const const32 = (value: number) => [I32_CONST, ...sleb(value)];
+
+  const body: number[] = [
+    // stride = words * 16 (bytes per bitset)
+    ...get(WORDS), ...const32(4), I32_SHL, ...set(STRIDE),
+  ];
+
+  // base[p] = table + (p * 33 + vds[p]) * stride
+  for (let p = 0; p < POSITIONS; p++) {
+    body.push(
+      ...get(TABLE),
+      ...const32(p * ALPHABET_SIZE),
+      ...get(VDS), I32_LOAD8_U, 0, ...uleb(p),
+      I32_ADD,
+      ...get(STRIDE),
+      I32_MUL,
+      I32_ADD,
+      ...set(BASE + p),
+    );
+  }
+
+  // for (offset = 0; offset < stride; offset += 16) out[offset] = AND of base[p][offset]
+  body.push(BLOCK, VOID, LOOP, VOID);
+  body.push(...get(OFFSET), ...get(STRIDE), I32_GE_U, BR_IF, 1);
+  body.push(...get(OUT), ...get(OFFSET), I32_ADD);
+  for (let p = 0; p < POSITIONS; p++) {
+    body.push(...get(BASE + p), ...get(OFFSET), I32_ADD, SIMD, ...uleb(V128_LOAD), 4, 0);
+    if (p > 0) {
+      body.push(SIMD, ...uleb(V128_AND));
+    }
+  }
+  body.push(SIMD, ...uleb(V128_STORE), 4, 0);
+  body.push(...get(OFFSET), ...const32(16), I32_ADD, ...set(OFFSET));
+  body.push(BR, 0, END, END);
+  body.push(END);
+
+  const locals = vec([[...uleb(OFFSET - STRIDE + 1), I32]]);
+  const code = [...locals, ...body];
+
+  return new Uint8Array([
+    0x00, 0x61, 0x73, 0x6d, // magic
+    0x01, 0x00, 0x00, 0x00, // version
+    ...section(1, vec([[0x60, ...vec([[I32], [I32], [I32], [I32]]), ...vec([])]])),
+    ...section(3, vec([[0]])),
+    ...section(5, vec([[0x00, ...uleb(1)]])),
+    ...section(7, vec([
+      [...name('memory'), 0x02, 0],
+      [...name('match'), 0x00, 0],
+    ])),
+    ...section(10, vec([[...uleb(code.length), ...code]])),
+  ]);
+}
+
+/** Binary of the matching kernel */
+export const MATCH_KERNEL_WASM: Uint8Array = assemble();
@@ -0,0 +1,232 @@
+import { MATCH_KERNEL_WASM } from './match-kernel-wasm';
+import { compileVdsAcceptance, VDS_LENGTH, VIN_ALPHABET, VIS_PADDING } from './vds-classes';
+import { createLogger } from '../logger';
+
+const logger = createLogger('MatchKernel');
+
+/** WebAssembly page size */
+const PAGE_SIZE = 65536;
+
+/** Bytes per v128 lane */
+const LANE = 16;
+
+/**
+ * Options for the matching kernel
+ */
+export interface MatchKernelOptions {
+  /** Memory for compiled pattern sets before they are recompiled on demand (default: 16MB) */
+  maxBytes?: number;
+}
+
+/**
+ * Matching kernel statistics
+ */
+export interface MatchKernelStats {
+  /** Pattern sets currently compiled */
+  sets: number;
+
+  /** Bytes of kernel memory in use */
+  bytes: number;
+
+  /** VDS evaluations run in WebAssembly */
+  matches: number;
+
+  /** Times the compiled sets were dropped to stay under maxBytes */
+  resets: number;
+}
+
+/**
+ * A schema set's patterns laid out for the kernel
+ */
+interface CompiledSet {
+  patterns: string[];
+  /** Confidence of each pattern when it matches */
+  confidences: number[];
+  words: number;
+  table: number;
+  vds: number;
+  out: number;
+}
+
+type MatchFunction = (table: number, words: number, vds: number, out: number) => void;
+
+/**
+ * WebAssembly SIMD matcher for VDS patterns
+ *
+ * Each schema set's VDS patterns are compiled once into per-position,
+ * per-character bitsets. A VDS is then evaluated against all patterns at once
+ * by ANDing six bitsets 128 patterns at a time, which keeps matching latency
+ * independent of JIT warm-up in short-lived browser and Worker isolates.
+ * Pattern sets the kernel cannot cover fall back to the JS matcher.
+ *
+ * Attach an instance to a DatabaseAdapter as `kernel` to use it. Compiled sets
+ * are keyed by schema IDs, so use one instance per database.
+ */
+export class MatchKernel {
+  private memory: WebAssembly.Memory;
+  private run: MatchFunction;
+  private sets = new Map<string, CompiledSet | null>();
+  private maxBytes: number;
+  private next = 0;
+  private stats = { matches: 0, resets: 0 };
+
+  private constructor(instance: WebAssembly.Instance, options: MatchKernelOptions) {
+    this.memory = instance.exports.memory as WebAssembly.Memory;
+    this.run = instance.exports.match as MatchFunction;
+    this.maxBytes = options.maxBytes ?? 16 * 1024 * 1024;
+  }
+
+  /**
+   * Instantiate the kernel
+   *
+   * @param source - Precompiled module or module bytes (default: the bundled kernel)
+   * @param options - Kernel options
+   * @returns The kernel, or null when WebAssembly SIMD is unavailable
+   */
+  static async create(
+    source: WebAssembly.Module | BufferSource = MATCH_KERNEL_WASM,
+    options: MatchKernelOptions = {},
+  ): Promise<MatchKernel | null> {
+    if (typeof WebAssembly === 'undefined') {
+      return null;
+    }
+
+    try {
+      const module = source instanceof WebAssembly.Module ? source : await WebAssembly.compile(source);
+      const instance = await WebAssembly.instantiate(module);
+      return new MatchKernel(instance, options);
+    } catch (error) {
+      logger.debug({ error }, 'WebAssembly SIMD unavailable, using JS matcher');
+      return null;
+    }
+  }
+
+  /**
+   * Match a VDS against a pattern set
+   *
+   * @param key - Identifies the pattern set (e.g. its schema IDs)
+   * @param patterns - Pattern strings of the set (VIS patterns are ignored)
+   * @param score - Runtime confidence function used to compile the set
+   * @param vds - Six-character VDS
+   * @returns Confidence of each matched VDS pattern, or undefined if not covered
+   */
+  match(
+    key: string,
+    patterns: string[],
+    score: (pattern: string, input: string) => number,
+    vds: string,
+  ): Map<string, number> | undefined {
+    let set = this.sets.get(key);
+    if (set === undefined) {
+      set = this.compile(patterns, score);
+      this.sets.set(key, set);
+    }
+    if (!set || vds.length !== VDS_LENGTH) {
+      return undefined;
+    }
+
+    const bytes = new Uint8Array(this.memory.buffer);
+    for (let p = 0; p < VDS_LENGTH; p++) {
+      const char = VIN_ALPHABET.indexOf(vds[p]);
+      if (char === -1) {
+        return undefined;
+      }
+      bytes[set.vds + p] = char;
+    }
+
+    this.run(set.table, set.words, set.vds, set.out);
+    this.stats.matches++;
+
+    const matched = new Map<string, number>();
+    for (let byte = 0; byte < set.words * LANE; byte++) {
+      let bits = bytes[set.out + byte];
+      while (bits !== 0) {
+        const bit = 31 - Math.clz32(bits & -bits);
+        const index = byte * 8 + bit;
+        matched.set(set.patterns[index], set.confidences[index]);
+        bits &= bits - 1;
+      }
+    }
+    return matched;
+  }
+
+  /**
+   * Get kernel statistics
+   */
+  getStats(): MatchKernelStats {
+    let sets = 0;
+    for (const set of this.sets.values()) {
+      if (set) sets++;
+    }
+    return { sets, bytes: this.next, ...this.stats };
+  }
+
+  /**
+   * Lay out a pattern set's bitsets in kernel memory
+   */
+  private compile(
+    patterns: string[],
+    score: (pattern: string, input: string) => number,
+  ): CompiledSet | null {
+    const acceptance = compileVdsAcceptance(patterns, score);
+    if (!acceptance || acceptance.patterns.length === 0) {
+      return null;
+    }
+
+    const count = acceptance.patterns.length;
+    const words = Math.ceil(count / (LANE * 8));
+    const stride = words * LANE;
+    const size = VDS_LENGTH * VIN_ALPHABET.length * stride + stride + LANE;
+    if (size > this.maxBytes) {
+      return null;
+    }
+
+    const table = this.allocate(size);
+    const out = table + VDS_LENGTH * VIN_ALPHABET.length * stride;
+    const vds = out + stride;
+
+    const bytes = new Uint8Array(this.memory.buffer);
+    bytes.fill(0, table, table + size);
+    acceptance.masks.forEach((chars, p) => {
+      chars.forEach((mask, c) => {
+        const row = table + (p * VIN_ALPHABET.length + c) * stride;
+        mask.forEach((accepted, i) => {
+          if (accepted) bytes[row + (i >> 3)] |= 1 << (i & 7);
+        });
+      });
+    });
+
+    // Confidence depends only on the pattern once it matches, so score any accepted VDS
+    const confidences = acceptance.patterns.map((pattern, i) => {
+      let sample = '';
+      for (let p = 0; p < VDS_LENGTH; p++) {
+        const c = acceptance.masks[p].findIndex(mask => mask[i]);
+        if (c === -1) return 0;
+        sample += VIN_ALPHABET[c];
+      }
+      return score(pattern, sample + VIS_PADDING);
+    });
+
+    return { patterns: acceptance.patterns, confidences, words, table, vds, out };
+  }
+
+  /**
+   * Reserve kernel memory, dropping every compiled set when over budget
+   */
+  private allocate(size: number): number {
+    if (this.next + size > this.maxBytes) {
+      this.sets.clear();
+      this.next = 0;
+      this.stats.resets++;
+    }
+
+    const start = this.next;
+    this.next = Math.ceil((start + size) / LANE) * LANE;
+
+    const needed = Math.ceil(this.next / PAGE_SIZE) - this.memory.buffer.byteLength / PAGE_SIZE;
+    if (needed > 0) {
+      this.memory.grow(needed);
+    }
+    return start;
+  }
+}
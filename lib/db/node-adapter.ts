@@ -2,6 +2,7 @@ import type { DatabaseAdapter, QueryResult, DatabaseAdapterFactory } from './ada
 import type { Database as BetterSQLite3Database } from 'better-sqlite3';
 import Database from 'better-sqlite3';
 import { createLogger } from '../logger';
+import { HttpRangeDatabaseAdapterFactory } from './http-adapter';
 
 const logger = createLogger('NodeDatabaseAdapter');
 
@@ -92,12 +93,15 @@ export class NodeDatabaseAdapterFactory implements DatabaseAdapterFactory {
   /**
    * Create a new database adapter for the given path
    * 
-   * @param pathOrUrl - Path to the SQLite database file
+   * @param pathOrUrl - Path to the SQLite database file, or an http(s) URL read via Range requests
    * @returns Initialized database adapter
    */
   async createAdapter(pathOrUrl: string): Promise<DatabaseAdapter> {
-    if (pathOrUrl.startsWith('libsql:') || pathOrUrl.startsWith('http')) {
-      throw new Error('Remote database connections are not supported in the CLI. Use a local SQLite file instead.');
+    if (pathOrUrl.startsWith('http:') || pathOrUrl.startsWith('https:')) {
+      return new HttpRangeDatabaseAdapterFactory().createAdapter(pathOrUrl);
+    }
+    if (pathOrUrl.startsWith('libsql:')) {
+      throw new Error('libsql connections are not supported. Use a local SQLite file or an http(s) URL instead.');
     }
     return new NodeDatabaseAdapter(pathOrUrl);
   }
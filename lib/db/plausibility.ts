@@ -0,0 +1,380 @@
+import type { DatabaseAdapter } from './adapter';
+import { VPICDatabase } from '../db';
+import { checkDigitMatches, checkDigitSum } from '../check-digit';
+
+/** Format version of serialized filters */
+const FORMAT_VERSION = 1;
+
+/** Header fields (u32 each): version, log2 of bit count, hash count, VDS prefix length, key count */
+const HEADER_BYTES = 20;
+
+/** Position-10 characters in cycle order, starting at 1980 */
+const YEAR_CODES = 'ABCDEFGHJKLMNPRSTVWXY123456789';
+
+/** Year code used for keys that match VINs with no model year ("0" in position 10) */
+const ANY_YEAR = '0';
+
+/** Characters a VIN can hold in the VDS, for expanding wildcards */
+const VIN_CHARS = '0123456789ABCDEFGHJKLMNPRSTUVWXYZ';
+
+/**
+ * Options for compiling a plausibility filter
+ */
+export interface PlausibilityFilterOptions {
+  /** Target false positive rate for VINs with an unknown WMI, year and VDS prefix combination (default: 0.01) */
+  falsePositiveRate?: number;
+
+  /** VDS characters (from position 4) included in each key (default: 2) */
+  prefixLength?: number;
+
+  /** Last model year for schemas without an end year (default: two years after the current year) */
+  openYear?: number;
+}
+
+/**
+ * Options for a plausibility check
+ */
+export interface PlausibilityCheckOptions {
+  /** Require a valid check digit (default: only for North American VINs, position 1 is 1-5) */
+  checkDigit?: boolean;
+}
+
+/**
+ * Size and accuracy of a plausibility filter
+ */
+export interface PlausibilityFilterStats {
+  /** Distinct (WMI, year code, VDS prefix) keys */
+  keys: number;
+  /** Filter size in bytes */
+  bytes: number;
+  /** Hash functions per key */
+  hashes: number;
+  /** VDS characters per key */
+  prefixLength: number;
+  /** False positive rate implied by the filter's size and key count */
+  falsePositiveRate: number;
+}
+
+/** One mixing step of the two key hashes */
+function fnv(h: number, code: number): number {
+  return Math.imul(h ^ code, 16777619);
+}
+
+function murmur(h: number, code: number): number {
+  return Math.imul(h ^ code, 0x5bd1e995);
+}
+
+/** Murmur3 finalizer */
+function fmix(h: number): number {
+  h ^= h >>> 16;
+  h = Math.imul(h, 0x85ebca6b);
+  h ^= h >>> 13;
+  h = Math.imul(h, 0xc2b2ae35);
+  return (h ^ (h >>> 16)) >>> 0;
+}
+
+/** Upper-case char code for ASCII letters */
+function upper(code: number): number {
+  return code >= 97 && code <= 122 ? code - 32 : code;
+}
+
+/**
+ * Check digit sum of a VIN, or -1 if it is not 17 valid VIN characters with a
+ * digit or X in position 9
+ */
+function weightedSum(vin: string): number {
+  const checkDigit = upper(vin.charCodeAt(8));
+  if (checkDigit !== 88 && (checkDigit < 48 || checkDigit > 57)) {
+    return -1;
+  }
+  return checkDigitSum(vin);
+}
+
+/**
+ * Whether a VIN is assigned in North America (position 1 is 1-5), where the check digit is mandatory
+ */
+function isNorthAmerican(vin: string): boolean {
+  const region = vin.charCodeAt(0);
+  return region >= 49 && region <= 53;
+}
+
+/**
+ * Year codes for a range of model years
+ */
+function yearCodes(from: number, to: number): string[] {
+  const codes = new Set<string>([ANY_YEAR]);
+  for (let year = Math.max(from, 1980); year <= to && codes.size <= YEAR_CODES.length; year++) {
+    codes.add(YEAR_CODES[(((year - 1980) % 30) + 30) % 30]);
+  }
+  return [...codes];
+}
+
+/**
+ * Expand the first `length` positions of a pattern into every string they match
+ */
+function expandPrefix(pattern: string, length: number): string[] {
+  let prefixes = [''];
+  let index = 0;
+  for (let position = 0; position < length; position++) {
+    let chars: string;
+    const char = pattern[index];
+    if (char === undefined || char === '*') {
+      chars = VIN_CHARS;
+      index++;
+    } else if (char === '[') {
+      const close = pattern.indexOf(']', index);
+      const content = close === -1 ? '' : pattern.slice(index + 1, close);
+      chars = '';
+      for (let i = 0; i < content.length; i++) {
+        if (content[i + 1] === '-' && i + 2 < content.length) {
+          for (let code = content.charCodeAt(i); code <= content.charCodeAt(i + 2); code++) {
+            chars += String.fromCharCode(code);
+          }
+          i += 2;
+        } else {
+          chars += content[i];
+        }
+      }
+      index = close === -1 ? pattern.length : close + 1;
+    } else {
+      chars = char;
+      index++;
+    }
+
+    const next: string[] = [];
+    for (const prefix of prefixes) {
+      for (const c of chars) {
+        if (VIN_CHARS.includes(c)) next.push(prefix + c);
+      }
+    }
+    prefixes = next;
+  }
+  return prefixes;
+}
+
+/**
+ * Compile a plausibility filter from Model pattern rows
+ *
+ * @param rows - Rows from VPICDatabase.getModelPatternYearRanges
+ * @param options - Filter options
+ * @returns Filter over every (WMI, year code, VDS prefix) a Model pattern allows
+ */
+export function compilePlausibilityFilter(
+  rows: Array<{ Wmi: string; Pattern: string; YearFrom: number; YearTo: number | null }>,
+  options: PlausibilityFilterOptions = {},
+): PlausibilityFilter {
+  const falsePositiveRate = options.falsePositiveRate ?? 0.01;
+  const prefixLength = options.prefixLength ?? 2;
+  const openYear = options.openYear ?? new Date().getFullYear() + 2;
+
+  const keys = new Set<string>();
+  for (const row of rows) {
+    const wmi = row.Wmi.toUpperCase();
+    const prefixes = expandPrefix(row.Pattern.toUpperCase(), prefixLength);
+    for (const code of yearCodes(row.YearFrom, row.YearTo ?? openYear)) {
+      for (const prefix of prefixes) {
+        keys.add(code + wmi + prefix);
+      }
+    }
+  }
+
+  // Round the optimal size up to a power of two so a probe is a mask, not a division
+  const n = Math.max(keys.size, 1);
+  const optimalBits = Math.ceil((-n * Math.log(falsePositiveRate)) / (Math.LN2 * Math.LN2));
+  const log2Bits = Math.min(31, Math.max(6, Math.ceil(Math.log2(optimalBits))));
+  const hashes = Math.max(1, Math.round(((2 ** log2Bits) / n) * Math.LN2));
+
+  const filter = new PlausibilityFilter(
+    new Uint32Array(2 ** (log2Bits - 5)),
+    log2Bits,
+    Math.min(hashes, 16),
+    prefixLength,
+    keys.size,
+  );
+  for (const key of keys) {
+    filter.addKey(key);
+  }
+  return filter;
+}
+
+/**
+ * Answers "could this VIN exist?" without SQL or pattern scoring
+ *
+ * A Bloom filter holds every (WMI, model year code, VDS prefix) combination
+ * allowed by a Model pattern of a schema linked to the WMI for that year. A
+ * VIN is plausible when its characters are valid, its check digit matches
+ * (by default only for North American VINs, since other regions do not
+ * require one), and its combination is in the filter. VINs without a model year ("0" in
+ * position 10) are checked against any year.
+ *
+ * The filter never rejects a combination the database allows. It accepts an
+ * unknown combination with the false positive rate reported by `getStats`
+ * (about 1% with the default options). A check runs a table lookup per
+ * character and a few hash probes, and allocates nothing.
+ */
+export class PlausibilityFilter {
+  private mask: number;
+
+  /**
+   * Use `compilePlausibilityFilter`, `PlausibilityFilter.deserialize` or `PlausibilityFilter.load`
+   */
+  constructor(
+    private bits: Uint32Array,
+    private log2Bits: number,
+    private hashes: number,
+    private prefixLength: number,
+    private keys: number,
+  ) {
+    this.mask = 2 ** log2Bits - 1;
+  }
+
+  /**
+   * Load the filter stored in the database, or compile it from the Pattern table
+   *
+   * @param adapter - Database adapter
+   * @param options - Options used when compiling
+   * @returns Filter
+   */
+  static async load(adapter: DatabaseAdapter, options: PlausibilityFilterOptions = {}): Promise<PlausibilityFilter> {
+    const db = new VPICDatabase(adapter);
+    const stored = await db.getStoredPlausibilityFilter();
+    return stored
+      ? PlausibilityFilter.deserialize(stored)
+      : compilePlausibilityFilter(await db.getModelPatternYearRanges(), options);
+  }
+
+  /**
+   * Read a filter written by `serialize`
+   *
+   * @param data - Serialized filter
+   * @returns Filter
+   */
+  static deserialize(data: Uint8Array): PlausibilityFilter {
+    const view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+    const version = view.getUint32(0, true);
+    if (version !== FORMAT_VERSION) {
+      throw new Error(`Unsupported plausibility filter version: ${version}`);
+    }
+    const log2Bits = view.getUint32(4, true);
+    const words = 2 ** (log2Bits - 5);
+    const bits = new Uint32Array(words);
+    for (let i = 0; i < words; i++) {
+      bits[i] = view.getUint32(HEADER_BYTES + i * 4, true);
+    }
+    return new PlausibilityFilter(bits, log2Bits, view.getUint32(8, true), view.getUint32(12, true), view.getUint32(16, true));
+  }
+
+  /**
+   * Write the filter for storage (e.g. the PlausibilityFilter table or a Worker bundle)
+   */
+  serialize(): Uint8Array {
+    const data = new Uint8Array(HEADER_BYTES + this.bits.length * 4);
+    const view = new DataView(data.buffer);
+    view.setUint32(0, FORMAT_VERSION, true);
+    view.setUint32(4, this.log2Bits, true);
+    view.setUint32(8, this.hashes, true);
+    view.setUint32(12, this.prefixLength, true);
+    view.setUint32(16, this.keys, true);
+    for (let i = 0; i < this.bits.length; i++) {
+      view.setUint32(HEADER_BYTES + i * 4, this.bits[i], true);
+    }
+    return data;
+  }
+
+  /**
+   * Get filter size and false positive rate
+   */
+  getStats(): PlausibilityFilterStats {
+    const m = 2 ** this.log2Bits;
+    return {
+      keys: this.keys,
+      bytes: this.bits.length * 4,
+      hashes: this.hashes,
+      prefixLength: this.prefixLength,
+      falsePositiveRate: (1 - Math.exp((-this.hashes * this.keys) / m)) ** this.hashes,
+    };
+  }
+
+  /**
+   * Check whether a VIN could exist
+   *
+   * @param vin - VIN (upper or lower case, no surrounding whitespace)
+   * @param options - Check options
+   * @returns False when the VIN certainly does not decode to a model; true when it probably does
+   */
+  isPlausible(vin: string, options?: PlausibilityCheckOptions): boolean {
+    const sum = weightedSum(vin);
+    if (sum === -1) {
+      return false;
+    }
+    const checkDigit = options?.checkDigit ?? isNorthAmerican(vin);
+    if (checkDigit && !checkDigitMatches(vin, sum)) {
+      return false;
+    }
+
+    // Key: year code, WMI (positions 1-3, plus 12-14 for small manufacturers), VDS prefix
+    let h1 = 2166136261;
+    let h2 = 0x9747b28c;
+    const code = upper(vin.charCodeAt(9));
+    h1 = fnv(h1, code);
+    h2 = murmur(h2, code);
+    for (let i = 0; i < 3; i++) {
+      const c = upper(vin.charCodeAt(i));
+      h1 = fnv(h1, c);
+      h2 = murmur(h2, c);
+    }
+    if (vin.charCodeAt(2) === 57) {
+      for (let i = 11; i < 14; i++) {
+        const c = upper(vin.charCodeAt(i));
+        h1 = fnv(h1, c);
+        h2 = murmur(h2, c);
+      }
+    }
+    for (let i = 3; i < 3 + this.prefixLength; i++) {
+      const c = upper(vin.charCodeAt(i));
+      h1 = fnv(h1, c);
+      h2 = murmur(h2, c);
+    }
+    return this.contains(fmix(h1), fmix(h2) | 1);
+  }
+
+  /**
+   * Check a VIN's check digit (position 9) with table lookups
+   *
+   * @param vin - 17-character VIN (upper or lower case)
+   * @returns Whether the check digit matches
+   */
+  static hasValidCheckDigit(vin: string): boolean {
+    const sum = checkDigitSum(vin);
+    return sum !== -1 && checkDigitMatches(vin, sum);
+  }
+
+  /**
+   * Add a key (year code, WMI and VDS prefix) while compiling
+   */
+  addKey(key: string): void {
+    let h1 = 2166136261;
+    let h2 = 0x9747b28c;
+    for (let i = 0; i < key.length; i++) {
+      const c = key.charCodeAt(i);
+      h1 = fnv(h1, c);
+      h2 = murmur(h2, c);
+    }
+    h1 = fmix(h1);
+    h2 = fmix(h2) | 1;
+    for (let i = 0; i < this.hashes; i++) {
+      const bit = (h1 + Math.imul(i, h2)) & this.mask;
+      this.bits[bit >>> 5] |= 1 << (bit & 31);
+    }
+  }
+
+  private contains(h1: number, h2: number): boolean {
+    for (let i = 0; i < this.hashes; i++) {
+      const bit = (h1 + Math.imul(i, h2)) & this.mask;
+      if ((this.bits[bit >>> 5] & (1 << (bit & 31))) === 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
@@ -0,0 +1,285 @@
+import { readFile, writeFile } from 'fs/promises';
+import type { DatabaseAdapter, QueryResult, VPICIndex } from './adapter';
+import type { MatchKernel } from './match-kernel';
+
+/**
+ * One distinct query and its outcome
+ */
+export interface RecordedQuery {
+  query: string;
+  params: any[];
+  /** Rows returned, absent if the query failed */
+  result?: QueryResult[];
+  /** Error message if the query failed */
+  error?: string;
+  /** Time the recorded adapter took to answer, in milliseconds */
+  latency: number;
+}
+
+/**
+ * Queries recorded by RecordingDatabaseAdapter, as saved to disk
+ */
+export interface QueryRecording {
+  version: 1;
+  entries: RecordedQuery[];
+}
+
+/**
+ * Latency added to each replayed query, in milliseconds
+ *
+ * - a number: fixed latency
+ * - `uniform`: between `min` and `max`
+ * - `normal`: `mean` and `stddev`, clamped at 0
+ * - `lognormal`: `median` and `sigma`, the usual shape of network round trips
+ * - `recorded`: the latency observed while recording, times `scale` (default: 1)
+ * - a function: called per query
+ */
+export type LatencyModel =
+  | number
+  | { type: 'uniform'; min: number; max: number }
+  | { type: 'normal'; mean: number; stddev: number }
+  | { type: 'lognormal'; median: number; sigma: number }
+  | { type: 'recorded'; scale?: number }
+  | ((query: string, params: any[]) => number);
+
+/**
+ * Options for the replay adapter
+ */
+export interface ReplayAdapterOptions {
+  /** Latency added to each query (default: 0) */
+  latency?: LatencyModel;
+
+  /** Queries in flight at once; further queries wait their turn, like a connection limit (default: unlimited) */
+  concurrency?: number;
+
+  /** Seed for sampled latencies, so runs are repeatable (default: 1) */
+  seed?: number;
+
+  /** Adapter for queries missing from the recording (default: none, such queries fail) */
+  fallback?: DatabaseAdapter;
+}
+
+/**
+ * Counters describing a replay
+ */
+export interface ReplayStats {
+  /** Queries answered from the recording */
+  queries: number;
+  /** Queries not in the recording */
+  misses: number;
+  /** Most queries in flight at once */
+  maxInFlight: number;
+  /** Total latency injected, in milliseconds */
+  latency: number;
+  /** Total time queries waited for a concurrency slot, in milliseconds */
+  queueWait: number;
+}
+
+function queryKey(query: string, params: any[]): string {
+  return `${query}\u0000${JSON.stringify(params)}`;
+}
+
+function now(): number {
+  return performance.now ? performance.now() : Date.now();
+}
+
+/**
+ * Adapter that records every distinct query and its result from another adapter
+ *
+ * Decode a representative workload through it, then `save` the recording and
+ * serve it back with ReplayDatabaseAdapter. The wrapped adapter's index and
+ * kernel are used as usual, so only queries that reach SQL are recorded.
+ */
+export class RecordingDatabaseAdapter implements DatabaseAdapter {
+  private entries = new Map<string, RecordedQuery>();
+
+  /**
+   * @param inner - Adapter whose queries are recorded
+   */
+  constructor(private inner: DatabaseAdapter) {}
+
+  get index(): VPICIndex | undefined {
+    return this.inner.index;
+  }
+
+  get kernel(): MatchKernel | undefined {
+    return this.inner.kernel;
+  }
+
+  async exec(query: string, params: any[] = []): Promise<QueryResult[]> {
+    const start = now();
+    try {
+      const result = await this.inner.exec(query, params);
+      this.record({ query, params, result, latency: now() - start });
+      return result;
+    } catch (error) {
+      this.record({ query, params, error: error instanceof Error ? error.message : String(error), latency: now() - start });
+      throw error;
+    }
+  }
+
+  /**
+   * Get the queries recorded so far
+   */
+  getRecording(): QueryRecording {
+    return { version: 1, entries: [...this.entries.values()] };
+  }
+
+  /**
+   * Write the recording as JSON
+   *
+   * @param path - Output file
+   */
+  async save(path: string): Promise<void> {
+    await writeFile(path, JSON.stringify(this.getRecording()));
+  }
+
+  async close(): Promise<void> {
+    await this.inner.close();
+  }
+
+  private record(entry: RecordedQuery): void {
+    // The first answer is kept; later ones come from a warm database and say little about latency
+    const key = queryKey(entry.query, entry.params);
+    if (!this.entries.has(key)) {
+      this.entries.set(key, entry);
+    }
+  }
+}
+
+/**
+ * Adapter that answers queries from a recording with simulated latency
+ *
+ * Local SQLite answers in microseconds, which hides what batching,
+ * prefetching and caching save against D1 or a remote database. Replaying a
+ * recording with a latency model and a concurrency limit reproduces that
+ * behavior offline and repeatably, without a network or the database file.
+ *
+ * Results are the recorded rows; callers must not modify them.
+ */
+export class ReplayDatabaseAdapter implements DatabaseAdapter {
+  private entries = new Map<string, RecordedQuery>();
+  private waiting: Array<() => void> = [];
+  private inFlight = 0;
+  private random: () => number;
+  private stats: ReplayStats = { queries: 0, misses: 0, maxInFlight: 0, latency: 0, queueWait: 0 };
+
+  /**
+   * @param recording - Queries recorded by RecordingDatabaseAdapter
+   * @param options - Latency, concurrency and fallback
+   */
+  constructor(recording: QueryRecording, private options: ReplayAdapterOptions = {}) {
+    if (recording.version !== 1) {
+      throw new Error(`Unsupported query recording version: ${recording.version}`);
+    }
+    for (const entry of recording.entries) {
+      this.entries.set(queryKey(entry.query, entry.params), entry);
+    }
+
+    // mulberry32
+    let seed = (options.seed ?? 1) >>> 0;
+    this.random = () => {
+      seed = (seed + 0x6d2b79f5) >>> 0;
+      let t = seed;
+      t = Math.imul(t ^ (t >>> 15), t | 1);
+      t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+      return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+  }
+
+  /**
+   * Load a recording saved with RecordingDatabaseAdapter.save
+   *
+   * @param path - Recording file
+   * @param options - Latency, concurrency and fallback
+   */
+  static async load(path: string, options: ReplayAdapterOptions = {}): Promise<ReplayDatabaseAdapter> {
+    return new ReplayDatabaseAdapter(JSON.parse(await readFile(path, 'utf8')), options);
+  }
+
+  /**
+   * Get replay statistics
+   */
+  getStats(): ReplayStats {
+    return { ...this.stats };
+  }
+
+  async exec(query: string, params: any[] = []): Promise<QueryResult[]> {
+    const entry = this.entries.get(queryKey(query, params));
+    if (!entry) {
+      this.stats.misses++;
+      if (this.options.fallback) {
+        return this.options.fallback.exec(query, params);
+      }
+      throw new Error(`Query not in recording: ${query.replace(/\s+/g, ' ').trim().slice(0, 120)}`);
+    }
+
+    await this.acquire();
+    try {
+      const latency = this.sampleLatency(entry);
+      this.stats.queries++;
+      this.stats.latency += latency;
+      if (latency > 0) {
+        await new Promise(resolve => setTimeout(resolve, latency));
+      }
+    } finally {
+      this.release();
+    }
+
+    if (entry.error !== undefined) {
+      throw new Error(entry.error);
+    }
+    return entry.result!;
+  }
+
+  async close(): Promise<void> {
+    await this.options.fallback?.close();
+  }
+
+  private async acquire(): Promise<void> {
+    const limit = this.options.concurrency ?? Infinity;
+    if (this.inFlight >= limit) {
+      const start = now();
+      // release() hands its slot over, so inFlight is already counted for us
+      await new Promise<void>(resolve => this.waiting.push(resolve));
+      this.stats.queueWait += now() - start;
+    } else {
+      this.inFlight++;
+    }
+    this.stats.maxInFlight = Math.max(this.stats.maxInFlight, this.inFlight);
+  }
+
+  private release(): void {
+    const next = this.waiting.shift();
+    if (next) {
+      next();
+    } else {
+      this.inFlight--;
+    }
+  }
+
+  private sampleLatency(entry: RecordedQuery): number {
+    const model = this.options.latency ?? 0;
+    if (typeof model === 'number') {
+      return model;
+    }
+    if (typeof model === 'function') {
+      return Math.max(0, model(entry.query, entry.params));
+    }
+    switch (model.type) {
+      case 'uniform':
+        return model.min + this.random() * (model.max - model.min);
+      case 'normal':
+        return Math.max(0, model.mean + model.stddev * this.gaussian());
+      case 'lognormal':
+        return model.median * Math.exp(model.sigma * this.gaussian());
+      case 'recorded':
+        return entry.latency * (model.scale ?? 1);
+    }
+  }
+
+  private gaussian(): number {
+    // Box-Muller; 1 - random() keeps the logarithm finite
+    return Math.sqrt(-2 * Math.log(1 - this.random())) * Math.cos(2 * Math.PI * this.random());
+  }
+}
@@ -5,12 +5,18 @@ import {
   existsSync,
   mkdirSync,
   readdirSync,
+  openSync,
+  readSync,
+  closeSync,
+  fstatSync,
+  readFileSync,
 } from "fs";
 import { join, dirname } from "path";
 import { homedir } from "os";
 import { pipeline } from "stream/promises";
 import { fileURLToPath } from "url";
 import { createLogger } from "../logger";
+import { applyDeltas } from "./delta";
 
 const logger = createLogger("DbUtils");
 
@@ -79,9 +85,77 @@ function getUncompressedDbPaths(): string[] {
   return paths;
 }
 
+/**
+ * Get the installed corgi version from the package manifest
+ *
+ * @returns Package version, or "unknown" if the manifest cannot be found
+ */
+export function getPackageVersion(): string {
+  // lib/db in development, dist or dist/db when built
+  for (const path of [
+    join(DIRNAME, "..", "..", "package.json"),
+    join(DIRNAME, "..", "package.json"),
+  ]) {
+    try {
+      const manifest = JSON.parse(readFileSync(path, "utf-8"));
+      if (manifest.name === "@cardog/corgi") {
+        return manifest.version;
+      }
+    } catch {
+      // Try the next location
+    }
+  }
+  return "unknown";
+}
+
+/**
+ * Get the path of the database copy in the local cache
+ */
+export function getCachedDatabasePath(): string {
+  return CACHE_DB_PATH;
+}
+
+/**
+ * Get potential delta directories shipped with the package, in order of preference
+ */
+function getDeltaDirPaths(): string[] {
+  return getCompressedDbPaths().map((path) => join(dirname(path), "deltas"));
+}
+
+/**
+ * Bring the cached database up to date from a delta source
+ *
+ * Failures are logged and leave the cached database as it was; a database
+ * that cannot be patched is still a usable database.
+ */
+async function updateCachedDatabase(source: string | undefined): Promise<void> {
+  const dir =
+    source ??
+    getDeltaDirPaths().find((path) => existsSync(join(path, "manifest.json")));
+  if (!dir) {
+    return;
+  }
+
+  try {
+    const result = await applyDeltas(CACHE_DB_PATH, dir);
+    if (result.applied > 0) {
+      logger.debug(
+        { source: dir, applied: result.applied, bytes: result.bytes },
+        "Updated cached database from deltas"
+      );
+    }
+  } catch (error) {
+    logger.warn({ error, source: dir }, "Failed to apply database deltas");
+  }
+}
+
 /**
  * Gets the path to the database, handling decompression if needed
  *
+ * A cached database is brought up to date by applying the chain of deltas
+ * from `options.deltas` (or the deltas shipped with the package) instead of
+ * decompressing the full database again.
+ *
  * @param options - Optional configuration
  * @returns Path to usable database file
  */
@@ -89,6 +163,8 @@ export async function getDatabasePath(
   options: {
     forceFresh?: boolean;
     databasePath?: string;
+    /** Directory or HTTP(S) base URL with a delta `manifest.json` */
+    deltas?: string;
   } = {}
 ): Promise<string> {
   // If explicit path is provided, use it
@@ -115,6 +191,7 @@ export async function getDatabasePath(
     // Check if we already have a cached decompressed version
     if (!options.forceFresh && existsSync(CACHE_DB_PATH)) {
       logger.debug({ path: CACHE_DB_PATH }, "Using cached database");
+      await updateCachedDatabase(options.deltas);
       return CACHE_DB_PATH;
     }
 
@@ -184,6 +261,31 @@ async function decompressDatabase(
   }
 }
 
+/**
+ * Get a version string for a SQLite database file
+ *
+ * Built from the file size and the header's file change counter, so every
+ * copy of the same database reports the same version regardless of where or
+ * when it was decompressed.
+ *
+ * @param dbPath - Path to the database file
+ * @returns Version string, or "unknown" if the file cannot be read
+ */
+export function getDatabaseVersion(dbPath: string): string {
+  try {
+    const fd = openSync(dbPath, "r");
+    try {
+      const header = Buffer.alloc(100);
+      readSync(fd, header, 0, 100, 0);
+      return `${fstatSync(fd).size.toString(36)}-${header.readUInt32BE(24).toString(36)}`;
+    } finally {
+      closeSync(fd);
+    }
+  } catch {
+    return "unknown";
+  }
+}
+
 /**
  * Copy a file from source to destination
  *
@@ -0,0 +1,71 @@
+import type { DatabaseAdapter } from './adapter';
+import { VPICDatabase } from '../db';
+import { PatternMatcher } from '../pattern';
+import { compileVdsClasses } from './vds-classes';
+import type { VdsClassTable } from './vds-classes';
+
+/**
+ * Options for compiling VDS class tables
+ */
+export interface VdsClassBuildOptions {
+  /** Schemas to compile (default: every schema) */
+  schemaIds?: number[];
+
+  /** Skip schemas whose transition table exceeds this many states (default: 10000) */
+  maxStates?: number;
+}
+
+/**
+ * Compiled VDS class tables and what was left out
+ */
+export interface VdsClassBuildResult {
+  tables: Map<number, VdsClassTable>;
+
+  /** Schemas with patterns reading past the VDS */
+  skippedLong: number[];
+
+  /** Schemas over the state limit */
+  skippedLarge: number[];
+}
+
+/**
+ * Compile VDS class tables for a database's schemas
+ *
+ * Patterns are read with the same VPICDatabase query used at decode time and
+ * scored with the runtime PatternMatcher.
+ *
+ * @param adapter - Adapter for the source database
+ * @param options - Build options
+ * @returns Class tables keyed by schema ID
+ */
+export async function compileVdsClassTables(
+  adapter: DatabaseAdapter,
+  options: VdsClassBuildOptions = {},
+): Promise<VdsClassBuildResult> {
+  const db = new VPICDatabase(adapter);
+  const matcher = new PatternMatcher(adapter);
+  const score = (pattern: string, input: string) => matcher.calculateConfidence(pattern, input);
+  const maxStates = options.maxStates ?? 10000;
+
+  let schemaIds = options.schemaIds;
+  if (!schemaIds) {
+    const [result] = await adapter.exec('SELECT Id FROM VinSchema ORDER BY Id');
+    schemaIds = (result?.values ?? []).map(row => Number(row[0]));
+  }
+
+  const build: VdsClassBuildResult = { tables: new Map(), skippedLong: [], skippedLarge: [] };
+
+  for (const schemaId of schemaIds) {
+    const rows = await db.getPatterns([schemaId]);
+    const table = compileVdsClasses(rows.map(row => String(row.Pattern)), score);
+    if (!table) {
+      build.skippedLong.push(schemaId);
+    } else if (table.states.length > maxStates) {
+      build.skippedLarge.push(schemaId);
+    } else {
+      build.tables.set(schemaId, table);
+    }
+  }
+
+  return build;
+}
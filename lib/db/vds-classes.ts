@@ -0,0 +1,215 @@
+/** Characters that can appear in a structurally valid VIN */
+export const VIN_ALPHABET = '0123456789ABCDEFGHJKLMNPRSTUVWXYZ';
+
+/** Number of VDS positions (VIN positions 4-9) */
+export const VDS_LENGTH = 6;
+
+/** Filler for VIS positions when scoring a VDS-only pattern */
+export const VIS_PADDING = '00000000';
+
+/**
+ * Precompiled VDS equivalence classes for one schema
+ *
+ * VDS strings in the same class match exactly the same patterns with the same
+ * confidence. A class is found by walking one transition per VDS position:
+ * `groups[p]` maps each alphabet character to a group, and `states[s][g]` is
+ * the next state (or, after the last position, the class index).
+ */
+export interface VdsClassTable {
+  /** Format version */
+  version: 1;
+
+  /** Distinct VDS pattern strings of the schema */
+  patterns: string[];
+
+  /** Per position: group index for each character of VIN_ALPHABET */
+  groups: number[][];
+
+  /** Transition table; state 0 is the start state */
+  states: number[][];
+
+  /** Per class: matched patterns as [pattern index, confidence] */
+  classes: Array<Array<[number, number]>>;
+}
+
+/**
+ * Split a pattern into per-position tokens the way PatternMatcher reads it
+ *
+ * @returns Tokens, or null if the pattern can never match (unclosed class)
+ */
+function tokenize(pattern: string): string[] | null {
+  const tokens: string[] = [];
+  let i = 0;
+  while (i < pattern.length) {
+    if (pattern[i] === '[') {
+      const close = pattern.indexOf(']', i);
+      if (close === -1) return null;
+      tokens.push(pattern.substring(i, close + 1));
+      i = close + 1;
+    } else {
+      tokens.push(pattern[i]);
+      i++;
+    }
+  }
+  return tokens;
+}
+
+/**
+ * Which characters each VDS pattern accepts at each position
+ */
+export interface VdsAcceptance {
+  /** Distinct VDS pattern strings */
+  patterns: string[];
+
+  /** `masks[position][alphabet index][pattern index]` */
+  masks: boolean[][][];
+}
+
+/**
+ * Compute per-position acceptance for a schema's VDS patterns
+ *
+ * Acceptance is computed with the runtime scorer itself, so anything built
+ * from it agrees with scoring the VIN directly.
+ *
+ * @param patterns - Pattern strings (VIS patterns are ignored)
+ * @param score - Runtime confidence function, `(pattern, vdsAndVis) => confidence`
+ * @returns Acceptance masks, or null if a pattern reads past the VDS
+ */
+export function compileVdsAcceptance(
+  patterns: string[],
+  score: (pattern: string, input: string) => number,
+): VdsAcceptance | null {
+  const distinct = [...new Set(patterns.filter(p => !p.includes('|')))];
+  const tokenized: Array<string[] | null> = distinct.map(tokenize);
+
+  if (tokenized.some(tokens => tokens && tokens.length > VDS_LENGTH)) {
+    return null;
+  }
+
+  const accepts = (tokens: string[] | null, position: number, char: string): boolean => {
+    if (!tokens) return false;
+    if (position >= tokens.length) return true;
+    return score(tokens[position], char + VIS_PADDING) > 0;
+  };
+
+  const masks: boolean[][][] = [];
+  for (let p = 0; p < VDS_LENGTH; p++) {
+    masks.push([...VIN_ALPHABET].map(char => tokenized.map(tokens => accepts(tokens, p, char))));
+  }
+
+  return { patterns: distinct, masks };
+}
+
+/**
+ * Compile the VDS equivalence classes for a schema's patterns
+ *
+ * @param patterns - The schema's pattern strings (VIS patterns are ignored)
+ * @param score - Runtime confidence function, `(pattern, vdsAndVis) => confidence`
+ * @returns Class table, or null if a pattern reads past the VDS
+ */
+export function compileVdsClasses(
+  patterns: string[],
+  score: (pattern: string, input: string) => number,
+): VdsClassTable | null {
+  const acceptance = compileVdsAcceptance(patterns, score);
+  if (!acceptance) {
+    return null;
+  }
+  const distinct = acceptance.patterns;
+
+  // Group characters that every pattern treats identically at a position
+  const groups: number[][] = [];
+  const groupMasks: boolean[][][] = [];
+  for (let p = 0; p < VDS_LENGTH; p++) {
+    const signatures = new Map<string, number>();
+    const positionGroups: number[] = [];
+    const masks: boolean[][] = [];
+    for (const mask of acceptance.masks[p]) {
+      const key = mask.map(bit => (bit ? '1' : '0')).join('');
+      let group = signatures.get(key);
+      if (group === undefined) {
+        group = masks.length;
+        signatures.set(key, group);
+        masks.push(mask);
+      }
+      positionGroups.push(group);
+    }
+    groups.push(positionGroups);
+    groupMasks.push(masks);
+  }
+
+  // Walk the positions, merging states with the same set of live patterns
+  const states: number[][] = [];
+  const classes: Array<Array<[number, number]>> = [];
+  const classIndex = new Map<string, number>();
+  const stateIndex = new Map<string, number>();
+
+  const visit = (depth: number, alive: boolean[], prefix: string): number => {
+    const key = `${depth}:${alive.map(bit => (bit ? '1' : '0')).join('')}`;
+
+    if (depth === VDS_LENGTH) {
+      let index = classIndex.get(key);
+      if (index === undefined) {
+        const vds = prefix + VIS_PADDING;
+        const matched: Array<[number, number]> = [];
+        alive.forEach((bit, i) => {
+          const confidence = bit ? score(distinct[i], vds) : 0;
+          if (confidence > 0) matched.push([i, confidence]);
+        });
+        index = classes.length;
+        classes.push(matched);
+        classIndex.set(key, index);
+      }
+      return index;
+    }
+
+    let index = stateIndex.get(key);
+    if (index === undefined) {
+      index = states.length;
+      stateIndex.set(key, index);
+      const transitions: number[] = [];
+      states.push(transitions);
+
+      groupMasks[depth].forEach((mask, group) => {
+        const representative = VIN_ALPHABET[groups[depth].indexOf(group)];
+        transitions.push(visit(depth + 1, alive.map((bit, i) => bit && mask[i]), prefix + representative));
+      });
+    }
+    return index;
+  };
+
+  visit(0, distinct.map(() => true), '');
+
+  return { version: 1, patterns: distinct, groups, states, classes };
+}
+
+/**
+ * Find the equivalence class of a VDS using a compiled class table
+ *
+ * @param table - Compiled class table
+ * @param vds - Six-character VDS
+ * @returns Class index, or undefined for characters outside the VIN alphabet
+ */
+export function findVdsClass(table: VdsClassTable, vds: string): number | undefined {
+  let state = 0;
+  for (let p = 0; p < VDS_LENGTH; p++) {
+    const char = VIN_ALPHABET.indexOf(vds[p]);
+    if (char === -1) {
+      return undefined;
+    }
+    state = table.states[state][table.groups[p][char]];
+  }
+  return state;
+}
+
+/**
+ * Find the patterns a VDS matches using a compiled class table
+ *
+ * @param table - Compiled class table
+ * @param vds - Six-character VDS
+ * @returns Matched patterns as [pattern index, confidence], or undefined for characters outside the VIN alphabet
+ */
+export function lookupVdsClass(table: VdsClassTable, vds: string): Array<[number, number]> | undefined {
+  const index = findVdsClass(table, vds);
+  return index === undefined ? undefined : table.classes[index];
+}
@@ -1,12 +1,24 @@
 import { DatabaseAdapter } from './db/adapter';
 import { VPICDatabase } from './db';
 import { PatternMatcher } from './pattern';
+import type { MatchOutcome } from './pattern';
+import type { TieredCache } from './cache/backend';
+import type { PatternOverlay } from './overlay';
 import { createLogger } from './logger';
+import { resolveModelYear, selectModelYear } from './model-year';
+import { validateCheckDigit } from './check-digit';
+import { ResultTemplates } from './templates';
+import type { ResultTemplateStats } from './templates';
+import { RejectTemplates } from './reject';
+import type { RejectStats } from './reject';
+import { findSimilarVins } from './similarity';
+import { PriorityScheduler } from './scheduler';
+import type { PrioritySchedulerOptions, SchedulerStats } from './scheduler';
+import type { NearDuplicatePair, SimilarityJoinOptions } from './similarity';
 import { BODY_STYLE_MAP, BodyStyle } from './types';
 import {
   WMIResult,
   ModelYearResult,
-  CheckDigitResult,
   PatternMatch,
   DecodeError,
   DecodeResult,
@@ -22,16 +34,31 @@ import {
   PlantInfo,
   EngineInfo,
   DecodeOptions,
+  BatchDecodeOptions,
+  BatchLocalityStats,
+  PreparedDecode,
 } from './types';
 
 // Create logger for the decoder
 const logger = createLogger('VINDecoder');
 
-// Canonical VIN character sequence for a 30-year block (1980-2009 or 2010-2039)
-const modelYearCodes = [
-  'A','B','C','D','E','F','G','H','J','K','L','M','N','P','R','S','T','V','W',
-  'X','Y','1','2','3','4','5','6','7','8','9'
-];
+/**
+ * Extract the World Manufacturer Identifier from a VIN
+ *
+ * @param vin - Complete VIN string
+ * @returns WMI code
+ */
+export function extractWMI(vin: string): string {
+  // Handle standard and extended WMI cases
+  const baseWMI = vin.substring(0, 3);
+
+  // If position 3 is '9', this is an extended WMI, and part is encoded elsewhere in the VIN
+  if (baseWMI[2] === '9' && vin.length >= 14) {
+    return baseWMI + vin.substring(11, 14);
+  }
+
+  return baseWMI;
+}
 
 /**
  * Helper function to decode a VIN using a provided database adapter
@@ -56,15 +83,28 @@ export async function decodeVIN(
 export class VINDecoder {
   private db: VPICDatabase;
   private patternMatcher: PatternMatcher;
+  private sharedCache?: TieredCache;
+  private overlayViews = new WeakMap<PatternOverlay, { db: VPICDatabase; patternMatcher: PatternMatcher }>();
+  private templates = new ResultTemplates();
+  /** Match outcome keys of freshly decoded results, for sharing their components */
+  private outcomes = new WeakMap<DecodeResult, string>();
+  /** Whether the pattern set of a freshly decoded result came from a cache, for batch stats */
+  private patternLookups = new WeakMap<DecodeResult, boolean>();
+  private rejects = new RejectTemplates();
+  private scheduler: PriorityScheduler;
 
   /**
    * Create a new VIN decoder
    *
    * @param adapter - Database adapter for the current environment
+   * @param sharedCache - Optional shared cache for pattern sets and decode results
+   * @param scheduler - Options for scheduling interactive and bulk decodes
    */
-  constructor(adapter: DatabaseAdapter) {
-    this.db = new VPICDatabase(adapter);
-    this.patternMatcher = new PatternMatcher(adapter);
+  constructor(adapter: DatabaseAdapter, sharedCache?: TieredCache, scheduler?: PrioritySchedulerOptions) {
+    this.db = new VPICDatabase(adapter, sharedCache);
+    this.patternMatcher = new PatternMatcher(adapter, sharedCache);
+    this.sharedCache = sharedCache;
+    this.scheduler = new PriorityScheduler(scheduler);
   }
 
   /**
@@ -75,6 +115,449 @@ export class VINDecoder {
    * @returns Decoded VIN information
    */
   async decode(vin: string, options: DecodeOptions = {}): Promise<DecodeResult> {
+    const priority = options.priority ?? 'interactive';
+    const end = this.scheduler.begin(priority);
+    try {
+      await this.scheduler.checkpoint(priority);
+      const result = await this.decodeShared(vin, options);
+      // Overlay results are tenant-private, so their components are never shared either
+      if (!options.shareComponents || options.overlay) {
+        return result;
+      }
+      const shared = this.templates.share(result, this.outcomes.get(result));
+      const cached = this.patternLookups.get(result);
+      if (cached !== undefined) {
+        this.patternLookups.set(shared, cached);
+      }
+      return shared;
+    } finally {
+      end();
+    }
+  }
+
+  /**
+   * Get statistics for components shared with `shareComponents`
+   */
+  getTemplateStats(): ResultTemplateStats {
+    return this.templates.getStats();
+  }
+
+  /**
+   * Get interactive and bulk decode counts and latency
+   */
+  getSchedulerStats(): SchedulerStats {
+    return this.scheduler.getStats();
+  }
+
+  /**
+   * Get counts of VINs rejected with `fastReject`
+   */
+  getRejectStats(): RejectStats {
+    return this.rejects.getStats();
+  }
+
+  /**
+   * Decode through the shared cache, if any
+   */
+  private async decodeShared(vin: string, options: DecodeOptions): Promise<DecodeResult> {
+    // Overlay results are tenant-private and never enter the shared cache
+    if (!this.sharedCache || options.overlay) {
+      return this.decodeUncached(vin, options);
+    }
+
+    const startTime = performance.now ? performance.now() : Date.now();
+    const key = [
+      'decode',
+      vin.toUpperCase().trim(),
+      options.modelYear ?? '',
+      options.confidenceThreshold ?? '',
+      options.includePatternDetails ? 'p' : '',
+      options.includeRawData ? 'r' : '',
+      options.includeDiagnostics ? 'd' : '',
+    ].join(':');
+
+    const cached = await this.sharedCache.get<DecodeResult>(key);
+    if (cached !== undefined) {
+      // The cached result is shared with L1; callers get their own copy
+      const result: DecodeResult = JSON.parse(JSON.stringify(cached));
+      result.metadata!.processingTime = (performance.now ? performance.now() : Date.now()) - startTime;
+      return result;
+    }
+
+    const result = await this.decodeUncached(vin, options);
+
+    // Database failures are transient and must not be shared with other instances
+    if (!result.errors.some(error => error.category === ErrorCategory.DATABASE)) {
+      this.sharedCache.set(key, result);
+    }
+
+    return result;
+  }
+
+  /**
+   * Validate VIN structure and check digit without touching the database
+   *
+   * @param vin - The Vehicle Identification Number to validate
+   * @returns Result with structure errors and check digit; no vehicle components
+   */
+  validate(vin: string): DecodeResult {
+    const startTime = performance.now ? performance.now() : Date.now();
+    const cleanVin = vin.toUpperCase().trim();
+    const result: DecodeResult = {
+      vin: cleanVin,
+      valid: false,
+      components: {},
+      errors: this.validateStructure(cleanVin),
+      metadata: {
+        processingTime: 0,
+        confidence: 0,
+        schemaVersion: '1.0',
+      },
+    };
+
+    if (result.errors.length === 0) {
+      const checkDigit = validateCheckDigit(cleanVin);
+      result.components.checkDigit = checkDigit;
+      result.valid = checkDigit.isValid;
+
+      if (!checkDigit.isValid) {
+        result.errors.push({
+          code: ErrorCode.INVALID_CHECK_DIGIT,
+          category: ErrorCategory.VALIDATION,
+          severity: ErrorSeverity.WARNING,
+          message: 'Invalid check digit',
+          positions: [8],
+          expected: checkDigit.expected,
+          actual: checkDigit.actual,
+        } as ValidationError);
+      }
+    }
+
+    result.metadata!.processingTime = (performance.now ? performance.now() : Date.now()) - startTime;
+    return result;
+  }
+
+  /**
+   * Decode a list of VINs in order
+   *
+   * @param vins - VINs to decode
+   * @param options - Decode options, plus lookahead depth
+   * @returns Decoded VIN information, in input order
+   */
+  async decodeBatch(vins: string[], options: BatchDecodeOptions = {}): Promise<DecodeResult[]> {
+    const results: DecodeResult[] = [];
+    for await (const result of this.decodeStream(vins, options)) {
+      results.push(result);
+    }
+    return results;
+  }
+
+  /**
+   * Find pairs of VINs that differ in at most `maxDistance` positions and
+   * whether both decode to the same vehicle
+   *
+   * Pairs come from findSimilarVins; each VIN in a pair is then decoded once
+   * as a batch. A pair with `sameSpec` and one invalid check digit is the
+   * usual sign of a typo or a cloned VIN.
+   *
+   * @param vins - VINs to join
+   * @param options - Decode options, plus lookahead depth and maximum distance
+   * @returns Pairs, ordered by the first VIN's input position
+   */
+  async findNearDuplicates(
+    vins: Iterable<string>,
+    options: BatchDecodeOptions & SimilarityJoinOptions = {},
+  ): Promise<NearDuplicatePair[]> {
+    const { maxDistance, ...decodeOptions } = options;
+    const pairs = findSimilarVins(vins, { maxDistance });
+    if (pairs.length === 0) {
+      return [];
+    }
+
+    const involved = [...new Set(pairs.flatMap(pair => [pair.a, pair.b]))];
+    const results = await this.decodeBatch(involved, decodeOptions);
+    const specs = new Map<string, string | undefined>();
+    involved.forEach((vin, i) => {
+      const { vehicle, modelYear, engine } = results[i].components;
+      specs.set(vin, vehicle ? JSON.stringify([vehicle, modelYear?.year, engine]) : undefined);
+    });
+
+    return pairs.map(pair => {
+      const spec = specs.get(pair.a);
+      return { ...pair, sameSpec: spec !== undefined && spec === specs.get(pair.b) };
+    });
+  }
+
+  /**
+   * Decode a stream of VINs in order, prefetching ahead
+   *
+   * While one VIN decodes, the WMI, schemas and patterns of the next
+   * `lookahead` VINs are already being fetched, so on async adapters (D1,
+   * remote databases) the I/O of upcoming VINs overlaps the current decode.
+   * With `reorderWindow`, VINs are decoded grouped by pattern set within each
+   * window (see decodeReordered).
+   *
+   * @param vins - VINs to decode
+   * @param options - Decode options, plus lookahead depth and reorder window
+   * @param stats - Locality counters to add this stream's decodes to
+   * @returns Decoded VIN information, in input order
+   */
+  async *decodeStream(
+    vins: Iterable<string> | AsyncIterable<string>,
+    options: BatchDecodeOptions = {},
+    stats?: BatchLocalityStats,
+  ): AsyncGenerator<DecodeResult> {
+    const { lookahead = 16, reorderWindow = 0, fastReject = false, priority = 'bulk', ...rest } = options;
+    const decodeOptions: DecodeOptions = { ...rest, priority };
+    const decode = fastReject
+      ? async (vin: string) => (await this.reject(vin, decodeOptions)) ?? this.decode(vin, decodeOptions)
+      : (vin: string) => this.decode(vin, decodeOptions);
+    const iterator =
+      Symbol.asyncIterator in vins
+        ? (vins as AsyncIterable<string>)[Symbol.asyncIterator]()
+        : (vins as Iterable<string>)[Symbol.iterator]();
+
+    if (reorderWindow > 1) {
+      yield* this.decodeReordered(iterator, reorderWindow, lookahead, decodeOptions, decode, stats);
+      return;
+    }
+
+    const queue: string[] = [];
+    let done = false;
+    let previous: string | undefined;
+
+    while (true) {
+      while (!done && queue.length <= lookahead) {
+        const next = await iterator.next();
+        if (next.done) {
+          done = true;
+        } else {
+          queue.push(next.value);
+          if (queue.length > 1) {
+            void this.prefetch(next.value, decodeOptions.modelYear, decodeOptions.overlay);
+          }
+        }
+      }
+
+      const vin = queue.shift();
+      if (vin === undefined) {
+        return;
+      }
+      if (stats) {
+        const group = this.localityKey(vin, decodeOptions.modelYear).group;
+        const hit = group === previous ? 1 : 0;
+        stats.decoded++;
+        stats.hits += hit;
+        stats.inputOrderHits += hit;
+        previous = group;
+      }
+      const result = await decode(vin);
+      if (stats) {
+        this.countPatternLookup(result, stats);
+      }
+      yield result;
+    }
+  }
+
+  /**
+   * Decode windows of VINs sorted by WMI, model year and VDS
+   *
+   * Interleaved input (a feed mixing hundreds of makes) otherwise switches
+   * pattern sets on almost every VIN, evicting bounded caches (shared cache
+   * L1, remote page cache) and compiled matchers before they are reused.
+   * Sorting a window makes VINs with the same pattern set decode back to
+   * back. Results are yielded in input order as soon as every earlier VIN in
+   * the window has been decoded.
+   */
+  private async *decodeReordered(
+    iterator: Iterator<string> | AsyncIterator<string>,
+    window: number,
+    lookahead: number,
+    options: DecodeOptions,
+    decode: (vin: string) => Promise<DecodeResult>,
+    stats?: BatchLocalityStats,
+  ): AsyncGenerator<DecodeResult> {
+    let done = false;
+    let previous: string | undefined;
+    let previousInput: string | undefined;
+
+    while (!done) {
+      const vins: string[] = [];
+      while (vins.length < window) {
+        const next = await iterator.next();
+        if (next.done) {
+          done = true;
+          break;
+        }
+        vins.push(next.value);
+      }
+      if (vins.length === 0) {
+        return;
+      }
+
+      const keys = vins.map(vin => this.localityKey(vin, options.modelYear));
+      const order = vins
+        .map((_, i) => i)
+        .sort((a, b) => (keys[a].sort < keys[b].sort ? -1 : keys[a].sort > keys[b].sort ? 1 : a - b));
+
+      if (stats) {
+        for (const key of keys) {
+          stats.inputOrderHits += key.group === previousInput ? 1 : 0;
+          previousInput = key.group;
+        }
+      }
+
+      const results: Array<DecodeResult | undefined> = new Array(vins.length);
+      let emitted = 0;
+      for (let position = 0; position < order.length; position++) {
+        // Warm the next pattern set while this group decodes
+        const ahead = order[position + lookahead];
+        if (lookahead > 0 && ahead !== undefined && keys[ahead].group !== keys[order[position + lookahead - 1]].group) {
+          void this.prefetch(vins[ahead], options.modelYear, options.overlay);
+        }
+
+        const index = order[position];
+        results[index] = await decode(vins[index]);
+        if (stats) {
+          stats.decoded++;
+          stats.hits += keys[index].group === previous ? 1 : 0;
+          previous = keys[index].group;
+          this.countPatternLookup(results[index]!, stats);
+        }
+
+        while (emitted < results.length && results[emitted] !== undefined) {
+          const result = results[emitted]!;
+          results[emitted++] = undefined;
+          yield result;
+        }
+      }
+    }
+  }
+
+  /**
+   * Shared error result for a VIN that fails before pattern lookup, if it does
+   *
+   * Structure is checked without building per-VIN errors; a VIN with a valid
+   * structure and model year is rejected when its WMI is unknown, which the
+   * database answers from cache for repeated WMIs.
+   */
+  private async reject(vin: string, options: DecodeOptions): Promise<DecodeResult | undefined> {
+    const cleanVin = vin.toUpperCase().trim();
+    const rejected = this.rejects.structure(cleanVin);
+    if (rejected || (!options.modelYear && !resolveModelYear(cleanVin)?.year)) {
+      return rejected;
+    }
+
+    const wmi = this.extractWMI(cleanVin);
+    try {
+      if (!(await this.scope(options.overlay).db.getWMI(wmi))) {
+        return this.rejects.unknownWmi(cleanVin, wmi);
+      }
+    } catch (error) {
+      // Database failures are reported by the full decode
+      logger.debug({ vin: cleanVin, error }, 'Reject check failed');
+    }
+    return undefined;
+  }
+
+  /**
+   * Count a decode's pattern set lookup as a cache hit or miss; decodes that
+   * never looked one up (fast rejects, cached results) count as neither
+   */
+  private countPatternLookup(result: DecodeResult, stats: BatchLocalityStats): void {
+    const cached = this.patternLookups.get(result);
+    if (cached === true) {
+      stats.cacheHits++;
+    } else if (cached === false) {
+      stats.cacheMisses++;
+    }
+  }
+
+  /**
+   * Grouping keys for a VIN: `group` identifies its pattern set (WMI and
+   * model year), `sort` also orders by VDS within the group
+   */
+  private localityKey(vin: string, modelYear?: number): { group: string; sort: string } {
+    const cleanVin = vin.toUpperCase().trim();
+    if (cleanVin.length !== 17) {
+      return { group: '', sort: '' };
+    }
+    const year = modelYear ?? resolveModelYear(cleanVin)?.year ?? 0;
+    const group = `${this.extractWMI(cleanVin)}|${year}`;
+    return { group, sort: `${group}|${cleanVin.substring(3, 9)}` };
+  }
+
+  /**
+   * Warm the caches for a VIN that will be decoded soon
+   *
+   * Only the cheap local steps (WMI extraction, model year) run here; failures
+   * are ignored and surface when the VIN is actually decoded.
+   *
+   * @param vin - VIN to prefetch
+   * @param modelYear - Optional model year override
+   * @param overlay - Optional tenant overlay the VIN will be decoded with
+   */
+  async prefetch(vin: string, modelYear?: number, overlay?: PatternOverlay): Promise<void> {
+    const cleanVin = vin.toUpperCase().trim();
+    if (cleanVin.length !== 17) {
+      return;
+    }
+
+    const resolved = modelYear ? undefined : resolveModelYear(cleanVin);
+    if (!modelYear && !resolved?.year) {
+      return;
+    }
+
+    try {
+      const wmi = this.extractWMI(cleanVin);
+      const { db, patternMatcher } = this.scope(overlay);
+      if (await db.getWMI(wmi)) {
+        const year = modelYear ?? (await this.selectModelYear(db, wmi, resolved!)).year;
+        await patternMatcher.prefetch(wmi, year);
+      }
+    } catch (error) {
+      logger.debug({ vin: cleanVin, error }, 'Prefetch failed');
+    }
+  }
+
+  /**
+   * Database and matcher for a decode, viewed through its overlay if any
+   *
+   * Views are created once per overlay and share this decoder's caches.
+   */
+  private scope(overlay?: PatternOverlay): { db: VPICDatabase; patternMatcher: PatternMatcher } {
+    if (!overlay) {
+      return { db: this.db, patternMatcher: this.patternMatcher };
+    }
+    let view = this.overlayViews.get(overlay);
+    if (!view) {
+      view = { db: this.db.withOverlay(overlay), patternMatcher: this.patternMatcher.withOverlay(overlay) };
+      this.overlayViews.set(overlay, view);
+    }
+    return view;
+  }
+
+  /**
+   * Decode a VIN without consulting the shared cache
+   */
+  private async decodeUncached(vin: string, options: DecodeOptions): Promise<DecodeResult> {
+    const prepared = this.prepare(vin, options);
+    await this.scheduler.checkpoint(options.priority ?? 'interactive');
+    return this.complete(prepared, options);
+  }
+
+  /**
+   * Run the database-independent decode stages: structure and check digit
+   * validation, model year and WMI extraction
+   *
+   * The returned state can be completed against any number of databases with
+   * `complete`, so these stages run once per VIN.
+   *
+   * @param vin - The Vehicle Identification Number to decode
+   * @param options - Optional configuration for the decoding process
+   * @returns Prepared decode state
+   */
+  prepare(vin: string, options: DecodeOptions = {}): PreparedDecode {
     // Record start time for processing
     const startTime = performance.now ? performance.now() : Date.now();
     const cleanVin = vin.toUpperCase().trim();
@@ -108,11 +591,11 @@ export class VINDecoder {
       if (structureErrors.length > 0) {
         result.errors = structureErrors;
         result.metadata!.processingTime = Date.now() - startTime;
-        return result;
+        return { vin: cleanVin, startTime, result, done: true };
       }
 
       // 2. Validate check digit
-      const checkDigit = this.validateCheckDigit(cleanVin);
+      const checkDigit = validateCheckDigit(cleanVin);
       result.components.checkDigit = checkDigit;
 
       if (!checkDigit.isValid) {
@@ -134,7 +617,7 @@ export class VINDecoder {
             source: 'override' as const,
             confidence: 1,
           }
-        : this.determineModelYear(cleanVin);
+        : resolveModelYear(cleanVin);
 
       if (!modelYear) {
         result.errors.push({
@@ -146,7 +629,7 @@ export class VINDecoder {
         } as ValidationError);
 
         result.metadata!.processingTime = Date.now() - startTime;
-        return result;
+        return { vin: cleanVin, startTime, result, done: true };
       }
 
       // Handle VIN 10th digit '0' - some countries don't encode model year
@@ -163,9 +646,67 @@ export class VINDecoder {
 
       result.components.modelYear = modelYear;
 
-      // 4. Get WMI information
+      // 4. Extract WMI
       const wmi = this.extractWMI(cleanVin);
-      const wmiInfo = await this.db.getWMI(wmi);
+
+      return { vin: cleanVin, startTime, result, wmi, modelYear, done: false };
+    } catch (error) {
+      logger.error({ vin, error }, 'Decoder error');
+
+      result.errors.push({
+        code: ErrorCode.QUERY_ERROR,
+        category: ErrorCategory.DATABASE,
+        severity: ErrorSeverity.ERROR,
+        message: 'Unexpected error during decoding',
+        details: error instanceof Error ? error.message : 'Unknown error',
+      } as DatabaseError);
+
+      result.metadata!.processingTime = performance.now
+        ? performance.now() - startTime
+        : Date.now() - startTime;
+
+      return { vin: cleanVin, startTime, result, done: true };
+    }
+  }
+
+  /**
+   * Run the database-dependent decode stages on prepared state
+   *
+   * The prepared state is not modified, so it can be completed again against
+   * another decoder's database.
+   *
+   * @param prepared - State from `prepare`
+   * @param options - Optional configuration for the decoding process
+   * @returns Decoded VIN information
+   */
+  async complete(prepared: PreparedDecode, options: DecodeOptions = {}): Promise<DecodeResult> {
+    const { vin, startTime, wmi } = prepared;
+    let { modelYear } = prepared;
+    const cleanVin = vin;
+    const result: DecodeResult = {
+      ...prepared.result,
+      components: { ...prepared.result.components },
+      errors: [...prepared.result.errors],
+      metadata: { ...prepared.result.metadata! },
+    };
+
+    // Prepared state holds only empty diagnostic arrays; give each completion its own
+    if (options.includeDiagnostics) {
+      result.metadata!.queries = [];
+    }
+    if (options.includeRawData) {
+      result.metadata!.rawRecords = [];
+    }
+
+    if (prepared.done || !wmi || !modelYear) {
+      return result;
+    }
+
+    const { db, patternMatcher } = this.scope(options.overlay);
+
+    try {
+      // 4. Get WMI information
+      const wmiInfo = await db.getWMI(wmi);
 
       if (!wmiInfo) {
         result.errors.push({
@@ -183,13 +724,25 @@ export class VINDecoder {
 
       result.components.wmi = wmiInfo;
 
+      // Pick the model year cycle the WMI's schemas actually cover
+      modelYear = await this.selectModelYear(db, wmi, modelYear);
+      result.components.modelYear = modelYear;
+
       // 5. Get pattern matches
+      await this.scheduler.checkpoint(options.priority ?? 'interactive');
       try {
         const vds = cleanVin.substring(3, 9);
         const vis = cleanVin.substring(9, 17);
 
         // Get pattern matches for this VIN
-        const patterns = await this.patternMatcher.getPatternMatches(wmi, modelYear.year, vds, vis);
+        const outcome: MatchOutcome = {};
+        const patterns = await patternMatcher.getPatternMatches(wmi, modelYear.year, vds, vis, outcome);
+        if (outcome.key !== undefined) {
+          this.outcomes.set(result, `${wmi}|${modelYear.year}|${outcome.key}`);
+        }
+        if (outcome.cached !== undefined) {
+          this.patternLookups.set(result, outcome.cached);
+        }
 
         if (patterns.length > 0) {
           // Split patterns into VDS and VIS components
@@ -601,148 +1154,26 @@ export class VINDecoder {
    * @returns WMI code
    */
   private extractWMI(vin: string): string {
-    // Handle standard and extended WMI cases
-    const baseWMI = vin.substring(0, 3);
-
-    // If position 3 is '9', this is an extended WMI, and part is encoded elsewhere in the VIN
-    if (baseWMI[2] === '9' && vin.length >= 14) {
-      return baseWMI + vin.substring(11, 14);
-    }
-
-    return baseWMI;
+    return extractWMI(vin);
   }
 
   /**
-   * Determine model year from VIN
+   * Choose the model year cycle from the years a WMI's schemas cover
    *
-   * @param vin - Complete VIN string
-   * @returns Model year information or null
-   */
-  private determineModelYear(vin: string): ModelYearResult | null {
-    const yearChar = vin[9].toUpperCase();
-    const position7 = vin[6].charCodeAt(0); // don't need uppercase for digits check
-
-    // Handle '0' - some countries don't encode model year
-    if (yearChar === '0') {
-      return {
-        year: 0,
-        source: 'position' as const,
-        confidence: 0,
-      };
-    }
-
-    const index = modelYearCodes.indexOf(yearChar);
-    if (index === -1) {
-      return null;
-    }
-
-    // Position 7 determines the decade block per 49 CFR 565.15
-    const baseYear = position7 >= 48 && position7 <= 57 ? 1980 : 2010;
-
-    // Adjust year for older vehicles
-    let adjustedYear = baseYear + index;
-
-    // If the year would be in the future, subtract 30 years
-    // This handles older vehicles from previous cycles
-    const nextYear = new Date().getFullYear() + 1;
-    if (adjustedYear > nextYear) {
-      adjustedYear -= 30;
-    }
-
-    return {
-      year: adjustedYear,
-      source: 'position',
-      confidence: 1,
-    };
-  }
-
-  /**
-   * Validate the check digit in a VIN
+   * Only position-derived years with more than one candidate need the WMI's
+   * year ranges. They come from the index, or from the same cached schema
+   * query the pattern lookup then filters, so no extra query is made.
    *
-   * @param vin - Complete VIN string
-   * @returns Check digit validation result
+   * @param db - Database (or overlay view) the VIN is decoded against
+   * @param wmi - WMI code
+   * @param modelYear - Model year from the prepare stage
+   * @returns Model year to decode with
    */
-  private validateCheckDigit(vin: string): CheckDigitResult {
-    // Check digit weights according to CFR Title 49 § 565.15(c)
-    const weights = [8, 7, 6, 5, 4, 3, 2, 10, 0, 9, 8, 7, 6, 5, 4, 3, 2];
-
-    // Transliterate characters to numerical values
-    const transliterate = (c: string): number => {
-      const char = c.toUpperCase();
-
-      if (/[0-9]/.test(char)) return parseInt(char, 10);
-
-      if (/[A-Z]/.test(char)) {
-        // Values according to CFR Title 49 § 565.15(c)
-        switch (char) {
-          case 'A':
-            return 1;
-          case 'B':
-            return 2;
-          case 'C':
-            return 3;
-          case 'D':
-            return 4;
-          case 'E':
-            return 5;
-          case 'F':
-            return 6;
-          case 'G':
-            return 7;
-          case 'H':
-            return 8;
-          case 'J':
-            return 1;
-          case 'K':
-            return 2;
-          case 'L':
-            return 3;
-          case 'M':
-            return 4;
-          case 'N':
-            return 5;
-          case 'P':
-            return 7;
-          case 'R':
-            return 9;
-          case 'S':
-            return 2;
-          case 'T':
-            return 3;
-          case 'U':
-            return 4;
-          case 'V':
-            return 5;
-          case 'W':
-            return 6;
-          case 'X':
-            return 7;
-          case 'Y':
-            return 8;
-          case 'Z':
-            return 9;
-          default:
-            return 0;
-        }
-      }
-
-      return 0;
-    };
-
-    // Calculate weighted sum
-    const sum = [...vin].reduce((acc, char, idx) => acc + transliterate(char) * weights[idx], 0);
-
-    // Calculate check digit
-    const calculated = sum % 11;
-    const expected = calculated === 10 ? 'X' : calculated.toString();
-    const actual = vin[8].toUpperCase();
-
-    return {
-      position: 9,
-      actual,
-      expected,
-      isValid: actual === expected,
-    };
+  private async selectModelYear(db: VPICDatabase, wmi: string, modelYear: ModelYearResult): Promise<ModelYearResult> {
+    if (!modelYear.candidates || modelYear.candidates.length < 2) {
+      return modelYear;
+    }
+    return selectModelYear(modelYear, await db.getWmiYearRanges(wmi));
   }
 
   /**
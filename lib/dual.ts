@@ -0,0 +1,287 @@
+import { createHash } from 'crypto';
+import type { DatabaseAdapter } from './db/adapter';
+import { VPICDatabase } from './db';
+import { VINDecoder } from './decode';
+import type { DecodeOptions, DecodeResult } from './types';
+
+/**
+ * WMIs whose decode inputs differ between two database snapshots
+ */
+export interface DiffManifest {
+  /** Format version */
+  version: 1;
+
+  /** WMIs with identical WMI info, schemas, patterns and resolved lookup values */
+  unchanged: string[];
+
+  /** WMIs with any difference (including added or removed) */
+  changed: string[];
+}
+
+/**
+ * A single field that differs between two decodes
+ */
+export interface FieldChange {
+  field: string;
+  before: unknown;
+  after: unknown;
+}
+
+/**
+ * Result of decoding one VIN against both snapshots
+ */
+export interface DualDecodeResult {
+  vin: string;
+  before: DecodeResult;
+  after: DecodeResult;
+  /** True when the second decode was skipped and `before` reused */
+  reused: boolean;
+  changes: FieldChange[];
+}
+
+/**
+ * Compact diff report for a corpus
+ */
+export interface DualDecodeReport {
+  summary: {
+    total: number;
+    changed: number;
+    unchanged: number;
+    reused: number;
+    /** Number of VINs in which each field changed */
+    fields: Record<string, number>;
+  };
+  /** Changed VINs only */
+  changes: Array<{ vin: string; changes: FieldChange[] }>;
+}
+
+/** Largest id list sent in one lookup query */
+const LOOKUP_CHUNK_SIZE = 500;
+
+/**
+ * Per-snapshot fingerprints of everything a WMI's decodes read
+ */
+class SnapshotFingerprints {
+  private db: VPICDatabase;
+  private schemas = new Map<number, string>();
+
+  constructor(adapter: DatabaseAdapter) {
+    this.db = new VPICDatabase(adapter);
+  }
+
+  async wmi(wmi: string): Promise<string> {
+    const hash = createHash('sha1');
+    const info = await this.db.getWMI(wmi);
+    hash.update(JSON.stringify(info));
+
+    if (info) {
+      const ranges = await this.db.getSchemaYearRanges(wmi);
+      hash.update(JSON.stringify(ranges));
+      for (const { SchemaId } of ranges) {
+        hash.update(await this.schema(SchemaId));
+      }
+    }
+
+    return hash.digest('hex');
+  }
+
+  /**
+   * Hash a schema's pattern rows together with the lookup values they resolve to
+   */
+  private async schema(schemaId: number): Promise<string> {
+    let digest = this.schemas.get(schemaId);
+    if (digest) {
+      return digest;
+    }
+
+    const rows = await this.db.getPatterns([schemaId]);
+    const hash = createHash('sha1').update(JSON.stringify(rows));
+
+    const idsByTable = new Map<string, Set<string>>();
+    for (const row of rows) {
+      if (row.LookupTable && row.AttributeId !== null && row.AttributeId !== undefined) {
+        if (!idsByTable.has(row.LookupTable)) {
+          idsByTable.set(row.LookupTable, new Set());
+        }
+        idsByTable.get(row.LookupTable)!.add(String(row.AttributeId));
+      }
+    }
+
+    for (const table of [...idsByTable.keys()].sort()) {
+      const ids = [...idsByTable.get(table)!].sort();
+      for (let i = 0; i < ids.length; i += LOOKUP_CHUNK_SIZE) {
+        const chunk = ids.slice(i, i + LOOKUP_CHUNK_SIZE);
+        const values = await this.db.lookupValues(table, chunk);
+        hash.update(JSON.stringify([table, chunk.map(id => values.get(id) ?? null)]));
+      }
+    }
+
+    digest = hash.digest('hex');
+    this.schemas.set(schemaId, digest);
+    return digest;
+  }
+}
+
+/**
+ * Compare two database snapshots for a set of WMIs
+ *
+ * A WMI is unchanged when its WMI info, schema year ranges, pattern rows and
+ * the lookup values those patterns resolve to are identical, so any VIN under
+ * it decodes identically on both snapshots.
+ *
+ * @param before - Adapter for the current snapshot
+ * @param after - Adapter for the candidate snapshot
+ * @param wmis - WMIs to compare
+ * @returns Diff manifest
+ */
+export async function buildDiffManifest(
+  before: DatabaseAdapter,
+  after: DatabaseAdapter,
+  wmis: Iterable<string>,
+): Promise<DiffManifest> {
+  const left = new SnapshotFingerprints(before);
+  const right = new SnapshotFingerprints(after);
+  const manifest: DiffManifest = { version: 1, unchanged: [], changed: [] };
+
+  for (const wmi of new Set(wmis)) {
+    const [a, b] = await Promise.all([left.wmi(wmi), right.wmi(wmi)]);
+    (a === b ? manifest.unchanged : manifest.changed).push(wmi);
+  }
+
+  return manifest;
+}
+
+/**
+ * Flatten the user-visible parts of a result for comparison
+ */
+function flattenResult(result: DecodeResult): Record<string, unknown> {
+  const fields: Record<string, unknown> = {
+    valid: result.valid,
+    errors: result.errors.map(error => error.code).sort().join(','),
+    matchedSchema: result.metadata?.matchedSchema,
+  };
+
+  for (const section of ['wmi', 'vehicle', 'engine', 'plant'] as const) {
+    const value = result.components[section] as Record<string, unknown> | undefined;
+    for (const [key, field] of Object.entries(value ?? {})) {
+      if (field !== undefined && typeof field !== 'object') {
+        fields[`${section}.${key}`] = field;
+      }
+    }
+  }
+
+  return fields;
+}
+
+/**
+ * Field-level differences between two results
+ *
+ * @param before - Result from the current snapshot
+ * @param after - Result from the candidate snapshot
+ * @returns Changed fields
+ */
+export function diffResults(before: DecodeResult, after: DecodeResult): FieldChange[] {
+  const a = flattenResult(before);
+  const b = flattenResult(after);
+  const changes: FieldChange[] = [];
+
+  for (const field of new Set([...Object.keys(a), ...Object.keys(b)])) {
+    if (a[field] !== b[field]) {
+      changes.push({ field, before: a[field], after: b[field] });
+    }
+  }
+
+  return changes;
+}
+
+/**
+ * Decode VINs against two database snapshots, sharing database-independent work
+ *
+ * Validation, check digit, model year and WMI extraction run once per VIN;
+ * only the database stages run against both snapshots, and the second run is
+ * skipped for WMIs the manifest lists as unchanged.
+ */
+export class DualDecoder {
+  private before: VINDecoder;
+  private after: VINDecoder;
+  private unchanged: Set<string>;
+
+  /**
+   * @param before - Adapter for the current snapshot
+   * @param after - Adapter for the candidate snapshot
+   * @param manifest - Optional diff manifest from buildDiffManifest
+   */
+  constructor(before: DatabaseAdapter, after: DatabaseAdapter, manifest?: DiffManifest) {
+    this.before = new VINDecoder(before);
+    this.after = new VINDecoder(after);
+    this.unchanged = new Set(manifest?.unchanged ?? []);
+  }
+
+  /**
+   * Decode one VIN against both snapshots
+   *
+   * @param vin - The VIN to decode
+   * @param options - Decode options
+   * @returns Both results and their differences
+   */
+  async decode(vin: string, options: DecodeOptions = {}): Promise<DualDecodeResult> {
+    const prepared = this.before.prepare(vin, options);
+
+    if (prepared.done || this.unchanged.has(prepared.wmi!)) {
+      const before = await this.before.complete(prepared, options);
+      return { vin: prepared.vin, before, after: before, reused: true, changes: [] };
+    }
+
+    const [before, after] = await Promise.all([
+      this.before.complete(prepared, options),
+      this.after.complete(prepared, options),
+    ]);
+
+    return { vin: prepared.vin, before, after, reused: false, changes: diffResults(before, after) };
+  }
+
+  /**
+   * Decode a corpus against both snapshots and summarize the differences
+   *
+   * @param vins - VINs to decode
+   * @param options - Decode options
+   * @returns Compact diff report
+   */
+  async report(
+    vins: Iterable<string> | AsyncIterable<string>,
+    options: DecodeOptions = {},
+  ): Promise<DualDecodeReport> {
+    const report: DualDecodeReport = {
+      summary: { total: 0, changed: 0, unchanged: 0, reused: 0, fields: {} },
+      changes: [],
+    };
+
+    for await (const vin of vins) {
+      const result = await this.decode(vin, options);
+      report.summary.total++;
+      if (result.reused) {
+        report.summary.reused++;
+      }
+
+      if (result.changes.length === 0) {
+        report.summary.unchanged++;
+        continue;
+      }
+
+      report.summary.changed++;
+      report.changes.push({ vin: result.vin, changes: result.changes });
+      for (const { field } of result.changes) {
+        report.summary.fields[field] = (report.summary.fields[field] ?? 0) + 1;
+      }
+    }
+
+    return report;
+  }
+
+  /**
+   * Close both snapshots
+   */
+  async close(): Promise<void> {
+    await Promise.all([this.before.close(), this.after.close()]);
+  }
+}
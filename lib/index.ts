@@ -6,24 +6,109 @@
  */
 
 // Core decoder
-import { VINDecoder, decodeVIN as decodeVINCore } from './decode';
+import { VINDecoder, decodeVIN as decodeVINCore, extractWMI } from './decode';
 
 // Database adapters
 import type { DatabaseAdapter, QueryResult, DatabaseAdapterFactory } from './db/adapter';
 
 import { BrowserDatabaseAdapter, BrowserDatabaseAdapterFactory } from './db/browser-adapter';
+import type { BrowserAdapterOptions, BrowserLoadProgress } from './db/browser-adapter';
 
 import { NodeDatabaseAdapter, NodeDatabaseAdapterFactory } from './db/node-adapter';
 
+import {
+  HttpRangeDatabaseAdapter,
+  HttpRangeDatabaseAdapterFactory,
+  RemotePageCache,
+} from './db/http-adapter';
+import type { HttpRangeAdapterOptions, RemotePageCacheStats } from './db/http-adapter';
+
 import { CloudflareD1Adapter, createD1Adapter } from './db/d1-adapter';
+import type { D1AdapterOptions } from './db/d1-adapter';
+
+import { HotIndex, IndexedDatabaseAdapter } from './db/hot-index';
+import type { HotIndexData, HotIndexStats } from './db/hot-index';
+import { compileHotIndex } from './db/hot-index-builder';
+import { RecordingDatabaseAdapter, ReplayDatabaseAdapter } from './db/replay-adapter';
+import type {
+  LatencyModel,
+  QueryRecording,
+  RecordedQuery,
+  ReplayAdapterOptions,
+  ReplayStats,
+} from './db/replay-adapter';
+import { MatchKernel } from './db/match-kernel';
+import type { MatchKernelOptions, MatchKernelStats } from './db/match-kernel';
+
+// Shared cache
+import { TieredCache } from './cache/backend';
+import type { CacheBackend, TieredCacheOptions, TieredCacheStats } from './cache/backend';
+import { RespCacheBackend } from './cache/resp-backend';
+import type { RespCacheOptions } from './cache/resp-backend';
+
+// Snapshot migration validation
+import { DualDecoder, buildDiffManifest, diffResults } from './dual';
+import type { DiffManifest, DualDecodeResult, DualDecodeReport, FieldChange } from './dual';
+
+// Worker pool, admission control and HTTP serving
+import { DecoderPool } from './pool';
+import type { DecoderPoolOptions, DecoderPoolStats, PoolDecoder } from './pool';
+import { AdmissionController, OverloadError } from './admission';
+import type { AdmissionOptions, AdmissionStats, RequestClass } from './admission';
+import { LatencyHistogram, PriorityScheduler } from './scheduler';
+import type { LatencyStats, PrioritySchedulerOptions, SchedulerStats } from './scheduler';
+import { createDecodeServer, renderMetrics } from './server';
+import { affinityKey, pickByAffinity, rankByAffinity } from './affinity';
+import type { AffinityMode } from './affinity';
+
+// Sharded bulk decode of large files
+import { bulkDecode, planShards } from './bulk';
+import type { BulkDecodeOptions, BulkDecodeSummary, BulkDecoder, BulkManifest, BulkShard } from './bulk';
+
+// Tenant pattern overlays
+import { PatternOverlay } from './overlay';
+import type { OverlayFile, OverlayPattern } from './overlay';
+
+// Free-text make and model search
+import { ModelSearchIndex, tokenizeSearchText } from './search';
+import type { ModelSearchMemoryReport, ModelSearchOptions, ModelSearchResult } from './search';
+
+// Shared result components
+import { ResultTemplates } from './templates';
+import type { ResultTemplateStats } from './templates';
+import { RejectTemplates } from './reject';
+import type { RejectStats } from './reject';
+
+// Web Streams decode interface
+import { createDecodeStream, createByteDecodeStream, createNdjsonStream } from './stream';
+import type { DecodeStreamOptions, StreamDecoder } from './stream';
+
+// Make, model and year catalog
+import { VehicleCatalog, compileCatalog } from './db/catalog';
+import type { CatalogData, CatalogItem, CatalogStats } from './db/catalog';
+import { PlausibilityFilter, compilePlausibilityFilter } from './db/plausibility';
+import type {
+  PlausibilityCheckOptions,
+  PlausibilityFilterOptions,
+  PlausibilityFilterStats,
+} from './db/plausibility';
+import { findSimilarVins } from './similarity';
+import type { NearDuplicatePair, SimilarVinPair, SimilarityJoinOptions } from './similarity';
 
 // Database utilities for compressed database handling
-import { getDatabasePath } from './db/utils';
+import { getCachedDatabasePath, getDatabasePath, getDatabaseVersion } from './db/utils';
+import { IndexCacheAdapter } from './db/index-cache';
+import type { IndexCacheKey, IndexCacheOptions, IndexCacheStats } from './db/index-cache';
+import { applyDeltas, createDelta, publishDelta, planDeltaChain } from './db/delta';
+import type { DeltaBuild, DeltaEntry, DeltaManifest, DeltaUpdateResult } from './db/delta';
 
 // Type imports
 import type {
   DecodeResult,
   DecodeOptions,
+  DecodePriority,
+  BatchDecodeOptions,
+  BatchLocalityStats,
   VINComponents,
   VehicleInfo,
   PlantInfo,
@@ -40,6 +125,7 @@ import type {
   DatabaseError,
   Position,
   DiagnosticInfo,
+  PreparedDecode,
 } from './types';
 
 // Enum imports
@@ -64,6 +150,12 @@ export interface DecoderConfig {
    */
   forceFresh?: boolean;
 
+  /**
+   * Directory or HTTP(S) base URL of database deltas used to update the cached database
+   * (defaults to the deltas shipped with the package, if any)
+   */
+  deltas?: string;
+
   /**
    * Optional default decode options
    */
@@ -73,6 +165,35 @@ export interface DecoderConfig {
    * Runtime environment (automatic detection if not specified)
    */
   runtime?: 'node' | 'browser' | 'cloudflare';
+
+  /**
+   * Shared second-level cache for pattern sets and decode results
+   */
+  cache?: CacheBackend;
+
+  /**
+   * Shared cache options (dbVersion defaults to a fingerprint of the database)
+   */
+  cacheOptions?: Partial<TieredCacheOptions>;
+
+  /**
+   * Build the model search index while creating the decoder (default: true in
+   * Node.js; elsewhere it is built on the first search, so browser cold starts
+   * and per-request D1 decoders do not pay for it)
+   */
+  searchIndex?: boolean;
+
+  /**
+   * Keep the WMIs this process decodes compiled in a file next to the database,
+   * so restarts skip rebuilding them from SQL (Node.js only; default: on for the
+   * database in ~/.corgi-cache, off for other paths)
+   */
+  indexCache?: boolean | IndexCacheOptions;
+
+  /**
+   * Options for scheduling interactive decodes ahead of bulk decodes
+   */
+  scheduler?: PrioritySchedulerOptions;
 }
 
 /**
@@ -103,14 +224,18 @@ export async function createDecoder(config: DecoderConfig = {}): Promise<VINDeco
   const {
     databasePath,
     forceFresh = false,
+    deltas,
     defaultOptions = {},
     runtime = detectRuntime(),
+    cache,
+    cacheOptions = {},
   } = config;
 
   // Get the appropriate database path (handles decompression if needed)
   const resolvedDbPath = await getDatabasePath({
     databasePath,
     forceFresh,
+    deltas,
   });
 
   logger.debug({ runtime, databasePath: resolvedDbPath }, 'Creating VIN decoder');
@@ -131,27 +256,60 @@ export async function createDecoder(config: DecoderConfig = {}): Promise<VINDeco
     // Node.js adapter
     const factory = new NodeDatabaseAdapterFactory();
     adapter = await factory.createAdapter(resolvedDbPath);
+
+    const { indexCache = resolvedDbPath === getCachedDatabasePath() } = config;
+    if (indexCache) {
+      adapter = await IndexCacheAdapter.open(adapter, resolvedDbPath, indexCache === true ? {} : indexCache);
+    }
   }
 
-  return new VINDecoderWrapper(adapter, defaultOptions);
+  const sharedCache = cache
+    ? new TieredCache(cache, {
+        ...cacheOptions,
+        dbVersion:
+          cacheOptions.dbVersion ??
+          (runtime === 'node' ? getDatabaseVersion(resolvedDbPath) : await fingerprintDatabase(adapter)),
+      })
+    : undefined;
+
+  const decoder = new VINDecoderWrapper(adapter, defaultOptions, sharedCache, config.scheduler);
+  if (config.searchIndex ?? runtime === 'node') {
+    const index = await decoder.getSearchIndex();
+    logger.debug(index.getMemoryReport(), 'Model search index ready');
+  }
+  return decoder;
 }
 
 /**
  * Wrapper for VIN decoder with simplified API
  */
 export class VINDecoderWrapper {
+  private adapter: DatabaseAdapter;
   private decoder: VINDecoder;
   private defaultOptions: DecodeOptions;
+  private sharedCache?: TieredCache;
+  private searchIndex?: Promise<ModelSearchIndex>;
+  private catalog?: Promise<VehicleCatalog>;
+  private plausibilityFilter?: Promise<PlausibilityFilter>;
 
   /**
    * Create a new VIN decoder wrapper
    *
    * @param adapter - Database adapter
    * @param defaultOptions - Default decode options
+   * @param sharedCache - Optional shared second-level cache
+   * @param scheduler - Options for scheduling interactive and bulk decodes
    */
-  constructor(adapter: DatabaseAdapter, defaultOptions: DecodeOptions = {}) {
-    this.decoder = new VINDecoder(adapter);
+  constructor(
+    adapter: DatabaseAdapter,
+    defaultOptions: DecodeOptions = {},
+    sharedCache?: TieredCache,
+    scheduler?: PrioritySchedulerOptions,
+  ) {
+    this.adapter = adapter;
+    this.decoder = new VINDecoder(adapter, sharedCache, scheduler);
     this.defaultOptions = defaultOptions;
+    this.sharedCache = sharedCache;
   }
 
   /**
@@ -170,11 +328,189 @@ export class VINDecoderWrapper {
     return this.decoder.decode(vin, mergedOptions);
   }
 
+  /**
+   * Validate VIN structure and check digit without touching the database
+   *
+   * @param vin - The VIN to validate
+   * @returns Validation result
+   */
+  validate(vin: string): DecodeResult {
+    return this.decoder.validate(vin);
+  }
+
+  /**
+   * Decode a list of VINs, prefetching upcoming VINs while earlier ones decode
+   *
+   * @param vins - VINs to decode
+   * @param options - Optional decode options and lookahead depth
+   * @returns Decoded VIN information, in input order
+   */
+  decodeBatch(vins: string[], options?: BatchDecodeOptions): Promise<DecodeResult[]> {
+    return this.decoder.decodeBatch(vins, { ...this.defaultOptions, ...options });
+  }
+
+  /**
+   * Find pairs of VINs within `maxDistance` differing positions, annotated
+   * with check digit validity and whether both decode to the same vehicle
+   *
+   * @param vins - VINs to join
+   * @param options - Optional decode options, lookahead depth and maximum distance (default: 1)
+   * @returns Pairs, ordered by the first VIN's input position
+   */
+  findNearDuplicates(vins: Iterable<string>, options?: BatchDecodeOptions & SimilarityJoinOptions): Promise<NearDuplicatePair[]> {
+    return this.decoder.findNearDuplicates(vins, { ...this.defaultOptions, ...options });
+  }
+
+  /**
+   * Decode a stream of VINs, prefetching upcoming VINs while earlier ones decode
+   *
+   * @param vins - VINs to decode (array, iterable or async iterable)
+   * @param options - Optional decode options, lookahead depth and reorder window
+   * @param stats - Locality counters to add this stream's decodes to
+   * @returns Decoded VIN information, in input order
+   */
+  decodeStream(
+    vins: Iterable<string> | AsyncIterable<string>,
+    options?: BatchDecodeOptions,
+    stats?: BatchLocalityStats,
+  ): AsyncGenerator<DecodeResult> {
+    return this.decoder.decodeStream(vins, { ...this.defaultOptions, ...options }, stats);
+  }
+
+  /**
+   * Find makes and models matching free text such as "f150" or "model y lr"
+   *
+   * The search index is built by createDecoder in Node.js (otherwise on
+   * first use, see `searchIndex`) and kept in memory.
+   *
+   * @param text - Search text
+   * @param options - Make and year filters, result limit
+   * @returns Matches, best first
+   */
+  async searchModels(text: string, options?: ModelSearchOptions): Promise<ModelSearchResult[]> {
+    return (await this.getSearchIndex()).searchModels(text, options);
+  }
+
+  /**
+   * Get the model search index, building it on first use
+   */
+  getSearchIndex(): Promise<ModelSearchIndex> {
+    if (!this.searchIndex) {
+      this.searchIndex = ModelSearchIndex.build(this.adapter);
+      this.searchIndex.catch(() => (this.searchIndex = undefined));
+    }
+    return this.searchIndex;
+  }
+
+  /**
+   * List makes with at least one model in a model year
+   *
+   * @param year - Model year
+   * @returns Makes sorted by name
+   */
+  async listMakes(year: number): Promise<CatalogItem[]> {
+    return (await this.getCatalog()).listMakes(year);
+  }
+
+  /**
+   * List a make's models, optionally only those in a model year
+   *
+   * @param make - Make id or name
+   * @param year - Model year
+   * @returns Models sorted by name
+   */
+  async listModels(make: number | string, year?: number): Promise<CatalogItem[]> {
+    return (await this.getCatalog()).listModels(make, year);
+  }
+
+  /**
+   * List the model years of a make's model
+   *
+   * @param make - Make id or name
+   * @param model - Model id or name
+   * @returns Years in ascending order
+   */
+  async listYears(make: number | string, model: number | string): Promise<number[]> {
+    return (await this.getCatalog()).listYears(make, model);
+  }
+
+  /**
+   * Get the make, model and year catalog, loading it on first use
+   */
+  getCatalog(): Promise<VehicleCatalog> {
+    if (!this.catalog) {
+      this.catalog = VehicleCatalog.load(this.adapter);
+      this.catalog.catch(() => (this.catalog = undefined));
+    }
+    return this.catalog;
+  }
+
+  /**
+   * Check whether a VIN could exist, without SQL or pattern scoring
+   *
+   * For high volumes, get the filter once with `getPlausibilityFilter` and
+   * call its synchronous `isPlausible`.
+   *
+   * @param vin - VIN to check
+   * @param options - Check options
+   * @returns False when the VIN certainly does not decode to a model; true when it probably does
+   */
+  async isPlausible(vin: string, options?: PlausibilityCheckOptions): Promise<boolean> {
+    return (await this.getPlausibilityFilter()).isPlausible(vin.trim(), options);
+  }
+
+  /**
+   * Get the VIN plausibility filter, loading it on first use
+   */
+  getPlausibilityFilter(): Promise<PlausibilityFilter> {
+    if (!this.plausibilityFilter) {
+      this.plausibilityFilter = PlausibilityFilter.load(this.adapter);
+      this.plausibilityFilter.catch(() => (this.plausibilityFilter = undefined));
+    }
+    return this.plausibilityFilter;
+  }
+
   /**
    * Close the decoder and release resources
    */
   async close(): Promise<void> {
     await this.decoder.close();
+    await this.sharedCache?.close();
+  }
+
+  /**
+   * Get shared cache statistics, if a shared cache is configured
+   */
+  getCacheStats(): TieredCacheStats | undefined {
+    return this.sharedCache?.getStats();
+  }
+
+  /**
+   * Get compiled index cache statistics, if the index cache is enabled
+   */
+  getIndexCacheStats(): IndexCacheStats | undefined {
+    return this.adapter instanceof IndexCacheAdapter ? this.adapter.getStats() : undefined;
+  }
+
+  /**
+   * Get statistics for components shared with `shareComponents`
+   */
+  getTemplateStats(): ResultTemplateStats {
+    return this.decoder.getTemplateStats();
+  }
+
+  /**
+   * Get counts of VINs rejected with `fastReject`
+   */
+  getRejectStats(): RejectStats {
+    return this.decoder.getRejectStats();
+  }
+
+  /**
+   * Get interactive and bulk decode counts and latency
+   */
+  getSchedulerStats(): SchedulerStats {
+    return this.decoder.getSchedulerStats();
   }
 }
 
@@ -256,6 +592,21 @@ export async function decodeVIN(
   return decodeVINCore(vin, adapter, options);
 }
 
+/**
+ * Fingerprint a database through its adapter, for runtimes without file access
+ *
+ * @param adapter - Database adapter
+ * @returns Version string that changes when patterns or schemas change
+ */
+async function fingerprintDatabase(adapter: DatabaseAdapter): Promise<string> {
+  const [result] = await adapter.exec(
+    `SELECT (SELECT COUNT(*) FROM Pattern), (SELECT MAX(Id) FROM Pattern),
+            (SELECT COUNT(*) FROM VinSchema), (SELECT MAX(Id) FROM VinSchema)`,
+  );
+  const row = result?.values[0] ?? [];
+  return `db-${row.map(value => Number(value ?? 0).toString(36)).join('-')}`;
+}
+
 /**
  * Detect the current runtime environment
  *
@@ -277,8 +628,8 @@ function detectRuntime(): 'node' | 'browser' | 'cloudflare' {
 }
 
 // Initialize D1 adapter for Cloudflare environment
-export function initD1Adapter(d1: any): void {
-  globalThis.__D1_FACTORY = async () => createD1Adapter(d1);
+export function initD1Adapter(d1: any, options: D1AdapterOptions = {}): void {
+  globalThis.__D1_FACTORY = async () => createD1Adapter(d1, options);
 }
 
 // Declare global D1 factory
@@ -294,6 +645,9 @@ export type {
   DatabaseAdapterFactory,
   DecodeResult,
   DecodeOptions,
+  DecodePriority,
+  BatchDecodeOptions,
+  BatchLocalityStats,
   VINComponents,
   VehicleInfo,
   PlantInfo,
@@ -310,6 +664,69 @@ export type {
   DatabaseError,
   Position,
   DiagnosticInfo,
+  HttpRangeAdapterOptions,
+  RemotePageCacheStats,
+  BrowserAdapterOptions,
+  BrowserLoadProgress,
+  D1AdapterOptions,
+  IndexCacheKey,
+  IndexCacheOptions,
+  IndexCacheStats,
+  LatencyModel,
+  QueryRecording,
+  RecordedQuery,
+  ReplayAdapterOptions,
+  ReplayStats,
+  HotIndexData,
+  HotIndexStats,
+  MatchKernelOptions,
+  MatchKernelStats,
+  CacheBackend,
+  TieredCacheOptions,
+  TieredCacheStats,
+  RespCacheOptions,
+  DecoderPoolOptions,
+  DecoderPoolStats,
+  PoolDecoder,
+  AdmissionOptions,
+  AdmissionStats,
+  RequestClass,
+  LatencyStats,
+  PrioritySchedulerOptions,
+  SchedulerStats,
+  AffinityMode,
+  PreparedDecode,
+  BulkDecodeOptions,
+  BulkDecodeSummary,
+  BulkDecoder,
+  BulkManifest,
+  BulkShard,
+  DiffManifest,
+  DualDecodeResult,
+  DualDecodeReport,
+  FieldChange,
+  OverlayFile,
+  OverlayPattern,
+  ModelSearchMemoryReport,
+  ModelSearchOptions,
+  ModelSearchResult,
+  CatalogData,
+  CatalogItem,
+  CatalogStats,
+  PlausibilityCheckOptions,
+  PlausibilityFilterOptions,
+  PlausibilityFilterStats,
+  SimilarityJoinOptions,
+  SimilarVinPair,
+  NearDuplicatePair,
+  DeltaBuild,
+  DeltaEntry,
+  DeltaManifest,
+  DeltaUpdateResult,
+  DecodeStreamOptions,
+  StreamDecoder,
+  ResultTemplateStats,
+  RejectStats,
 };
 
 // Export classes, enums and functions
@@ -323,8 +740,54 @@ export {
   BrowserDatabaseAdapterFactory,
   NodeDatabaseAdapter,
   NodeDatabaseAdapterFactory,
+  HttpRangeDatabaseAdapter,
+  HttpRangeDatabaseAdapterFactory,
+  RemotePageCache,
   CloudflareD1Adapter,
   createD1Adapter,
+  HotIndex,
+  IndexedDatabaseAdapter,
+  IndexCacheAdapter,
+  RecordingDatabaseAdapter,
+  ReplayDatabaseAdapter,
+  compileHotIndex,
+  MatchKernel,
+  TieredCache,
+  RespCacheBackend,
+  DecoderPool,
+  AdmissionController,
+  OverloadError,
+  LatencyHistogram,
+  PriorityScheduler,
+  createDecodeServer,
+  renderMetrics,
+  affinityKey,
+  rankByAffinity,
+  pickByAffinity,
+  bulkDecode,
+  planShards,
+  DualDecoder,
+  buildDiffManifest,
+  diffResults,
+  PatternOverlay,
+  ModelSearchIndex,
+  tokenizeSearchText,
+  VehicleCatalog,
+  compileCatalog,
+  PlausibilityFilter,
+  compilePlausibilityFilter,
+  findSimilarVins,
+  createDecodeStream,
+  createByteDecodeStream,
+  createNdjsonStream,
+  ResultTemplates,
+  RejectTemplates,
+  extractWMI,
   createLogger,
   getDatabasePath,
+  getDatabaseVersion,
+  applyDeltas,
+  createDelta,
+  publishDelta,
+  planDeltaChain,
 };
@@ -0,0 +1,119 @@
+import type { ModelYearResult } from './types';
+
+/** Years between two uses of the same model year character */
+export const MODEL_YEAR_CYCLE = 30;
+
+/** First year of the cycle selected by a numeric position 7 (49 CFR 565.15) */
+const CYCLE_A = 1980;
+
+/** First year of the cycle selected by an alphabetic position 7 */
+const CYCLE_B = 2010;
+
+/**
+ * Position-10 year for each character code, as an offset into a cycle (-1 when
+ * the character does not encode a year). Built once; a decode reads one slot.
+ */
+const YEAR_OFFSETS = (() => {
+  const offsets = new Int8Array(128).fill(-1);
+  'ABCDEFGHJKLMNPRSTVWXY123456789'.split('').forEach((char, offset) => {
+    offsets[char.charCodeAt(0)] = offset;
+    offsets[char.toLowerCase().charCodeAt(0)] = offset;
+  });
+  return offsets;
+})();
+
+/** Latest plausible model year and when it next changes */
+let latestYear = 0;
+let latestYearUntil = 0;
+
+/**
+ * Latest model year a VIN can carry: next calendar year, recomputed only when
+ * the calendar year rolls over
+ */
+function getLatestModelYear(): number {
+  const now = Date.now();
+  if (now >= latestYearUntil) {
+    const year = new Date(now).getFullYear();
+    latestYear = year + 1;
+    latestYearUntil = new Date(year + 1, 0, 1).getTime();
+  }
+  return latestYear;
+}
+
+/**
+ * Resolve the model year encoded in position 10
+ *
+ * Every year character appears once per 30-year cycle. Position 7 picks the
+ * cycle for North American light vehicles (digit: 1980-2009, letter:
+ * 2010-2039), and a year beyond next year falls back one cycle. The other
+ * cycle's year, when not in the future, is returned in `candidates` so a
+ * caller that knows which years a manufacturer used can choose between them.
+ *
+ * @param vin - Upper- or lower-case VIN (at least 10 characters)
+ * @returns Model year with candidates (most likely first), a year of 0 when
+ *   position 10 is "0", or null if position 10 does not encode a year
+ */
+export function resolveModelYear(vin: string): ModelYearResult | null {
+  const code = vin.charCodeAt(9);
+  if (code === 48) {
+    // Some countries do not encode the model year
+    return { year: 0, source: 'position', confidence: 0 };
+  }
+
+  const offset = code < 128 ? YEAR_OFFSETS[code] : -1;
+  if (offset === -1) {
+    return null;
+  }
+
+  const position7 = vin.charCodeAt(6);
+  const numeric = position7 >= 48 && position7 <= 57;
+  const latest = getLatestModelYear();
+
+  let year = (numeric ? CYCLE_A : CYCLE_B) + offset;
+  if (year > latest) {
+    year -= MODEL_YEAR_CYCLE;
+  }
+  const other = year === CYCLE_A + offset ? CYCLE_B + offset : CYCLE_A + offset;
+
+  return {
+    year,
+    source: 'position',
+    confidence: 1,
+    candidates: other <= latest ? [year, other] : [year],
+  };
+}
+
+/**
+ * Choose between the candidate years of a model year using the years a WMI's
+ * schemas cover
+ *
+ * @param modelYear - Model year from resolveModelYear
+ * @param spans - Merged [from, to] year ranges of the WMI (to null when open-ended)
+ * @returns The same result when its year is covered or no candidate is;
+ *   otherwise the first covered candidate, with reduced confidence
+ */
+export function selectModelYear(
+  modelYear: ModelYearResult,
+  spans: Array<[number, number | null]>,
+): ModelYearResult {
+  const candidates = modelYear.candidates;
+  if (!candidates || candidates.length < 2 || spans.length === 0) {
+    return modelYear;
+  }
+
+  const covered = (year: number) => spans.some(([from, to]) => year >= from && (to === null || year <= to));
+  if (covered(modelYear.year)) {
+    return modelYear;
+  }
+
+  const year = candidates.find(covered);
+  if (year === undefined) {
+    return modelYear;
+  }
+  return {
+    year,
+    source: 'position',
+    confidence: 0.8,
+    candidates: [year, ...candidates.filter(candidate => candidate !== year)],
+  };
+}
@@ -0,0 +1,403 @@
+import type { WMIResult } from './types';
+
+/**
+ * A pattern in an overlay file
+ */
+export interface OverlayPattern {
+  /** Six-character VDS pattern (positions 4-9) */
+  pattern: string;
+  /** Element name as in the VPIC Element table (e.g. "Model", "Body Class") */
+  element: string;
+  /** Decoded value */
+  value: string;
+}
+
+/**
+ * Tenant overlay for one WMI, in the shape of the community YAML files in
+ * `community/wmi` (sources and test VINs may be present and are ignored)
+ *
+ * - `new` (default) defines a WMI of its own, replacing any base WMI with the same code
+ * - `supplement` layers patterns on the base schemas of an existing WMI
+ */
+export interface OverlayFile {
+  wmi: string;
+  mode?: 'new' | 'supplement';
+  manufacturer?: string;
+  make?: string;
+  country?: string;
+  vehicle_type?: string;
+  /** Model years covered (for `supplement`, limits which base schemas are layered) */
+  years?: { from: number; to: number | null };
+  schema_name?: string;
+  patterns: OverlayPattern[];
+}
+
+/**
+ * Element columns of a pattern row, as read from the Element table
+ */
+export interface OverlayElement {
+  ElementId: number | null;
+  ElementName: string;
+  ElementCode: string | null;
+  GroupName: string | null;
+  Description: string | null;
+  ElementWeight: number | null;
+}
+
+/**
+ * A schema owned by an overlay
+ */
+export interface OverlaySchema {
+  /** Overlay schema id (negative, unique across overlays) */
+  id: number;
+  wmi: string;
+  /** Base schema this one is a copy of, or null for a `new` WMI */
+  baseId: number | null;
+  name: string;
+  /** Overlay file the schema was created for */
+  file: OverlayFile;
+}
+
+/** Overlay schema ids count down from -1 so they never collide with VPIC ids or each other */
+let nextSchemaId = -1;
+
+/**
+ * Whether a schema id belongs to an overlay
+ */
+export function isOverlaySchemaId(id: number): boolean {
+  return id < 0;
+}
+
+/**
+ * Region reported for a WMI country, as VPICDatabase.getWMI derives it
+ */
+function regionOf(country: string): string {
+  switch (country.toUpperCase()) {
+    case 'UNITED STATES':
+    case 'CANADA':
+    case 'MEXICO':
+      return 'NORTH AMERICA';
+    case 'JAPAN':
+    case 'KOREA':
+    case 'CHINA':
+    case 'TAIWAN':
+      return 'ASIA';
+    case 'GERMANY':
+    case 'UNITED KINGDOM':
+    case 'ITALY':
+    case 'FRANCE':
+    case 'SWEDEN':
+      return 'EUROPE';
+    default:
+      return 'OTHER';
+  }
+}
+
+/**
+ * Intersect a base schema's model years with an overlay file's
+ *
+ * @returns [from, to]; null where neither side sets a bound
+ */
+function narrowYears(
+  base: [number, number | null] | undefined,
+  file: OverlayFile['years'],
+): [number | null, number | null] {
+  const from = Math.max(base?.[0] ?? -Infinity, file?.from ?? -Infinity);
+  const to = Math.min(base?.[1] ?? Infinity, file?.to ?? Infinity);
+  return [Number.isFinite(from) ? from : null, Number.isFinite(to) ? to : null];
+}
+
+/**
+ * Tenant-scoped patterns layered on a shared base database
+ *
+ * An overlay holds only a tenant's own WMIs and corrections; everything else
+ * is read from the base database and its caches, which all tenants share.
+ * A base schema is copied into the overlay only when a `supplement` file
+ * touches it, and its rows are compiled on first use: base rows with the same
+ * pattern and element as an overlay pattern are replaced, the rest are kept.
+ *
+ * Updating or deleting a WMI discards only that WMI's compiled schemas, and
+ * re-created schemas get new ids so no cache keyed by schema id can serve
+ * stale rows. Decodes already in flight finish against the schemas they
+ * started with, which are kept until the next update or delete.
+ *
+ * @example
+ * ```typescript
+ * const fleet = new PatternOverlay('fleet-a', [parse(readFileSync('XP7.yaml', 'utf-8'))]);
+ * const result = await decoder.decode(vin, { overlay: fleet });
+ * ```
+ */
+export class PatternOverlay {
+  readonly tenant: string;
+  private files = new Map<string, OverlayFile>();
+  private schemas = new Map<number, OverlaySchema>();
+  /** Current schema id per `${wmi}:${baseId ?? 'new'}` */
+  private current = new Map<string, number>();
+  private compiled = new Map<number, any[]>();
+  /** Schemas retired by the last invalidation, dropped by the next one */
+  private retired: number[] = [];
+
+  /**
+   * @param tenant - Tenant identifier, for logging and diagnostics
+   * @param files - Initial overlay files
+   */
+  constructor(tenant: string, files: OverlayFile[] = []) {
+    this.tenant = tenant;
+    for (const file of files) {
+      this.set(file);
+    }
+  }
+
+  /**
+   * WMIs with an overlay file
+   */
+  get wmis(): string[] {
+    return [...this.files.keys()];
+  }
+
+  /**
+   * Add or replace the overlay file for a WMI
+   *
+   * @param file - Overlay file (community YAML shape, already parsed)
+   * @throws Error if the file is malformed
+   */
+  set(file: OverlayFile): void {
+    const wmi = String(file.wmi ?? '').toUpperCase();
+    // Same shape extractWMI produces: 3 characters, or 6 when position 3 is '9' (small manufacturers)
+    if (wmi.length !== (wmi[2] === '9' ? 6 : 3)) {
+      throw new Error(`Overlay WMI must be 3 characters, or 6 when the third is 9: "${file.wmi}"`);
+    }
+    if (!Array.isArray(file.patterns) || file.patterns.length === 0) {
+      throw new Error(`Overlay for ${wmi} has no patterns`);
+    }
+    for (const pattern of file.patterns) {
+      if (typeof pattern.pattern !== 'string' || pattern.pattern.length !== 6 || !pattern.element) {
+        throw new Error(`Invalid overlay pattern for ${wmi}: ${JSON.stringify(pattern)}`);
+      }
+    }
+    if (file.mode !== 'supplement' && !file.make) {
+      throw new Error(`Overlay for new WMI ${wmi} requires a make`);
+    }
+
+    this.invalidate(wmi);
+    this.files.set(wmi, {
+      ...file,
+      wmi,
+      patterns: file.patterns.map(p => ({ ...p, pattern: p.pattern.toUpperCase() })),
+    });
+  }
+
+  /**
+   * Remove the overlay file for a WMI
+   *
+   * @param wmi - WMI code (3 characters, or 6 for small manufacturers)
+   * @returns True if the WMI had an overlay
+   */
+  delete(wmi: string): boolean {
+    const key = wmi.toUpperCase();
+    this.invalidate(key);
+    return this.files.delete(key);
+  }
+
+  /**
+   * WMI information for a `new` WMI
+   *
+   * @param wmi - WMI code (3 characters, or 6 for small manufacturers)
+   * @returns WMI information, or undefined to read the base database
+   */
+  getWMI(wmi: string): WMIResult | undefined {
+    const file = this.files.get(wmi);
+    if (!file || file.mode === 'supplement') {
+      return undefined;
+    }
+
+    const country = file.country ?? '';
+    return {
+      code: wmi,
+      manufacturer: file.manufacturer ?? file.make!,
+      make: file.make!,
+      country,
+      vehicleType: file.vehicle_type ?? '',
+      region: regionOf(country),
+    };
+  }
+
+  /**
+   * Model years covered by a `new` WMI
+   *
+   * @param wmi - WMI code (3 characters, or 6 for small manufacturers)
+   * @returns [from, to] ranges (empty when the file has no years), or undefined to read the base database
+   */
+  getYearRanges(wmi: string): Array<[number, number | null]> | undefined {
+    const file = this.files.get(wmi);
+    if (!file || file.mode === 'supplement') {
+      return undefined;
+    }
+    return file.years ? [[file.years.from, file.years.to]] : [];
+  }
+
+  /**
+   * Layer overlay schemas on the base schemas for a WMI and model year
+   *
+   * @param wmi - WMI code (3 characters, or 6 for small manufacturers)
+   * @param modelYear - Vehicle model year
+   * @param base - Schemas from the base database
+   * @returns Schemas to decode with; base schemas the overlay touches are replaced by their copies
+   */
+  getValidSchemas(
+    wmi: string,
+    modelYear: number,
+    base: Array<{ SchemaId: number; SchemaName: string }>,
+  ): Array<{ SchemaId: number; SchemaName: string }> {
+    const file = this.files.get(wmi);
+    if (!file) {
+      return base;
+    }
+
+    const inYears = !file.years || (modelYear >= file.years.from && (file.years.to === null || modelYear <= file.years.to));
+    if (file.mode !== 'supplement') {
+      if (!inYears) {
+        return [];
+      }
+      const from = file.years?.from;
+      const name =
+        file.schema_name ?? `${file.make} Schema for ${wmi} (Overlay)${from ? ` - ${from}${file.years!.to ? `-${file.years!.to}` : '+'}` : ''}`;
+      const schema = this.schemaFor(file, null, name);
+      return [{ SchemaId: schema.id, SchemaName: schema.name }];
+    }
+
+    if (!inYears) {
+      return base;
+    }
+    return base.map(({ SchemaId, SchemaName }) => {
+      const schema = this.schemaFor(file, SchemaId, SchemaName);
+      return { SchemaId: schema.id, SchemaName: schema.name };
+    });
+  }
+
+  /**
+   * Get an overlay schema by id
+   */
+  getSchema(id: number): OverlaySchema | undefined {
+    return this.schemas.get(id);
+  }
+
+  /**
+   * Compiled rows for a schema, if already compiled
+   */
+  getCompiled(id: number): any[] | undefined {
+    return this.compiled.get(id);
+  }
+
+  /**
+   * Element names a schema's overlay rows need
+   */
+  getElementNames(schema: OverlaySchema): string[] {
+    const names = new Set(schema.file.patterns.map(p => p.element));
+    if (names.has('Model')) {
+      names.add('Make');
+    }
+    return [...names];
+  }
+
+  /**
+   * Compile a schema's pattern rows
+   *
+   * Overlay rows get the model years of the base schema's link to this WMI,
+   * narrowed to the file's `years`, or just the file's `years` for a `new` WMI.
+   *
+   * @param schema - Overlay schema
+   * @param baseRows - Rows of the base schema it copies (empty for a `new` WMI)
+   * @param elements - Element columns by lower-case element name
+   * @param baseYears - [from, to] of the base schema's link to this WMI (to null when open-ended)
+   * @returns Rows in the shape returned by VPICDatabase.getPatterns
+   * @throws Error if an element is not in the Element table
+   */
+  compile(
+    schema: OverlaySchema,
+    baseRows: any[],
+    elements: Map<string, OverlayElement>,
+    baseYears?: [number, number | null],
+  ): any[] {
+    const { file } = schema;
+    const [yearFrom, yearTo] = narrowYears(baseYears, file.years);
+    const make = file.make ?? baseRows.find(row => row.ElementName === 'Make')?.AttributeId;
+
+    const row = (pattern: string, elementName: string, value: string) => {
+      const element = elements.get(elementName.toLowerCase());
+      if (!element) {
+        throw new Error(`Unknown element "${elementName}" in overlay for ${schema.wmi}`);
+      }
+      return {
+        Pattern: pattern,
+        ElementId: element.ElementId,
+        ElementName: element.ElementName,
+        ElementCode: element.ElementCode,
+        GroupName: element.GroupName,
+        Description: element.Description,
+        LookupTable: null,
+        AttributeId: value,
+        SchemaName: schema.name,
+        YearFrom: yearFrom,
+        YearTo: yearTo,
+        ElementWeight: element.ElementWeight,
+      };
+    };
+
+    // Overlay values are literal, so no lookup table is consulted for them
+    const rows: any[] = [];
+    for (const { pattern, element, value } of file.patterns) {
+      rows.push(row(pattern, element, String(value)));
+      if (element === 'Model' && make) {
+        rows.push(row(pattern, 'Make', String(make)));
+      }
+    }
+
+    const replaced = new Set(rows.map(r => `${r.ElementName}|${r.Pattern}`));
+    const compiled = [...baseRows.filter(r => !replaced.has(`${r.ElementName}|${r.Pattern}`)), ...rows];
+
+    // Schemas replaced by a later update are not cached; their decodes are already in flight
+    if (this.current.get(this.keyOf(schema)) === schema.id) {
+      this.compiled.set(schema.id, compiled);
+    }
+    return compiled;
+  }
+
+  private keyOf(schema: { wmi: string; baseId: number | null }): string {
+    return `${schema.wmi}:${schema.baseId ?? 'new'}`;
+  }
+
+  private schemaFor(file: OverlayFile, baseId: number | null, name: string): OverlaySchema {
+    const key = this.keyOf({ wmi: file.wmi, baseId });
+    const id = this.current.get(key);
+    if (id !== undefined) {
+      return this.schemas.get(id)!;
+    }
+
+    const schema: OverlaySchema = { id: nextSchemaId--, wmi: file.wmi, baseId, name, file };
+    this.schemas.set(schema.id, schema);
+    this.current.set(key, schema.id);
+    return schema;
+  }
+
+  /**
+   * Retire a WMI's schemas so they are recreated from its new file
+   *
+   * Retired schemas stay readable until the next invalidation so decodes in
+   * flight can finish; schemas retired before that are dropped.
+   */
+  private invalidate(wmi: string): void {
+    for (const id of this.retired) {
+      this.schemas.delete(id);
+    }
+    this.retired = [];
+
+    for (const [key, id] of this.current) {
+      if (key.startsWith(`${wmi}:`)) {
+        this.current.delete(key);
+        this.compiled.delete(id);
+        this.retired.push(id);
+      }
+    }
+  }
+}
@@ -1,5 +1,9 @@
 import type { DatabaseAdapter } from './db/adapter';
 import { VPICDatabase } from './db';
+import type { TieredCache } from './cache/backend';
+import { findVdsClass, VDS_LENGTH } from './db/vds-classes';
+import type { MatchKernel } from './db/match-kernel';
+import type { PatternOverlay } from './overlay';
 import { PatternMatch } from './types';
 import { createLogger } from './logger';
 
@@ -87,19 +91,42 @@ interface RawPatternMatch {
   positions: number[];
 }
 
+/**
+ * Receives a key identifying a match outcome: VINs with the same WMI, model
+ * year and key get the same pattern matches
+ */
+export interface MatchOutcome {
+  key?: string;
+  /** Whether the pattern set came from a cache (query cache, hot index or shared cache) rather than the database */
+  cached?: boolean;
+}
+
 /**
  * Pattern matching utility class for VIN decoding
  */
 export class PatternMatcher {
   private db: VPICDatabase;
+  private kernel?: MatchKernel;
 
   /**
    * Create a new pattern matcher
    *
    * @param adapter - Database adapter for SQL queries
+   * @param sharedCache - Optional shared cache for pattern sets
+   */
+  constructor(adapter: DatabaseAdapter, sharedCache?: TieredCache) {
+    this.db = new VPICDatabase(adapter, sharedCache);
+    this.kernel = adapter.kernel;
+  }
+
+  /**
+   * Get a matcher that reads through a tenant overlay
+   *
+   * @param overlay - Tenant overlay
+   * @returns Matcher sharing this matcher's database caches and kernel
    */
-  constructor(adapter: DatabaseAdapter) {
-    this.db = new VPICDatabase(adapter);
+  withOverlay(overlay: PatternOverlay): PatternMatcher {
+    return Object.assign(Object.create(PatternMatcher.prototype), this, { db: this.db.withOverlay(overlay) });
   }
 
   /**
@@ -383,6 +410,19 @@ export class PatternMatcher {
     };
   }
 
+  /**
+   * Warm the caches used by getPatternMatches for a WMI and model year
+   *
+   * @param wmi - World Manufacturer Identifier
+   * @param modelYear - Vehicle model year
+   */
+  async prefetch(wmi: string, modelYear: number): Promise<void> {
+    const validSchemas = await this.db.getValidSchemas(wmi, modelYear);
+    if (validSchemas.length > 0) {
+      await this.db.getPatterns(validSchemas.map(s => s.SchemaId));
+    }
+  }
+
   /**
    * Get matching patterns for a VIN
    *
@@ -390,6 +430,7 @@ export class PatternMatcher {
    * @param modelYear - Vehicle model year
    * @param vds - Vehicle Descriptor Section
    * @param vis - Vehicle Identifier Section
+   * @param outcome - Receives the key of the match outcome and whether its pattern set was cached
    * @returns Array of pattern matches
    */
   async getPatternMatches(
@@ -397,9 +438,10 @@ export class PatternMatcher {
     modelYear: number,
     vds: string,
     vis: string,
+    outcome?: MatchOutcome,
   ): Promise<PatternMatch[]> {
     // Get raw pattern matches first
-    const rawMatches = await this.getRawPatternMatches(wmi, modelYear, vds, vis);
+    const rawMatches = await this.getRawPatternMatches(wmi, modelYear, vds, vis, outcome);
 
     // Transform matches into the cleaner format and filter by confidence
     const transformedMatches = rawMatches
@@ -485,6 +527,62 @@ export class PatternMatcher {
     return result;
   }
 
+  /**
+   * Create a scorer for patterns matched against the VDS and VIS
+   *
+   * When every schema has a compiled VDS class table the VDS is resolved to its
+   * equivalence class once and each pattern's confidence is read from the class.
+   * Otherwise the adapter's WebAssembly kernel, if any, matches all VDS patterns
+   * at once; pattern sets neither can cover are scored directly.
+   *
+   * @param schemaIds - Schemas being matched
+   * @param patterns - Pattern strings of those schemas
+   * @param vds - Vehicle Descriptor Section
+   * @param vis - Vehicle Identifier Section
+   * @returns `score(pattern)` returning `calculateConfidence(pattern, vds + vis)`, and
+   *   `key`, which is the same for every VDS and VIS the scores are the same for
+   */
+  private async createVdsScorer(
+    schemaIds: number[],
+    patterns: string[],
+    vds: string,
+    vis: string,
+  ): Promise<{ score: (pattern: string) => number; key: string }> {
+    const input = vds + vis;
+    const direct = (pattern: string) => this.calculateConfidence(pattern, input);
+    const fromMatches = (matched: Map<string, number>) => (pattern: string) =>
+      pattern.includes('|') ? direct(pattern) : (matched.get(pattern) ?? 0);
+    // Without class tables, patterns reaching past the VDS make the whole VIS part of the key
+    const directKey = () =>
+      patterns.some(pattern => pattern.length > VDS_LENGTH && !pattern.includes('|')) ? input : vds;
+
+    const tables = vds.length === 6 ? await this.db.getVdsClassTables(schemaIds) : undefined;
+    if (!tables) {
+      const matched = this.kernel?.match(
+        schemaIds.join(','),
+        patterns,
+        (pattern, text) => this.calculateConfidence(pattern, text),
+        vds,
+      );
+      return { score: matched ? fromMatches(matched) : direct, key: directKey() };
+    }
+
+    const matched = new Map<string, number>();
+    const classes: number[] = [];
+    for (const table of tables) {
+      const index = findVdsClass(table, vds);
+      if (index === undefined) {
+        return { score: direct, key: directKey() };
+      }
+      classes.push(index);
+      for (const [pattern, confidence] of table.classes[index]) {
+        matched.set(table.patterns[pattern], confidence);
+      }
+    }
+
+    return { score: fromMatches(matched), key: `#${classes.join(',')}` };
+  }
+
   /**
    * Get raw pattern matches from the database
    *
@@ -492,6 +590,7 @@ export class PatternMatcher {
    * @param modelYear - Vehicle model year
    * @param vds - Vehicle Descriptor Section
    * @param vis - Vehicle Identifier Section
+   * @param outcome - Receives the key of the match outcome and whether its pattern set was cached
    * @returns Array of raw pattern matches
    */
   async getRawPatternMatches(
@@ -499,6 +598,7 @@ export class PatternMatcher {
     modelYear: number,
     vds: string,
     vis: string,
+    outcome?: MatchOutcome,
   ): Promise<RawPatternMatch[]> {
     try {
       // 1. Find valid schemas
@@ -512,7 +612,7 @@ export class PatternMatcher {
       const schemaIds = validSchemas.map(s => s.SchemaId);
 
       // 2. Get all patterns for these schemas
-      const allPatterns = await this.db.getPatterns(schemaIds);
+      const allPatterns = await this.db.getPatterns(schemaIds, outcome);
       // 3. Filter patterns using valid lookup tables
 
       const filteredPatterns = allPatterns.filter(p => {
@@ -592,11 +692,21 @@ export class PatternMatcher {
       });
 
       // 8. Find the most specific schema by looking at model patterns
+      const { score: scoreVds, key: vdsKey } = await this.createVdsScorer(
+        schemaIds,
+        allPatterns.map(row => String(row.Pattern)),
+        vds,
+        vis,
+      );
+      // VIS patterns only read position 11
+      if (outcome) {
+        outcome.key = `${schemaIds.join(',')}|${vdsKey}|${vis[1]}`;
+      }
       const modelPatterns = resolvedPatterns
         .filter(row => row.ElementName === 'Model')
         .map(row => ({
           ...row,
-          confidence: this.calculateConfidence(row.Pattern, vds + vis),
+          confidence: scoreVds(row.Pattern),
         }))
         .sort((a, b) => b.confidence - a.confidence);
 
@@ -611,7 +721,7 @@ export class PatternMatcher {
         // Calculate base confidence
         const baseConfidence = isVISPattern
           ? this.calculateConfidence(pattern, vis[1])
-          : this.calculateConfidence(pattern, vds + vis);
+          : scoreVds(pattern);
 
         // Adjust confidence based on schema match for plant codes
         let confidence = baseConfidence;
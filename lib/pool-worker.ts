@@ -0,0 +1,27 @@
+import { parentPort, workerData } from 'worker_threads';
+import { createDecoder } from './index';
+import type { DecoderPoolRequest, DecoderPoolResponse } from './pool';
+
+/**
+ * Worker thread entry for DecoderPool
+ *
+ * Each worker owns its own decoder and database connection; the pool sends
+ * at most one request at a time so queueing happens in the pool, where
+ * admission control can see it.
+ */
+const decoderPromise = createDecoder({ databasePath: workerData?.databasePath, searchIndex: false });
+
+parentPort?.on('message', async (request: DecoderPoolRequest) => {
+  let response: DecoderPoolResponse;
+  try {
+    const decoder = await decoderPromise;
+    const result =
+      request.type === 'validate'
+        ? decoder.validate(request.vin)
+        : await decoder.decode(request.vin, request.options);
+    response = { id: request.id, result };
+  } catch (error) {
+    response = { id: request.id, error: error instanceof Error ? error.message : String(error) };
+  }
+  parentPort!.postMessage(response);
+});
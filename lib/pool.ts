@@ -0,0 +1,431 @@
+import { Worker } from 'worker_threads';
+import { cpus } from 'os';
+import { join } from 'path';
+import { fileURLToPath } from 'url';
+import { AdmissionController } from './admission';
+import { affinityKey, rankByAffinity } from './affinity';
+import type { AffinityMode } from './affinity';
+import type { AdmissionOptions, AdmissionStats, RequestClass } from './admission';
+import { ErrorCategory } from './types';
+import type { DecodeOptions, DecodeResult } from './types';
+import { createLogger } from './logger';
+
+const logger = createLogger('DecoderPool');
+
+/** Characters allowed in a well-formed VIN */
+const VIN_SHAPE = /^[A-HJ-NPR-Z0-9]{17}$/;
+
+/**
+ * Message sent to a pool worker
+ */
+export type DecoderPoolRequest =
+  | { id: number; type: 'decode'; vin: string; options?: DecodeOptions }
+  | { id: number; type: 'validate'; vin: string };
+
+/**
+ * Message returned by a pool worker
+ */
+export type DecoderPoolResponse = { id: number; result: DecodeResult } | { id: number; error: string };
+
+/**
+ * Decoder used by a pool running on the main thread
+ */
+export interface PoolDecoder {
+  decode(vin: string, options?: DecodeOptions): Promise<DecodeResult>;
+  validate(vin: string): DecodeResult;
+}
+
+/**
+ * Options for a decoder pool
+ */
+export interface DecoderPoolOptions extends AdmissionOptions {
+  /**
+   * Database path passed to each worker; resolve it once with getDatabasePath
+   * so workers do not each resolve (and update) the cached database
+   */
+  databasePath?: string;
+
+  /** Worker thread count (default: CPU count - 1); 0 decodes on the main thread with `decoder` */
+  workers?: number;
+
+  /** Decoder used when `workers` is 0 */
+  decoder?: PoolDecoder;
+
+  /** Worker entry script (default: the bundled pool-worker next to this module) */
+  workerScript?: string;
+
+  /** Recent decode results kept on the main thread and served without queueing (default: 10000) */
+  resultCacheSize?: number;
+
+  /**
+   * Route decodes to workers by a consistent hash of this key so each worker
+   * caches its own slice of schemas and patterns (default: `wmi`; false
+   * dispatches to any idle worker)
+   */
+  affinity?: AffinityMode | false;
+
+  /**
+   * Decodes that may wait for a busy key owner; further decodes for that
+   * worker spill to the next idle worker in the key's order (default: 2)
+   */
+  affinityQueueDepth?: number;
+
+  /** Longest a decode waits for a busy key owner before it spills, in milliseconds (default: 10) */
+  affinityMaxWait?: number;
+}
+
+/**
+ * Pool statistics
+ */
+export interface DecoderPoolStats extends AdmissionStats {
+  /** Worker threads (0 when decoding on the main thread) */
+  workers: number;
+  /** Requests answered from the main-thread result cache */
+  cacheHits: number;
+  /** Decodes run on the worker owning their affinity key, including those that waited for it */
+  affinityHits: number;
+  /** Decodes that waited for their key owner instead of spilling */
+  affinityQueued: number;
+  /** Decodes spilled to another worker because the owner's queue was at `affinityQueueDepth` */
+  affinityDepthSpills: number;
+  /** Decodes spilled to another worker after waiting `affinityMaxWait` for the owner */
+  affinityWaitSpills: number;
+}
+
+/**
+ * Decode waiting for its key owner to finish the current one
+ */
+interface QueuedDecode {
+  /** Worker slots in the key's preference order */
+  ranked: number[];
+  start: (worker: PoolWorker) => void;
+  fail: (error: Error) => void;
+  timer: ReturnType<typeof setTimeout>;
+}
+
+interface PoolWorker {
+  /** Stable position used for affinity routing; kept across restarts */
+  slot: number;
+  worker: Worker;
+  pending: Map<number, { resolve: (result: DecodeResult) => void; reject: (error: Error) => void }>;
+  /** Decodes waiting for this worker because it owns their affinity key */
+  queue: QueuedDecode[];
+}
+
+/**
+ * Resolve a bundled worker entry next to this module
+ *
+ * @param name - Entry name without extension (e.g. "pool-worker")
+ * @returns Path to the .mjs or .cjs build of the entry
+ */
+export function resolveWorkerScript(name: string): string {
+  try {
+    // ESM
+    if (typeof import.meta.url === 'string') {
+      return fileURLToPath(new URL(`./${name}.mjs`, import.meta.url));
+    }
+  } catch {
+    // CJS
+  }
+  return join(__dirname, `${name}.cjs`);
+}
+
+/**
+ * Pool of decoders behind admission control
+ *
+ * Full decodes are dispatched to worker threads so synchronous SQLite never
+ * blocks the event loop; requests wait in the pool's admission queue rather
+ * than in worker message queues, so queueing delay is visible and overload is
+ * shed with OverloadError instead of growing without bound.
+ *
+ * Decodes are routed by a consistent hash of their WMI, so each worker caches
+ * a slice of the schema space instead of all of it. A decode whose owner is
+ * busy waits in a short per-worker queue, and only spills to another worker
+ * when that queue is full or it has waited too long, so routing stays sticky
+ * under load.
+ */
+export class DecoderPool {
+  private admission: AdmissionController;
+  private workers: PoolWorker[] = [];
+  private idle: PoolWorker[] = [];
+  private decoder?: PoolDecoder;
+  private workerScript: string;
+  private databasePath?: string;
+  /** Serialized, so every caller gets its own copy */
+  private results = new Map<string, string>();
+  private resultCacheSize: number;
+  private cacheHits = 0;
+  private affinity: AffinityMode | false;
+  private affinityQueueDepth: number;
+  private affinityMaxWait: number;
+  private slots: number[] = [];
+  private affinityHits = 0;
+  private affinityQueued = 0;
+  private affinityDepthSpills = 0;
+  private affinityWaitSpills = 0;
+  private nextId = 0;
+  private closed = false;
+
+  /**
+   * @param options - Pool and admission options
+   */
+  constructor(options: DecoderPoolOptions = {}) {
+    const workerCount = options.workers ?? Math.max(1, cpus().length - 1);
+    if (workerCount === 0 && !options.decoder) {
+      throw new Error('A decoder is required when workers is 0');
+    }
+
+    this.decoder = workerCount === 0 ? options.decoder : undefined;
+    this.workerScript = options.workerScript ?? resolveWorkerScript('pool-worker');
+    this.databasePath = options.databasePath;
+    this.resultCacheSize = options.resultCacheSize ?? 10000;
+    this.affinity = options.affinity ?? 'wmi';
+    this.affinityQueueDepth = options.affinityQueueDepth ?? 2;
+    this.affinityMaxWait = options.affinityMaxWait ?? 10;
+    this.admission = new AdmissionController({
+      ...options,
+      concurrency: workerCount || options.concurrency || 4,
+    });
+
+    for (let slot = 0; slot < workerCount; slot++) {
+      this.slots.push(slot);
+      this.idle.push(this.spawn(slot));
+    }
+  }
+
+  /**
+   * Decode a VIN
+   *
+   * Recently decoded VINs are answered immediately, except for decodes with
+   * a tenant overlay; malformed VINs are admitted as cheap requests ahead of
+   * full decodes. Bulk decodes (`priority: 'bulk'`) queue behind interactive ones.
+   *
+   * @param vin - The VIN to decode
+   * @param options - Decode options
+   * @returns Decoded VIN information
+   * @throws OverloadError if the request is shed
+   * @throws Error if an overlay is passed to a pool with worker threads
+   */
+  async decode(vin: string, options: DecodeOptions = {}): Promise<DecodeResult> {
+    // Priority only decides queueing here; workers decode one VIN at a time
+    const { priority = 'interactive', ...decodeOptions } = options;
+    const cleanVin = vin.toUpperCase().trim();
+    if (decodeOptions.overlay && !this.decoder) {
+      throw new Error('Overlays cannot be sent to worker threads; use a pool with workers: 0');
+    }
+    // Overlay results are tenant-private (and overlays do not serialize), so they bypass the result cache
+    const key = decodeOptions.overlay ? undefined : `${cleanVin}:${JSON.stringify(decodeOptions)}`;
+
+    const startTime = performance.now ? performance.now() : Date.now();
+    const cached = key === undefined ? undefined : this.results.get(key);
+    if (cached) {
+      this.cacheHits++;
+      this.results.delete(key);
+      this.results.set(key, cached);
+      const result: DecodeResult = JSON.parse(cached);
+      result.metadata!.processingTime = (performance.now ? performance.now() : Date.now()) - startTime;
+      return result;
+    }
+
+    const requestClass: RequestClass = VIN_SHAPE.test(cleanVin) ? 'full' : 'cheap';
+    const result = await this.admission.run(
+      requestClass,
+      () => this.dispatch({ id: this.nextId++, type: 'decode', vin: cleanVin, options: decodeOptions }),
+      priority,
+    );
+
+    if (key !== undefined && !result.errors.some(error => error.category === ErrorCategory.DATABASE)) {
+      this.results.set(key, JSON.stringify(result));
+      if (this.results.size > this.resultCacheSize) {
+        this.results.delete(this.results.keys().next().value as string);
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * Validate VIN structure and check digit (admitted as a cheap request)
+   *
+   * @param vin - The VIN to validate
+   * @returns Validation result
+   * @throws OverloadError if the request is shed
+   */
+  validate(vin: string): Promise<DecodeResult> {
+    return this.admission.run('cheap', () => this.dispatch({ id: this.nextId++, type: 'validate', vin }));
+  }
+
+  /**
+   * Get pool and admission statistics
+   */
+  getStats(): DecoderPoolStats {
+    return {
+      ...this.admission.getStats(),
+      workers: this.workers.length,
+      cacheHits: this.cacheHits,
+      affinityHits: this.affinityHits,
+      affinityQueued: this.affinityQueued,
+      affinityDepthSpills: this.affinityDepthSpills,
+      affinityWaitSpills: this.affinityWaitSpills,
+    };
+  }
+
+  /**
+   * Stop all workers
+   */
+  async close(): Promise<void> {
+    this.closed = true;
+    for (const { queue } of this.workers) {
+      for (const queued of queue.splice(0)) {
+        clearTimeout(queued.timer);
+        queued.fail(new Error('Decoder pool closed'));
+      }
+    }
+    await Promise.all(this.workers.map(({ worker }) => worker.terminate()));
+    this.workers = [];
+    this.idle = [];
+  }
+
+  private async dispatch(request: DecoderPoolRequest): Promise<DecodeResult> {
+    if (this.decoder) {
+      return request.type === 'validate'
+        ? this.decoder.validate(request.vin)
+        : this.decoder.decode(request.vin, request.options);
+    }
+
+    const poolWorker = await this.acquire(request);
+
+    try {
+      return await new Promise<DecodeResult>((resolve, reject) => {
+        poolWorker.pending.set(request.id, { resolve, reject });
+        poolWorker.worker.postMessage(request);
+      });
+    } finally {
+      this.release(poolWorker);
+    }
+  }
+
+  /**
+   * Get a worker for a request: the key's owner when idle, a place in the
+   * owner's queue while it has room, otherwise the next idle worker in the
+   * key's preference order
+   */
+  private acquire(request: DecoderPoolRequest): Promise<PoolWorker> {
+    if (!this.affinity || request.type !== 'decode') {
+      // Admission concurrency equals the worker count, so a worker is always idle here
+      const poolWorker = this.idle.pop();
+      return poolWorker ? Promise.resolve(poolWorker) : Promise.reject(new Error('No idle decoder worker'));
+    }
+
+    const ranked = rankByAffinity(affinityKey(request.vin, this.affinity), this.slots);
+    const owner = this.workers.find(w => w.slot === ranked[0]);
+    const ownerIndex = owner ? this.idle.indexOf(owner) : -1;
+    if (ownerIndex !== -1) {
+      this.affinityHits++;
+      return Promise.resolve(this.idle.splice(ownerIndex, 1)[0]);
+    }
+
+    if (owner && owner.queue.length < this.affinityQueueDepth) {
+      this.affinityQueued++;
+      return new Promise<PoolWorker>((start, fail) => {
+        const queued: QueuedDecode = { ranked, start, fail, timer: undefined! };
+        queued.timer = setTimeout(() => this.spillQueued(queued), this.affinityMaxWait);
+        owner.queue.push(queued);
+      });
+    }
+
+    // Requests waiting in owner queues hold admission slots, so at least one worker is idle here
+    const spill = this.takeIdle(ranked);
+    if (!spill) {
+      return Promise.reject(new Error('No idle decoder worker'));
+    }
+    this.affinityDepthSpills++;
+    return Promise.resolve(spill);
+  }
+
+  /**
+   * Move a decode that waited too long for its owner to an idle worker, if any
+   */
+  private spillQueued(queued: QueuedDecode): void {
+    const owner = this.workers.find(w => w.queue.includes(queued));
+    const spill = owner && this.takeIdle(queued.ranked);
+    if (!owner || !spill) {
+      return;
+    }
+    owner.queue.splice(owner.queue.indexOf(queued), 1);
+    this.affinityWaitSpills++;
+    queued.start(spill);
+  }
+
+  /**
+   * Take the first idle worker in a key's preference order
+   */
+  private takeIdle(ranked: number[]): PoolWorker | undefined {
+    for (const slot of ranked) {
+      const index = this.idle.findIndex(w => w.slot === slot);
+      if (index !== -1) {
+        return this.idle.splice(index, 1)[0];
+      }
+    }
+    return undefined;
+  }
+
+  /**
+   * Hand a finished worker to the next decode waiting for it, or mark it idle
+   */
+  private release(poolWorker: PoolWorker): void {
+    if (!this.workers.includes(poolWorker)) {
+      return;
+    }
+    const next = poolWorker.queue.shift();
+    if (next) {
+      clearTimeout(next.timer);
+      this.affinityHits++;
+      next.start(poolWorker);
+    } else {
+      this.idle.push(poolWorker);
+    }
+  }
+
+  private spawn(slot: number): PoolWorker {
+    const worker = new Worker(this.workerScript, { workerData: { databasePath: this.databasePath } });
+    const poolWorker: PoolWorker = { slot, worker, pending: new Map(), queue: [] };
+
+    worker.on('message', (response: DecoderPoolResponse) => {
+      const pending = poolWorker.pending.get(response.id);
+      poolWorker.pending.delete(response.id);
+      if ('error' in response) {
+        pending?.reject(new Error(response.error));
+      } else {
+        pending?.resolve(response.result);
+      }
+    });
+
+    const fail = (error: Error) => {
+      for (const { reject } of poolWorker.pending.values()) {
+        reject(error);
+      }
+      poolWorker.pending.clear();
+      this.workers = this.workers.filter(w => w !== poolWorker);
+      this.idle = this.idle.filter(w => w !== poolWorker);
+
+      if (!this.closed) {
+        logger.error({ error }, 'Decoder worker failed, restarting');
+        // The replacement owns the same keys, so it takes over the decodes waiting for this worker
+        const replacement = this.spawn(slot);
+        replacement.queue = poolWorker.queue;
+        this.release(replacement);
+      }
+    };
+
+    worker.on('error', fail);
+    worker.on('exit', code => {
+      if (this.workers.includes(poolWorker)) {
+        fail(new Error(`Decoder worker exited with code ${code}`));
+      }
+    });
+
+    this.workers.push(poolWorker);
+    return poolWorker;
+  }
+}
@@ -0,0 +1,165 @@
+import { ErrorCategory, ErrorCode, ErrorSeverity } from './enums';
+import type { DecodeError, DecodeResult } from './types';
+
+/** 1 for characters valid in a VIN, by char code */
+const CHAR_CLASS = (() => {
+  const classes = new Uint8Array(128);
+  for (const char of '0123456789ABCDEFGHJKLMNPRSTUVWXYZ') {
+    classes[char.charCodeAt(0)] = 1;
+  }
+  return classes;
+})();
+
+/** Distinct WMI results held before the table is reset */
+const MAX_WMI_RESULTS = 10000;
+
+/**
+ * Rejected VINs, per error code
+ */
+export interface RejectStats {
+  /** VINs rejected on the fast path */
+  total: number;
+  /** Rejections per error code */
+  byCode: Partial<Record<ErrorCode, number>>;
+}
+
+/**
+ * Bit mask of positions (bit 0 = position 1) holding characters a VIN cannot contain
+ *
+ * Matches the character rules of the full decode: digits and letters other
+ * than I, O and Q everywhere, and only digits or X in position 9.
+ *
+ * @param vin - Upper-case, 17-character VIN
+ * @returns Mask of invalid positions, 0 when every character is valid
+ */
+export function invalidCharacterMask(vin: string): number {
+  let mask = 0;
+  for (let i = 0; i < 17; i++) {
+    const code = vin.charCodeAt(i);
+    const valid = i === 8 ? code === 88 || (code >= 48 && code <= 57) : code < 128 && CHAR_CLASS[code] === 1;
+    if (!valid) {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+}
+
+/**
+ * Freeze a result so it can be returned for any number of VINs
+ */
+function template(error: DecodeError): Readonly<Omit<DecodeResult, 'vin'>> {
+  Object.freeze(error.positions);
+  return Object.freeze({
+    valid: false,
+    components: Object.freeze({}),
+    errors: Object.freeze([Object.freeze(error)]) as DecodeError[],
+    metadata: Object.freeze({ processingTime: 0, confidence: 0, schemaVersion: '1.0' }),
+  });
+}
+
+/**
+ * Prebuilt results for VINs that fail before any pattern lookup
+ *
+ * Feeds with many garbage VINs otherwise pay for a full result per VIN:
+ * regex checks, error messages built per VIN, and timing calls. Here the
+ * structure check is a table lookup per character, and the result is copied
+ * from a frozen template built once per error (keyed by invalid position
+ * mask or WMI), with only `vin` set per VIN.
+ *
+ * Rejected results carry only the rejecting error: no check digit or model
+ * year components, and the invalid characters message lists positions only.
+ */
+export class RejectTemplates {
+  private length = template({
+    code: ErrorCode.INVALID_LENGTH,
+    category: ErrorCategory.STRUCTURE,
+    severity: ErrorSeverity.ERROR,
+    message: 'Invalid VIN length',
+  });
+  private characters = new Map<number, ReturnType<typeof template>>();
+  private wmis = new Map<string, ReturnType<typeof template>>();
+  private counts = new Map<ErrorCode, number>();
+  private total = 0;
+
+  /**
+   * Reject a VIN whose structure is invalid
+   *
+   * @param vin - Upper-case, trimmed VIN
+   * @returns Prebuilt result with `vin` set, or undefined if the structure is valid
+   */
+  structure(vin: string): DecodeResult | undefined {
+    if (vin.length !== 17) {
+      return this.result(vin, this.length);
+    }
+
+    const mask = invalidCharacterMask(vin);
+    if (mask === 0) {
+      return undefined;
+    }
+
+    let shared = this.characters.get(mask);
+    if (!shared) {
+      const positions: number[] = [];
+      for (let i = 0; i < 17; i++) {
+        if (mask & (1 << i)) positions.push(i + 1);
+      }
+      shared = template({
+        code: ErrorCode.INVALID_CHARACTERS,
+        category: ErrorCategory.STRUCTURE,
+        severity: ErrorSeverity.ERROR,
+        message: `Invalid characters at positions ${positions.join(', ')}`,
+        positions,
+      });
+      this.characters.set(mask, shared);
+    }
+    return this.result(vin, shared);
+  }
+
+  /**
+   * Reject a VIN whose WMI is not in the database
+   *
+   * @param vin - Upper-case, trimmed VIN
+   * @param wmi - WMI extracted from the VIN
+   * @returns Prebuilt result with `vin` set
+   */
+  unknownWmi(vin: string, wmi: string): DecodeResult {
+    let shared = this.wmis.get(wmi);
+    if (!shared) {
+      if (this.wmis.size >= MAX_WMI_RESULTS) {
+        this.wmis.clear();
+      }
+      shared = template({
+        code: ErrorCode.WMI_NOT_FOUND,
+        category: ErrorCategory.LOOKUP,
+        severity: ErrorSeverity.ERROR,
+        message: 'WMI not found in database',
+        searchKey: wmi,
+        searchType: 'WMI',
+      } as DecodeError);
+      this.wmis.set(wmi, shared);
+    }
+    return this.result(vin, shared);
+  }
+
+  /**
+   * Get rejection counts
+   */
+  getStats(): RejectStats {
+    return { total: this.total, byCode: Object.fromEntries(this.counts) };
+  }
+
+  private result(vin: string, shared: ReturnType<typeof template>): DecodeResult {
+    const code = shared.errors[0].code;
+    this.counts.set(code, (this.counts.get(code) ?? 0) + 1);
+    this.total++;
+    // The frozen template is copied so callers get the mutable result its type promises
+    const [error] = shared.errors;
+    return {
+      vin,
+      valid: false,
+      components: {},
+      errors: [error.positions ? { ...error, positions: [...error.positions] } : { ...error }],
+      metadata: { ...shared.metadata! },
+    };
+  }
+}
@@ -0,0 +1,177 @@
+import type { DecodePriority } from './types';
+
+/** Upper bounds of the latency histogram buckets, in milliseconds */
+export const LATENCY_BUCKETS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000];
+
+/**
+ * Latency histogram of one priority class
+ */
+export interface LatencyStats {
+  /** Requests recorded */
+  count: number;
+  /** Total latency, in milliseconds */
+  sum: number;
+  /** Requests per LATENCY_BUCKETS bucket, plus one for anything slower */
+  buckets: number[];
+}
+
+/**
+ * Latency histogram with fixed buckets
+ */
+export class LatencyHistogram {
+  private count = 0;
+  private sum = 0;
+  private buckets = new Array<number>(LATENCY_BUCKETS.length + 1).fill(0);
+
+  /**
+   * @param ms - Latency to record, in milliseconds
+   */
+  record(ms: number): void {
+    let bucket = 0;
+    while (bucket < LATENCY_BUCKETS.length && ms > LATENCY_BUCKETS[bucket]) bucket++;
+    this.buckets[bucket]++;
+    this.count++;
+    this.sum += ms;
+  }
+
+  getStats(): LatencyStats {
+    return { count: this.count, sum: this.sum, buckets: [...this.buckets] };
+  }
+}
+
+/**
+ * Options for priority scheduling
+ */
+export interface PrioritySchedulerOptions {
+  /** Share of stages bulk decodes still get while interactive decodes run, 0-1 (default: 0.1) */
+  minBulkShare?: number;
+
+  /** Longest bulk decodes run before yielding to the event loop, in milliseconds (default: 10) */
+  bulkSlice?: number;
+}
+
+/**
+ * Priority scheduler counters
+ */
+export interface SchedulerStats {
+  /** Decodes in progress, per priority */
+  running: Record<DecodePriority, number>;
+  /** Bulk decodes waiting at a stage boundary */
+  waiting: number;
+  /** Bulk stages that waited for interactive decodes */
+  preempted: number;
+  /** Bulk stages run on the guaranteed share while interactive decodes were running */
+  bulkGrants: number;
+  /** Decode latency, per priority */
+  latency: Record<DecodePriority, LatencyStats>;
+}
+
+function now(): number {
+  return performance.now ? performance.now() : Date.now();
+}
+
+const defer: (callback: () => void) => void =
+  typeof setImmediate === 'function' ? callback => setImmediate(callback) : callback => setTimeout(callback, 0);
+
+/**
+ * Scheduler sharing one decoder between interactive and bulk decodes
+ *
+ * Decodes report each stage boundary (after validation, after the WMI
+ * lookup). While any interactive decode is running, bulk decodes wait at
+ * their next boundary, so a lookup behind a user request does not queue
+ * behind a nightly batch. Interactive stages earn bulk work credit, so bulk
+ * still gets `minBulkShare` of all stages under sustained interactive load.
+ *
+ * With a synchronous database, a batch otherwise runs start to finish
+ * without giving the event loop a turn; bulk decodes also yield to it every
+ * `bulkSlice` milliseconds so incoming interactive requests can start.
+ */
+export class PriorityScheduler {
+  private running: Record<DecodePriority, number> = { interactive: 0, bulk: 0 };
+  private waiting: Array<() => void> = [];
+  private credit = 0;
+  private creditPerStage: number;
+  private bulkSlice: number;
+  private lastYield = now();
+  private preempted = 0;
+  private bulkGrants = 0;
+  private latency: Record<DecodePriority, LatencyHistogram> = {
+    interactive: new LatencyHistogram(),
+    bulk: new LatencyHistogram(),
+  };
+
+  /**
+   * @param options - Scheduling options
+   */
+  constructor(options: PrioritySchedulerOptions = {}) {
+    const share = Math.min(Math.max(options.minBulkShare ?? 0.1, 0), 0.99);
+    this.creditPerStage = share / (1 - share);
+    this.bulkSlice = options.bulkSlice ?? 10;
+  }
+
+  /**
+   * Start tracking a decode
+   *
+   * @param priority - Priority of the decode
+   * @returns Function to call once the decode has finished
+   */
+  begin(priority: DecodePriority): () => void {
+    const start = now();
+    this.running[priority]++;
+    return () => {
+      this.running[priority]--;
+      this.latency[priority].record(now() - start);
+      if (priority === 'interactive' && this.running.interactive === 0) {
+        this.credit = 0;
+        for (const resume of this.waiting.splice(0)) resume();
+      }
+    };
+  }
+
+  /**
+   * Stage boundary of a decode; bulk decodes may wait here
+   *
+   * @param priority - Priority of the decode
+   */
+  checkpoint(priority: DecodePriority): Promise<void> | void {
+    if (priority === 'interactive') {
+      if (this.waiting.length > 0) {
+        this.credit += this.creditPerStage;
+        while (this.credit >= 1 && this.waiting.length > 0) {
+          this.credit--;
+          this.bulkGrants++;
+          this.waiting.shift()!();
+        }
+      }
+      return;
+    }
+
+    if (this.running.interactive > 0) {
+      if (this.credit >= 1) {
+        this.credit--;
+        this.bulkGrants++;
+      } else {
+        this.preempted++;
+        return new Promise<void>(resolve => this.waiting.push(resolve));
+      }
+    }
+
+    if (now() - this.lastYield > this.bulkSlice) {
+      this.lastYield = now();
+      return new Promise<void>(resolve => defer(resolve));
+    }
+  }
+
+  /**
+   * Get scheduler statistics
+   */
+  getStats(): SchedulerStats {
+    return {
+      running: { ...this.running },
+      waiting: this.waiting.length,
+      preempted: this.preempted,
+      bulkGrants: this.bulkGrants,
+      latency: { interactive: this.latency.interactive.getStats(), bulk: this.latency.bulk.getStats() },
+    };
+  }
+}
@@ -0,0 +1,480 @@
+import type { DatabaseAdapter } from './db/adapter';
+import { VPICDatabase } from './db';
+import { createLogger } from './logger';
+
+const logger = createLogger('ModelSearch');
+
+/** Field codes packed into the low bits of each posting */
+const FIELD_MODEL = 0;
+const FIELD_MAKE = 1;
+const FIELD_ATTRIBUTE = 2;
+const FIELD_ACRONYM = 3;
+
+/** Score of an exact token match per field */
+const FIELD_WEIGHTS = [1, 0.6, 0.5, 0.45];
+
+/** Share of the field weight earned by a prefix match */
+const PREFIX_WEIGHT = 0.7;
+
+/** Most index tokens a single query prefix expands to */
+const MAX_PREFIX_EXPANSIONS = 64;
+
+/** Trigram similarity below which fuzzy model-name matches are ignored */
+const MIN_TRIGRAM_SIMILARITY = 0.4;
+
+/** Year used for open-ended schema ranges */
+const OPEN_YEAR = 9999;
+
+/**
+ * Options for a model search
+ */
+export interface ModelSearchOptions {
+  /** Restrict to one make, by id or name */
+  make?: number | string;
+
+  /** Restrict to models with patterns valid for this model year */
+  year?: number;
+
+  /** Maximum results (default: 10) */
+  limit?: number;
+}
+
+/**
+ * A ranked make and model
+ */
+export interface ModelSearchResult {
+  makeId: number;
+  make: string;
+  modelId: number;
+  model: string;
+  /** Relevance, higher is better (not comparable across queries) */
+  score: number;
+}
+
+/**
+ * Size of a search index
+ */
+export interface ModelSearchMemoryReport {
+  /** Make and model pairs indexed */
+  models: number;
+  makes: number;
+  /** Distinct Series and Trim names linked to models */
+  attributes: number;
+  tokens: number;
+  trigrams: number;
+  postings: number;
+  /** Approximate heap size in bytes */
+  bytes: number;
+  /** Build time in milliseconds */
+  buildMs: number;
+}
+
+/**
+ * Normalize text into search tokens
+ *
+ * Lower-cases, strips accents and punctuation, and splits letters from digits
+ * so "F-150", "f150" and "F 150" all become ["f", "150"].
+ */
+export function tokenizeSearchText(text: string): string[] {
+  return text
+    .normalize('NFKD')
+    .replace(/[\u0300-\u036f]/g, '')
+    .toLowerCase()
+    .replace(/([a-z])(?=\d)|(\d)(?=[a-z])/g, '$1$2 ')
+    .split(/[^a-z0-9]+/)
+    .filter(Boolean);
+}
+
+function trigrams(compact: string): string[] {
+  const grams = new Set<string>();
+  for (let i = 0; i + 3 <= compact.length; i++) {
+    grams.add(compact.substring(i, i + 3));
+  }
+  return [...grams];
+}
+
+/**
+ * Split a pattern key into one entry per VIN position ("[A-C]" is one position)
+ */
+function keyPositions(key: string): string[] {
+  return key.match(/\[[^\]]*\]|./g) ?? [];
+}
+
+/**
+ * Whether some VIN could match both pattern keys (character classes are treated as wildcards)
+ */
+function keysOverlap(a: string[], b: string[]): boolean {
+  for (let i = 0; i < Math.min(a.length, b.length); i++) {
+    if (a[i].length === 1 && b[i].length === 1 && a[i] !== '*' && b[i] !== '*' && a[i] !== b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+function freeze(postings: Map<string, number[]>): Map<string, Int32Array> {
+  const frozen = new Map<string, Int32Array>();
+  for (const [key, list] of postings) {
+    frozen.set(key, Int32Array.from(list));
+  }
+  return frozen;
+}
+
+/**
+ * In-memory search over vPIC make, model, series and trim names
+ *
+ * Each make and model pair is a document. Its model name, make name, and the
+ * Series and Trim values whose patterns overlap one of its Model patterns are
+ * indexed as normalized tokens (plus initials of multi-word names, so "lr"
+ * finds "Long Range"); model names are also indexed by trigram for
+ * misspellings. Queries score exact tokens, token prefixes and trigram
+ * similarity, and never touch the database.
+ *
+ * @example
+ * ```typescript
+ * const index = await ModelSearchIndex.build(adapter);
+ * index.searchModels("f150", { year: 2020 }); // [{ make: "FORD", model: "F-150", ... }]
+ * ```
+ */
+export class ModelSearchIndex {
+  private docMake: Int32Array;
+  private docModel: Int32Array;
+  private makeNames: Map<number, string>;
+  private modelNames: Map<number, string>;
+  private makesByName: Map<string, number[]>;
+  private modelYears: Map<number, number[]>;
+  private tokens: Map<string, Int32Array>;
+  private sortedTokens: string[];
+  private grams: Map<string, Int32Array>;
+  private docGramCount: Uint16Array;
+  private docCompact: string[];
+  private report: ModelSearchMemoryReport;
+
+  // Per-query scratch space, reset after each search
+  private scores: Float64Array;
+  private best: Float64Array;
+
+  private constructor(
+    pairs: Array<{ MakeId: number; Make: string; ModelId: number; Model: string }>,
+    modelYears: Map<number, number[]>,
+    modelAttributes: Map<number, Set<string>>,
+    buildStart: number,
+  ) {
+    const docs = pairs.length;
+    this.docMake = new Int32Array(docs);
+    this.docModel = new Int32Array(docs);
+    this.docGramCount = new Uint16Array(docs);
+    this.docCompact = new Array(docs);
+    this.makeNames = new Map();
+    this.modelNames = new Map();
+    this.makesByName = new Map();
+    this.modelYears = modelYears;
+
+    const tokens = new Map<string, number[]>();
+    const grams = new Map<string, number[]>();
+    const post = (index: Map<string, number[]>, key: string, value: number) => {
+      const list = index.get(key);
+      if (list) {
+        list.push(value);
+      } else {
+        index.set(key, [value]);
+      }
+    };
+
+    const attributes = new Set<string>();
+    pairs.forEach(({ MakeId, Make, ModelId, Model }, doc) => {
+      this.docMake[doc] = MakeId;
+      this.docModel[doc] = ModelId;
+      this.modelNames.set(ModelId, Model);
+      if (!this.makeNames.has(MakeId)) {
+        this.makeNames.set(MakeId, Make);
+        post(this.makesByName, tokenizeSearchText(Make).join(' '), MakeId);
+      }
+
+      // Each token is posted once per document, under the highest-weighted field it occurs in
+      const fields = new Map<string, number>();
+      const add = (token: string, field: number) => {
+        const current = fields.get(token);
+        if (current === undefined || FIELD_WEIGHTS[field] > FIELD_WEIGHTS[current]) {
+          fields.set(token, field);
+        }
+      };
+      const addName = (name: string, field: number) => {
+        const words = tokenizeSearchText(name);
+        words.forEach(word => add(word, field));
+        if (words.length > 1) {
+          add(words.map(word => word[0]).join(''), FIELD_ACRONYM);
+        }
+      };
+
+      addName(Model, FIELD_MODEL);
+      addName(Make, FIELD_MAKE);
+      for (const attribute of modelAttributes.get(ModelId) ?? []) {
+        attributes.add(attribute);
+        addName(attribute, FIELD_ATTRIBUTE);
+      }
+      for (const [token, field] of fields) {
+        post(tokens, token, doc * 4 + field);
+      }
+
+      const compact = tokenizeSearchText(Model).join('');
+      const modelGrams = trigrams(compact);
+      this.docCompact[doc] = compact;
+      this.docGramCount[doc] = modelGrams.length;
+      modelGrams.forEach(gram => post(grams, gram, doc));
+    });
+
+    this.tokens = freeze(tokens);
+    this.grams = freeze(grams);
+    this.sortedTokens = [...this.tokens.keys()].sort();
+    this.scores = new Float64Array(docs);
+    this.best = new Float64Array(docs);
+
+    let postings = 0;
+    let bytes = docs * (4 + 4 + 2 + 8 + 8 + 8);
+    for (const index of [this.tokens, this.grams]) {
+      for (const [key, list] of index) {
+        postings += list.length;
+        bytes += list.byteLength + key.length * 2 + 64;
+      }
+    }
+    bytes += this.sortedTokens.length * 8;
+    for (const name of [...this.makeNames.values(), ...this.modelNames.values(), ...this.docCompact]) {
+      bytes += name.length * 2 + 48;
+    }
+    for (const years of this.modelYears.values()) {
+      bytes += years.length * 8 + 48;
+    }
+
+    this.report = {
+      models: docs,
+      makes: this.makeNames.size,
+      attributes: attributes.size,
+      tokens: this.tokens.size,
+      trigrams: this.grams.size,
+      postings,
+      bytes,
+      buildMs: Date.now() - buildStart,
+    };
+    logger.debug(this.report, 'Model search index built');
+  }
+
+  /**
+   * Build a search index from a vPIC database
+   *
+   * Reads Make_Model, the Model, Series and Trim patterns and the schema year
+   * ranges once; the queries are not cached afterwards.
+   *
+   * @param adapter - Database adapter
+   * @returns Search index
+   */
+  static async build(adapter: DatabaseAdapter): Promise<ModelSearchIndex> {
+    const start = Date.now();
+    const db = new VPICDatabase(adapter);
+    const [pairs, ranges, models, series, trims] = await Promise.all([
+      db.getMakeModels(),
+      db.getAllSchemaYearRanges(),
+      db.getElementPatterns('Model'),
+      db.getElementPatterns('Series'),
+      db.getElementPatterns('Trim'),
+    ]);
+
+    const schemaYears = new Map<number, Array<[number, number]>>();
+    for (const { SchemaId, YearFrom, YearTo } of ranges) {
+      const list = schemaYears.get(SchemaId) ?? [];
+      list.push([YearFrom, YearTo ?? OPEN_YEAR]);
+      schemaYears.set(SchemaId, list);
+    }
+
+    // Model years, merged into sorted [from, to, from, to, ...] ranges
+    const modelRanges = new Map<number, Array<[number, number]>>();
+    const schemaModels = new Map<number, Array<{ modelId: number; key: string[] }>>();
+    for (const row of models) {
+      const modelId = Number(row.AttributeId);
+      const list = modelRanges.get(modelId) ?? [];
+      list.push(...(schemaYears.get(row.SchemaId) ?? []));
+      modelRanges.set(modelId, list);
+
+      const inSchema = schemaModels.get(row.SchemaId) ?? [];
+      inSchema.push({ modelId, key: keyPositions(row.Pattern) });
+      schemaModels.set(row.SchemaId, inSchema);
+    }
+
+    const modelYears = new Map<number, number[]>();
+    for (const [modelId, list] of modelRanges) {
+      const merged: number[] = [];
+      for (const [from, to] of list.sort((a, b) => a[0] - b[0])) {
+        if (merged.length > 0 && from <= merged[merged.length - 1] + 1) {
+          merged[merged.length - 1] = Math.max(merged[merged.length - 1], to);
+        } else {
+          merged.push(from, to);
+        }
+      }
+      modelYears.set(modelId, merged);
+    }
+
+    // Series and trims are linked to the models whose patterns they can co-occur with
+    const modelAttributes = new Map<number, Set<string>>();
+    for (const row of [...series, ...trims]) {
+      const value = String(row.Value ?? '').trim();
+      if (!value) {
+        continue;
+      }
+      const key = keyPositions(row.Pattern);
+      for (const model of schemaModels.get(row.SchemaId) ?? []) {
+        if (keysOverlap(key, model.key)) {
+          const set = modelAttributes.get(model.modelId) ?? new Set<string>();
+          set.add(value);
+          modelAttributes.set(model.modelId, set);
+        }
+      }
+    }
+
+    return new ModelSearchIndex(pairs, modelYears, modelAttributes, start);
+  }
+
+  /**
+   * Get the size of the index
+   */
+  getMemoryReport(): ModelSearchMemoryReport {
+    return { ...this.report };
+  }
+
+  /**
+   * Find makes and models matching free text
+   *
+   * @param text - Query such as "f150" or "model y lr"
+   * @param options - Make and year filters, result limit
+   * @returns Matches, best first
+   */
+  searchModels(text: string, options: ModelSearchOptions = {}): ModelSearchResult[] {
+    const queryTokens = tokenizeSearchText(text);
+    if (queryTokens.length === 0) {
+      return [];
+    }
+
+    const makeIds = this.resolveMake(options.make);
+    if (makeIds && makeIds.size === 0) {
+      return [];
+    }
+
+    const touched = new Set<number>();
+    for (const token of queryTokens) {
+      const bestTouched: number[] = [];
+      const offer = (packed: number, factor: number) => {
+        const doc = packed >> 2;
+        const score = FIELD_WEIGHTS[packed & 3] * factor;
+        if (this.best[doc] === 0) {
+          bestTouched.push(doc);
+        }
+        if (score > this.best[doc]) {
+          this.best[doc] = score;
+        }
+      };
+
+      this.tokens.get(token)?.forEach(packed => offer(packed, 1));
+      for (const prefixed of this.expandPrefix(token)) {
+        this.tokens.get(prefixed)!.forEach(packed => offer(packed, PREFIX_WEIGHT));
+      }
+
+      for (const doc of bestTouched) {
+        this.scores[doc] += this.best[doc];
+        this.best[doc] = 0;
+        touched.add(doc);
+      }
+    }
+
+    // Fuzzy match on the whole query against model names
+    const compact = queryTokens.join('');
+    const queryGrams = trigrams(compact);
+    const shared = new Map<number, number>();
+    for (const gram of queryGrams) {
+      this.grams.get(gram)?.forEach(doc => shared.set(doc, (shared.get(doc) ?? 0) + 1));
+    }
+    const similarity = new Map<number, number>();
+    for (const [doc, count] of shared) {
+      const dice = (2 * count) / (queryGrams.length + this.docGramCount[doc]);
+      if (dice >= MIN_TRIGRAM_SIMILARITY) {
+        similarity.set(doc, dice);
+        touched.add(doc);
+      }
+    }
+
+    const results: ModelSearchResult[] = [];
+    for (const doc of touched) {
+      const tokenScore = this.scores[doc];
+      this.scores[doc] = 0;
+
+      const makeId = this.docMake[doc];
+      const modelId = this.docModel[doc];
+      if ((makeIds && !makeIds.has(makeId)) || (options.year !== undefined && !this.hasYear(modelId, options.year))) {
+        continue;
+      }
+
+      const exact = this.docCompact[doc] === compact ? 1 : 0;
+      results.push({
+        makeId,
+        make: this.makeNames.get(makeId)!,
+        modelId,
+        model: this.modelNames.get(modelId)!,
+        score: tokenScore / queryTokens.length + (similarity.get(doc) ?? 0) + exact,
+      });
+    }
+
+    return results
+      .sort((a, b) => b.score - a.score || a.model.length - b.model.length || a.modelId - b.modelId)
+      .slice(0, options.limit ?? 10);
+  }
+
+  /**
+   * Index tokens starting with (and longer than) a query token
+   */
+  private expandPrefix(token: string): string[] {
+    if (token.length < 2 && !/\d/.test(token)) {
+      return [];
+    }
+
+    let low = 0;
+    let high = this.sortedTokens.length;
+    while (low < high) {
+      const mid = (low + high) >> 1;
+      if (this.sortedTokens[mid] <= token) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+
+    const expanded: string[] = [];
+    for (let i = low; i < this.sortedTokens.length && expanded.length < MAX_PREFIX_EXPANSIONS; i++) {
+      if (!this.sortedTokens[i].startsWith(token)) {
+        break;
+      }
+      expanded.push(this.sortedTokens[i]);
+    }
+    return expanded;
+  }
+
+  private resolveMake(make: number | string | undefined): Set<number> | undefined {
+    if (make === undefined) {
+      return undefined;
+    }
+    if (typeof make === 'number') {
+      return new Set(this.makeNames.has(make) ? [make] : []);
+    }
+    return new Set(this.makesByName.get(tokenizeSearchText(make).join(' ')) ?? []);
+  }
+
+  private hasYear(modelId: number, year: number): boolean {
+    const years = this.modelYears.get(modelId);
+    if (!years) {
+      return false;
+    }
+    for (let i = 0; i < years.length; i += 2) {
+      if (year >= years[i] && year <= years[i + 1]) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
@@ -0,0 +1,128 @@
+import { createServer, IncomingMessage, Server, ServerResponse } from 'http';
+import { OverloadError } from './admission';
+import type { DecoderPool } from './pool';
+import { LATENCY_BUCKETS } from './scheduler';
+import type { LatencyStats } from './scheduler';
+import type { DecodeOptions } from './types';
+import { createLogger } from './logger';
+
+const logger = createLogger('DecodeServer');
+
+function renderHistogram(name: string, labels: string, stats: LatencyStats): string[] {
+  const lines: string[] = [];
+  let cumulative = 0;
+  LATENCY_BUCKETS.forEach((bound, i) => {
+    cumulative += stats.buckets[i];
+    lines.push(`${name}_bucket{${labels},le="${bound / 1000}"} ${cumulative}`);
+  });
+  lines.push(`${name}_bucket{${labels},le="+Inf"} ${stats.count}`);
+  lines.push(`${name}_sum{${labels}} ${stats.sum / 1000}`);
+  lines.push(`${name}_count{${labels}} ${stats.count}`);
+  return lines;
+}
+
+/**
+ * Render pool statistics in the Prometheus text exposition format
+ *
+ * @param pool - Decoder pool
+ * @returns Metrics text
+ */
+export function renderMetrics(pool: DecoderPool): string {
+  const stats = pool.getStats();
+  return [
+    '# TYPE corgi_requests_completed_total counter',
+    `corgi_requests_completed_total{class="cheap"} ${stats.completed.cheap}`,
+    `corgi_requests_completed_total{class="full"} ${stats.completed.full}`,
+    '# TYPE corgi_requests_shed_total counter',
+    `corgi_requests_shed_total{reason="latency"} ${stats.shedLatency}`,
+    `corgi_requests_shed_total{reason="queue-full"} ${stats.shedQueueFull}`,
+    '# TYPE corgi_result_cache_hits_total counter',
+    `corgi_result_cache_hits_total ${stats.cacheHits}`,
+    '# TYPE corgi_affinity_routed_total counter',
+    `corgi_affinity_routed_total{result="owner"} ${stats.affinityHits}`,
+    `corgi_affinity_routed_total{result="spill",reason="queue-depth"} ${stats.affinityDepthSpills}`,
+    `corgi_affinity_routed_total{result="spill",reason="wait"} ${stats.affinityWaitSpills}`,
+    '# TYPE corgi_affinity_queued_total counter',
+    `corgi_affinity_queued_total ${stats.affinityQueued}`,
+    '# TYPE corgi_queue_depth gauge',
+    `corgi_queue_depth{class="cheap"} ${stats.queued.cheap}`,
+    `corgi_queue_depth{class="full"} ${stats.queued.full}`,
+    '# TYPE corgi_bulk_queue_depth gauge',
+    `corgi_bulk_queue_depth ${stats.queuedBulk}`,
+    '# TYPE corgi_bulk_grants_total counter',
+    `corgi_bulk_grants_total ${stats.bulkGrants}`,
+    '# TYPE corgi_request_duration_seconds histogram',
+    ...renderHistogram('corgi_request_duration_seconds', 'priority="interactive"', stats.latency.interactive),
+    ...renderHistogram('corgi_request_duration_seconds', 'priority="bulk"', stats.latency.bulk),
+    '# TYPE corgi_requests_running gauge',
+    `corgi_requests_running ${stats.running}`,
+    '# TYPE corgi_overloaded gauge',
+    `corgi_overloaded ${stats.overloaded ? 1 : 0}`,
+    '# TYPE corgi_workers gauge',
+    `corgi_workers ${stats.workers}`,
+    '',
+  ].join('\n');
+}
+
+function send(res: ServerResponse, status: number, body: unknown, headers: Record<string, string> = {}): void {
+  const text = typeof body === 'string' ? body : JSON.stringify(body);
+  res.writeHead(status, {
+    'Content-Type': typeof body === 'string' ? 'text/plain; version=0.0.4' : 'application/json',
+    'Content-Length': Buffer.byteLength(text),
+    ...headers,
+  });
+  res.end(text);
+}
+
+function parseDecodeOptions(params: URLSearchParams): DecodeOptions {
+  const options: DecodeOptions = {};
+  if (params.has('patterns')) options.includePatternDetails = params.get('patterns') !== 'false';
+  if (params.has('raw')) options.includeRawData = params.get('raw') !== 'false';
+  if (params.has('year')) options.modelYear = Number(params.get('year'));
+  if (params.get('priority') === 'bulk') options.priority = 'bulk';
+  return options;
+}
+
+/**
+ * Create an HTTP server decoding VINs through a pool
+ *
+ * Routes:
+ * - `GET /decode/:vin` - full decode (`?patterns`, `?raw`, `?year=`, `?priority=bulk`)
+ * - `GET /validate/:vin` - structure and check digit only
+ * - `GET /metrics` - Prometheus metrics, including shed counts and latency per priority
+ * - `GET /health`
+ *
+ * Shed requests get `503` with `Retry-After`.
+ *
+ * @param pool - Decoder pool
+ * @returns HTTP server (not yet listening)
+ */
+export function createDecodeServer(pool: DecoderPool): Server {
+  return createServer(async (req: IncomingMessage, res: ServerResponse) => {
+    const url = new URL(req.url ?? '/', 'http://localhost');
+    const [, route, vin] = url.pathname.split('/');
+
+    try {
+      if (req.method !== 'GET') {
+        send(res, 405, { error: 'Method not allowed' });
+      } else if (route === 'decode' && vin) {
+        send(res, 200, await pool.decode(decodeURIComponent(vin), parseDecodeOptions(url.searchParams)));
+      } else if (route === 'validate' && vin) {
+        send(res, 200, await pool.validate(decodeURIComponent(vin)));
+      } else if (route === 'metrics') {
+        send(res, 200, renderMetrics(pool));
+      } else if (route === 'health') {
+        send(res, 200, { status: 'ok' });
+      } else {
+        send(res, 404, { error: 'Not found' });
+      }
+    } catch (error) {
+      if (error instanceof OverloadError) {
+        send(res, 503, { error: error.message }, { 'Retry-After': String(error.retryAfter) });
+      } else {
+        logger.error({ error, url: req.url }, 'Request failed');
+        send(res, 500, { error: error instanceof Error ? error.message : 'Unknown error' });
+      }
+    }
+  });
+}
@@ -0,0 +1,228 @@
+import { validateCheckDigit } from './check-digit';
+
+/** Characters packed per 32-bit word (6 bits each) */
+const CHARS_PER_WORD = 5;
+
+/** Words per packed VIN */
+const WORDS = Math.ceil(17 / CHARS_PER_WORD);
+
+/** Lowest bit of every 6-bit character field in a word */
+const FIELD_LOW_BITS = 0x1041041;
+
+/** 6-bit code per char code (1-36 for 0-9 and A-Z, either case), 0 when not alphanumeric */
+const CHAR_CODES = (() => {
+  const codes = new Uint8Array(128);
+  const chars = '0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ';
+  for (let i = 0; i < chars.length; i++) {
+    codes[chars.charCodeAt(i)] = i + 1;
+    codes[chars.toLowerCase().charCodeAt(i)] = i + 1;
+  }
+  return codes;
+})();
+
+/**
+ * Options for a VIN similarity join
+ */
+export interface SimilarityJoinOptions {
+  /** Most differing positions for a pair to be reported (default: 1) */
+  maxDistance?: number;
+}
+
+/**
+ * Two VINs that differ in at most `maxDistance` positions
+ */
+export interface SimilarVinPair {
+  /** VIN that appears first in the input */
+  a: string;
+  /** Other VIN */
+  b: string;
+  /** Number of differing positions */
+  distance: number;
+  /** Differing positions (1-based) */
+  positions: number[];
+  /** Whether each VIN's check digit is valid, in `a`, `b` order */
+  checkDigitValid: [boolean, boolean];
+}
+
+/**
+ * Similar VIN pair, annotated with whether both VINs decode to the same vehicle
+ */
+export interface NearDuplicatePair extends SimilarVinPair {
+  /** Both VINs decode to the same make, model, year, trim, body and engine */
+  sameSpec: boolean;
+}
+
+function popcount(x: number): number {
+  x -= (x >>> 1) & 0x55555555;
+  x = (x & 0x33333333) + ((x >>> 2) & 0x33333333);
+  return (Math.imul((x + (x >>> 4)) & 0x0f0f0f0f, 0x01010101) >>> 24);
+}
+
+/**
+ * Split the 17 positions into segments of roughly equal entropy
+ *
+ * Pigeonhole: two VINs within distance k agree exactly on at least one of k + 1
+ * segments, so only VINs sharing a segment value need comparing. Positions
+ * such as the WMI barely vary within a batch; spreading entropy evenly keeps
+ * every segment's buckets small.
+ */
+function planSegments(codes: Uint8Array, count: number, segments: number): number[][] {
+  const entropy: Array<[number, number]> = [];
+  const histogram = new Uint32Array(37);
+  for (let position = 0; position < 17; position++) {
+    histogram.fill(0);
+    for (let i = 0; i < count; i++) {
+      histogram[codes[i * 17 + position]]++;
+    }
+    let bits = 0;
+    for (const n of histogram) {
+      if (n > 0) bits -= (n / count) * Math.log2(n / count);
+    }
+    entropy.push([position, bits]);
+  }
+
+  // Greedy: highest-entropy positions first, each to the segment with the least so far
+  entropy.sort((x, y) => y[1] - x[1]);
+  const plan = Array.from({ length: segments }, () => ({ positions: [] as number[], bits: 0 }));
+  for (const [position, bits] of entropy) {
+    const target = plan.reduce((min, segment) =>
+      segment.bits < min.bits || (segment.bits === min.bits && segment.positions.length < min.positions.length) ? segment : min,
+    );
+    target.positions.push(position);
+    target.bits += bits;
+  }
+  return plan.map(segment => segment.positions.sort((x, y) => x - y));
+}
+
+/**
+ * Find every pair of VINs that differ in at most `maxDistance` positions
+ *
+ * Cloned VINs and typos show up as pairs that differ in one or two
+ * characters (a transposition is two). VINs are packed at 6 bits per
+ * character and split into `maxDistance + 1` segments; VINs are grouped by
+ * each segment's value and only VINs in the same group are compared, with a
+ * few word operations per comparison. Each pair is reported once, from the
+ * first segment it agrees on.
+ *
+ * Input is upper-cased and trimmed; duplicates and entries that are not 17
+ * letters and digits are ignored. Cost grows with the size of the largest
+ * groups, so batches of one model from one plant and year, where only the
+ * serial number varies, are the slowest case.
+ *
+ * @param vins - VINs to join
+ * @param options - Join options
+ * @returns Pairs, ordered by the first VIN's input position
+ */
+export function findSimilarVins(vins: Iterable<string>, options: SimilarityJoinOptions = {}): SimilarVinPair[] {
+  const maxDistance = Math.max(1, Math.min(16, Math.floor(options.maxDistance ?? 1)));
+
+  const unique: string[] = [];
+  const seen = new Set<string>();
+  for (const raw of vins) {
+    const vin = raw.toUpperCase().trim();
+    if (vin.length !== 17 || seen.has(vin)) continue;
+    let valid = true;
+    for (let i = 0; i < 17 && valid; i++) {
+      const code = vin.charCodeAt(i);
+      valid = code < 128 && CHAR_CODES[code] !== 0;
+    }
+    if (valid) {
+      seen.add(vin);
+      unique.push(vin);
+    }
+  }
+
+  const count = unique.length;
+  const codes = new Uint8Array(count * 17);
+  const packed = new Uint32Array(count * WORDS);
+  for (let i = 0; i < count; i++) {
+    const vin = unique[i];
+    for (let position = 0; position < 17; position++) {
+      const code = CHAR_CODES[vin.charCodeAt(position)];
+      codes[i * 17 + position] = code;
+      const word = i * WORDS + Math.floor(position / CHARS_PER_WORD);
+      packed[word] |= code << ((position % CHARS_PER_WORD) * 6);
+    }
+  }
+
+  // Distance between two packed VINs, or maxDistance + 1 once it is exceeded
+  const distance = (a: number, b: number): number => {
+    let d = 0;
+    for (let w = 0; w < WORDS && d <= maxDistance; w++) {
+      const x = packed[a * WORDS + w] ^ packed[b * WORDS + w];
+      if (x !== 0) {
+        d += popcount((x | (x >>> 1) | (x >>> 2) | (x >>> 3) | (x >>> 4) | (x >>> 5)) & FIELD_LOW_BITS);
+      }
+    }
+    return d;
+  };
+
+  // Segment values hashed to 53 bits; collisions only add candidates that fail the distance check
+  const segments = planSegments(codes, count, maxDistance + 1);
+  const keys = segments.map(positions => {
+    const segmentKeys = new Float64Array(count);
+    for (let i = 0; i < count; i++) {
+      let hi = 0x811c9dc5;
+      let lo = 0x9747b28c;
+      for (const position of positions) {
+        const code = codes[i * 17 + position];
+        hi = Math.imul(hi ^ code, 16777619);
+        lo = Math.imul(lo ^ code, 0x5bd1e995);
+      }
+      segmentKeys[i] = (hi >>> 11) * 4294967296 + (lo >>> 0);
+    }
+    return segmentKeys;
+  });
+
+  // Matches as index pairs; objects are only built once they are in order
+  const left: number[] = [];
+  const right: number[] = [];
+  const order = new Uint32Array(count);
+  for (let s = 0; s < segments.length; s++) {
+    const segmentKeys = keys[s];
+    for (let i = 0; i < count; i++) order[i] = i;
+    order.sort((x, y) => segmentKeys[x] - segmentKeys[y] || x - y);
+
+    for (let start = 0; start < count; ) {
+      let end = start + 1;
+      while (end < count && segmentKeys[order[end]] === segmentKeys[order[start]]) end++;
+
+      for (let p = start; p < end; p++) {
+        for (let q = p + 1; q < end; q++) {
+          const a = order[p];
+          const b = order[q];
+          // Reported already from an earlier segment they agree on
+          let earlier = false;
+          for (let t = 0; t < s && !earlier; t++) {
+            earlier = keys[t][a] === keys[t][b] && segments[t].every(position => codes[a * 17 + position] === codes[b * 17 + position]);
+          }
+          if (earlier) continue;
+
+          const d = distance(a, b);
+          if (d > maxDistance || d === 0) continue;
+
+          left.push(a);
+          right.push(b);
+        }
+      }
+      start = end;
+    }
+  }
+
+  const matches = Array.from(left.keys()).sort((x, y) => left[x] - left[y] || right[x] - right[y]);
+  return matches.map((m): SimilarVinPair => {
+    const a = left[m];
+    const b = right[m];
+    const positions: number[] = [];
+    for (let position = 0; position < 17; position++) {
+      if (codes[a * 17 + position] !== codes[b * 17 + position]) positions.push(position + 1);
+    }
+    return {
+      a: unique[a],
+      b: unique[b],
+      distance: positions.length,
+      positions,
+      checkDigitValid: [validateCheckDigit(unique[a]).isValid, validateCheckDigit(unique[b]).isValid],
+    };
+  });
+}
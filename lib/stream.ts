@@ -0,0 +1,211 @@
+import type { DecodeOptions, DecodeResult } from './types';
+
+/** Line feed, carriage return and comma as bytes */
+const LF = 0x0a;
+const CR = 0x0d;
+const COMMA = 0x2c;
+
+/**
+ * Options for decode streams
+ */
+export interface DecodeStreamOptions extends DecodeOptions {
+  /** VINs decoded at once; results are still emitted in input order (default: 8) */
+  concurrency?: number;
+
+  /**
+   * Results buffered on the readable side before the stream stops accepting
+   * input (default: `concurrency`)
+   */
+  highWaterMark?: number;
+}
+
+/**
+ * Anything that decodes a single VIN asynchronously (VINDecoder, the browser
+ * VINDecoder, VINDecoderWrapper, DecoderPool)
+ */
+export interface StreamDecoder {
+  decode(vin: string, options?: DecodeOptions): Promise<DecodeResult>;
+}
+
+/**
+ * Ordered window of decodes in flight, shared by both stream variants
+ */
+function decodeWindow(decoder: StreamDecoder, options: DecodeStreamOptions) {
+  const { concurrency = 8, highWaterMark, priority = 'bulk', ...rest } = options;
+  const decodeOptions: DecodeOptions = { ...rest, priority };
+  const size = Math.max(1, concurrency);
+  const pending: Promise<DecodeResult>[] = [];
+
+  return {
+    size,
+    highWaterMark: highWaterMark ?? size,
+
+    /**
+     * Start decoding a VIN; once the window is full, wait for the oldest
+     * decode and emit it, which holds back further writes
+     */
+    async push(vin: string, controller: TransformStreamDefaultController<DecodeResult>): Promise<void> {
+      const decode = decoder.decode(vin, decodeOptions);
+      // Rejections are reported when the decode reaches the front of the window
+      decode.catch(() => undefined);
+      pending.push(decode);
+      if (pending.length >= size) {
+        controller.enqueue(await pending.shift()!);
+      }
+    },
+
+    async drain(controller: TransformStreamDefaultController<DecodeResult>): Promise<void> {
+      while (pending.length > 0) {
+        controller.enqueue(await pending.shift()!);
+      }
+    },
+  };
+}
+
+/**
+ * Decode a stream of VINs, one VIN per chunk
+ *
+ * Up to `concurrency` VINs decode at once and results come out in input
+ * order. Writes wait while the window is full and the reader has not taken
+ * the buffered results, so a slow consumer slows the producer instead of
+ * growing a queue. With a D1 adapter created with `batchQueries`, the queries
+ * of the decodes in the window share round trips.
+ *
+ * @param decoder - Decoder to use
+ * @param options - Decode options, concurrency and buffering
+ * @returns Transform stream from VINs to decode results
+ *
+ * @example
+ * ```typescript
+ * const results = vinStream.pipeThrough(createDecodeStream(decoder, { concurrency: 16 }));
+ * ```
+ */
+export function createDecodeStream(
+  decoder: StreamDecoder,
+  options: DecodeStreamOptions = {},
+): TransformStream<string, DecodeResult> {
+  const decodes = decodeWindow(decoder, options);
+  return new TransformStream<string, DecodeResult>(
+    {
+      transform: (vin, controller) => decodes.push(vin, controller),
+      flush: controller => decodes.drain(controller),
+    },
+    new CountQueuingStrategy({ highWaterMark: decodes.size }),
+    new CountQueuingStrategy({ highWaterMark: decodes.highWaterMark }),
+  );
+}
+
+/**
+ * Split bytes into VINs, one per line
+ *
+ * Lines are found by scanning bytes, so only the first field of each line
+ * (up to the first comma) is ever decoded to a string; the rest of a CSV row
+ * is skipped. LF and CRLF line endings are accepted, fields are trimmed and
+ * upper-cased, and empty lines are dropped. Lines may span chunks.
+ */
+class LineSplitter {
+  private carry: Uint8Array | null = null;
+  private text = new TextDecoder();
+
+  split(chunk: Uint8Array, emit: (vin: string) => void): void {
+    let bytes = chunk;
+    if (this.carry) {
+      bytes = new Uint8Array(this.carry.length + chunk.length);
+      bytes.set(this.carry);
+      bytes.set(chunk, this.carry.length);
+      this.carry = null;
+    }
+
+    let start = 0;
+    for (let end = bytes.indexOf(LF); end !== -1; end = bytes.indexOf(LF, start)) {
+      this.line(bytes, start, end, emit);
+      start = end + 1;
+    }
+    if (start < bytes.length) {
+      // Copy so the caller's chunk can be reused
+      this.carry = bytes.slice(start);
+    }
+  }
+
+  end(emit: (vin: string) => void): void {
+    if (this.carry) {
+      this.line(this.carry, 0, this.carry.length, emit);
+      this.carry = null;
+    }
+  }
+
+  private line(bytes: Uint8Array, start: number, end: number, emit: (vin: string) => void): void {
+    let fieldEnd = start;
+    while (fieldEnd < end && bytes[fieldEnd] !== COMMA && bytes[fieldEnd] !== CR) {
+      fieldEnd++;
+    }
+    const vin = this.text.decode(bytes.subarray(start, fieldEnd)).trim().toUpperCase();
+    if (vin) {
+      emit(vin);
+    }
+  }
+}
+
+/**
+ * Decode a byte stream of VINs, one per line, such as an uploaded CSV body
+ *
+ * Each line's first comma-separated field is taken as the VIN (the same rule
+ * as bulkDecode). Otherwise behaves as createDecodeStream: bounded
+ * concurrency, results in input order, and backpressure through to the
+ * byte source.
+ *
+ * @param decoder - Decoder to use
+ * @param options - Decode options, concurrency and buffering
+ * @returns Transform stream from bytes to decode results
+ *
+ * @example
+ * ```typescript
+ * // Cloudflare Worker
+ * const results = request.body!.pipeThrough(createByteDecodeStream(decoder));
+ * ```
+ */
+export function createByteDecodeStream(
+  decoder: StreamDecoder,
+  options: DecodeStreamOptions = {},
+): TransformStream<Uint8Array, DecodeResult> {
+  const decodes = decodeWindow(decoder, options);
+  const splitter = new LineSplitter();
+
+  // Push the VINs of a chunk one at a time so a full window pauses the split
+  const pushAll = async (vins: string[], controller: TransformStreamDefaultController<DecodeResult>) => {
+    for (const vin of vins) {
+      await decodes.push(vin, controller);
+    }
+  };
+
+  return new TransformStream<Uint8Array, DecodeResult>(
+    {
+      transform: (chunk, controller) => {
+        const vins: string[] = [];
+        splitter.split(chunk, vin => vins.push(vin));
+        return pushAll(vins, controller);
+      },
+      flush: async controller => {
+        const vins: string[] = [];
+        splitter.end(vin => vins.push(vin));
+        await pushAll(vins, controller);
+        await decodes.drain(controller);
+      },
+    },
+    // Chunks are byte buffers of any size; count them, not their bytes
+    new CountQueuingStrategy({ highWaterMark: 1 }),
+    new CountQueuingStrategy({ highWaterMark: decodes.highWaterMark }),
+  );
+}
+
+/**
+ * Encode decode results as newline-delimited JSON, e.g. for a streamed response body
+ *
+ * @returns Transform stream from decode results to NDJSON bytes
+ */
+export function createNdjsonStream(): TransformStream<DecodeResult, Uint8Array> {
+  const encoder = new TextEncoder();
+  return new TransformStream<DecodeResult, Uint8Array>({
+    transform: (result, controller) => controller.enqueue(encoder.encode(JSON.stringify(result) + '\n')),
+  });
+}
@@ -0,0 +1,116 @@
+import type { DecodeResult, PatternMatch, VINComponents } from './types';
+
+/**
+ * Counters for shared result components
+ */
+export interface ResultTemplateStats {
+  /** Components replaced by an existing shared instance */
+  hits: number;
+  /** Components that became a new shared instance */
+  misses: number;
+  /** Shared instances held */
+  entries: number;
+}
+
+/**
+ * Freeze an object and everything reachable from it
+ */
+function deepFreeze<T>(value: T): T {
+  if (value && typeof value === 'object' && !Object.isFrozen(value)) {
+    Object.freeze(value);
+    for (const child of Object.values(value)) {
+      deepFreeze(child);
+    }
+  }
+  return value;
+}
+
+/**
+ * Frozen component instances shared across decode results
+ *
+ * VINs from the same build decode to identical WMI, vehicle, plant, engine
+ * and VDS components; keeping one frozen instance of each lets large result
+ * sets hold references instead of copies. Pattern-derived components are keyed
+ * by the match outcome the decoder reports (WMI, model year, schemas, VDS
+ * class or VDS, and plant character), so sharing costs no serialization; the
+ * WMI is keyed by its code and the model year by its content. Results without
+ * an outcome key (e.g. from the shared cache) are keyed by content. Per-VIN
+ * parts (the VIN, check digit, VIS raw string and metadata) stay fresh on
+ * every result.
+ *
+ * Instances are held until `maxEntries` is reached, then the oldest are
+ * forgotten; results that already reference them are unaffected.
+ */
+export class ResultTemplates {
+  private entries = new Map<string, unknown>();
+  private stats = { hits: 0, misses: 0 };
+
+  /**
+   * @param maxEntries - Shared instances held before the oldest are forgotten (default: 50000)
+   */
+  constructor(private maxEntries = 50000) {}
+
+  /**
+   * Get sharing statistics
+   */
+  getStats(): ResultTemplateStats {
+    return { ...this.stats, entries: this.entries.size };
+  }
+
+  /**
+   * Forget every shared instance (e.g. after the database changes)
+   */
+  clear(): void {
+    this.entries.clear();
+  }
+
+  /**
+   * Replace a result's components with shared frozen instances
+   *
+   * @param result - Decode result; only its `components` and `patterns` references change
+   * @param outcome - Match outcome key reported by the decoder, if known
+   * @returns The same result
+   */
+  share(result: DecodeResult, outcome?: string): DecodeResult {
+    const source = result.components;
+    const components: VINComponents = { ...source };
+
+    if (source.wmi) components.wmi = this.intern('w', source.wmi, source.wmi.code);
+    if (source.modelYear) components.modelYear = this.intern('y', source.modelYear);
+    if (source.vehicle) components.vehicle = this.intern('v', source.vehicle, outcome);
+    if (source.plant) components.plant = this.intern('p', source.plant, outcome);
+    if (source.engine) components.engine = this.intern('e', source.engine, outcome);
+
+    // The VDS component also carries the raw VDS, which its class does not determine
+    if (source.vds) {
+      components.vds = this.intern('d', source.vds, outcome && `${outcome}|${source.vds.raw}`);
+    }
+    if (source.vis) {
+      components.vis = { raw: source.vis.raw, patterns: this.intern('s', source.vis.patterns, outcome) };
+    }
+    if (result.patterns) {
+      result.patterns = this.intern<PatternMatch[]>('a', result.patterns, outcome);
+    }
+
+    result.components = components;
+    return result;
+  }
+
+  private intern<T>(kind: string, value: T, key?: string): T {
+    const entryKey = `${kind}:${key ?? JSON.stringify(value)}`;
+    const existing = this.entries.get(entryKey);
+    if (existing !== undefined) {
+      this.stats.hits++;
+      return existing as T;
+    }
+
+    this.stats.misses++;
+    if (this.entries.size >= this.maxEntries) {
+      this.entries.delete(this.entries.keys().next().value!);
+    }
+    // Freeze a copy: the value may still be referenced by database or matcher caches
+    const shared = deepFreeze(structuredClone(value));
+    this.entries.set(entryKey, shared);
+    return shared;
+  }
+}
@@ -3,6 +3,7 @@
  */
 
 import { BodyStyle, ErrorSeverity, ErrorCategory, ErrorCode } from './enums';
+import type { PatternOverlay } from './overlay';
 
 // Re-export enums for backward compatibility
 export { BodyStyle, ErrorSeverity, ErrorCategory, ErrorCode };
@@ -139,6 +140,11 @@ export interface Position {
   value: string;
 }
 
+/**
+ * Scheduling priority of a decode: interactive lookups go ahead of bulk work
+ */
+export type DecodePriority = 'interactive' | 'bulk';
+
 /**
  * Configuration options for VIN decoding
  */
@@ -157,6 +163,87 @@ export interface DecodeOptions {
 
   /** Include timing and debug information */
   includeDiagnostics?: boolean;
+
+  /** Tenant overlay layered on the shared database (in-process decoders only) */
+  overlay?: PatternOverlay;
+
+  /**
+   * Return frozen WMI, model year, vehicle, plant, engine and VDS components
+   * shared with other results from the same build instead of fresh copies
+   */
+  shareComponents?: boolean;
+
+  /**
+   * Scheduling priority (default: `interactive` for single decodes, `bulk`
+   * for batches and streams); bulk decodes wait at stage boundaries while
+   * interactive decodes run
+   */
+  priority?: DecodePriority;
+}
+
+/**
+ * Decode state after the database-independent stages
+ */
+export interface PreparedDecode {
+  /** Cleaned VIN */
+  vin: string;
+
+  /** Decode start time */
+  startTime: number;
+
+  /** Partial result: validation errors, check digit and model year */
+  result: DecodeResult;
+
+  /** Extracted WMI (absent when done) */
+  wmi?: string;
+
+  /** Resolved model year (absent when done) */
+  modelYear?: ModelYearResult;
+
+  /** True when validation already determined the final result */
+  done: boolean;
+}
+
+/**
+ * Configuration options for batch and streaming decode
+ */
+export interface BatchDecodeOptions extends DecodeOptions {
+  /** Number of upcoming VINs whose schemas and patterns are prefetched (default: 16, 0 disables) */
+  lookahead?: number;
+
+  /**
+   * VINs read ahead and decoded grouped by WMI, model year and VDS, so VINs
+   * sharing patterns decode back to back; results keep input order (default:
+   * 0, off). Larger windows group more VINs but hold them and their results
+   * in memory until the earliest one is done.
+   */
+  reorderWindow?: number;
+
+  /**
+   * Return prebuilt error results for VINs with an invalid structure or
+   * unknown WMI instead of fully decoding them (default: false). Rejected
+   * results hold only the rejecting error, with positions for invalid
+   * characters.
+   */
+  fastReject?: boolean;
+}
+
+/**
+ * Pattern set locality of a batch, counted per decode: a hit is a VIN with
+ * the same WMI and model year as the VIN decoded just before it. Cache hits
+ * and misses count the pattern set lookups the decodes actually made
+ */
+export interface BatchLocalityStats {
+  /** VINs decoded */
+  decoded: number;
+  /** VINs decoded right after one with the same WMI and model year (a locality count, not cache hits) */
+  hits: number;
+  /** The same count had the VINs been decoded in input order */
+  inputOrderHits: number;
+  /** Pattern set lookups answered from the query cache, hot index or shared cache */
+  cacheHits: number;
+  /** Pattern set lookups read from the database */
+  cacheMisses: number;
 }
 
 /**
@@ -194,6 +281,9 @@ export interface ModelYearResult {
 
   /** Confidence in the year (0-1) */
   confidence: number;
+
+  /** Years the model year character can encode, most likely first (position-derived years only) */
+  candidates?: number[];
 }
 
 /**
@@ -0,0 +1,90 @@
+/**
+ * Make / Model / Year Catalog Builder
+ *
+ * Derives which models each make has in each model year from the Model
+ * patterns, their schemas' Wmi_VinSchema year ranges and Make_Model, and
+ * stores the result as compact sorted arrays in the Catalog table. Decoders
+ * load it once instead of running the Pattern scan at startup.
+ *
+ * Run after any change to the Pattern table (e.g. community:apply); the
+ * Catalog table is rebuilt from scratch each time.
+ *
+ * Usage:
+ *   npx tsx scripts/build-catalog.ts
+ *   npx tsx scripts/build-catalog.ts --db path/to/db.db
+ */
+
+import { existsSync } from "fs";
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import Database from "better-sqlite3";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VPICDatabase } from "../lib/db";
+import { compileCatalog, VehicleCatalog } from "../lib/db/catalog";
+
+// ESM-compatible __dirname
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// ANSI colors
+const RED = "\x1b[31m";
+const GREEN = "\x1b[32m";
+const RESET = "\x1b[0m";
+const BOLD = "\x1b[1m";
+
+function argValue(args: string[], name: string): string | undefined {
+  const index = args.indexOf(name);
+  return index !== -1 ? args[index + 1] : undefined;
+}
+
+function formatBytes(bytes: number): string {
+  return bytes >= 1024 * 1024
+    ? `${(bytes / 1024 / 1024).toFixed(2)} MB`
+    : `${(bytes / 1024).toFixed(1)} KB`;
+}
+
+async function main() {
+  const args = process.argv.slice(2);
+  const baseDir = join(__dirname, "..");
+  const dbPath = argValue(args, "--db") ?? join(baseDir, "db/vpic.lite.db");
+
+  console.log(`${BOLD}Make / Model / Year Catalog Builder${RESET}`);
+  console.log(`Database: ${dbPath}`);
+  console.log();
+
+  if (!existsSync(dbPath)) {
+    console.error(`${RED}Database not found: ${dbPath}${RESET}`);
+    process.exit(1);
+  }
+
+  const adapter = new NodeDatabaseAdapter(dbPath);
+  const start = Date.now();
+  const data = compileCatalog(await new VPICDatabase(adapter).getModelYearRanges());
+  const elapsed = Date.now() - start;
+  await adapter.close();
+
+  const stats = new VehicleCatalog(data).getStats();
+  const json = JSON.stringify(data);
+
+  const writer = new Database(dbPath);
+  writer.transaction(() => {
+    writer.exec("DROP TABLE IF EXISTS Catalog");
+    writer.exec("CREATE TABLE Catalog (Id INTEGER PRIMARY KEY, Data TEXT NOT NULL)");
+    writer.prepare("INSERT INTO Catalog (Id, Data) VALUES (1, ?)").run(json);
+  })();
+  writer.close();
+
+  console.log(`${BOLD}Contents${RESET}`);
+  console.log(`  Makes:          ${stats.makes}`);
+  console.log(`  Models:         ${stats.models}`);
+  console.log(`  Year ranges:    ${stats.ranges}`);
+  console.log(`  Table size:     ${formatBytes(json.length)}`);
+  console.log(`  Pattern scan:   ${elapsed} ms`);
+  console.log();
+  console.log(`${GREEN}Wrote Catalog to ${dbPath}${RESET}`);
+}
+
+main().catch((error) => {
+  console.error(`${RED}${error instanceof Error ? error.message : error}${RESET}`);
+  process.exit(1);
+});
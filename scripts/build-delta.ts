@@ -0,0 +1,94 @@
+/**
+ * Database Delta Builder
+ *
+ * Compares the previously published database with a new build page by page
+ * and writes the changed pages as a patch next to a manifest of the whole
+ * chain. Installed copies in ~/.corgi-cache are brought up to date by
+ * applying the patches from their version onwards (see getDatabasePath)
+ * instead of decompressing the full database again.
+ *
+ * Run once per release with the database shipped by the previous release.
+ * Both files must be uncompressed; the page size is read from the new
+ * database's header.
+ *
+ * Usage:
+ *   npx tsx scripts/build-delta.ts --from previous/vpic.lite.db
+ *   npx tsx scripts/build-delta.ts --from previous/vpic.lite.db --to db/vpic.lite.db --out dist/db/deltas
+ */
+
+import { existsSync, statSync } from "fs";
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import { createDelta, publishDelta } from "../lib/db/delta";
+
+// ESM-compatible __dirname
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// ANSI colors
+const RED = "\x1b[31m";
+const GREEN = "\x1b[32m";
+const YELLOW = "\x1b[33m";
+const RESET = "\x1b[0m";
+const BOLD = "\x1b[1m";
+
+function argValue(args: string[], name: string): string | undefined {
+  const index = args.indexOf(name);
+  return index !== -1 ? args[index + 1] : undefined;
+}
+
+function formatBytes(bytes: number): string {
+  return bytes >= 1024 * 1024
+    ? `${(bytes / 1024 / 1024).toFixed(2)} MB`
+    : `${(bytes / 1024).toFixed(1)} KB`;
+}
+
+async function main() {
+  const args = process.argv.slice(2);
+  const baseDir = join(__dirname, "..");
+  const fromPath = argValue(args, "--from");
+  const toPath = argValue(args, "--to") ?? join(baseDir, "db/vpic.lite.db");
+  const outDir = argValue(args, "--out") ?? join(baseDir, "dist/db/deltas");
+
+  console.log(`${BOLD}Database Delta Builder${RESET}`);
+  console.log(`From: ${fromPath ?? "(missing)"}`);
+  console.log(`To:   ${toPath}`);
+  console.log();
+
+  if (!fromPath) {
+    console.error(`${RED}--from is required${RESET}`);
+    process.exit(1);
+  }
+  for (const path of [fromPath, toPath]) {
+    if (!existsSync(path)) {
+      console.error(`${RED}Database not found: ${path}${RESET}`);
+      process.exit(1);
+    }
+  }
+
+  const start = Date.now();
+  const build = await createDelta(fromPath, toPath);
+  const elapsed = Date.now() - start;
+
+  if (build.from === build.to) {
+    console.log(`${YELLOW}Databases are identical; no delta written${RESET}`);
+    return;
+  }
+
+  const manifest = await publishDelta(outDir, build);
+
+  console.log(`${BOLD}Delta${RESET}`);
+  console.log(`  Page size:      ${build.pageSize}`);
+  console.log(`  Pages changed:  ${build.pages} of ${build.totalPages} (${((build.pages / build.totalPages) * 100).toFixed(1)}%)`);
+  console.log(`  Patch size:     ${formatBytes(build.patch.length)}`);
+  console.log(`  Full database:  ${formatBytes(statSync(toPath).size)}`);
+  console.log(`  Chain length:   ${manifest.deltas.length}`);
+  console.log(`  Compare time:   ${elapsed} ms`);
+  console.log();
+  console.log(`${GREEN}Wrote ${build.from.slice(0, 12)} -> ${build.to.slice(0, 12)} to ${outDir}${RESET}`);
+}
+
+main().catch((error) => {
+  console.error(`${RED}${error instanceof Error ? error.message : error}${RESET}`);
+  process.exit(1);
+});
@@ -0,0 +1,175 @@
+/**
+ * Hot-WMI Index Builder
+ *
+ * Compiles WMI info, schemas, patterns and resolved lookups for the most
+ * requested WMIs into an ES module that can be bundled with a Cloudflare
+ * Worker. Decodes for those WMIs then run entirely in-isolate, and only the
+ * tail goes to D1.
+ *
+ * WMIs are ranked by a sample of real traffic when --traffic is given
+ * (one VIN per line, or CSV with the VIN in the first column), otherwise
+ * by how many schemas the WMI has.
+ *
+ * Usage:
+ *   npx tsx scripts/build-hot-index.ts --top 50 --out src/corgi-hot-index.js
+ *   npx tsx scripts/build-hot-index.ts --traffic vins.csv --max-bytes 2000000
+ *   npx tsx scripts/build-hot-index.ts --db path/to/db.db
+ */
+
+import { readFileSync, writeFileSync, existsSync, statSync } from "fs";
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import { gzipSync } from "zlib";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { compileHotIndex, measureHotIndex } from "../lib/db/hot-index-builder";
+import { extractWMI } from "../lib/decode";
+import type { HotIndexData } from "../lib/db/hot-index";
+
+// ESM-compatible __dirname
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// ANSI colors
+const RED = "\x1b[31m";
+const GREEN = "\x1b[32m";
+const YELLOW = "\x1b[33m";
+const RESET = "\x1b[0m";
+const BOLD = "\x1b[1m";
+
+// Cloudflare Workers compressed script size limits
+const WORKER_LIMIT_FREE = 3 * 1024 * 1024;
+const WORKER_LIMIT_PAID = 10 * 1024 * 1024;
+
+// ============================================================================
+// Ranking
+// ============================================================================
+
+function rankFromTraffic(path: string): string[] {
+  const counts = new Map<string, number>();
+  for (const line of readFileSync(path, "utf-8").split(/\r?\n/)) {
+    const vin = line.split(",")[0].trim().toUpperCase();
+    if (vin.length !== 17) continue;
+    const wmi = extractWMI(vin);
+    counts.set(wmi, (counts.get(wmi) ?? 0) + 1);
+  }
+  return [...counts.entries()].sort((a, b) => b[1] - a[1]).map(([wmi]) => wmi);
+}
+
+async function rankBySchemaCount(adapter: NodeDatabaseAdapter, limit: number): Promise<string[]> {
+  const [result] = await adapter.exec(
+    `
+    SELECT w.Wmi, COUNT(*) as schemaCount
+    FROM Wmi w
+    JOIN Wmi_VinSchema wvs ON wvs.WmiId = w.Id
+    GROUP BY w.Wmi
+    ORDER BY schemaCount DESC, w.Wmi
+    LIMIT ?
+  `,
+    [limit]
+  );
+  return result.values.map((row) => String(row[0]));
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+function renderModule(data: HotIndexData): string {
+  return [
+    "// Generated by scripts/build-hot-index.ts - do not edit",
+    "/** @type {import('@cardog/corgi/d1-adapter').HotIndexData} */",
+    `export default ${JSON.stringify(data)};`,
+    "",
+  ].join("\n");
+}
+
+function formatBytes(bytes: number): string {
+  return bytes >= 1024 * 1024
+    ? `${(bytes / 1024 / 1024).toFixed(2)} MB`
+    : `${(bytes / 1024).toFixed(1)} KB`;
+}
+
+function printReport(data: HotIndexData, source: string, maxBytes: number) {
+  const sizes = measureHotIndex(data);
+  const compressed = gzipSync(source, { level: 9 }).length;
+  const patternRows = Object.values(data.schemas).reduce((n, rows) => n + rows.length, 0);
+  const lookupValues = Object.values(data.lookups).reduce((n, t) => n + Object.keys(t).length, 0);
+
+  console.log(`${BOLD}Contents${RESET}`);
+  console.log(`  WMIs:          ${Object.keys(data.wmis).length}`);
+  console.log(`  Schemas:       ${Object.keys(data.schemas).length}`);
+  console.log(`  Pattern rows:  ${patternRows}`);
+  console.log(`  Elements:      ${data.elements.length}`);
+  console.log(`  Lookup values: ${lookupValues} in ${Object.keys(data.lookups).length} tables`);
+  console.log();
+  console.log(`${BOLD}Size${RESET}`);
+  for (const section of ["wmis", "schemas", "elements", "lookups"]) {
+    console.log(`  ${section.padEnd(14)} ${formatBytes(sizes[section])}`);
+  }
+  console.log(`  ${"module".padEnd(14)} ${formatBytes(source.length)}`);
+  console.log(`  ${"gzip".padEnd(14)} ${formatBytes(compressed)}`);
+  console.log();
+
+  const budgetColor = compressed <= maxBytes ? GREEN : RED;
+  console.log(`  Budget:           ${budgetColor}${((compressed / maxBytes) * 100).toFixed(1)}%${RESET} of ${formatBytes(maxBytes)}`);
+  console.log(`  Worker (free):    ${((compressed / WORKER_LIMIT_FREE) * 100).toFixed(1)}% of ${formatBytes(WORKER_LIMIT_FREE)}`);
+  console.log(`  Worker (paid):    ${((compressed / WORKER_LIMIT_PAID) * 100).toFixed(1)}% of ${formatBytes(WORKER_LIMIT_PAID)}`);
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+function argValue(args: string[], name: string): string | undefined {
+  const index = args.indexOf(name);
+  return index !== -1 ? args[index + 1] : undefined;
+}
+
+async function main() {
+  const args = process.argv.slice(2);
+  const baseDir = join(__dirname, "..");
+  const dbPath = argValue(args, "--db") ?? join(baseDir, "db/vpic.lite.db");
+  const outPath = argValue(args, "--out") ?? join(process.cwd(), "corgi-hot-index.js");
+  const trafficPath = argValue(args, "--traffic");
+  const maxBytes = Number(argValue(args, "--max-bytes") ?? 1024 * 1024);
+  let top = Number(argValue(args, "--top") ?? 50);
+
+  console.log(`${BOLD}Hot-WMI Index Builder${RESET}`);
+  console.log(`Database: ${dbPath}`);
+  console.log();
+
+  if (!existsSync(dbPath)) {
+    console.error(`${RED}Database not found: ${dbPath}${RESET}`);
+    process.exit(1);
+  }
+
+  const adapter = new NodeDatabaseAdapter(dbPath);
+  const ranked = trafficPath ? rankFromTraffic(trafficPath) : await rankBySchemaCount(adapter, top);
+  const dbVersion = `${statSync(dbPath).size}-${statSync(dbPath).mtime.toISOString()}`;
+
+  // Shrink the WMI count until the compressed module fits the budget
+  let data: HotIndexData;
+  let source: string;
+  for (;;) {
+    data = await compileHotIndex(adapter, ranked.slice(0, top), { dbVersion });
+    source = renderModule(data);
+    const compressed = gzipSync(source, { level: 9 }).length;
+    if (compressed <= maxBytes || top <= 1) break;
+
+    const next = Math.max(1, Math.min(top - 1, Math.floor((top * maxBytes) / compressed)));
+    console.log(`${YELLOW}${top} WMIs compress to ${formatBytes(compressed)}, trying ${next}${RESET}`);
+    top = next;
+  }
+
+  await adapter.close();
+
+  writeFileSync(outPath, source);
+  printReport(data, source, maxBytes);
+  console.log();
+  console.log(`${GREEN}Wrote ${outPath}${RESET}`);
+}
+
+main().catch((error) => {
+  console.error(`${RED}${error instanceof Error ? error.message : error}${RESET}`);
+  process.exit(1);
+});
@@ -0,0 +1,106 @@
+/**
+ * VIN Plausibility Filter Builder
+ *
+ * Compiles a Bloom filter over every (WMI, model year code, VDS prefix)
+ * combination allowed by a Model pattern, and stores it in the
+ * PlausibilityFilter table. Decoders load it once for `isPlausible` instead
+ * of scanning the Pattern table at startup.
+ *
+ * Run after any change to the Pattern table (e.g. community:apply); the
+ * PlausibilityFilter table is rebuilt from scratch each time.
+ *
+ * Usage:
+ *   npx tsx scripts/build-plausibility.ts
+ *   npx tsx scripts/build-plausibility.ts --db path/to/db.db --fp-rate 0.001 --prefix 3
+ */
+
+import { existsSync } from "fs";
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import Database from "better-sqlite3";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VPICDatabase } from "../lib/db";
+import { compilePlausibilityFilter } from "../lib/db/plausibility";
+
+// ESM-compatible __dirname
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// ANSI colors
+const RED = "\x1b[31m";
+const GREEN = "\x1b[32m";
+const RESET = "\x1b[0m";
+const BOLD = "\x1b[1m";
+
+function argValue(args: string[], name: string): string | undefined {
+  const index = args.indexOf(name);
+  return index !== -1 ? args[index + 1] : undefined;
+}
+
+function formatBytes(bytes: number): string {
+  return bytes >= 1024 * 1024
+    ? `${(bytes / 1024 / 1024).toFixed(2)} MB`
+    : `${(bytes / 1024).toFixed(1)} KB`;
+}
+
+async function main() {
+  const args = process.argv.slice(2);
+  const baseDir = join(__dirname, "..");
+  const dbPath = argValue(args, "--db") ?? join(baseDir, "db/vpic.lite.db");
+  const falsePositiveRate = Number(argValue(args, "--fp-rate") ?? 0.01);
+  const prefixLength = Number(argValue(args, "--prefix") ?? 2);
+
+  console.log(`${BOLD}VIN Plausibility Filter Builder${RESET}`);
+  console.log(`Database: ${dbPath}`);
+  console.log();
+
+  if (!existsSync(dbPath)) {
+    console.error(`${RED}Database not found: ${dbPath}${RESET}`);
+    process.exit(1);
+  }
+
+  const adapter = new NodeDatabaseAdapter(dbPath);
+  const start = Date.now();
+  const rows = await new VPICDatabase(adapter).getModelPatternYearRanges();
+  const filter = compilePlausibilityFilter(rows, { falsePositiveRate, prefixLength });
+  const elapsed = Date.now() - start;
+  await adapter.close();
+
+  // Throughput on VINs made of random VIN characters, nearly all of which fail
+  const chars = "0123456789ABCDEFGHJKLMNPRSTUVWXYZ";
+  const sample = Array.from({ length: 100000 }, () =>
+    Array.from({ length: 17 }, () => chars[Math.floor(Math.random() * chars.length)]).join(""),
+  );
+  const benchStart = performance.now();
+  for (let round = 0; round < 10; round++) {
+    for (const vin of sample) filter.isPlausible(vin, { checkDigit: false });
+  }
+  const perSecond = (sample.length * 10) / ((performance.now() - benchStart) / 1000);
+
+  const stats = filter.getStats();
+  const data = filter.serialize();
+
+  const writer = new Database(dbPath);
+  writer.transaction(() => {
+    writer.exec("DROP TABLE IF EXISTS PlausibilityFilter");
+    writer.exec("CREATE TABLE PlausibilityFilter (Id INTEGER PRIMARY KEY, Data BLOB NOT NULL)");
+    writer.prepare("INSERT INTO PlausibilityFilter (Id, Data) VALUES (1, ?)").run(Buffer.from(data));
+  })();
+  writer.close();
+
+  console.log(`${BOLD}Contents${RESET}`);
+  console.log(`  Model patterns:   ${rows.length}`);
+  console.log(`  Keys:             ${stats.keys}`);
+  console.log(`  Hash functions:   ${stats.hashes}`);
+  console.log(`  False positives:  ${(stats.falsePositiveRate * 100).toFixed(3)}%`);
+  console.log(`  Table size:       ${formatBytes(data.length)}`);
+  console.log(`  Build time:       ${elapsed} ms`);
+  console.log(`  Checks/second:    ${(perSecond / 1e6).toFixed(1)}M (one core, no check digit)`);
+  console.log();
+  console.log(`${GREEN}Wrote PlausibilityFilter to ${dbPath}${RESET}`);
+}
+
+main().catch((error) => {
+  console.error(`${RED}${error instanceof Error ? error.message : error}${RESET}`);
+  process.exit(1);
+});
@@ -0,0 +1,103 @@
+/**
+ * VDS Equivalence Class Builder
+ *
+ * Partitions the VDS character space of each schema into equivalence classes
+ * (VDS strings that match the same patterns with the same confidence) and
+ * stores one compact class table per schema in the VdsClass table. Decodes
+ * for covered schemas then resolve a VIN's patterns with six table lookups
+ * instead of scoring every pattern.
+ *
+ * Run after any change to the Pattern table (e.g. community:apply); the
+ * VdsClass table is rebuilt from scratch each time.
+ *
+ * Usage:
+ *   npx tsx scripts/build-vds-classes.ts
+ *   npx tsx scripts/build-vds-classes.ts --db path/to/db.db --max-states 5000
+ */
+
+import { existsSync } from "fs";
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import Database from "better-sqlite3";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { compileVdsClassTables } from "../lib/db/vds-class-builder";
+
+// ESM-compatible __dirname
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// ANSI colors
+const RED = "\x1b[31m";
+const GREEN = "\x1b[32m";
+const YELLOW = "\x1b[33m";
+const RESET = "\x1b[0m";
+const BOLD = "\x1b[1m";
+
+function argValue(args: string[], name: string): string | undefined {
+  const index = args.indexOf(name);
+  return index !== -1 ? args[index + 1] : undefined;
+}
+
+function formatBytes(bytes: number): string {
+  return bytes >= 1024 * 1024
+    ? `${(bytes / 1024 / 1024).toFixed(2)} MB`
+    : `${(bytes / 1024).toFixed(1)} KB`;
+}
+
+async function main() {
+  const args = process.argv.slice(2);
+  const baseDir = join(__dirname, "..");
+  const dbPath = argValue(args, "--db") ?? join(baseDir, "db/vpic.lite.db");
+  const maxStates = Number(argValue(args, "--max-states") ?? 10000);
+
+  console.log(`${BOLD}VDS Equivalence Class Builder${RESET}`);
+  console.log(`Database: ${dbPath}`);
+  console.log();
+
+  if (!existsSync(dbPath)) {
+    console.error(`${RED}Database not found: ${dbPath}${RESET}`);
+    process.exit(1);
+  }
+
+  // Compile every schema against a read-only connection first
+  const adapter = new NodeDatabaseAdapter(dbPath);
+  const { tables, skippedLong, skippedLarge } = await compileVdsClassTables(adapter, { maxStates });
+  const [schemaResult] = await adapter.exec("SELECT COUNT(*) FROM VinSchema");
+  const schemaCount = Number(schemaResult.values[0][0]);
+  await adapter.close();
+
+  const classCount = [...tables.values()].reduce((n, table) => n + table.classes.length, 0);
+
+  // Replace the VdsClass table in one transaction
+  const writer = new Database(dbPath);
+  let bytes = 0;
+  writer.transaction(() => {
+    writer.exec("DROP TABLE IF EXISTS VdsClass");
+    writer.exec("CREATE TABLE VdsClass (VinSchemaId INTEGER PRIMARY KEY, Data TEXT NOT NULL)");
+    const insert = writer.prepare("INSERT INTO VdsClass (VinSchemaId, Data) VALUES (?, ?)");
+    for (const [schemaId, table] of tables) {
+      const data = JSON.stringify(table);
+      bytes += data.length;
+      insert.run(schemaId, data);
+    }
+  })();
+  writer.close();
+
+  console.log(`${BOLD}Contents${RESET}`);
+  console.log(`  Schemas:        ${tables.size} of ${schemaCount}`);
+  console.log(`  Classes:        ${classCount}`);
+  console.log(`  Table size:     ${formatBytes(bytes)}`);
+  if (skippedLong.length > 0) {
+    console.log(`  ${YELLOW}Skipped ${skippedLong.length} schemas with patterns reading past the VDS${RESET}`);
+  }
+  if (skippedLarge.length > 0) {
+    console.log(`  ${YELLOW}Skipped ${skippedLarge.length} schemas over ${maxStates} states${RESET}`);
+  }
+  console.log();
+  console.log(`${GREEN}Wrote VdsClass to ${dbPath}${RESET}`);
+}
+
+main().catch((error) => {
+  console.error(`${RED}${error instanceof Error ? error.message : error}${RESET}`);
+  process.exit(1);
+});
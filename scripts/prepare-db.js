@@ -11,6 +11,7 @@ import zlib from 'zlib';
 import { pipeline } from 'stream/promises';
 import { createReadStream, createWriteStream, mkdirSync } from 'fs';
 import { fileURLToPath } from 'url';
+import Database from 'better-sqlite3';
 
 // Get __dirname equivalent in ESM
 const __dirname = fileURLToPath(new URL('.', import.meta.url));
@@ -20,6 +21,56 @@ const DB_PATH = path.join(__dirname, '..', 'db', 'vpic.lite.db');
 const DIST_DIR = path.join(__dirname, '..', 'dist', 'db');
 const DIST_DB_PATH = path.join(DIST_DIR, 'vpic.lite.db.gz');
 
+/**
+ * Report the make / model / year catalog built by scripts/build-catalog.ts
+ */
+function reportCatalog() {
+  const db = new Database(DB_PATH, { readonly: true });
+  try {
+    const table = db.prepare("SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'Catalog'").get();
+    if (!table) {
+      console.log('Catalog: not built (run `pnpm catalog`)');
+      return;
+    }
+    const { Data } = db.prepare('SELECT Data FROM Catalog ORDER BY Id DESC LIMIT 1').get();
+    const catalog = JSON.parse(Data);
+    console.log(
+      `Catalog: ${catalog.makes.length} makes, ${catalog.models.length} models, ` +
+        `${catalog.entries.length / 4} year ranges (${(Data.length / 1024).toFixed(1)} KB)`
+    );
+  } finally {
+    db.close();
+  }
+}
+
+/**
+ * Report the VIN plausibility filter built by scripts/build-plausibility.ts
+ */
+function reportPlausibilityFilter() {
+  const db = new Database(DB_PATH, { readonly: true });
+  try {
+    const table = db
+      .prepare("SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'PlausibilityFilter'")
+      .get();
+    if (!table) {
+      console.log('Plausibility filter: not built (run `pnpm plausibility`)');
+      return;
+    }
+    const { Data } = db.prepare('SELECT Data FROM PlausibilityFilter ORDER BY Id DESC LIMIT 1').get();
+    // Header: version, log2 of bit count, hash count, VDS prefix length, key count (u32 LE)
+    const keys = Data.readUInt32LE(16);
+    const hashes = Data.readUInt32LE(8);
+    const bits = 2 ** Data.readUInt32LE(4);
+    const falsePositiveRate = (1 - Math.exp((-hashes * keys) / bits)) ** hashes;
+    console.log(
+      `Plausibility filter: ${keys} keys, ${(falsePositiveRate * 100).toFixed(3)}% false positives ` +
+        `(${(Data.length / 1024).toFixed(1)} KB)`
+    );
+  } finally {
+    db.close();
+  }
+}
+
 async function main() {
   console.log('Preparing database for distribution...');
 
@@ -55,6 +106,9 @@ async function main() {
     console.log(`Compressed size: ${(destSize / 1024 / 1024).toFixed(2)} MB`);
     console.log(`Compression ratio: ${compressionRatio}%`);
 
+    reportCatalog();
+    reportPlausibilityFilter();
+
     console.log('Database preparation complete!');
   } catch (error) {
     console.error('Error preparing database:', error);
@@ -0,0 +1,140 @@
+/**
+ * Query Replay Benchmark
+ *
+ * Records the queries a VIN sample issues against the local database, then
+ * replays them with D1-like latency to compare decode paths offline:
+ * one-at-a-time decode, batch decode without prefetch, and batch decode with
+ * lookahead prefetch. Every pass starts from a cold decoder.
+ *
+ * Latency is a fixed number of milliseconds, `uniform:MIN:MAX`,
+ * `normal:MEAN:STDDEV`, `lognormal:MEDIAN:SIGMA` or `recorded[:SCALE]`.
+ *
+ * Usage:
+ *   npx tsx scripts/replay-bench.ts --record queries.json --vins vins.txt
+ *   npx tsx scripts/replay-bench.ts --replay queries.json --vins vins.txt --latency lognormal:15:0.5 --concurrency 6
+ */
+
+import { existsSync, readFileSync } from "fs";
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { RecordingDatabaseAdapter, ReplayDatabaseAdapter } from "../lib/db/replay-adapter";
+import type { LatencyModel, ReplayAdapterOptions } from "../lib/db/replay-adapter";
+import { VINDecoder } from "../lib/decode";
+
+// ESM-compatible __dirname
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// ANSI colors
+const RED = "\x1b[31m";
+const GREEN = "\x1b[32m";
+const RESET = "\x1b[0m";
+const BOLD = "\x1b[1m";
+
+function argValue(args: string[], name: string): string | undefined {
+  const index = args.indexOf(name);
+  return index !== -1 ? args[index + 1] : undefined;
+}
+
+function parseLatency(spec: string): LatencyModel {
+  const [type, a, b] = spec.split(":");
+  switch (type) {
+    case "uniform":
+      return { type, min: Number(a), max: Number(b) };
+    case "normal":
+      return { type, mean: Number(a), stddev: Number(b) };
+    case "lognormal":
+      return { type, median: Number(a), sigma: Number(b) };
+    case "recorded":
+      return { type, scale: a !== undefined ? Number(a) : 1 };
+    default:
+      if (Number.isNaN(Number(type))) {
+        throw new Error(`Unknown latency model: ${spec}`);
+      }
+      return Number(type);
+  }
+}
+
+function readVins(path: string): string[] {
+  return readFileSync(path, "utf-8")
+    .split(/\r?\n/)
+    .map((line) => line.split(",")[0].trim())
+    .filter((vin) => vin.length > 0);
+}
+
+async function record(dbPath: string, vins: string[], outPath: string): Promise<void> {
+  const adapter = new RecordingDatabaseAdapter(new NodeDatabaseAdapter(dbPath));
+  await new VINDecoder(adapter).decodeBatch(vins);
+  await adapter.save(outPath);
+  await adapter.close();
+
+  const recording = adapter.getRecording();
+  const latency = recording.entries.reduce((sum, entry) => sum + entry.latency, 0);
+  console.log(`${GREEN}Recorded ${recording.entries.length} queries (${latency.toFixed(1)} ms) to ${outPath}${RESET}`);
+}
+
+async function replay(recordingPath: string, vins: string[], options: ReplayAdapterOptions): Promise<void> {
+  const passes: Array<[string, (decoder: VINDecoder) => Promise<unknown>]> = [
+    [
+      "decode",
+      async (decoder) => {
+        for (const vin of vins) await decoder.decode(vin);
+      },
+    ],
+    ["batch", (decoder) => decoder.decodeBatch(vins, { lookahead: 0 })],
+    ["batch + prefetch", (decoder) => decoder.decodeBatch(vins, { lookahead: 16 })],
+  ];
+
+  console.log(`${BOLD}${"Pass".padEnd(18)}${"Time".padStart(10)}${"VIN/s".padStart(10)}${"Queries".padStart(10)}${"Misses".padStart(8)}${"Max in flight".padStart(15)}${RESET}`);
+  for (const [name, run] of passes) {
+    const adapter = await ReplayDatabaseAdapter.load(recordingPath, options);
+    const start = performance.now();
+    await run(new VINDecoder(adapter));
+    const elapsed = performance.now() - start;
+    const stats = adapter.getStats();
+    console.log(
+      `${name.padEnd(18)}${`${elapsed.toFixed(0)} ms`.padStart(10)}${(vins.length / (elapsed / 1000)).toFixed(0).padStart(10)}` +
+        `${String(stats.queries).padStart(10)}${String(stats.misses).padStart(8)}${String(stats.maxInFlight).padStart(15)}`,
+    );
+  }
+}
+
+async function main() {
+  const args = process.argv.slice(2);
+  const baseDir = join(__dirname, "..");
+  const dbPath = argValue(args, "--db") ?? join(baseDir, "db/vpic.lite.db");
+  const vinsPath = argValue(args, "--vins");
+  const recordPath = argValue(args, "--record");
+  const replayPath = argValue(args, "--replay");
+
+  console.log(`${BOLD}Query Replay Benchmark${RESET}`);
+  console.log();
+
+  if (!vinsPath || !existsSync(vinsPath) || (!recordPath && !replayPath)) {
+    console.error(`${RED}--vins and one of --record or --replay are required${RESET}`);
+    process.exit(1);
+  }
+  const vins = readVins(vinsPath);
+
+  if (recordPath) {
+    if (!existsSync(dbPath)) {
+      console.error(`${RED}Database not found: ${dbPath}${RESET}`);
+      process.exit(1);
+    }
+    await record(dbPath, vins, recordPath);
+    return;
+  }
+
+  const concurrency = argValue(args, "--concurrency");
+  await replay(replayPath!, vins, {
+    latency: parseLatency(argValue(args, "--latency") ?? "10"),
+    concurrency: concurrency !== undefined ? Number(concurrency) : undefined,
+    seed: Number(argValue(args, "--seed") ?? 1),
+  });
+}
+
+main().catch((error) => {
+  console.error(`${RED}${error instanceof Error ? error.message : error}${RESET}`);
+  process.exit(1);
+});
@@ -0,0 +1,50 @@
+import { describe, it, expect } from "vitest";
+import { affinityKey, pickByAffinity, rankByAffinity } from "../lib/affinity";
+
+const NODES = ["node-a", "node-b", "node-c", "node-d"];
+const WMIS = Array.from({ length: 400 }, (_, i) => {
+  const chars = "0123456789ABCDEFGHJKLMNPRSTUVWXYZ";
+  return chars[i % 33] + chars[Math.floor(i / 33) % 33] + chars[(i * 7) % 33];
+});
+
+describe("Affinity routing", () => {
+  it("should key VINs by WMI or WMI and model year", () => {
+    expect(affinityKey("km8k2cab4pu001140")).toBe("KM8");
+    expect(affinityKey("KM8K2CAB4PU001140", "wmi-year")).toBe("KM8:P");
+  });
+
+  it("should rank nodes deterministically regardless of input order", () => {
+    const ranked = rankByAffinity("KM8", NODES);
+    expect(ranked).toHaveLength(NODES.length);
+    expect(rankByAffinity("KM8", [...NODES].reverse())).toEqual(ranked);
+  });
+
+  it("should spread keys across nodes", () => {
+    const owners = new Map<string, number>();
+    for (const wmi of WMIS) {
+      const owner = rankByAffinity(wmi, NODES)[0];
+      owners.set(owner, (owners.get(owner) ?? 0) + 1);
+    }
+    for (const node of NODES) {
+      expect(owners.get(node)).toBeGreaterThan(WMIS.length / NODES.length / 2);
+    }
+  });
+
+  it("should only move keys owned by a removed node", () => {
+    const remaining = NODES.filter((node) => node !== "node-c");
+    for (const wmi of WMIS) {
+      const before = rankByAffinity(wmi, NODES)[0];
+      const after = rankByAffinity(wmi, remaining)[0];
+      if (before !== "node-c") {
+        expect(after).toBe(before);
+      }
+    }
+  });
+
+  it("should spill to the next preferred node when the owner is hot", () => {
+    const [owner, second] = rankByAffinity("5N1", NODES);
+    expect(pickByAffinity("5N1", NODES)).toEqual({ node: owner, rank: 0 });
+    expect(pickByAffinity("5N1", NODES, (node) => node !== owner)).toEqual({ node: second, rank: 1 });
+    expect(pickByAffinity("5N1", NODES, () => false)).toBeUndefined();
+  });
+});
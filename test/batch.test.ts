@@ -0,0 +1,108 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import type { BatchLocalityStats } from "../lib/types";
+import { comparable, CountingAdapter } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = [
+  "KM8K2CAB4PU001140",
+  "5N1AT2MT9LC784186",
+  "2FTEF14H8TCA73155",
+  "INVALID",
+  "KM8K2CAB4PU001140",
+];
+
+describe("Batch decode", () => {
+  it("should return the same results as one-at-a-time decoding, in order", async () => {
+    const sequential = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const expected = [];
+    for (const vin of VINS) {
+      expected.push(comparable(await sequential.decode(vin)));
+    }
+
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const results = await decoder.decodeBatch(VINS, { lookahead: 4 });
+
+    expect(results.map(comparable)).toEqual(expected);
+  });
+
+  it("should overlap I/O for upcoming VINs without duplicating queries", async () => {
+    const serial = new CountingAdapter(new NodeDatabaseAdapter(TEST_DB_PATH), 5);
+    await new VINDecoder(serial).decodeBatch(VINS, { lookahead: 0 });
+    expect(serial.maxActive).toBe(1);
+
+    const prefetching = new CountingAdapter(new NodeDatabaseAdapter(TEST_DB_PATH), 5);
+    await new VINDecoder(prefetching).decodeBatch(VINS, { lookahead: 4 });
+    expect(prefetching.maxActive).toBeGreaterThan(1);
+    expect(prefetching.queries).toBe(serial.queries);
+  });
+
+  it("should accept async iterables", async () => {
+    async function* source() {
+      yield "KM8K2CAB4PU001140";
+      yield "5N1AT2MT9LC784186";
+    }
+
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const makes = [];
+    for await (const result of decoder.decodeStream(source())) {
+      makes.push(result.components.vehicle?.make);
+    }
+
+    expect(makes).toEqual(["Hyundai", "Nissan"]);
+  });
+
+  it("should decode a reordered window grouped by pattern set and return input order", async () => {
+    // A dealer feed interleaving makes
+    const interleaved = Array.from({ length: 4 }, () => [
+      "KM8K2CAB4PU001140",
+      "5N1AT2MT9LC784186",
+      "1FTEW1EG5JFA00000",
+      "KM8K2CAB4PU001141",
+      "5N1AT2MT9LC784187",
+    ]).flat();
+
+    const reference = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const expected = (await reference.decodeBatch(interleaved)).map(comparable);
+
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const stats: BatchLocalityStats = { decoded: 0, hits: 0, inputOrderHits: 0, cacheHits: 0, cacheMisses: 0 };
+    const results = [];
+    for await (const result of decoder.decodeStream(interleaved, { reorderWindow: 8 }, stats)) {
+      results.push(comparable(result));
+    }
+
+    expect(results).toEqual(expected);
+    expect(stats.decoded).toBe(interleaved.length);
+    expect(stats.inputOrderHits).toBe(0);
+    // Windows of 8, 8 and 4 VINs hold 3, 3 and 3 groups
+    expect(stats.hits).toBe(interleaved.length - 9);
+  });
+
+  it("should count pattern set cache hits and misses", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const stats: BatchLocalityStats = { decoded: 0, hits: 0, inputOrderHits: 0, cacheHits: 0, cacheMisses: 0 };
+    const vins = [VINS[0], VINS[0], VINS[0]];
+    for await (const _ of decoder.decodeStream(vins, { lookahead: 0 }, stats)) {
+      // drain
+    }
+
+    // The first decode reads the pattern set, the rest find it in the query cache
+    expect(stats.cacheMisses).toBe(1);
+    expect(stats.cacheHits).toBe(2);
+  });
+
+  it("should count locality in input order when not reordering", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const stats: BatchLocalityStats = { decoded: 0, hits: 0, inputOrderHits: 0, cacheHits: 0, cacheMisses: 0 };
+    for await (const _ of decoder.decodeStream(VINS, {}, stats)) {
+      // drain
+    }
+
+    expect(stats).toMatchObject({ decoded: VINS.length, hits: 0, inputOrderHits: 0 });
+    expect(stats.cacheHits + stats.cacheMisses).toBeGreaterThan(0);
+  });
+});
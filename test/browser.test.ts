@@ -3,6 +3,7 @@ import {
   BrowserDatabaseAdapterFactory 
 } from '../lib/db/browser-adapter';
 import { describe, it, expect, vi, beforeAll, afterEach } from 'vitest';
+import { gzipSync } from 'zlib';
 
 describe('Browser Adapter', () => {
   // Mock the browser SQL.js environment
@@ -120,4 +121,91 @@ describe('Browser Adapter', () => {
         .rejects.toThrow('Failed to load database: Not Found');
     });
   });
+  describe('Cold-start pipeline', () => {
+    const sqlite = new Uint8Array(200000).map((_, i) => i % 251);
+
+    const streamingResponse = (body: Uint8Array) =>
+      new Response(new Blob([body]).stream(), {
+        headers: { 'content-length': String(body.length) },
+      });
+
+    it('should decompress a gzip database while streaming and report progress', async () => {
+      const compressed = gzipSync(sqlite);
+      (global.fetch as any).mockImplementation(() => Promise.resolve(streamingResponse(compressed)));
+      const DatabaseSpy = vi.fn().mockReturnValue(mockDB);
+      (global.window as any).SQL = { Database: DatabaseSpy };
+
+      const progress: any[] = [];
+      const factory = new BrowserDatabaseAdapterFactory({ onProgress: p => progress.push(p) });
+      await factory.createAdapter('vpic.lite.db.gz');
+
+      const loaded = DatabaseSpy.mock.calls[0][0] as Uint8Array;
+      expect(loaded).toEqual(sqlite);
+
+      const last = progress[progress.length - 1];
+      expect(last.loaded).toBe(compressed.length);
+      expect(last.total).toBe(compressed.length);
+      expect(last.decompressed).toBe(sqlite.length);
+      expect(progress.some(p => p.wasmReady)).toBe(true);
+
+      (global.window as any).SQL = new MockSqlJs();
+    });
+
+    it('should report progress separately for concurrent loads on one factory', async () => {
+      const small = sqlite.subarray(0, 50000);
+      (global.fetch as any).mockImplementation((url: string) =>
+        Promise.resolve(streamingResponse(url === 'small.db' ? small : sqlite)),
+      );
+      (global.window as any).SQL = { Database: vi.fn().mockReturnValue(mockDB) };
+
+      const progress: any[] = [];
+      const factory = new BrowserDatabaseAdapterFactory({ onProgress: p => progress.push(p) });
+      await Promise.all([factory.createAdapter('small.db'), factory.createAdapter('large.db')]);
+
+      for (const p of progress) {
+        if (p.total !== undefined) expect(p.loaded).toBeLessThanOrEqual(p.total);
+      }
+      expect(progress.some(p => p.loaded === small.length && p.total === small.length)).toBe(true);
+      expect(progress.some(p => p.loaded === sqlite.length && p.total === sqlite.length)).toBe(true);
+
+      (global.window as any).SQL = new MockSqlJs();
+    });
+
+    it('should pass uncompressed databases through unchanged', async () => {
+      (global.fetch as any).mockImplementation(() => Promise.resolve(streamingResponse(sqlite)));
+      const DatabaseSpy = vi.fn().mockReturnValue(mockDB);
+      (global.window as any).SQL = { Database: DatabaseSpy };
+
+      const factory = new BrowserDatabaseAdapterFactory({ uncompressedSize: sqlite.length });
+      await factory.createAdapter('vpic.lite.db');
+
+      expect(DatabaseSpy.mock.calls[0][0]).toEqual(sqlite);
+
+      (global.window as any).SQL = new MockSqlJs();
+    });
+
+    it('should reject instead of hanging when the WASM module cannot be loaded', async () => {
+      (global.fetch as any).mockImplementation((url: string) =>
+        Promise.resolve(
+          url.endsWith('.wasm')
+            ? { ok: false, status: 404, statusText: 'Not Found' }
+            : streamingResponse(sqlite),
+        ),
+      );
+      const streaming = vi.spyOn(WebAssembly, 'instantiateStreaming').mockRejectedValue(new Error('Bad MIME type'));
+      const { SQL, initSqlJs } = global.window as any;
+      delete (global.window as any).SQL;
+      // Like sql.js: initSqlJs only settles once instantiateWasm hands over the instance
+      (global.window as any).initSqlJs = (config: any) => {
+        config.instantiateWasm({}, () => undefined);
+        return new Promise(() => undefined);
+      };
+
+      const factory = new BrowserDatabaseAdapterFactory({ uncompressedSize: sqlite.length });
+      await expect(factory.createAdapter('vpic.lite.db')).rejects.toThrow('Failed to load /sql-wasm.wasm: 404');
+
+      streaming.mockRestore();
+      Object.assign(global.window as any, { SQL, initSqlJs });
+    });
+  });
 });
\ No newline at end of file
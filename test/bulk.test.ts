@@ -0,0 +1,87 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { existsSync, mkdtempSync, readFileSync, writeFileSync } from "fs";
+import { tmpdir } from "os";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { bulkDecode, planShards } from "../lib/bulk";
+import type { BulkDecoder } from "../lib/bulk";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = [
+  "KM8K2CAB4PU001140",
+  "5N1AT2MT9LC784186",
+  "2FTEF14H8TCA73155",
+  "INVALID",
+  "1HGCM82633A123456",
+  "KM8K2CAB4PU001140",
+  "5N1AT2MT9LC784186",
+];
+
+describe("Bulk decode", () => {
+  let dir: string;
+  let inputPath: string;
+  let decoder: VINDecoder;
+
+  beforeAll(() => {
+    dir = mkdtempSync(path.join(tmpdir(), "corgi-bulk-"));
+    inputPath = path.join(dir, "vins.csv");
+    // Mixed line endings and a CSV column to check line alignment
+    writeFileSync(inputPath, VINS.map((vin, i) => (i % 2 ? `${vin},x\r\n` : `${vin}\n`)).join(""));
+    decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+  });
+
+  it("should split the file into shards on line boundaries", async () => {
+    const shards = await planShards(inputPath, 25);
+    const text = readFileSync(inputPath, "utf-8");
+
+    expect(shards.length).toBeGreaterThan(1);
+    expect(shards[0].start).toBe(0);
+    expect(shards[shards.length - 1].end).toBe(text.length);
+    for (let i = 1; i < shards.length; i++) {
+      expect(shards[i].start).toBe(shards[i - 1].end);
+      expect(text[shards[i].start - 1]).toBe("\n");
+    }
+  });
+
+  it("should write results in input order", async () => {
+    const outputPath = path.join(dir, "ordered.jsonl");
+    const summary = await bulkDecode(inputPath, outputPath, { workers: 0, decoder, shardSize: 25 });
+
+    const results = readFileSync(outputPath, "utf-8").trim().split("\n").map((line) => JSON.parse(line));
+    expect(results.map((r) => r.vin)).toEqual(VINS);
+    expect(results[0].components.vehicle.model).toBe("Kona");
+    expect(summary).toMatchObject({ resumed: 0, lines: VINS.length });
+    expect(existsSync(`${outputPath}.manifest.json`)).toBe(false);
+  });
+
+  it("should resume an interrupted job from the last completed shard", async () => {
+    const outputPath = path.join(dir, "resumed.jsonl");
+    let decoded = 0;
+    const failing: BulkDecoder = {
+      async *decodeStream(vins, options) {
+        for await (const result of decoder.decodeStream(vins, options)) {
+          if (result.vin === "1HGCM82633A123456") throw new Error("interrupted");
+          decoded++;
+          yield result;
+        }
+      },
+    };
+
+    await expect(bulkDecode(inputPath, outputPath, { workers: 0, decoder: failing, shardSize: 25 })).rejects.toThrow(
+      "interrupted"
+    );
+    const manifest = JSON.parse(readFileSync(`${outputPath}.manifest.json`, "utf-8"));
+    const done = manifest.shards.filter((s: any) => s.done).length;
+    expect(done).toBeGreaterThan(0);
+
+    const summary = await bulkDecode(inputPath, outputPath, { workers: 0, decoder, shardSize: 25 });
+    expect(summary.resumed).toBe(done);
+    expect(summary.lines).toBe(VINS.length);
+
+    const vins = readFileSync(outputPath, "utf-8").trim().split("\n").map((line) => JSON.parse(line).vin);
+    expect(vins).toEqual(VINS);
+    expect(decoded).toBeGreaterThan(0);
+  });
+});
@@ -0,0 +1,49 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VPICDatabase } from "../lib/db";
+import { VehicleCatalog, compileCatalog } from "../lib/db/catalog";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+describe("Vehicle catalog", () => {
+  let catalog: VehicleCatalog;
+
+  beforeAll(async () => {
+    catalog = await VehicleCatalog.load(new NodeDatabaseAdapter(TEST_DB_PATH));
+  });
+
+  it("should list makes with models in a year", () => {
+    expect(catalog.listMakes(2020).map((m) => m.name)).toEqual(["FORD", "HYUNDAI", "NISSAN"]);
+    expect(catalog.listMakes(2000).map((m) => m.name)).toEqual(["FORD"]);
+    expect(catalog.listMakes(1970)).toEqual([]);
+  });
+
+  it("should list a make's models by name or id", () => {
+    expect(catalog.listModels("ford", 2010).map((m) => m.name)).toEqual(["F-150", "F-250", "Mustang"]);
+    expect(catalog.listModels("FORD", 2020).map((m) => m.name)).toEqual(["F-150", "Mustang"]);
+    const [hyundai] = catalog.listMakes(2020).filter((m) => m.name === "HYUNDAI");
+    expect(catalog.listModels(hyundai.id).map((m) => m.name)).toEqual(["Kona", "Tucson"]);
+    expect(catalog.listModels("Unknown")).toEqual([]);
+  });
+
+  it("should merge year ranges across schemas", () => {
+    // F-150 patterns span 1997-2014 and 2015- schemas
+    const years = catalog.listYears("Ford", "f-150");
+    expect(years[0]).toBe(1997);
+    expect(years).toContain(2014);
+    expect(years).toContain(2015);
+    expect(years[years.length - 1]).toBe(catalog.getStats().openYear);
+    expect(catalog.listYears("Nissan", "Rogue")).toEqual([2014, 2015, 2016, 2017, 2018, 2019, 2020, 2021, 2022]);
+  });
+
+  it("should serve identical answers from stored data", async () => {
+    const rows = await new VPICDatabase(new NodeDatabaseAdapter(TEST_DB_PATH)).getModelYearRanges();
+    const data = compileCatalog(rows);
+    expect(data.entries.length % 4).toBe(0);
+
+    const restored = new VehicleCatalog(JSON.parse(JSON.stringify(data)));
+    expect(restored.listModels("Ford", 2010)).toEqual(catalog.listModels("Ford", 2010));
+    expect(restored.getStats()).toEqual(catalog.getStats());
+  });
+});
@@ -0,0 +1,94 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { copyFileSync, mkdtempSync, readdirSync, readFileSync, statSync } from "fs";
+import { tmpdir } from "os";
+import Database from "better-sqlite3";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VPICDatabase } from "../lib/db";
+import { applyDeltas, createDelta, getDatabaseHash, planDeltaChain, publishDelta } from "../lib/db/delta";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+// Copy a database and change a few rows, as a release would
+function release(dir: string, from: string, name: string, sql: string): string {
+  const to = path.join(dir, name);
+  copyFileSync(from, to);
+  const db = new Database(to);
+  db.exec(sql);
+  db.close();
+  return to;
+}
+
+describe("Database deltas", () => {
+  let dir: string;
+  let deltas: string;
+  let v1: string;
+  let v2: string;
+  let v3: string;
+
+  beforeAll(async () => {
+    dir = mkdtempSync(path.join(tmpdir(), "corgi-delta-"));
+    deltas = path.join(dir, "deltas");
+    v1 = path.join(dir, "v1.db");
+    copyFileSync(TEST_DB_PATH, v1);
+    v2 = release(dir, v1, "v2.db", "UPDATE Make SET Name = 'NISSAN MOTOR' WHERE Name = 'NISSAN'");
+    v3 = release(dir, v2, "v3.db", "INSERT INTO Model (Id, Name) VALUES (40, 'Bronco')");
+
+    await publishDelta(deltas, await createDelta(v1, v2));
+    await publishDelta(deltas, await createDelta(v2, v3));
+  });
+
+  it("should store only the pages that changed", async () => {
+    const build = await createDelta(v1, v2);
+    expect(build.pages).toBeGreaterThan(0);
+    expect(build.pages).toBeLessThan(build.totalPages);
+    expect(build.patch.length).toBeLessThan(statSync(v2).size / 2);
+  });
+
+  it("should apply a chain of deltas to reach the latest version", async () => {
+    const cached = path.join(dir, "cached.db");
+    copyFileSync(v1, cached);
+
+    const result = await applyDeltas(cached, deltas, { verify: true });
+    expect(result.applied).toBe(2);
+    expect(readFileSync(cached).equals(readFileSync(v3))).toBe(true);
+    expect(result.version).toBe(await getDatabaseHash(v3));
+    expect(readdirSync(dir).filter((name) => name.startsWith("cached.db."))).toEqual(["cached.db.sha256"]);
+
+    const adapter = new NodeDatabaseAdapter(cached);
+    const wmi = await new VPICDatabase(adapter).getWMI("5N1");
+    expect(wmi?.make).toBe("NISSAN MOTOR");
+    await adapter.close();
+
+    expect((await applyDeltas(cached, deltas)).applied).toBe(0);
+  });
+
+  it("should apply deltas once when several workers update the same database", async () => {
+    const shared = path.join(dir, "shared.db");
+    copyFileSync(v1, shared);
+
+    const results = await Promise.all([1, 2, 3].map(() => applyDeltas(shared, deltas)));
+    expect(results.map((result) => result.applied).sort()).toEqual([0, 0, 2]);
+    expect(readFileSync(shared).equals(readFileSync(v3))).toBe(true);
+    expect(readdirSync(dir).filter((name) => name.startsWith("shared.db."))).toEqual(["shared.db.sha256"]);
+  });
+
+  it("should leave a database it cannot patch unchanged", async () => {
+    const other = release(dir, v1, "other.db", "UPDATE Make SET Name = 'FORD MOTOR' WHERE Name = 'FORD'");
+    const before = readFileSync(other);
+
+    const result = await applyDeltas(other, deltas);
+    expect(result.applied).toBe(0);
+    expect(readFileSync(other).equals(before)).toBe(true);
+  });
+
+  it("should plan chains only from known versions", async () => {
+    const manifest = JSON.parse(readFileSync(path.join(deltas, "manifest.json"), "utf-8"));
+    const [first, second] = manifest.deltas;
+
+    expect(planDeltaChain(manifest, first.from)).toEqual([first, second]);
+    expect(planDeltaChain(manifest, second.from)).toEqual([second]);
+    expect(planDeltaChain(manifest, manifest.latest)).toEqual([]);
+    expect(planDeltaChain(manifest, "0".repeat(64))).toBeNull();
+  });
+});
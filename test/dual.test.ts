@@ -0,0 +1,81 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { copyFileSync, mkdtempSync } from "fs";
+import { tmpdir } from "os";
+import Database from "better-sqlite3";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { buildDiffManifest, DualDecoder } from "../lib/dual";
+import type { DiffManifest } from "../lib/dual";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const KONA = "KM8K2CAB4PU001140";
+const ROGUE = "5N1AT2MT9LC784186";
+
+describe("Dual-version decode", () => {
+  let candidatePath: string;
+  let manifest: DiffManifest;
+
+  beforeAll(async () => {
+    // Candidate snapshot: identical except for one renamed model
+    candidatePath = path.join(mkdtempSync(path.join(tmpdir(), "corgi-dual-")), "candidate.db");
+    copyFileSync(TEST_DB_PATH, candidatePath);
+    const db = new Database(candidatePath);
+    db.prepare("UPDATE Model SET Name = 'Kona Electric' WHERE Name = 'Kona'").run();
+    db.close();
+
+    manifest = await buildDiffManifest(
+      new NodeDatabaseAdapter(TEST_DB_PATH),
+      new NodeDatabaseAdapter(candidatePath),
+      ["KM8", "5N1"]
+    );
+  });
+
+  it("should list only WMIs whose decode inputs changed", () => {
+    expect(manifest.changed).toEqual(["KM8"]);
+    expect(manifest.unchanged).toEqual(["5N1"]);
+  });
+
+  it("should decode changed WMIs against both snapshots and diff them", async () => {
+    const decoder = new DualDecoder(
+      new NodeDatabaseAdapter(TEST_DB_PATH),
+      new NodeDatabaseAdapter(candidatePath),
+      manifest
+    );
+
+    const result = await decoder.decode(KONA);
+    expect(result.reused).toBe(false);
+    expect(result.changes).toEqual([
+      { field: "vehicle.model", before: "Kona", after: "Kona Electric" },
+    ]);
+  });
+
+  it("should reuse the first result for unchanged WMIs and invalid VINs", async () => {
+    const decoder = new DualDecoder(
+      new NodeDatabaseAdapter(TEST_DB_PATH),
+      new NodeDatabaseAdapter(candidatePath),
+      manifest
+    );
+
+    const report = await decoder.report([KONA, ROGUE, "INVALID"]);
+    expect(report.summary).toEqual({
+      total: 3,
+      changed: 1,
+      unchanged: 2,
+      reused: 2,
+      fields: { "vehicle.model": 1 },
+    });
+    expect(report.changes.map((c) => c.vin)).toEqual([KONA]);
+  });
+
+  it("should find the same differences without a manifest", async () => {
+    const decoder = new DualDecoder(
+      new NodeDatabaseAdapter(TEST_DB_PATH),
+      new NodeDatabaseAdapter(candidatePath)
+    );
+
+    const report = await decoder.report([KONA, ROGUE]);
+    expect(report.summary.changed).toBe(1);
+    expect(report.summary.reused).toBe(0);
+  });
+});
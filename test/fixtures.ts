@@ -4,6 +4,8 @@
  */
 
 import { BodyStyle } from "../lib/types";
+import type { DecodeResult } from "../lib/types";
+import type { DatabaseAdapter, QueryResult } from "../lib/db/adapter";
 
 export interface VINTestCase {
   vin: string;
@@ -611,3 +613,45 @@ export function getAllTestVINs(): VINTestCase[] {
 export function getTestVINCount(): number {
   return getAllTestVINs().length;
 }
+
+/**
+ * Strip timing so results from different decoders, adapters or databases can be compared
+ */
+export function comparable(result: DecodeResult) {
+  const { processingTime, ...metadata } = result.metadata!;
+  return { ...result, metadata };
+}
+
+/**
+ * Adapter that counts queries reaching the wrapped adapter, optionally adding
+ * latency like D1, and records how many overlap
+ */
+export class CountingAdapter implements DatabaseAdapter {
+  queries = 0;
+  active = 0;
+  maxActive = 0;
+
+  /**
+   * @param inner - Adapter answering the queries
+   * @param delayMs - Latency added to each query (default: none)
+   */
+  constructor(private inner: DatabaseAdapter, private delayMs = 0) {}
+
+  async exec(query: string, params?: any[]): Promise<QueryResult[]> {
+    this.queries++;
+    this.active++;
+    this.maxActive = Math.max(this.maxActive, this.active);
+    try {
+      if (this.delayMs > 0) {
+        await new Promise((resolve) => setTimeout(resolve, this.delayMs));
+      }
+      return await this.inner.exec(query, params);
+    } finally {
+      this.active--;
+    }
+  }
+
+  close(): Promise<void> {
+    return this.inner.close();
+  }
+}
@@ -0,0 +1,63 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { compileHotIndex, measureHotIndex } from "../lib/db/hot-index-builder";
+import { HotIndex, IndexedDatabaseAdapter, HotIndexData } from "../lib/db/hot-index";
+import { comparable } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const HOT_VINS = ["KM8K2CAB4PU001140", "5N1AT2MT9LC784186"];
+const COLD_VIN = "2FTEF14H8TCA73155";
+
+describe("Hot-WMI index", () => {
+  let data: HotIndexData;
+  let baseline: VINDecoder;
+
+  beforeAll(async () => {
+    data = await compileHotIndex(new NodeDatabaseAdapter(TEST_DB_PATH), ["KM8", "5N1"]);
+    baseline = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+  });
+
+  it("should compile WMI info, schemas, patterns and lookups", () => {
+    expect(Object.keys(data.wmis)).toEqual(["KM8", "5N1"]);
+    expect(data.wmis.KM8.info?.make).toBe("Hyundai");
+    expect(Object.keys(data.schemas).length).toBeGreaterThan(0);
+    expect(data.lookups.Model).toBeDefined();
+
+    const sizes = measureHotIndex(data);
+    expect(sizes.total).toBe(JSON.stringify(data).length);
+  });
+
+  it("should decode hot WMIs without querying the fallback adapter", async () => {
+    const adapter = new IndexedDatabaseAdapter(new HotIndex(data), new NodeDatabaseAdapter(TEST_DB_PATH));
+    const decoder = new VINDecoder(adapter);
+
+    for (const vin of HOT_VINS) {
+      const indexed = await decoder.decode(vin);
+      const expected = await baseline.decode(vin);
+      expect(comparable(indexed)).toEqual(comparable(expected));
+    }
+
+    expect(adapter.fallbackQueryCount).toBe(0);
+  });
+
+  it("should fall back for WMIs outside the index", async () => {
+    const adapter = new IndexedDatabaseAdapter(new HotIndex(data), new NodeDatabaseAdapter(TEST_DB_PATH));
+    const decoder = new VINDecoder(adapter);
+
+    const result = await decoder.decode(COLD_VIN);
+    expect(result.components.vehicle?.model).toBe("F-150");
+    expect(adapter.fallbackQueryCount).toBeGreaterThan(0);
+  });
+
+  it("should survive a JSON round trip", async () => {
+    const restored = JSON.parse(JSON.stringify(data)) as HotIndexData;
+    const adapter = new IndexedDatabaseAdapter(new HotIndex(restored), new NodeDatabaseAdapter(TEST_DB_PATH));
+    const result = await new VINDecoder(adapter).decode(HOT_VINS[0]);
+
+    expect(result.components.vehicle?.model).toBe("Kona");
+    expect(adapter.fallbackQueryCount).toBe(0);
+  });
+});
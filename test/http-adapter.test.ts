@@ -0,0 +1,135 @@
+import { describe, it, expect, beforeAll, afterAll } from "vitest";
+import { Worker } from "worker_threads";
+import { mkdtempSync, rmSync, readdirSync, writeFileSync, utimesSync, existsSync } from "fs";
+import { tmpdir } from "os";
+import path from "path";
+import {
+  HttpRangeDatabaseAdapter,
+  HttpRangeDatabaseAdapterFactory,
+  RemotePageCache,
+} from "../lib/db/http-adapter";
+import { VINDecoder } from "../lib/decode";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+// The adapter blocks the calling thread while a block downloads, so the
+// static server has to live on another thread.
+const STATIC_SERVER_SOURCE = `
+const http = require('http');
+const fs = require('fs');
+const { parentPort, workerData } = require('worker_threads');
+const file = fs.readFileSync(workerData.file);
+let rangeRequests = 0;
+const server = http.createServer((req, res) => {
+  if (req.url === '/stats') return res.end(String(rangeRequests));
+  if (req.method === 'HEAD') {
+    res.writeHead(200, { 'content-length': file.length, etag: '"test"', 'accept-ranges': 'bytes' });
+    return res.end();
+  }
+  const match = /bytes=(\\d+)-(\\d+)/.exec(req.headers.range || '');
+  if (!match) {
+    res.writeHead(200, { 'content-length': file.length });
+    return res.end(file);
+  }
+  rangeRequests++;
+  const start = +match[1];
+  const end = Math.min(+match[2], file.length - 1);
+  res.writeHead(206, { 'content-length': end - start + 1 });
+  res.end(file.subarray(start, end + 1));
+});
+server.listen(0, '127.0.0.1', () => parentPort.postMessage(server.address().port));
+`;
+
+describe("HttpRangeDatabaseAdapter", () => {
+  let server: Worker;
+  let baseUrl: string;
+  let cacheDir: string;
+
+  beforeAll(async () => {
+    cacheDir = mkdtempSync(path.join(tmpdir(), "corgi-remote-"));
+    server = new Worker(STATIC_SERVER_SOURCE, {
+      eval: true,
+      workerData: { file: TEST_DB_PATH },
+    });
+    const port = await new Promise<number>((resolve) => server.once("message", resolve));
+    baseUrl = `http://127.0.0.1:${port}`;
+  });
+
+  afterAll(async () => {
+    await server.terminate();
+    rmSync(cacheDir, { recursive: true, force: true });
+  });
+
+  const rangeRequests = async () => Number(await (await fetch(`${baseUrl}/stats`)).text());
+
+  it("should decode a VIN from a remote database", async () => {
+    const factory = new HttpRangeDatabaseAdapterFactory({ cacheDir });
+    const adapter = (await factory.createAdapter(`${baseUrl}/vpic.db`)) as HttpRangeDatabaseAdapter;
+    const decoder = new VINDecoder(adapter);
+
+    const result = await decoder.decode("KM8K2CAB4PU001140");
+    expect(result.valid).toBe(true);
+    expect(result.components.vehicle?.make).toBe("Hyundai");
+    expect(result.components.vehicle?.model).toBe("Kona");
+
+    const stats = adapter.getCacheStats();
+    expect(stats.requests).toBeGreaterThan(0);
+    expect(stats.memoryHits).toBeGreaterThan(0);
+
+    await decoder.close();
+    expect(readdirSync(cacheDir).length).toBe(1);
+  });
+
+  it("should serve a restarted adapter from the disk cache", async () => {
+    const before = await rangeRequests();
+
+    const factory = new HttpRangeDatabaseAdapterFactory({ cacheDir });
+    const adapter = (await factory.createAdapter(`${baseUrl}/vpic.db`)) as HttpRangeDatabaseAdapter;
+    const decoder = new VINDecoder(adapter);
+
+    const result = await decoder.decode("KM8K2CAB4PU001140");
+    expect(result.components.vehicle?.model).toBe("Kona");
+    expect(adapter.getCacheStats().diskHits).toBeGreaterThan(0);
+    expect(await rangeRequests()).toBe(before);
+
+    await decoder.close();
+  });
+
+  it("should refetch truncated disk blocks and keep disk hits across restarts", () => {
+    const file = new Uint8Array(4096).map((_, i) => i % 251);
+    const reader = { read: (start: number, end: number) => file.slice(start, end + 1) };
+    const dir = mkdtempSync(path.join(tmpdir(), "corgi-blocks-"));
+    const options = { cacheDir: dir, blockSize: 1024, memoryBlocks: 1, diskBlocks: 3, prefetchBlocks: 0 };
+    const blockFile = (index: number) => path.join(dir, "key", `${index}.blk`);
+    const read = (cache: RemotePageCache, index: number) => {
+      const target = new Uint8Array(1024);
+      cache.read(target, 0, 1024, index * 1024);
+      return target;
+    };
+
+    const first = new RemotePageCache(reader, file.length, "key", options);
+    for (const index of [0, 1, 2]) read(first, index);
+    const past = new Date(Date.now() - 60_000);
+    for (const index of [0, 1, 2]) utimesSync(blockFile(index), past, past);
+
+    // A partial write must not be served
+    writeFileSync(blockFile(1), file.slice(1024, 1500));
+    const second = new RemotePageCache(reader, file.length, "key", options);
+    expect(read(second, 1)).toEqual(file.slice(1024, 2048));
+    expect(second.getStats()).toMatchObject({ diskHits: 0, requests: 1 });
+
+    // Block 0 was used last, so adding block 3 after a restart evicts block 2
+    expect(read(second, 0)).toEqual(file.slice(0, 1024));
+    const third = new RemotePageCache(reader, file.length, "key", options);
+    read(third, 3);
+    expect(existsSync(blockFile(0))).toBe(true);
+    expect(existsSync(blockFile(2))).toBe(false);
+
+    rmSync(dir, { recursive: true, force: true });
+  });
+
+  it("should reject URLs that cannot be loaded", async () => {
+    const factory = new HttpRangeDatabaseAdapterFactory({ cacheDir });
+    await expect(factory.createAdapter("http://127.0.0.1:1/vpic.db")).rejects.toThrow();
+  });
+});
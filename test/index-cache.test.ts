@@ -0,0 +1,159 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import os from "os";
+import fs from "fs";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { IndexCacheAdapter } from "../lib/db/index-cache";
+import { VINDecoder } from "../lib/decode";
+import { compileHotIndex } from "../lib/db/hot-index-builder";
+import { comparable, CountingAdapter } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = ["KM8K2CAB4PU001140", "5N1AT2MT9LC784186", "1HGCM82633A123456"];
+
+function tempCachePath() {
+  return path.join(fs.mkdtempSync(path.join(os.tmpdir(), "corgi-index-")), "vpic.index.json");
+}
+
+describe("Compiled index cache", () => {
+  // The checksum sidecar is written next to the database, so work on a copy
+  let dbPath: string;
+
+  beforeAll(() => {
+    dbPath = path.join(fs.mkdtempSync(path.join(os.tmpdir(), "corgi-index-db-")), "vpic.db");
+    fs.copyFileSync(TEST_DB_PATH, dbPath);
+  });
+
+  it("should write the WMIs decoded and answer from the file after a restart", async () => {
+    const cachePath = tempCachePath();
+    const first = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath });
+    const expected = (await new VINDecoder(first).decodeBatch(VINS)).map(comparable);
+    await first.close();
+
+    // 1HG is not in the test database, so it is left out of the file
+    expect(first.getStats()).toMatchObject({ loaded: false, writes: 1, wmis: 2 });
+    expect(fs.existsSync(cachePath)).toBe(true);
+
+    const counting = new CountingAdapter(new NodeDatabaseAdapter(dbPath));
+    const second = await IndexCacheAdapter.open(counting, dbPath, { path: cachePath });
+    const decoder = new VINDecoder(second);
+    const results = [];
+    for (const vin of VINS.slice(0, 2)) {
+      results.push(comparable(await decoder.decode(vin)));
+    }
+
+    expect(results).toEqual(expected.slice(0, 2));
+    expect(second.getStats()).toMatchObject({ loaded: true, wmis: 2 });
+    expect(second.getStats().hits).toBeGreaterThan(0);
+    expect(counting.queries).toBe(0);
+
+    expect(comparable(await decoder.decode(VINS[2]))).toEqual(expected[2]);
+    await second.close();
+    expect(second.getStats().writes).toBe(0);
+  });
+
+  it("should rebuild a cache file written for another database", async () => {
+    const cachePath = tempCachePath();
+    const first = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath });
+    await new VINDecoder(first).decode(VINS[0]);
+    await first.close();
+
+    const file = JSON.parse(fs.readFileSync(cachePath, "utf-8"));
+    file.key.dbHash = "0".repeat(64);
+    fs.writeFileSync(cachePath, JSON.stringify(file));
+
+    const second = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath });
+    expect(second.getStats()).toMatchObject({ loaded: false, wmis: 0 });
+    await new VINDecoder(second).decode(VINS[0]);
+    await second.close();
+    expect(JSON.parse(fs.readFileSync(cachePath, "utf-8")).key.dbHash).not.toBe("0".repeat(64));
+  });
+
+  it("should compile only new WMIs and merge them into the file", async () => {
+    const cachePath = tempCachePath();
+    const first = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath });
+    await new VINDecoder(first).decode(VINS[0]);
+    await first.close();
+
+    const counting = new CountingAdapter(new NodeDatabaseAdapter(dbPath));
+    const second = await IndexCacheAdapter.open(counting, dbPath, { path: cachePath });
+    const expected = comparable(await new VINDecoder(new NodeDatabaseAdapter(dbPath)).decode(VINS[1]));
+    expect(comparable(await new VINDecoder(second).decode(VINS[1]))).toEqual(expected);
+    const decodeQueries = counting.queries;
+    await second.close();
+
+    const file = JSON.parse(fs.readFileSync(cachePath, "utf-8"));
+    expect(Object.keys(file.index.wmis).sort()).toEqual(["5N1", "KM8"]);
+
+    // Compiling 5N1 alone; KM8 comes from the loaded index
+    const alone = new CountingAdapter(new NodeDatabaseAdapter(dbPath));
+    await compileHotIndex(alone, ["5N1"]);
+    expect(counting.queries - decodeQueries).toBe(alone.queries);
+
+    const third = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath });
+    const decoder = new VINDecoder(third);
+    for (const vin of VINS.slice(0, 2)) {
+      expect(comparable(await decoder.decode(vin))).toEqual(
+        comparable(await new VINDecoder(new NodeDatabaseAdapter(dbPath)).decode(vin))
+      );
+    }
+    await third.close();
+  });
+
+  it("should keep the WMIs other workers wrote to the same file", async () => {
+    const cachePath = tempCachePath();
+    const workers = await Promise.all(
+      VINS.slice(0, 2).map(() => IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath }))
+    );
+    await Promise.all(workers.map((worker, i) => new VINDecoder(worker).decode(VINS[i])));
+    await Promise.all(workers.map((worker) => worker.close()));
+
+    const file = JSON.parse(fs.readFileSync(cachePath, "utf-8"));
+    expect(Object.keys(file.index.wmis).sort()).toEqual(["5N1", "KM8"]);
+    expect(fs.existsSync(`${cachePath}.lock`)).toBe(false);
+
+    const next = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, { path: cachePath });
+    const decoder = new VINDecoder(next);
+    for (const vin of VINS.slice(0, 2)) {
+      expect(comparable(await decoder.decode(vin))).toEqual(
+        comparable(await new VINDecoder(new NodeDatabaseAdapter(dbPath)).decode(vin))
+      );
+    }
+    await next.close();
+    expect(next.getStats()).toMatchObject({ loaded: true, writes: 0 });
+  });
+
+  it("should not spend the limit on WMIs the database does not know", async () => {
+    const cachePath = tempCachePath();
+    const adapter = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, {
+      path: cachePath,
+      maxWmis: 1,
+    });
+    const decoder = new VINDecoder(adapter);
+    await decoder.decode("1HGCM82633A123456");
+    await decoder.decode("!!!CM82633A12345");
+    await adapter.close();
+    expect(adapter.getStats()).toMatchObject({ wmis: 0, writes: 0 });
+
+    const next = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, {
+      path: cachePath,
+      maxWmis: 1,
+    });
+    await new VINDecoder(next).decode(VINS[0]);
+    await next.close();
+    expect(next.getStats()).toMatchObject({ wmis: 1, writes: 1 });
+  });
+
+  it("should stop adding WMIs at the limit", async () => {
+    const cachePath = tempCachePath();
+    const adapter = await IndexCacheAdapter.open(new NodeDatabaseAdapter(dbPath), dbPath, {
+      path: cachePath,
+      maxWmis: 1,
+    });
+    await new VINDecoder(adapter).decodeBatch(VINS);
+    await adapter.close();
+
+    expect(adapter.getStats().wmis).toBe(1);
+  });
+});
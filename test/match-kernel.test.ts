@@ -0,0 +1,64 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { PatternMatcher } from "../lib/pattern";
+import { MatchKernel } from "../lib/db/match-kernel";
+import { MATCH_KERNEL_WASM } from "../lib/db/match-kernel-wasm";
+import { VIN_ALPHABET } from "../lib/db/vds-classes";
+import { comparable } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = ["KM8K2CAB4PU001140", "5N1AT2MT9LC784186", "2FTEF14H8TCA73155", "1HGCM82633A123456"];
+
+describe("WebAssembly matching kernel", () => {
+  const matcher = new PatternMatcher(new NodeDatabaseAdapter(TEST_DB_PATH));
+  const score = (pattern: string, input: string) => matcher.calculateConfidence(pattern, input);
+  let kernel: MatchKernel;
+
+  beforeAll(async () => {
+    expect(WebAssembly.validate(MATCH_KERNEL_WASM)).toBe(true);
+    kernel = (await MatchKernel.create())!;
+    expect(kernel).not.toBeNull();
+  });
+
+  it("should match the same patterns as the JS matcher across lanes", () => {
+    // Enough patterns to span two v128 words
+    const patterns = Array.from({ length: 150 }, (_, i) => {
+      const a = VIN_ALPHABET[i % VIN_ALPHABET.length];
+      const b = VIN_ALPHABET[(i * 7) % VIN_ALPHABET.length];
+      return [`${a}*`, `*[${a}-Z]${b}`, `[0-9${a}]**${b}`][i % 3];
+    });
+
+    for (let i = 0; i < 200; i++) {
+      const vds = Array.from({ length: 6 }, (_, p) =>
+        VIN_ALPHABET[(i * (p + 3) + p * 11) % VIN_ALPHABET.length]
+      ).join("");
+      const matched = kernel.match("synthetic", patterns, score, vds)!;
+      for (const pattern of new Set(patterns)) {
+        expect(matched.get(pattern) ?? 0).toBe(score(pattern, vds + "00000000"));
+      }
+    }
+
+    expect(kernel.getStats()).toMatchObject({ sets: 1, matches: 200, resets: 0 });
+  });
+
+  it("should leave sets reading past the VDS to the JS matcher", () => {
+    expect(kernel.match("long", ["ABCDEF*"], score, "ABCDEF")).toBeUndefined();
+  });
+
+  it("should decode identically with the kernel attached to the adapter", async () => {
+    const baseline = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const withKernel = (await MatchKernel.create())!;
+    const decoder = new VINDecoder(Object.assign(new NodeDatabaseAdapter(TEST_DB_PATH), { kernel: withKernel }));
+
+    for (const vin of VINS) {
+      const options = { includePatternDetails: true };
+      expect(comparable(await decoder.decode(vin, options))).toEqual(
+        comparable(await baseline.decode(vin, options))
+      );
+    }
+    expect(withKernel.getStats().matches).toBeGreaterThan(0);
+  });
+});
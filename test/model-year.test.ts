@@ -0,0 +1,79 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { VPICDatabase } from "../lib/db";
+import { resolveModelYear, selectModelYear } from "../lib/model-year";
+import { CountingAdapter } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+// The previous indexOf-based implementation, kept as a reference
+function reference(vin: string): number | null {
+  const codes = "ABCDEFGHJKLMNPRSTVWXY123456789";
+  const char = vin[9].toUpperCase();
+  if (char === "0") return 0;
+  const index = codes.indexOf(char);
+  if (index === -1) return null;
+  const p7 = vin.charCodeAt(6);
+  let year = (p7 >= 48 && p7 <= 57 ? 1980 : 2010) + index;
+  if (year > new Date().getFullYear() + 1) year -= 30;
+  return year;
+}
+
+describe("Model year resolution", () => {
+  it("should match the previous resolution for every position 7 and 10", () => {
+    const chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcxyz-";
+    for (const p7 of chars) {
+      for (const p10 of chars) {
+        const vin = `1HGCM8${p7}63${p10}A123456`;
+        expect(resolveModelYear(vin)?.year ?? null).toBe(reference(vin));
+      }
+    }
+  });
+
+  it("should list the other cycle's year as a candidate unless it is in the future", () => {
+    expect(resolveModelYear("KM8K2CAB4PU001140")).toMatchObject({ year: 2023, candidates: [2023, 1993] });
+    expect(resolveModelYear("KM8K2C3B4PU001140")).toMatchObject({ year: 1993, candidates: [1993, 2023] });
+
+    // The year after next falls back a cycle and has no other candidate
+    const future = new Date().getFullYear() + 2;
+    const char = "ABCDEFGHJKLMNPRSTVWXY123456789"[future - 2010];
+    expect(resolveModelYear(`KM8K2CAB4${char}U001140`)).toMatchObject({ year: future - 30, candidates: [future - 30] });
+    expect(resolveModelYear("KM8K2CAB40U001140")).toMatchObject({ year: 0, confidence: 0 });
+  });
+
+  it("should select the cycle a WMI's schemas cover", () => {
+    const year = resolveModelYear("KM8K2C3B4PU001140")!;
+    expect(selectModelYear(year, [[2018, null]])).toMatchObject({ year: 2023, confidence: 0.8, candidates: [2023, 1993] });
+    expect(selectModelYear(year, [[1990, 1999]])).toBe(year);
+    expect(selectModelYear(year, [[2000, 2010]])).toBe(year);
+    expect(selectModelYear(year, [])).toBe(year);
+  });
+
+  it("should decode a VIN whose position 7 points at the wrong cycle", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+
+    const result = await decoder.decode("KM8K2C3B4PU001140");
+    expect(result.components.modelYear).toMatchObject({ year: 2023, source: "position" });
+    expect(result.components.vehicle?.year).toBe(2023);
+    expect(result.components.vehicle?.model).toBe("Kona");
+
+    const unchanged = await decoder.decode("KM8K2CAB4PU001140");
+    expect(unchanged.components.modelYear).toMatchObject({ year: 2023, confidence: 1 });
+  });
+
+  it("should read schemas and year ranges for a WMI with one query", async () => {
+    const counting = new CountingAdapter(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const db = new VPICDatabase(counting);
+
+    const ranges = await db.getWmiYearRanges("KM8");
+    const schemas = await db.getValidSchemas("KM8", 2023);
+    await db.getValidSchemas("KM8", 1993);
+    expect(counting.queries).toBe(1);
+
+    expect(ranges.length).toBeGreaterThan(0);
+    expect(schemas.length).toBeGreaterThan(0);
+    expect(new Set(schemas.map((s) => s.SchemaId)).size).toBe(schemas.length);
+  });
+});
@@ -0,0 +1,128 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { PatternOverlay } from "../lib/overlay";
+import type { OverlayFile } from "../lib/overlay";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+// Same shape as community/wmi/tesla/XP7.yaml
+const BERLIN: OverlayFile = {
+  wmi: "XP7",
+  manufacturer: "TESLA, INC.",
+  make: "Tesla",
+  country: "GERMANY",
+  vehicle_type: "Passenger Car",
+  years: { from: 2022, to: null },
+  schema_name: "Tesla Schema for XP7 (Germany) - Model Y",
+  patterns: [
+    { pattern: "Y*****", element: "Model", value: "Model Y" },
+    { pattern: "YG****", element: "Body Class", value: "Sport Utility Vehicle (SUV)/Multi-Purpose Vehicle (MPV)" },
+  ],
+};
+
+const KONA_FLEET: OverlayFile = {
+  wmi: "KM8",
+  mode: "supplement",
+  patterns: [
+    { pattern: "K2C***", element: "Model", value: "Kona Fleet" },
+    { pattern: "K2CA**", element: "Trim", value: "Fleet Edition" },
+  ],
+};
+
+describe("Pattern overlays", () => {
+  const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+
+  it("should decode a tenant's own WMI only for that tenant", async () => {
+    const overlay = new PatternOverlay("fleet-a", [BERLIN]);
+
+    const result = await decoder.decode("XP7YGDEE6TB729697", { overlay });
+    expect(result.components.wmi).toMatchObject({ make: "Tesla", country: "GERMANY", region: "EUROPE" });
+    expect(result.components.vehicle?.model).toBe("Model Y");
+
+    const shared = await decoder.decode("XP7YGDEE6TB729697");
+    expect(shared.components.wmi).toBeUndefined();
+  });
+
+  it("should layer corrections on a base schema without changing it for others", async () => {
+    const overlay = new PatternOverlay("fleet-b", [KONA_FLEET]);
+
+    const result = await decoder.decode("KM8K2CAB4PU001140", { overlay, includePatternDetails: true });
+    expect(result.components.vehicle?.model).toBe("Kona Fleet");
+    expect(result.components.vehicle?.trim).toBe("Fleet Edition");
+    expect(result.components.vehicle?.driveType).toBeDefined();
+
+    const shared = await decoder.decode("KM8K2CAB4PU001140");
+    expect(shared.components.vehicle?.model).toBe("Kona");
+    expect(shared.components.vehicle?.trim).toBeUndefined();
+  });
+
+  it("should recompile only the schemas of an updated WMI", async () => {
+    const overlay = new PatternOverlay("fleet-c", [BERLIN, KONA_FLEET]);
+    await decoder.decode("XP7YGDEE6TB729697", { overlay });
+    await decoder.decode("KM8K2CAB4PU001140", { overlay });
+
+    const [berlin] = overlay.getValidSchemas("XP7", 2026, []);
+    const [kona] = overlay.getValidSchemas("KM8", 2023, [{ SchemaId: 1, SchemaName: "Hyundai Kona 2018-" }]);
+    const berlinRows = overlay.getCompiled(berlin.SchemaId);
+    expect(berlinRows).toBeDefined();
+    expect(overlay.getCompiled(kona.SchemaId)).toBeDefined();
+
+    overlay.set({ ...KONA_FLEET, patterns: [{ pattern: "K2C***", element: "Model", value: "Kona Pool" }] });
+    expect(overlay.getCompiled(berlin.SchemaId)).toBe(berlinRows);
+    expect(overlay.getCompiled(kona.SchemaId)).toBeUndefined();
+
+    const result = await decoder.decode("KM8K2CAB4PU001140", { overlay });
+    expect(result.components.vehicle?.model).toBe("Kona Pool");
+    expect(result.components.vehicle?.trim).toBeUndefined();
+
+    overlay.delete("KM8");
+    expect((await decoder.decode("KM8K2CAB4PU001140", { overlay })).components.vehicle?.model).toBe("Kona");
+  });
+
+  it("should drop retired schemas on the next update", () => {
+    const overlay = new PatternOverlay("fleet-d", [BERLIN]);
+    const [first] = overlay.getValidSchemas("XP7", 2026, []);
+
+    overlay.set(BERLIN);
+    const [second] = overlay.getValidSchemas("XP7", 2026, []);
+    expect(second.SchemaId).not.toBe(first.SchemaId);
+    expect(overlay.getSchema(first.SchemaId)).toBeDefined();
+
+    overlay.set(BERLIN);
+    expect(overlay.getSchema(first.SchemaId)).toBeUndefined();
+    expect(overlay.getSchema(second.SchemaId)).toBeDefined();
+  });
+
+  it("should give overlay rows the base schema's years for the WMI", () => {
+    const overlay = new PatternOverlay("fleet-e", [{ ...KONA_FLEET, years: { from: 2020, to: 2024 } }]);
+    const [schema] = overlay.getValidSchemas("KM8", 2023, [{ SchemaId: 1, SchemaName: "Hyundai Kona 2018-" }]);
+    const element = { ElementId: 1, ElementCode: null, GroupName: null, Description: null, ElementWeight: null };
+    const elements = new Map([
+      ["model", { ...element, ElementName: "Model" }],
+      ["trim", { ...element, ElementName: "Trim" }],
+    ]);
+    // Rows of a schema linked to several WMIs carry each link's years
+    const baseRows = [{ Pattern: "Z*****", ElementName: "Trim", AttributeId: "X", YearFrom: 1999, YearTo: 2001 }];
+
+    const rows = overlay.compile(overlay.getSchema(schema.SchemaId)!, baseRows, elements, [2018, null]);
+    const added = rows.filter((row) => row.Pattern.startsWith("K2C"));
+    expect(added.map((row) => [row.YearFrom, row.YearTo])).toEqual([
+      [2020, 2024],
+      [2020, 2024],
+    ]);
+  });
+
+  it("should accept six-character WMIs of small manufacturers", () => {
+    expect(new PatternOverlay("small", [{ ...BERLIN, wmi: "1g9abc" }]).wmis).toEqual(["1G9ABC"]);
+    expect(() => new PatternOverlay("bad", [{ ...BERLIN, wmi: "1G9" }])).toThrow("6 when the third is 9");
+    expect(() => new PatternOverlay("bad", [{ ...BERLIN, wmi: "XP7ABC" }])).toThrow("3 characters");
+  });
+
+  it("should reject malformed overlay files", () => {
+    expect(() => new PatternOverlay("bad", [{ ...BERLIN, wmi: "XP" }])).toThrow("3 characters");
+    expect(() => new PatternOverlay("bad", [{ ...BERLIN, patterns: [] }])).toThrow("no patterns");
+    expect(() => new PatternOverlay("bad", [{ ...BERLIN, make: undefined }])).toThrow("requires a make");
+  });
+});
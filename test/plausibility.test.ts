@@ -0,0 +1,56 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VPICDatabase } from "../lib/db";
+import { PlausibilityFilter, compilePlausibilityFilter } from "../lib/db/plausibility";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+describe("VIN plausibility filter", () => {
+  let filter: PlausibilityFilter;
+
+  beforeAll(async () => {
+    filter = await PlausibilityFilter.load(new NodeDatabaseAdapter(TEST_DB_PATH));
+  });
+
+  it("should accept VINs whose WMI, year and VDS prefix a Model pattern allows", () => {
+    expect(filter.isPlausible("KM8K2CAB4PU001140")).toBe(true);
+    expect(filter.isPlausible("5N1AT2MT9LC784186")).toBe(true);
+    expect(filter.isPlausible("1FTEW1EG0JFA00000")).toBe(true);
+    expect(filter.isPlausible("1FTF14009VC000001")).toBe(true);
+    expect(filter.isPlausible("km8k2cab4pu001140")).toBe(true);
+    // No model year encoded
+    expect(filter.isPlausible("KM8K2CAB70U001140")).toBe(true);
+  });
+
+  it("should reject unknown WMIs, years and VDS prefixes", () => {
+    expect(filter.isPlausible("1HGCM82673A123456")).toBe(false);
+    // KM8 schemas start in 2018
+    expect(filter.isPlausible("KM8K2CAB5AU001140")).toBe(false);
+    // No KM8 Model pattern starts with Z2
+    expect(filter.isPlausible("KM8Z2CAB6PU001140")).toBe(false);
+  });
+
+  it("should reject malformed VINs and bad North American check digits", () => {
+    expect(filter.isPlausible("KM8K2CAB4PU00114O")).toBe(false);
+    expect(filter.isPlausible("KM8K2CAB4PU00114")).toBe(false);
+    expect(filter.isPlausible("5N1AT2MT9LC784186")).toBe(true);
+    expect(filter.isPlausible("5N1AT2MT8LC784186")).toBe(false);
+    expect(filter.isPlausible("5N1AT2MT8LC784186", { checkDigit: false })).toBe(true);
+    // Korea does not require a check digit unless asked
+    expect(filter.isPlausible("KM8K2CAB5PU001140")).toBe(true);
+    expect(filter.isPlausible("KM8K2CAB5PU001140", { checkDigit: true })).toBe(false);
+    expect(PlausibilityFilter.hasValidCheckDigit("5N1AT2MT9LC784186")).toBe(true);
+  });
+
+  it("should round-trip through serialization and report its false positive rate", async () => {
+    const rows = await new VPICDatabase(new NodeDatabaseAdapter(TEST_DB_PATH)).getModelPatternYearRanges();
+    const strict = compilePlausibilityFilter(rows, { falsePositiveRate: 0.001 });
+    const restored = PlausibilityFilter.deserialize(strict.serialize());
+
+    expect(restored.getStats()).toEqual(strict.getStats());
+    expect(restored.getStats().falsePositiveRate).toBeLessThanOrEqual(0.001);
+    expect(filter.getStats().falsePositiveRate).toBeLessThanOrEqual(0.01);
+    expect(restored.isPlausible("KM8K2CAB4PU001140")).toBe(true);
+  });
+});
@@ -0,0 +1,72 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { ErrorCode } from "../lib/enums";
+import { invalidCharacterMask } from "../lib/reject";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+describe("Fast reject", () => {
+  it("should build one result per error and set the VIN per result", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [a, b] = await decoder.decodeBatch(["SHORT", "TOOSHORT"], { fastReject: true });
+
+    expect(a.vin).toBe("SHORT");
+    expect(b.vin).toBe("TOOSHORT");
+    expect(a.valid).toBe(false);
+    expect(a.errors[0].code).toBe(ErrorCode.INVALID_LENGTH);
+    expect(b.errors).toEqual(a.errors);
+  });
+
+  it("should return results callers can modify", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [a] = await decoder.decodeBatch(["IM8K2CAB4PU001140"], { fastReject: true });
+
+    a.errors.push({ ...a.errors[0], message: "Seen in feed" });
+    a.errors[0].positions!.push(2);
+    a.components.wmi = undefined;
+
+    const [b] = await decoder.decodeBatch(["IM8K2CAB4PU001141"], { fastReject: true });
+    expect(b.errors).toHaveLength(1);
+    expect(b.errors[0].positions).toEqual([1]);
+  });
+
+  it("should report invalid character positions", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [a, b, c] = await decoder.decodeBatch(
+      ["IM8K2CAB4PU001140", "OM8K2CAB4PU001141", "KM8K2CABZPU00114Q"],
+      { fastReject: true },
+    );
+
+    expect(a.errors[0].code).toBe(ErrorCode.INVALID_CHARACTERS);
+    expect(a.errors[0].positions).toEqual([1]);
+    expect(b.errors).toEqual(a.errors);
+    expect(c.errors[0].positions).toEqual([9, 17]);
+    expect(invalidCharacterMask("KM8K2CAB4PU001140")).toBe(0);
+  });
+
+  it("should reject unknown WMIs and count rejects by code", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [a, b] = await decoder.decodeBatch(["1HGCM82633A123456", "1HGCM82633A654321"], { fastReject: true });
+
+    expect(a.errors[0].code).toBe(ErrorCode.WMI_NOT_FOUND);
+    expect(b.errors).toEqual(a.errors);
+    expect(b.vin).toBe("1HGCM82633A654321");
+
+    await decoder.decodeBatch(["INVALID"], { fastReject: true, reorderWindow: 4 });
+    expect(decoder.getRejectStats()).toEqual({
+      total: 3,
+      byCode: { [ErrorCode.WMI_NOT_FOUND]: 2, [ErrorCode.INVALID_LENGTH]: 1 },
+    });
+  });
+
+  it("should decode valid VINs fully", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [fast] = await decoder.decodeBatch(["KM8K2CAB4PU001140"], { fastReject: true });
+    const full = await decoder.decode("KM8K2CAB4PU001140");
+
+    expect(fast.components.vehicle).toEqual(full.components.vehicle);
+    expect(decoder.getRejectStats().total).toBe(0);
+  });
+});
@@ -0,0 +1,82 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import os from "os";
+import fs from "fs";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { RecordingDatabaseAdapter, ReplayDatabaseAdapter } from "../lib/db/replay-adapter";
+import { VINDecoder } from "../lib/decode";
+import { comparable } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = ["KM8K2CAB4PU001140", "5N1AT2MT9LC784186", "1FTEW1EG5JFA00000", "INVALID"];
+
+async function recordVins() {
+  const recorder = new RecordingDatabaseAdapter(new NodeDatabaseAdapter(TEST_DB_PATH));
+  const results = await new VINDecoder(recorder).decodeBatch(VINS);
+  return { recorder, recording: recorder.getRecording(), results };
+}
+
+describe("Record and replay adapters", () => {
+  it("should replay recorded queries to the same results without the database", async () => {
+    const { recorder, recording, results } = await recordVins();
+    expect(recording.entries.length).toBeGreaterThan(0);
+
+    // Round trip through disk
+    const file = path.join(fs.mkdtempSync(path.join(os.tmpdir(), "corgi-replay-")), "queries.json");
+    await recorder.save(file);
+
+    const replay = await ReplayDatabaseAdapter.load(file);
+    const replayed = await new VINDecoder(replay).decodeBatch(VINS);
+
+    expect(replayed.map(comparable)).toEqual(results.map(comparable));
+    expect(replay.getStats().misses).toBe(0);
+  });
+
+  it("should fail queries missing from the recording unless there is a fallback", async () => {
+    const replay = new ReplayDatabaseAdapter({ version: 1, entries: [] });
+    await expect(replay.exec("SELECT 1")).rejects.toThrow("Query not in recording");
+
+    const fallback = new ReplayDatabaseAdapter(
+      { version: 1, entries: [] },
+      { fallback: new NodeDatabaseAdapter(TEST_DB_PATH) },
+    );
+    const [result] = await fallback.exec("SELECT 1 AS one");
+    expect(result.values).toEqual([[1]]);
+    expect(fallback.getStats().misses).toBe(1);
+  });
+
+  it("should inject latency and limit queries in flight", async () => {
+    const { recording } = await recordVins();
+    const entries = recording.entries.slice(0, 6);
+
+    const replay = new ReplayDatabaseAdapter(recording, { latency: 10, concurrency: 2 });
+    const start = performance.now();
+    await Promise.all(entries.map((entry) => replay.exec(entry.query, entry.params)));
+    const elapsed = performance.now() - start;
+
+    const stats = replay.getStats();
+    expect(stats.queries).toBe(entries.length);
+    expect(stats.maxInFlight).toBe(2);
+    expect(stats.latency).toBe(entries.length * 10);
+    expect(stats.queueWait).toBeGreaterThan(0);
+    // Three rounds of two queries
+    expect(elapsed).toBeGreaterThanOrEqual(25);
+  });
+
+  it("should sample repeatable latencies from a seed", async () => {
+    const { recording } = await recordVins();
+    const entry = recording.entries[0];
+    const latency = { type: "lognormal" as const, median: 1, sigma: 0.5 };
+
+    const totals = [];
+    for (let run = 0; run < 2; run++) {
+      const replay = new ReplayDatabaseAdapter(recording, { latency, seed: 42 });
+      for (let i = 0; i < 5; i++) await replay.exec(entry.query, entry.params);
+      totals.push(replay.getStats().latency);
+    }
+
+    expect(totals[0]).toBe(totals[1]);
+    expect(totals[0]).toBeGreaterThan(0);
+  });
+});
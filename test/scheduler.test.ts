@@ -0,0 +1,58 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { PriorityScheduler } from "../lib/scheduler";
+import { CountingAdapter } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+describe("Priority scheduling", () => {
+  it("should hold bulk decodes at stage boundaries while an interactive decode runs", async () => {
+    const decoder = new VINDecoder(new CountingAdapter(new NodeDatabaseAdapter(TEST_DB_PATH), 2));
+    const vins = Array.from({ length: 40 }, (_, i) => `5N1AT2MT9LC${String(784100 + i)}`);
+
+    let bulkDone = false;
+    const bulk = decoder.decodeBatch(vins, { lookahead: 0 }).then((results) => {
+      bulkDone = true;
+      return results;
+    });
+    await sleep(10);
+    const interactive = await decoder.decode("KM8K2CAB4PU001140");
+
+    expect(interactive.components.vehicle?.model).toBeDefined();
+    expect(bulkDone).toBe(false);
+    expect((await bulk).length).toBe(40);
+
+    const stats = decoder.getSchedulerStats();
+    expect(stats.preempted).toBeGreaterThan(0);
+    expect(stats.latency.interactive.count).toBe(1);
+    expect(stats.latency.bulk.count).toBe(40);
+    await decoder.close();
+  });
+
+  it("should let bulk work through on its minimum share", async () => {
+    const scheduler = new PriorityScheduler({ minBulkShare: 0.2 });
+    const end = scheduler.begin("interactive");
+
+    let resumed = false;
+    const waiting = Promise.resolve(scheduler.checkpoint("bulk")).then(() => (resumed = true));
+    for (let stage = 0; stage < 3; stage++) scheduler.checkpoint("interactive");
+    await Promise.resolve();
+    expect(resumed).toBe(false);
+
+    // Four interactive stages earn one bulk stage
+    scheduler.checkpoint("interactive");
+    await waiting;
+    expect(scheduler.getStats().bulkGrants).toBe(1);
+
+    // Further bulk stages wait until the interactive decode ends
+    const next = scheduler.checkpoint("bulk");
+    expect(next).toBeInstanceOf(Promise);
+    end();
+    await next;
+    expect(scheduler.getStats()).toMatchObject({ running: { interactive: 0, bulk: 0 }, waiting: 0, preempted: 2 });
+  });
+});
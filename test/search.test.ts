@@ -0,0 +1,47 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { ModelSearchIndex, tokenizeSearchText } from "../lib/search";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+describe("Model search", () => {
+  let index: ModelSearchIndex;
+
+  beforeAll(async () => {
+    index = await ModelSearchIndex.build(new NodeDatabaseAdapter(TEST_DB_PATH));
+  });
+
+  it("should normalize punctuation, case and letter-digit boundaries", () => {
+    expect(tokenizeSearchText("F-150")).toEqual(["f", "150"]);
+    expect(tokenizeSearchText("f150")).toEqual(["f", "150"]);
+    expect(tokenizeSearchText("  Citroën C4 ")).toEqual(["citroen", "c", "4"]);
+  });
+
+  it("should rank the model named by free text first", () => {
+    expect(index.searchModels("f150")[0]).toMatchObject({ make: "FORD", model: "F-150" });
+    expect(index.searchModels("ford f 250")[0]).toMatchObject({ model: "F-250" });
+    expect(index.searchModels("must")[0]).toMatchObject({ model: "Mustang" });
+    expect(index.searchModels("tucsn")[0]).toMatchObject({ model: "Tucson" });
+  });
+
+  it("should find models by their series and trim names", () => {
+    expect(index.searchModels("lariat")[0]).toMatchObject({ model: "F-150" });
+    expect(index.searchModels("SEL").map((r) => r.model)).toEqual(["Kona"]);
+  });
+
+  it("should filter by make and model year", () => {
+    expect(index.searchModels("f", { make: "Ford" }).every((r) => r.make === "FORD")).toBe(true);
+    expect(index.searchModels("kona", { make: "Nissan" })).toEqual([]);
+    expect(index.searchModels("f250", { year: 2010 })[0]).toMatchObject({ model: "F-250" });
+    expect(index.searchModels("f250", { year: 2020 }).map((r) => r.model)).not.toContain("F-250");
+  });
+
+  it("should report its size", () => {
+    const report = index.getMemoryReport();
+    expect(report.models).toBe(6);
+    expect(report.makes).toBe(3);
+    expect(report.attributes).toBeGreaterThan(0);
+    expect(report.bytes).toBeGreaterThan(0);
+  });
+});
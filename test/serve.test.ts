@@ -0,0 +1,238 @@
+import { describe, it, expect, beforeAll, afterAll } from "vitest";
+import path from "path";
+import os from "os";
+import fs from "fs";
+import type { AddressInfo } from "net";
+import type { Server } from "http";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { AdmissionController, OverloadError } from "../lib/admission";
+import { DecoderPool } from "../lib/pool";
+import { PatternOverlay } from "../lib/overlay";
+import { createDecodeServer } from "../lib/server";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+const VIN = "KM8K2CAB4PU001140";
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+describe("Admission control", () => {
+  it("should run cheap requests ahead of queued full requests", async () => {
+    const admission = new AdmissionController({ concurrency: 1 });
+    const order: string[] = [];
+    const task = (name: string) => async () => {
+      await sleep(5);
+      order.push(name);
+    };
+
+    await Promise.all([
+      admission.run("full", task("full-1")),
+      admission.run("full", task("full-2")),
+      admission.run("cheap", task("cheap")),
+    ]);
+
+    expect(order).toEqual(["full-1", "cheap", "full-2"]);
+  });
+
+  it("should shed full requests once a standing queue exceeds the target delay", async () => {
+    const admission = new AdmissionController({ concurrency: 1, targetDelay: 5, interval: 20 });
+    const slow = () => sleep(15);
+
+    const outcomes = await Promise.allSettled(
+      Array.from({ length: 12 }, () => admission.run("full", slow))
+    );
+    const shed = outcomes.filter((o) => o.status === "rejected");
+
+    expect(shed.length).toBeGreaterThan(0);
+    expect((shed[0] as PromiseRejectedResult).reason).toBeInstanceOf(OverloadError);
+    expect(admission.getStats().shedLatency).toBe(shed.length);
+
+    // Cheap requests are still served under the same load
+    const cheap = await admission.run("cheap", async () => "ok");
+    expect(cheap).toBe("ok");
+  });
+
+  it("should reject immediately when the queue is full", async () => {
+    const admission = new AdmissionController({ concurrency: 1, maxQueue: 1, retryAfter: 3 });
+    const running = admission.run("full", () => sleep(10));
+    const queued = admission.run("full", () => sleep(10));
+
+    await expect(admission.run("cheap", async () => 1)).rejects.toMatchObject({
+      reason: "queue-full",
+      retryAfter: 3,
+    });
+    await Promise.all([running, queued]);
+    expect(admission.getStats().shedQueueFull).toBe(1);
+  });
+
+  it("should run interactive requests ahead of queued bulk requests", async () => {
+    const admission = new AdmissionController({ concurrency: 1 });
+    const order: string[] = [];
+    const task = (name: string) => async () => {
+      await sleep(5);
+      order.push(name);
+    };
+
+    await Promise.all([
+      admission.run("full", task("bulk-1"), "bulk"),
+      admission.run("full", task("bulk-2"), "bulk"),
+      admission.run("full", task("interactive"), "interactive"),
+    ]);
+
+    expect(order).toEqual(["bulk-1", "interactive", "bulk-2"]);
+    const { latency } = admission.getStats();
+    expect(latency.interactive.count).toBe(1);
+    expect(latency.bulk.count).toBe(2);
+  });
+
+  it("should give bulk requests their minimum share under interactive load", async () => {
+    const admission = new AdmissionController({ concurrency: 1, minBulkShare: 0.25 });
+    const order: string[] = [];
+    const task = (name: string) => async () => {
+      await sleep(1);
+      order.push(name);
+    };
+
+    await Promise.all([
+      admission.run("full", task("i0")),
+      ...["b1", "b2"].map((name) => admission.run("full", task(name), "bulk")),
+      ...["i1", "i2", "i3", "i4", "i5", "i6"].map((name) => admission.run("full", task(name))),
+    ]);
+
+    // One bulk start for every three interactive starts while both wait
+    expect(order).toEqual(["i0", "i1", "i2", "i3", "b1", "i4", "i5", "i6", "b2"]);
+    expect(admission.getStats().bulkGrants).toBe(1);
+  });
+});
+
+describe("Decode server", () => {
+  let server: Server;
+  let pool: DecoderPool;
+  let base: string;
+
+  beforeAll(async () => {
+    // Slow decodes so concurrent requests reliably queue up
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    pool = new DecoderPool({
+      workers: 0,
+      concurrency: 1,
+      decoder: {
+        decode: async (vin, options) => {
+          await sleep(50);
+          return decoder.decode(vin, options);
+        },
+        validate: (vin) => decoder.validate(vin),
+      },
+      maxQueue: 2,
+      retryAfter: 2,
+    });
+    server = createDecodeServer(pool);
+    await new Promise<void>((resolve) => server.listen(0, "127.0.0.1", resolve));
+    base = `http://127.0.0.1:${(server.address() as AddressInfo).port}`;
+  });
+
+  afterAll(async () => {
+    await new Promise((resolve) => server.close(resolve));
+    await pool.close();
+  });
+
+  it("should decode and validate over HTTP", async () => {
+    const decoded = await (await fetch(`${base}/decode/${VIN}`)).json();
+    expect(decoded.components.vehicle.make).toBe("Hyundai");
+
+    const validated = await (await fetch(`${base}/validate/${VIN}`)).json();
+    expect(validated.valid).toBe(true);
+    expect(validated.components.vehicle).toBeUndefined();
+  });
+
+  it("should serve repeat decodes from the result cache", async () => {
+    await fetch(`${base}/decode/${VIN}`);
+    expect(pool.getStats().cacheHits).toBeGreaterThan(0);
+  });
+
+  it("should give each caller its own copy of a cached result", async () => {
+    const first = await pool.decode(VIN);
+    first.components.vehicle!.model = "Changed";
+
+    const second = await pool.decode(VIN);
+    expect(second).not.toBe(first);
+    expect(second.components.vehicle?.model).not.toBe("Changed");
+  });
+
+  it("should keep overlay decodes out of the result cache", async () => {
+    const overlay = new PatternOverlay("fleet-a");
+    const hits = pool.getStats().cacheHits;
+
+    await pool.decode(VIN, { overlay });
+    await pool.decode(VIN, { overlay });
+    expect(pool.getStats().cacheHits).toBe(hits);
+  });
+
+  it("should return 503 with Retry-After when overloaded and count it in metrics", async () => {
+    const vins = ["5N1AT2MT9LC784186", "2FTEF14H8TCA73155", "1FTEW1EG5JFA00000", "1HGCM82633A123456"];
+    const responses = await Promise.all(vins.map((vin) => fetch(`${base}/decode/${vin}`)));
+    const shed = responses.filter((r) => r.status === 503);
+
+    expect(shed.length).toBeGreaterThan(0);
+    expect(shed[0].headers.get("retry-after")).toBe("2");
+
+    const metrics = await (await fetch(`${base}/metrics`)).text();
+    expect(metrics).toContain(`corgi_requests_shed_total{reason="queue-full"} ${shed.length}`);
+    expect(metrics).toMatch(/corgi_request_duration_seconds_count\{priority="interactive"\} [1-9]/);
+  });
+});
+
+describe("Affinity routing", () => {
+  // Stub worker that answers after a delay and reports which thread decoded
+  const WORKER_SOURCE = `
+const { parentPort, threadId } = require("worker_threads");
+parentPort.on("message", (request) => {
+  setTimeout(() => parentPort.postMessage({
+    id: request.id,
+    result: { vin: request.vin, valid: true, components: {}, errors: [], metadata: { threadId } },
+  }), 60);
+});
+`;
+  const SAME_WMI = ["KM8K2CAB4PU001140", "KM8K53AG1PU000000"];
+  let workerScript: string;
+
+  beforeAll(() => {
+    workerScript = path.join(fs.mkdtempSync(path.join(os.tmpdir(), "corgi-pool-")), "worker.cjs");
+    fs.writeFileSync(workerScript, WORKER_SOURCE);
+  });
+
+  const decodeBoth = async (pool: DecoderPool) => {
+    const results = await Promise.all(SAME_WMI.map((vin) => pool.decode(vin)));
+    await pool.close();
+    return results.map((result) => (result.metadata as any).threadId);
+  };
+
+  it("should queue decodes for a busy owner instead of spilling", async () => {
+    const pool = new DecoderPool({ workers: 2, workerScript, affinityMaxWait: 1000 });
+    const [first, second] = await decodeBoth(pool);
+
+    expect(second).toBe(first);
+    expect(pool.getStats()).toMatchObject({
+      affinityHits: 2,
+      affinityQueued: 1,
+      affinityDepthSpills: 0,
+      affinityWaitSpills: 0,
+    });
+  });
+
+  it("should spill once the owner's queue is full", async () => {
+    const pool = new DecoderPool({ workers: 2, workerScript, affinityQueueDepth: 0 });
+    const [first, second] = await decodeBoth(pool);
+
+    expect(second).not.toBe(first);
+    expect(pool.getStats()).toMatchObject({ affinityHits: 1, affinityQueued: 0, affinityDepthSpills: 1 });
+  });
+
+  it("should spill decodes that waited too long for their owner", async () => {
+    const pool = new DecoderPool({ workers: 2, workerScript, affinityMaxWait: 5 });
+    const [first, second] = await decodeBoth(pool);
+
+    expect(second).not.toBe(first);
+    expect(pool.getStats()).toMatchObject({ affinityHits: 1, affinityQueued: 1, affinityWaitSpills: 1 });
+  });
+});
@@ -0,0 +1,166 @@
+import { describe, it, expect, beforeAll, afterAll } from "vitest";
+import path from "path";
+import { createServer } from "net";
+import type { Server, AddressInfo } from "net";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { VPICDatabase } from "../lib/db";
+import { TieredCache } from "../lib/cache/backend";
+import { RespCacheBackend, RespParser } from "../lib/cache/resp-backend";
+import type { RespValue } from "../lib/cache/resp-backend";
+import { comparable, CountingAdapter } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+const VIN = "KM8K2CAB4PU001140";
+
+// Minimal RESP server standing in for Redis: GET, MGET, SET, PING
+function startRespServer(store: Map<string, string>): Promise<Server> {
+  const bulk = (value: string | null | undefined) =>
+    value === null || value === undefined
+      ? "$-1\r\n"
+      : `$${Buffer.byteLength(value)}\r\n${value}\r\n`;
+
+  const server = createServer((socket) => {
+    const parser = new RespParser();
+    socket.on("data", (chunk) => {
+      for (const command of parser.push(chunk) as RespValue[][]) {
+        const [name, ...args] = command as string[];
+        switch (name.toUpperCase()) {
+          case "GET":
+            socket.write(bulk(store.get(args[0])));
+            break;
+          case "MGET":
+            socket.write(`*${args.length}\r\n${args.map((key) => bulk(store.get(key))).join("")}`);
+            break;
+          case "SET":
+            store.set(args[0], args[1]);
+            socket.write("+OK\r\n");
+            break;
+          case "PING":
+            socket.write("+PONG\r\n");
+            break;
+          default:
+            socket.write(`-ERR unknown command '${name}'\r\n`);
+        }
+      }
+    });
+  });
+
+  return new Promise((resolve) => server.listen(0, "127.0.0.1", () => resolve(server)));
+}
+
+describe("Shared cache", () => {
+  const store = new Map<string, string>();
+  let server: Server;
+  let url: string;
+
+  beforeAll(async () => {
+    server = await startRespServer(store);
+    url = `redis://127.0.0.1:${(server.address() as AddressInfo).port}`;
+  });
+
+  afterAll(async () => {
+    await new Promise((resolve) => server.close(resolve));
+  });
+
+  it("should get, set and multi-get over RESP", async () => {
+    const backend = new RespCacheBackend({ url });
+
+    await backend.set("a", "line\r\nbreak ünïcode");
+    await backend.set("b", "2", 60);
+
+    expect(await backend.get("a")).toBe("line\r\nbreak ünïcode");
+    expect(await backend.mget(["a", "missing", "b"])).toEqual(["line\r\nbreak ünïcode", null, "2"]);
+    expect(await backend.command(["PING"])).toBe("PONG");
+    await expect(backend.command(["FLUSHALL"])).rejects.toThrow("unknown command");
+
+    await backend.close();
+  });
+
+  it("should start a new instance warm from the shared cache", async () => {
+    const firstCache = new TieredCache(new RespCacheBackend({ url }), { dbVersion: "v1" });
+    const first = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH), firstCache);
+    const expected = await first.decode(VIN);
+    expect(expected.valid).toBe(true);
+    await firstCache.flush();
+    expect([...store.keys()].some((key) => key.startsWith("corgi:v1:patterns:"))).toBe(true);
+
+    const adapter = new CountingAdapter(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const cache = new TieredCache(new RespCacheBackend({ url }), { dbVersion: "v1" });
+    const second = new VINDecoder(adapter, cache);
+
+    expect(comparable(await second.decode(VIN))).toEqual(comparable(expected));
+    expect(adapter.queries).toBe(0);
+    expect(cache.getStats().l2Hits).toBe(1);
+
+    // Repeat decodes are served from the in-process L1
+    await second.decode(VIN);
+    expect(cache.getStats().l1Hits).toBe(1);
+
+    await first.close();
+    await second.close();
+    await firstCache.close();
+    await cache.close();
+  });
+
+  it("should namespace entries by database version", async () => {
+    const adapter = new CountingAdapter(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const cache = new TieredCache(new RespCacheBackend({ url }), { dbVersion: "v2" });
+    const decoder = new VINDecoder(adapter, cache);
+
+    await decoder.decode(VIN);
+    expect(adapter.queries).toBeGreaterThan(0);
+    expect(cache.getStats().l2Hits).toBe(0);
+
+    await cache.close();
+  });
+
+  it("should keep decoding when the backend is unavailable", async () => {
+    const cache = new TieredCache(new RespCacheBackend({ url: "redis://127.0.0.1:1", timeout: 200 }), {
+      dbVersion: "v3",
+    });
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH), cache);
+
+    const result = await decoder.decode(VIN);
+    expect(result.components.vehicle?.make).toBe("Hyundai");
+    await cache.flush();
+    expect(cache.getStats().l2Errors).toBeGreaterThan(0);
+  });
+
+  it("should not let callers mutate cached results", async () => {
+    const cache = new TieredCache(new RespCacheBackend({ url }), { dbVersion: "v4" });
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH), cache);
+
+    const first = await decoder.decode(VIN);
+    const expected = JSON.parse(JSON.stringify(comparable(first)));
+    first.errors.push(first.errors[0]);
+    first.components.vehicle!.model = "Changed";
+
+    const second = await decoder.decode(VIN);
+    expect(comparable(second)).toEqual(expected);
+    second.components.vehicle!.model = "Changed";
+    expect(comparable(await decoder.decode(VIN))).toEqual(expected);
+    expect(cache.getStats().l1Hits).toBeGreaterThan(0);
+
+    await cache.close();
+  });
+
+  it("should read pattern sets from the query cache first and copy shared rows", async () => {
+    const cache = new TieredCache(new RespCacheBackend({ url }), { dbVersion: "v5" });
+    const adapter = new NodeDatabaseAdapter(TEST_DB_PATH);
+    const schemaIds = (await new VPICDatabase(adapter).getValidSchemas("KM8", 2023)).map((s) => s.SchemaId);
+
+    const expected = JSON.parse(JSON.stringify(await new VPICDatabase(adapter, cache).getPatterns(schemaIds)));
+    const db = new VPICDatabase(adapter, cache);
+    const rows = await db.getPatterns(schemaIds);
+    expect(cache.getStats().l1Hits).toBe(1);
+    rows[0].ResolvedValue = "Changed";
+
+    // Served from this instance's query cache without asking the shared cache again
+    expect(await db.getPatterns(schemaIds)).toBe(rows);
+    expect(cache.getStats().l1Hits).toBe(1);
+
+    expect(await new VPICDatabase(adapter, cache).getPatterns(schemaIds)).toEqual(expected);
+    await cache.close();
+  });
+});
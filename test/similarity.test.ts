@@ -0,0 +1,93 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { findSimilarVins } from "../lib/similarity";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+describe("VIN similarity join", () => {
+  it("should pair VINs one character apart and annotate check digits", () => {
+    const pairs = findSimilarVins(["KM8K2CAB4PU001140", "5N1AT2MT9LC784186", "KM8K2CAB4PU001141"]);
+
+    expect(pairs).toEqual([
+      {
+        a: "KM8K2CAB4PU001140",
+        b: "KM8K2CAB4PU001141",
+        distance: 1,
+        positions: [17],
+        checkDigitValid: [true, false],
+      },
+    ]);
+  });
+
+  it("should agree with the decoder on which check digits are valid", () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const vins = ["1M8GDM9AXKP042788", "1M8GDM9AXKP042789", "1M8GDM9A1KP042788", "1m8gdm9axkp042780"];
+    const pairs = findSimilarVins(vins, { maxDistance: 2 });
+
+    expect(pairs.length).toBeGreaterThan(0);
+    for (const pair of pairs) {
+      expect(pair.checkDigitValid).toEqual([
+        decoder.validate(pair.a).components.checkDigit?.isValid ?? false,
+        decoder.validate(pair.b).components.checkDigit?.isValid ?? false,
+      ]);
+    }
+    expect(decoder.validate(vins[0]).valid).toBe(true);
+  });
+
+  it("should only report transpositions and other pairs within maxDistance", () => {
+    const vins = ["5N1AT2MT9LC784186", "5N1AT2MT9LC784168", "5N1AT2MT9LC748861"];
+
+    expect(findSimilarVins(vins)).toEqual([]);
+    const pairs = findSimilarVins(vins, { maxDistance: 2 });
+    expect(pairs.map((pair) => [pair.a, pair.b, pair.positions])).toEqual([
+      ["5N1AT2MT9LC784186", "5N1AT2MT9LC784168", [16, 17]],
+    ]);
+  });
+
+  it("should ignore duplicates, case and malformed entries", () => {
+    const pairs = findSimilarVins(["KM8K2CAB4PU001140", "km8k2cab4pu001140", "KM8K2CAB4PU00114", "KM8K2CAB4PU00114*"]);
+
+    expect(pairs).toEqual([]);
+  });
+
+  it("should find the same pairs as comparing every VIN with every other", () => {
+    // Two characters per position, so many pairs fall within distance 2
+    let seed = 7;
+    const random = () => {
+      seed = (Math.imul(seed, 1103515245) + 12345) >>> 0;
+      return seed / 4294967296;
+    };
+    const vins = Array.from({ length: 400 }, () =>
+      Array.from({ length: 17 }, () => "A0"[Math.floor(random() * 2)]).join(""),
+    );
+    const unique = [...new Set(vins)];
+
+    const expected: string[] = [];
+    for (let i = 0; i < unique.length; i++) {
+      for (let j = i + 1; j < unique.length; j++) {
+        let distance = 0;
+        for (let position = 0; position < 17; position++) {
+          if (unique[i][position] !== unique[j][position]) distance++;
+        }
+        if (distance <= 2) expected.push(`${unique[i]} ${unique[j]}`);
+      }
+    }
+
+    const pairs = findSimilarVins(vins, { maxDistance: 2 });
+    expect(expected.length).toBeGreaterThan(0);
+    expect(pairs.map((pair) => `${pair.a} ${pair.b}`)).toEqual(expected);
+  });
+
+  it("should mark whether both VINs decode to the same vehicle", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const pairs = await decoder.findNearDuplicates(["KM8K2CAB4PU001140", "KM8K2CAB4PU001141", "KM8K3CAB4PU001140"]);
+
+    expect(pairs.map((pair) => [pair.b, pair.sameSpec])).toEqual([
+      ["KM8K2CAB4PU001141", true],
+      ["KM8K3CAB4PU001140", false],
+    ]);
+    await decoder.close();
+  });
+});
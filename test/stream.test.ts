@@ -0,0 +1,135 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { CloudflareD1Adapter } from "../lib/db/d1-adapter";
+import { VINDecoder } from "../lib/decode";
+import { createByteDecodeStream, createDecodeStream, createNdjsonStream } from "../lib/stream";
+import type { DecodeOptions, DecodeResult } from "../lib/types";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = [
+  "KM8K2CAB4PU001140",
+  "5N1AT2MT9LC784186",
+  "2FTEF14H8TCA73155",
+  "INVALID",
+  "1HGCM82633A123456",
+  "KM8K2CAB4PU001140",
+];
+
+async function collect<T>(stream: ReadableStream<T>): Promise<T[]> {
+  const items: T[] = [];
+  const reader = stream.getReader();
+  for (let next = await reader.read(); !next.done; next = await reader.read()) {
+    items.push(next.value);
+  }
+  return items;
+}
+
+// Decoder that records how many decodes run at once
+function tracking(decoder: VINDecoder) {
+  const stats = { started: 0, active: 0, peak: 0 };
+  return {
+    stats,
+    async decode(vin: string, options?: DecodeOptions): Promise<DecodeResult> {
+      stats.started++;
+      stats.peak = Math.max(stats.peak, ++stats.active);
+      try {
+        await new Promise((resolve) => setTimeout(resolve, 2));
+        return await decoder.decode(vin, options);
+      } finally {
+        stats.active--;
+      }
+    },
+  };
+}
+
+// D1 binding served from the test database, counting batches
+function fakeD1(adapter: NodeDatabaseAdapter) {
+  const batches: number[] = [];
+  const statement = (query: string, params: any[]) => ({
+    async all() {
+      const [result] = await adapter.exec(query, params);
+      const rows = (result?.values ?? []).map((row) =>
+        Object.fromEntries(result.columns.map((column, i) => [column, row[i]])),
+      );
+      return { results: rows, success: true, meta: {} };
+    },
+  });
+  const d1 = {
+    prepare: (query: string) => ({ bind: (...params: any[]) => statement(query, params) }),
+    async batch(statements: Array<ReturnType<typeof statement>>) {
+      batches.push(statements.length);
+      return Promise.all(statements.map((s) => s.all()));
+    },
+  };
+  return { d1: d1 as any, batches };
+}
+
+describe("Decode streams", () => {
+  const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+
+  it("should decode VINs in input order with bounded concurrency", async () => {
+    const tracked = tracking(decoder);
+    const source = ReadableStream.from([...VINS, ...VINS, ...VINS]);
+
+    const results = await collect(source.pipeThrough(createDecodeStream(tracked, { concurrency: 4 })));
+    expect(results.map((r) => r.vin)).toEqual([...VINS, ...VINS, ...VINS]);
+    expect(tracked.stats.peak).toBeLessThanOrEqual(4);
+    expect(tracked.stats.peak).toBeGreaterThan(1);
+  });
+
+  it("should split CSV bytes into VINs across chunk boundaries", async () => {
+    const csv = VINS.map((vin, i) => (i % 2 ? `${vin.toLowerCase()},x,y\r\n` : ` ${vin}\n\n`)).join("");
+    const bytes = new TextEncoder().encode(csv.slice(0, -1));
+    // Chunks of 7 bytes split VINs and line endings
+    const chunks = Array.from({ length: Math.ceil(bytes.length / 7) }, (_, i) => bytes.slice(i * 7, i * 7 + 7));
+
+    const results = await collect(ReadableStream.from(chunks).pipeThrough(createByteDecodeStream(decoder)));
+    expect(results.map((r) => r.vin)).toEqual(VINS);
+
+    const direct = await decoder.decode(VINS[1]);
+    expect(results[1].components.vehicle).toEqual(direct.components.vehicle);
+  });
+
+  it("should stop pulling input while the reader is behind", async () => {
+    const tracked = tracking(decoder);
+    let pulled = 0;
+    const source = new ReadableStream<string>(
+      {
+        pull(controller) {
+          controller.enqueue(VINS[pulled++ % VINS.length]);
+          if (pulled === 1000) controller.close();
+        },
+      },
+      { highWaterMark: 0 },
+    );
+
+    const readable = source.pipeThrough(createDecodeStream(tracked, { concurrency: 4, highWaterMark: 2 }));
+    await new Promise((resolve) => setTimeout(resolve, 100));
+    expect(tracked.stats.started).toBeLessThan(20);
+    expect(pulled).toBeLessThan(20);
+    await readable.cancel();
+  });
+
+  it("should share D1 round trips between concurrent decodes", async () => {
+    const { d1, batches } = fakeD1(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const batched = new VINDecoder(new CloudflareD1Adapter(d1, { batchQueries: true }));
+
+    const results = await collect(ReadableStream.from(VINS).pipeThrough(createDecodeStream(batched)));
+    expect(results.map((r) => r.components.vehicle?.model)).toEqual(
+      await Promise.all(VINS.map(async (vin) => (await decoder.decode(vin)).components.vehicle?.model)),
+    );
+    expect(Math.max(...batches)).toBeGreaterThan(1);
+  });
+
+  it("should encode results as NDJSON", async () => {
+    const ndjson = ReadableStream.from(VINS.slice(0, 2))
+      .pipeThrough(createDecodeStream(decoder))
+      .pipeThrough(createNdjsonStream())
+      .pipeThrough(new TextDecoderStream());
+
+    const lines = (await collect(ndjson)).join("").trim().split("\n");
+    expect(lines.map((line) => JSON.parse(line).vin)).toEqual(VINS.slice(0, 2));
+  });
+});
@@ -0,0 +1,76 @@
+import { describe, it, expect } from "vitest";
+import path from "path";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VINDecoder } from "../lib/decode";
+import { ResultTemplates } from "../lib/templates";
+import { comparable } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+// Two Konas from the same build, differing only in serial number
+const SAME_BUILD = ["KM8K2CAB4PU001140", "KM8K2CAB4PU001141"];
+
+describe("Shared result components", () => {
+  it("should share frozen components between VINs of the same build", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [a, b] = await decoder.decodeBatch(SAME_BUILD, { shareComponents: true, includePatternDetails: true });
+
+    expect(b.components.vehicle).toBe(a.components.vehicle);
+    expect(b.components.wmi).toBe(a.components.wmi);
+    expect(b.components.vds).toBe(a.components.vds);
+    expect(b.components.engine).toBe(a.components.engine);
+    expect(Object.isFrozen(a.components.vehicle)).toBe(true);
+    expect(Object.isFrozen(a.components.vds!.patterns[0])).toBe(true);
+
+    // Per-VIN parts stay fresh
+    expect(b.vin).not.toBe(a.vin);
+    expect(b.components).not.toBe(a.components);
+    expect(b.components.vis?.raw).toBe("PU001141");
+    expect(b.metadata).not.toBe(a.metadata);
+
+    expect(decoder.getTemplateStats().hits).toBeGreaterThan(0);
+  });
+
+  it("should return the same content as unshared decoding", async () => {
+    const vins = [...SAME_BUILD, "5N1AT2MT9LC784186", "INVALID"];
+    const plain = await new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH)).decodeBatch(vins, {
+      includePatternDetails: true,
+    });
+    const shared = await new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH)).decodeBatch(vins, {
+      includePatternDetails: true,
+      shareComponents: true,
+    });
+
+    expect(shared.map(comparable)).toEqual(plain.map(comparable));
+  });
+
+  it("should share VDS components only between VINs with the same match outcome", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [result] = await decoder.decodeBatch([SAME_BUILD[0]]);
+    const templates = new ResultTemplates();
+
+    // Same WMI, year and VDS, but VIS matches that reorder the VDS patterns
+    const copy = () => JSON.parse(JSON.stringify(result));
+    const reordered = copy();
+    reordered.components.vds.patterns.reverse();
+    const expected = JSON.parse(JSON.stringify(reordered.components.vds));
+
+    const a = templates.share(copy(), "KM8|2023|1|#0|U");
+    const b = templates.share(reordered, "KM8|2023|1|#0|X");
+    const c = templates.share(copy(), "KM8|2023|1|#0|U");
+
+    expect(b.components.vds).not.toBe(a.components.vds);
+    expect(b.components.vds).toEqual(expected);
+    expect(c.components.vds).toBe(a.components.vds);
+    expect(c.components.vehicle).toBe(a.components.vehicle);
+  });
+
+  it("should leave results unshared unless asked", async () => {
+    const decoder = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+    const [a, b] = await decoder.decodeBatch(SAME_BUILD);
+
+    expect(b.components.vehicle).not.toBe(a.components.vehicle);
+    expect(Object.isFrozen(a.components.vehicle)).toBe(false);
+    expect(decoder.getTemplateStats()).toEqual({ hits: 0, misses: 0, entries: 0 });
+  });
+});
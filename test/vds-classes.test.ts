@@ -0,0 +1,108 @@
+import { describe, it, expect, beforeAll } from "vitest";
+import path from "path";
+import { copyFileSync, mkdtempSync } from "fs";
+import { tmpdir } from "os";
+import Database from "better-sqlite3";
+import { NodeDatabaseAdapter } from "../lib/db/node-adapter";
+import { VPICDatabase } from "../lib/db";
+import { VINDecoder } from "../lib/decode";
+import { PatternMatcher } from "../lib/pattern";
+import { compileVdsClasses, lookupVdsClass, VIN_ALPHABET } from "../lib/db/vds-classes";
+import { compileVdsClassTables } from "../lib/db/vds-class-builder";
+import { HotIndex, IndexedDatabaseAdapter } from "../lib/db/hot-index";
+import { compileHotIndex } from "../lib/db/hot-index-builder";
+import { comparable } from "./fixtures";
+
+const TEST_DB_PATH = path.join(__dirname, "./test.db");
+
+const VINS = [
+  "KM8K2CAB4PU001140",
+  "KM8K53AG1PU000000",
+  "5N1AT2MT9LC784186",
+  "5N1BT3BB0LC700000",
+  "2FTEF14H8TCA73155",
+  "1HGCM82633A123456",
+];
+
+describe("VDS equivalence classes", () => {
+  const matcher = new PatternMatcher(new NodeDatabaseAdapter(TEST_DB_PATH));
+  const score = (pattern: string, input: string) => matcher.calculateConfidence(pattern, input);
+
+  it("should agree with direct scoring for every VDS", () => {
+    const patterns = ["A[B-D]*", "*[0-4]", "[AC]1", "A1B*C2", "[A-C][1-3]*|*U", "******"];
+    const table = compileVdsClasses(patterns, score)!;
+    expect(table.patterns).not.toContain("[A-C][1-3]*|*U");
+
+    for (let i = 0; i < 500; i++) {
+      const vds = Array.from({ length: 6 }, (_, p) =>
+        VIN_ALPHABET[(i * (p + 7) + p * p * 13) % VIN_ALPHABET.length]
+      ).join("");
+      const matched = new Map(lookupVdsClass(table, vds)!.map(([index, confidence]) => [table.patterns[index], confidence]));
+      for (const pattern of table.patterns) {
+        expect(matched.get(pattern) ?? 0).toBe(score(pattern, vds + "00000000"));
+      }
+    }
+  });
+
+  it("should refuse schemas with patterns reading past the VDS", () => {
+    expect(compileVdsClasses(["ABCDEF*"], score)).toBeNull();
+  });
+
+  describe("compiled into a database", () => {
+    let classPath: string;
+
+    beforeAll(async () => {
+      classPath = path.join(mkdtempSync(path.join(tmpdir(), "corgi-vds-")), "classes.db");
+      copyFileSync(TEST_DB_PATH, classPath);
+
+      const { tables } = await compileVdsClassTables(new NodeDatabaseAdapter(TEST_DB_PATH));
+      expect(tables.size).toBeGreaterThan(0);
+
+      const db = new Database(classPath);
+      db.exec("CREATE TABLE VdsClass (VinSchemaId INTEGER PRIMARY KEY, Data TEXT NOT NULL)");
+      const insert = db.prepare("INSERT INTO VdsClass (VinSchemaId, Data) VALUES (?, ?)");
+      for (const [schemaId, table] of tables) {
+        insert.run(schemaId, JSON.stringify(table));
+      }
+      db.close();
+    });
+
+    it("should load class tables only when the table exists", async () => {
+      const withClasses = new VPICDatabase(new NodeDatabaseAdapter(classPath));
+      const withoutClasses = new VPICDatabase(new NodeDatabaseAdapter(TEST_DB_PATH));
+      const schemaIds = (await withClasses.getValidSchemas("KM8", 2023)).map((s) => s.SchemaId);
+
+      expect(await withClasses.getVdsClassTables(schemaIds)).toHaveLength(schemaIds.length);
+      expect(await withoutClasses.getVdsClassTables(schemaIds)).toBeUndefined();
+    });
+
+    it("should read class tables for indexed schemas from the index", async () => {
+      const data = await compileHotIndex(new NodeDatabaseAdapter(classPath), ["KM8"]);
+      const index = new HotIndex(data);
+      const adapter = new IndexedDatabaseAdapter(index, new NodeDatabaseAdapter(TEST_DB_PATH));
+      const db = new VPICDatabase(adapter);
+      const schemaIds = (await db.getValidSchemas("KM8", 2023)).map((s) => s.SchemaId);
+      const before = index.getStats();
+
+      expect(await db.getVdsClassTables(schemaIds)).toHaveLength(schemaIds.length);
+      expect(index.getStats()).toEqual(before);
+      expect(adapter.fallbackQueryCount).toBe(0);
+
+      const decoder = new VINDecoder(adapter);
+      const baseline = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+      expect(comparable(await decoder.decode(VINS[0]))).toEqual(comparable(await baseline.decode(VINS[0])));
+    });
+
+    it("should decode identically to direct pattern scoring", async () => {
+      const baseline = new VINDecoder(new NodeDatabaseAdapter(TEST_DB_PATH));
+      const decoder = new VINDecoder(new NodeDatabaseAdapter(classPath));
+
+      for (const vin of VINS) {
+        const options = { includePatternDetails: true };
+        expect(comparable(await decoder.decode(vin, options))).toEqual(
+          comparable(await baseline.decode(vin, options))
+        );
+      }
+    });
+  });
+});
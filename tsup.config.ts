@@ -1,4 +1,6 @@
 import { defineConfig } from "tsup";
+import { writeFileSync } from "fs";
+import { MATCH_KERNEL_WASM } from "./lib/db/match-kernel-wasm";
 
 // Properly configure tsup to generate declarations correctly
 export default defineConfig([
@@ -7,6 +9,8 @@ export default defineConfig([
     entry: [
       "lib/index.ts",
       "lib/cli.ts",
+      "lib/pool-worker.ts",
+      "lib/bulk-worker.ts",
     ],
     format: ["esm", "cjs"],
     dts: {
@@ -94,5 +98,9 @@ export default defineConfig([
         js: ".mjs",
       };
     },
+    // Workers only load precompiled WebAssembly, so ship the matching kernel as a file
+    async onSuccess() {
+      writeFileSync("dist/match-kernel.wasm", MATCH_KERNEL_WASM);
+    },
   },
 ]);